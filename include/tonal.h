@@ -20,8 +20,28 @@
 #ifndef TONAL_H_
 #define TONAL_H_
 
+#include <stddef.h>
 #include <stdio.h>
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Alteration range
+ *
+ * Pitch alterations range from TONAL_ALTERATION_MAX flats to
+ * TONAL_ALTERATION_MAX sharps. The default, 2, allows double flats and double
+ * sharps, and single diminished and augmented intervals. Compiling the
+ * library and its users with for example -DTONAL_ALTERATION_MAX=3 adds triple
+ * flats and sharps, and doubly diminished and doubly augmented intervals.
+ *
+ * TONAL_ALTERATION_MAX must be an integer literal from 2 to 8.
+ */
+#ifndef TONAL_ALTERATION_MAX
+#define TONAL_ALTERATION_MAX 2
+#endif
+
 /* Diatonic Pitch */
 enum {
         DP_C,
@@ -37,22 +57,30 @@ enum {
 /*
  * String representations of the DP_ (Diatonic Pitch) values, indexed by DP_.
  */
-extern const char *diatonic_pitch_str[];
+extern const char *const diatonic_pitch_str[];
 
-/* Pitch Alteration */
+/*
+ * Pitch Alteration
+ *
+ * Valid values are 0 to PA_NONE - 1. With a wider alteration range, values
+ * below PA_bb and above PA_ss are further flats and sharps.
+ */
 enum {
-        PA_bb,
+        PA_bb = TONAL_ALTERATION_MAX - 2,
         PA_b,
         PA_,
         PA_s,
         PA_ss,
-        PA_NONE
+        PA_NONE = 2 * TONAL_ALTERATION_MAX + 1
 };
 
+/* Pitch Alteration with a sharps (a > 0) or -a flats (a < 0). */
+#define PA_ALTERATION(a) (PA_ + (a))
+
 /*
  * String representation of the PA_ (Pitch Alteration) values, indexed by PA_.
  */
-extern const char *pitch_alteration_str[];
+extern const char *const pitch_alteration_str[];
 
 /* TPC: Tonal Pitch Class. */
 struct tonal_pitch_class {
@@ -60,13 +88,32 @@ struct tonal_pitch_class {
         int pitch_alteration;
 };
 
-/* TP: Tonal Pitch */
+/*
+ * TP: Tonal Pitch
+ *
+ * The octave may be any integer, also negative. Which MIDI Note Number a
+ * pitch has depends on the octave convention, see OC_.
+ */
 struct tonal_pitch {
         int diatonic_pitch;
         int pitch_alteration;
         int octave;
 };
 
+/*
+ * Octave Convention
+ *
+ * Pitch octaves are printed and parsed as they are, "C4" is octave 4. The
+ * octave convention decides which MIDI Note Number that is.
+ */
+enum {
+        /* C5 is MNN 60 and C0 is MNN 0. Used by tp_to_mnn(). */
+        OC_C5,
+        /* C4 is MNN 60 and C-1 is MNN 0, as in scientific pitch notation. */
+        OC_C4,
+        OC_NONE
+};
+
 
 /* Diatonic Interval */
 enum {
@@ -84,23 +131,33 @@ enum {
  * String representations of the DI_ (Diatonic Interval) values, indexed by
  * DI_.
  */
-extern const char *diatonic_interval_str[];
+extern const char *const diatonic_interval_str[];
 
-/* Interval Alteration */
+/*
+ * Interval Alteration
+ *
+ * Valid values are 0 to IA_NONE - 1. With a wider alteration range, values
+ * below IA_DIMINISHED are multiply diminished and values above IA_AUGMENTED
+ * multiply augmented, up to TONAL_ALTERATION_MAX - 1 times.
+ */
 enum {
-        IA_DIMINISHED,
+        IA_DIMINISHED = TONAL_ALTERATION_MAX - 2,
         IA_MINOR,
         IA_MAJOR,
         IA_PERFECT,
         IA_AUGMENTED,
-        IA_NONE
+        IA_NONE = IA_AUGMENTED + TONAL_ALTERATION_MAX - 1
 };
 
+/* n times diminished and n times augmented, IA_AUGMENTED_N(2) is doubly. */
+#define IA_DIMINISHED_N(n) (IA_DIMINISHED + 1 - (n))
+#define IA_AUGMENTED_N(n) (IA_AUGMENTED - 1 + (n))
+
 /*
  * String representations of the IA_ (Interval Alteration) values, indexed by
  * IA_.
  */
-extern const char *interval_alteration_str[];
+extern const char *const interval_alteration_str[];
 
 /* Interval Direction */
 enum {
@@ -113,7 +170,7 @@ enum {
  * String representations of the ID_ (Interval Direction) values, indexed by
  * ID_.
  */
-extern const char *interval_direction_str[];
+extern const char *const interval_direction_str[];
 
 /* TIC: Tonal Interval Class */
 struct tonal_interval_class {
@@ -141,6 +198,40 @@ enum {
         TONAL_FAIL
 };
 
+/*
+ * Error details
+ *
+ * Reported by the status arrays of the batch operations and by the _err
+ * variants of the arithmetic functions. Only computed once an operation has
+ * failed. TONAL_E_OK equals TONAL_OK, any other value is a failure.
+ */
+enum {
+        TONAL_E_OK = TONAL_OK,
+        /* Unspecified failure */
+        TONAL_E_FAIL = TONAL_FAIL,
+        /* NULL pointer parameter */
+        TONAL_E_NULL,
+        /* Diatonic pitch or diatonic interval out of range */
+        TONAL_E_DIATONIC,
+        /* Pitch alteration out of range */
+        TONAL_E_ALTERATION,
+        /* Negative interval octave */
+        TONAL_E_OCTAVE,
+        /* Invalid interval alteration for the diatonic interval */
+        TONAL_E_QUALITY,
+        /* Invalid interval direction */
+        TONAL_E_DIRECTION,
+        /* Valid operands, but the result can not be represented. */
+        TONAL_E_RANGE,
+        TONAL_E_NONE
+};
+
+/*
+ * String representations of the TONAL_E_ (error detail) values, indexed by
+ * TONAL_E_.
+ */
+extern const char *const tonal_error_str[];
+
 /* Pretty print to stream. */
 extern int tpc_print(FILE *stream, const struct tonal_pitch_class *tpc);
 extern int tp_print(FILE *stream, const struct tonal_pitch *tp);
@@ -200,7 +291,7 @@ extern int ti_add(
 /*
  * Calculate difference (tonal interval) between two tonal pitches.
  *
- * ti_diff := tp1 - tp0
+ * ti_diff := tp0 - tp1
  */
 extern int tp_sub(
         const struct tonal_pitch *tp0,
@@ -211,7 +302,7 @@ extern int tp_sub(
 /*
  * Calculate difference (tonal interval) between two tonal intervals.
  *
- * ti_diff := ti1 - ti0
+ * ti_diff := ti0 - ti1
  */
 extern int ti_sub(
         const struct tonal_interval *ti0,
@@ -219,10 +310,136 @@ extern int ti_sub(
         struct tonal_interval *ti_diff
 );
 
-/* Translate Tonal Pitch to MIDI Note Number. */
+/*
+ * Same as tp_add, ti_add, tp_sub and ti_sub. On failure, and if error is not
+ * NULL, *error is set to the reason (TONAL_E_).
+ */
+extern int tp_add_err(
+        const struct tonal_pitch *tp,
+        const struct tonal_interval *ti,
+        struct tonal_pitch *tp_sum,
+        int *error
+);
+extern int ti_add_err(
+        const struct tonal_interval *ti0,
+        const struct tonal_interval *ti1,
+        struct tonal_interval *ti_sum,
+        int *error
+);
+extern int tp_sub_err(
+        const struct tonal_pitch *tp0,
+        const struct tonal_pitch *tp1,
+        struct tonal_interval *ti_diff,
+        int *error
+);
+extern int ti_sub_err(
+        const struct tonal_interval *ti0,
+        const struct tonal_interval *ti1,
+        struct tonal_interval *ti_diff,
+        int *error
+);
+
+/*
+ * Translate Tonal Pitch to MIDI Note Number, with octave convention OC_C5.
+ * Returns INT_MIN if tp is invalid.
+ */
 extern int tp_to_mnn(
         const struct tonal_pitch *tp
 );
 
+/* Same as tp_to_mnn() with octave convention oc (OC_). */
+extern int tp_to_mnn_oc(
+        const struct tonal_pitch *tp,
+        int oc
+);
+
+/*
+ * Translate MIDI Note Number to Tonal Pitch with octave convention oc. Black
+ * keys are spelled with sharps.
+ */
+extern int tp_from_mnn(
+        struct tonal_pitch *tp,
+        int mnn,
+        int oc
+);
+
+/*
+ * Format as tpc_print() and tp_print() to buf, NUL terminated. Returns
+ * TONAL_FAIL if the argument is invalid or buf is too small.
+ */
+extern int tpc_snprint(
+        char *buf,
+        size_t size,
+        const struct tonal_pitch_class *tpc
+);
+extern int tp_snprint(
+        char *buf,
+        size_t size,
+        const struct tonal_pitch *tp
+);
+
+/*
+ * Parse a Tonal Pitch Class or Tonal Pitch as printed by tpc_print() and
+ * tp_print(): a letter A to G (or a to g), any number of "#" or of "b" within
+ * the alteration range, and for tp_parse() the octave, for example "Ebb-1".
+ * If end is not NULL, *end is set to the character after the parsed text.
+ */
+extern int tpc_parse(
+        const char *str,
+        struct tonal_pitch_class *tpc,
+        const char **end
+);
+extern int tp_parse(
+        const char *str,
+        struct tonal_pitch *tp,
+        const char **end
+);
+
+/*
+ * Batch operations
+ *
+ * Each operates element-wise on arrays of n elements. If status is not NULL,
+ * status[i] receives TONAL_OK or the reason (TONAL_E_) for the failure on
+ * element i. The return value is TONAL_OK if the operation succeeded on all
+ * elements.
+ */
+
+/* tp_sum[i] := tp[i] + ti[i] */
+extern int tp_add_n(
+        const struct tonal_pitch *tp,
+        const struct tonal_interval *ti,
+        struct tonal_pitch *tp_sum,
+        int *status,
+        size_t n
+);
+
+/* tp_sum[i] := tp[i] + ti */
+extern int tp_transpose_n(
+        const struct tonal_pitch *tp,
+        const struct tonal_interval *ti,
+        struct tonal_pitch *tp_sum,
+        int *status,
+        size_t n
+);
+
+/* ti_diff[i] := tp0[i] - tp1[i] */
+extern int tp_sub_n(
+        const struct tonal_pitch *tp0,
+        const struct tonal_pitch *tp1,
+        struct tonal_interval *ti_diff,
+        int *status,
+        size_t n
+);
+
+/* mnn[i] := tp_to_mnn(&tp[i]) */
+extern int tp_to_mnn_n(
+        const struct tonal_pitch *tp,
+        int *mnn,
+        size_t n
+);
+
+#ifdef __cplusplus
+}
 #endif
 
+#endif
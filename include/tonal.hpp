@@ -0,0 +1,692 @@
+/*
+ * Copyright 2016 Martin Aberg
+ *
+ * This file is part of tonal.
+ *
+ * tonal is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * tonal is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * C++ value types for tonal (C++17).
+ *
+ * Pitch, Interval, PitchClass and IntervalClass derive from the corresponding
+ * C structures, so they are layout compatible with the C API and can be
+ * passed to it directly. The (diatonic value, chromatic value) arithmetic of
+ * tonal.c is reimplemented here as constexpr, so that arithmetic on constant
+ * operands folds at compile time.
+ *
+ * Operations which may fail return std::optional. An empty optional
+ * corresponds to TONAL_FAIL from the C API. No exceptions are thrown.
+ */
+
+#ifndef TONAL_HPP_
+#define TONAL_HPP_
+
+#include <cstddef>
+#include <optional>
+
+#include <tonal.h>
+
+namespace tonal {
+
+namespace detail {
+
+/* Mirrors struct tonal_element in tonal_priv.h. */
+struct element {
+        int diatonic_point;
+        int alteration;
+        int octave;
+};
+
+/* Marks an invalid {diatonic_interval, interval_alteration} combination. */
+constexpr int X = 'x';
+
+constexpr int DT_TO_MPC_TABLE[7] = { 0, 2, 4, 5, 7, 9, 11 };
+
+/* Tonal Class alteration for IA_DIMINISHED to IA_AUGMENTED */
+constexpr int TIC_TO_TC_TABLE[DI_NONE][5] = {
+/*              DIM    MINOR    MAJOR     PERF      AUG */
+/* PRIME   */ { -1,       X,       X,       0,       1 },
+/* SECOND  */ { -2,      -1,       0,       X,       1 },
+/* THIRD   */ { -2,      -1,       0,       X,       1 },
+/* FOURTH  */ { -1,       X,       X,       0,       1 },
+/* FIFTH   */ { -1,       X,       X,       0,       1 },
+/* SIXTH   */ { -2,      -1,       0,       X,       1 },
+/* SEVENTH */ { -2,      -1,       0,       X,       1 },
+};
+
+/* As tic_get_alteration() in tonal.c, di and ia must be in range. */
+constexpr int tic_alteration(int di, int ia)
+{
+        if (ia < IA_DIMINISHED) {
+                return TIC_TO_TC_TABLE[di][0] - (IA_DIMINISHED - ia);
+        }
+        if (IA_AUGMENTED < ia) {
+                return 1 + (ia - IA_AUGMENTED);
+        }
+        return TIC_TO_TC_TABLE[di][ia - IA_DIMINISHED];
+}
+
+constexpr bool valid_alteration(int a)
+{
+        return -TONAL_ALTERATION_MAX <= a && a <= TONAL_ALTERATION_MAX;
+}
+
+constexpr bool valid_tpc(int dp, int pa)
+{
+        return DP_C <= dp && dp <= DP_B && 0 <= pa && pa < PA_NONE;
+}
+
+constexpr bool valid_tic(int di, int ia)
+{
+        return
+                DI_PRIME <= di && di <= DI_SEVENTH &&
+                0 <= ia && ia < IA_NONE &&
+                X != tic_alteration(di, ia);
+}
+
+constexpr bool valid_ti(int di, int ia, int octave, int direction)
+{
+        return
+                valid_tic(di, ia) &&
+                0 <= octave &&
+                (ID_UP == direction || ID_DOWN == direction) &&
+                !(0 == octave && DI_PRIME == di && ia <= IA_DIMINISHED);
+}
+
+constexpr int diatonic_value(const element &te)
+{
+        return 7 * te.octave + te.diatonic_point;
+}
+
+constexpr int chromatic_value(const element &te)
+{
+        return
+                12 * te.octave +
+                DT_TO_MPC_TABLE[te.diatonic_point] + te.alteration;
+}
+
+/* Proposition 1, as te_from_dv_cv() in tonal.c. */
+constexpr std::optional<element> from_dv_cv(int dv, int cv)
+{
+        int o = dv <= 0 ? (dv - 6) / 7 : dv / 7;
+
+        dv = dv - o * 7;
+        cv = cv - o * 12;
+        if (cv < -TONAL_ALTERATION_MAX || 11 + TONAL_ALTERATION_MAX < cv) {
+                return std::nullopt;
+        }
+
+        int a = cv - DT_TO_MPC_TABLE[dv];
+        if (!valid_alteration(a)) {
+                return std::nullopt;
+        }
+
+        return element{ dv, a, o };
+}
+
+constexpr std::optional<element> inv(const element &te)
+{
+        return from_dv_cv(-diatonic_value(te), -chromatic_value(te));
+}
+
+constexpr std::optional<element> add(const element &te0, const element &te1)
+{
+        return from_dv_cv(
+                diatonic_value(te0) + diatonic_value(te1),
+                chromatic_value(te0) + chromatic_value(te1)
+        );
+}
+
+/* te0 - te1, as te_sub() */
+constexpr std::optional<element> sub(const element &te0, const element &te1)
+{
+        return from_dv_cv(
+                diatonic_value(te0) - diatonic_value(te1),
+                chromatic_value(te0) - chromatic_value(te1)
+        );
+}
+
+/* As tc_to_tic() in tonal.c. Returns IA_NONE if there is no such quality. */
+constexpr int tc_to_ia(int dt, int a)
+{
+        for (int ia = 0; ia < IA_NONE; ia++) {
+                if (tic_alteration(dt, ia) == a) {
+                        return ia;
+                }
+        }
+        return IA_NONE;
+}
+
+} /* namespace detail */
+
+struct Interval;
+struct IntervalClass;
+
+/* TPC: Tonal Pitch Class */
+struct PitchClass : tonal_pitch_class {
+        constexpr PitchClass() : tonal_pitch_class{ DP_C, PA_ } {}
+        constexpr PitchClass(int diatonic_pitch, int pitch_alteration) :
+                tonal_pitch_class{ diatonic_pitch, pitch_alteration } {}
+        constexpr PitchClass(const tonal_pitch_class &tpc) :
+                tonal_pitch_class(tpc) {}
+
+        /* As tpc_set(): returns empty if the fields are out of range. */
+        static constexpr std::optional<PitchClass> make(
+                int diatonic_pitch,
+                int pitch_alteration
+        )
+        {
+                if (!detail::valid_tpc(diatonic_pitch, pitch_alteration)) {
+                        return std::nullopt;
+                }
+                return PitchClass(diatonic_pitch, pitch_alteration);
+        }
+
+        constexpr bool valid() const
+        {
+                return detail::valid_tpc(diatonic_pitch, pitch_alteration);
+        }
+
+        constexpr detail::element te() const
+        {
+                return { diatonic_pitch - DP_C, pitch_alteration - PA_, 0 };
+        }
+
+        static constexpr std::optional<PitchClass> from_te(
+                const std::optional<detail::element> &te
+        )
+        {
+                if (!te) { return std::nullopt; }
+                return PitchClass(
+                        te->diatonic_point + DP_C,
+                        te->alteration + PA_
+                );
+        }
+};
+
+/* TP: Tonal Pitch */
+struct Pitch : tonal_pitch {
+        constexpr Pitch() : tonal_pitch{ DP_C, PA_, 0 } {}
+        constexpr Pitch(int diatonic_pitch, int pitch_alteration, int octave) :
+                tonal_pitch{ diatonic_pitch, pitch_alteration, octave } {}
+        constexpr Pitch(const tonal_pitch &tp) : tonal_pitch(tp) {}
+
+        /* As tp_set(): returns empty if the fields are out of range. */
+        static constexpr std::optional<Pitch> make(
+                int diatonic_pitch,
+                int pitch_alteration,
+                int octave
+        )
+        {
+                Pitch tp(diatonic_pitch, pitch_alteration, octave);
+                if (!tp.valid()) { return std::nullopt; }
+                return tp;
+        }
+
+        constexpr bool valid() const
+        {
+                return detail::valid_tpc(diatonic_pitch, pitch_alteration);
+        }
+
+        constexpr PitchClass pitch_class() const
+        {
+                return PitchClass(diatonic_pitch, pitch_alteration);
+        }
+
+        /* As tp_to_mnn_oc(), but returns empty for invalid pitch. */
+        constexpr std::optional<int> mnn(int oc = OC_C5) const
+        {
+                if (!valid()) { return std::nullopt; }
+                switch (oc) {
+                        case OC_C5: return detail::chromatic_value(te());
+                        case OC_C4: return detail::chromatic_value(te()) + 12;
+                }
+                return std::nullopt;
+        }
+
+        constexpr detail::element te() const
+        {
+                return { diatonic_pitch - DP_C, pitch_alteration - PA_, octave };
+        }
+
+        static constexpr std::optional<Pitch> from_te(
+                const std::optional<detail::element> &te
+        )
+        {
+                if (!te) { return std::nullopt; }
+                return make(
+                        te->diatonic_point + DP_C,
+                        te->alteration + PA_,
+                        te->octave
+                );
+        }
+};
+
+/* TIC: Tonal Interval Class */
+struct IntervalClass : tonal_interval_class {
+        constexpr IntervalClass() :
+                tonal_interval_class{ DI_PRIME, IA_PERFECT } {}
+        constexpr IntervalClass(int diatonic_interval, int interval_alteration) :
+                tonal_interval_class{ diatonic_interval, interval_alteration } {}
+        constexpr IntervalClass(const tonal_interval_class &tic) :
+                tonal_interval_class(tic) {}
+
+        /* As tic_set(): returns empty for invalid combinations. */
+        static constexpr std::optional<IntervalClass> make(
+                int diatonic_interval,
+                int interval_alteration
+        )
+        {
+                if (!detail::valid_tic(diatonic_interval, interval_alteration)) {
+                        return std::nullopt;
+                }
+                return IntervalClass(diatonic_interval, interval_alteration);
+        }
+
+        constexpr bool valid() const
+        {
+                return detail::valid_tic(diatonic_interval, interval_alteration);
+        }
+
+        constexpr detail::element te() const
+        {
+                return {
+                        diatonic_interval - DI_PRIME,
+                        detail::tic_alteration(diatonic_interval, interval_alteration),
+                        0
+                };
+        }
+
+        static constexpr std::optional<IntervalClass> from_te(
+                const std::optional<detail::element> &te
+        )
+        {
+                if (!te) { return std::nullopt; }
+                return make(
+                        te->diatonic_point + DI_PRIME,
+                        detail::tc_to_ia(te->diatonic_point, te->alteration)
+                );
+        }
+};
+
+/* TI: Tonal Interval */
+struct Interval : tonal_interval {
+        constexpr Interval() :
+                tonal_interval{ DI_PRIME, IA_PERFECT, 0, ID_UP } {}
+        constexpr Interval(
+                int diatonic_interval,
+                int interval_alteration,
+                int octave = 0,
+                int interval_direction = ID_UP
+        ) :
+                tonal_interval{
+                        diatonic_interval,
+                        interval_alteration,
+                        octave,
+                        interval_direction
+                } {}
+        constexpr Interval(const tonal_interval &ti) : tonal_interval(ti) {}
+
+        /* As ti_set(): returns empty for invalid combinations. */
+        static constexpr std::optional<Interval> make(
+                int diatonic_interval,
+                int interval_alteration,
+                int octave,
+                int interval_direction
+        )
+        {
+                Interval ti(
+                        diatonic_interval,
+                        interval_alteration,
+                        octave,
+                        interval_direction
+                );
+                if (!ti.valid()) { return std::nullopt; }
+                return ti;
+        }
+
+        constexpr bool valid() const
+        {
+                return detail::valid_ti(
+                        diatonic_interval,
+                        interval_alteration,
+                        octave,
+                        interval_direction
+                );
+        }
+
+        constexpr IntervalClass interval_class() const
+        {
+                return IntervalClass(diatonic_interval, interval_alteration);
+        }
+
+        /* Same interval in the opposite direction. */
+        constexpr Interval reversed() const
+        {
+                return Interval(
+                        diatonic_interval,
+                        interval_alteration,
+                        octave,
+                        ID_UP == interval_direction ? ID_DOWN : ID_UP
+                );
+        }
+
+        /* As ti_to_te(). Requires a valid interval. */
+        constexpr detail::element te() const
+        {
+                detail::element te = {
+                        diatonic_interval - DI_PRIME,
+                        detail::tic_alteration(diatonic_interval, interval_alteration),
+                        octave
+                };
+                if (ID_DOWN == interval_direction) {
+                        te = *detail::inv(te);
+                }
+                return te;
+        }
+
+        /* As te_to_ti(). */
+        static constexpr std::optional<Interval> from_te(
+                const std::optional<detail::element> &te
+        )
+        {
+                if (!te) { return std::nullopt; }
+
+                detail::element up = *te;
+                int direction = ID_UP;
+                if (
+                        te->octave < 0 ||
+                        (0 == te->octave && 0 == te->diatonic_point && te->alteration < 0)
+                ) {
+                        std::optional<detail::element> i = detail::inv(*te);
+                        if (!i) { return std::nullopt; }
+                        up = *i;
+                        direction = ID_DOWN;
+                }
+                return make(
+                        up.diatonic_point + DI_PRIME,
+                        detail::tc_to_ia(up.diatonic_point, up.alteration),
+                        up.octave,
+                        direction
+                );
+        }
+};
+
+constexpr bool operator==(const PitchClass &a, const PitchClass &b)
+{
+        return
+                a.diatonic_pitch == b.diatonic_pitch &&
+                a.pitch_alteration == b.pitch_alteration;
+}
+
+constexpr bool operator==(const Pitch &a, const Pitch &b)
+{
+        return
+                a.diatonic_pitch == b.diatonic_pitch &&
+                a.pitch_alteration == b.pitch_alteration &&
+                a.octave == b.octave;
+}
+
+constexpr bool operator==(const IntervalClass &a, const IntervalClass &b)
+{
+        return
+                a.diatonic_interval == b.diatonic_interval &&
+                a.interval_alteration == b.interval_alteration;
+}
+
+constexpr bool operator==(const Interval &a, const Interval &b)
+{
+        return
+                a.diatonic_interval == b.diatonic_interval &&
+                a.interval_alteration == b.interval_alteration &&
+                a.octave == b.octave &&
+                a.interval_direction == b.interval_direction;
+}
+
+constexpr bool operator!=(const PitchClass &a, const PitchClass &b)
+{
+        return !(a == b);
+}
+
+constexpr bool operator!=(const Pitch &a, const Pitch &b)
+{
+        return !(a == b);
+}
+
+constexpr bool operator!=(const IntervalClass &a, const IntervalClass &b)
+{
+        return !(a == b);
+}
+
+constexpr bool operator!=(const Interval &a, const Interval &b)
+{
+        return !(a == b);
+}
+
+/*
+ * Arithmetic. Invalid operands give an empty result, as do results which can
+ * not be represented.
+ */
+
+/* tp_add: tp + ti */
+constexpr std::optional<Pitch> operator+(const Pitch &tp, const Interval &ti)
+{
+        if (!tp.valid() || !ti.valid()) { return std::nullopt; }
+        return Pitch::from_te(detail::add(tp.te(), ti.te()));
+}
+
+/* tp_add: tp - ti == tp + (reversed ti) */
+constexpr std::optional<Pitch> operator-(const Pitch &tp, const Interval &ti)
+{
+        return tp + ti.reversed();
+}
+
+/* tp_sub: tp0 - tp1 */
+constexpr std::optional<Interval> operator-(const Pitch &tp0, const Pitch &tp1)
+{
+        if (!tp0.valid() || !tp1.valid()) { return std::nullopt; }
+        return Interval::from_te(detail::sub(tp0.te(), tp1.te()));
+}
+
+/* ti_add: ti0 + ti1 */
+constexpr std::optional<Interval> operator+(
+        const Interval &ti0,
+        const Interval &ti1
+)
+{
+        if (!ti0.valid() || !ti1.valid()) { return std::nullopt; }
+        return Interval::from_te(detail::add(ti0.te(), ti1.te()));
+}
+
+/* ti_sub: ti0 - ti1 */
+constexpr std::optional<Interval> operator-(
+        const Interval &ti0,
+        const Interval &ti1
+)
+{
+        if (!ti0.valid() || !ti1.valid()) { return std::nullopt; }
+        return Interval::from_te(detail::sub(ti0.te(), ti1.te()));
+}
+
+/* Pitch class arithmetic is Tonal Element arithmetic with the octave dropped. */
+constexpr std::optional<PitchClass> operator+(
+        const PitchClass &tpc,
+        const IntervalClass &tic
+)
+{
+        if (!tpc.valid() || !tic.valid()) { return std::nullopt; }
+        return PitchClass::from_te(detail::add(tpc.te(), tic.te()));
+}
+
+/* Ascending interval class from tpc1 to tpc0. */
+constexpr std::optional<IntervalClass> operator-(
+        const PitchClass &tpc0,
+        const PitchClass &tpc1
+)
+{
+        if (!tpc0.valid() || !tpc1.valid()) { return std::nullopt; }
+        std::optional<detail::element> te = detail::sub(tpc0.te(), tpc1.te());
+        if (!te) { return std::nullopt; }
+        te->octave = 0;
+        return IntervalClass::from_te(te);
+}
+
+/*
+ * Chaining: an empty left operand propagates, so that expressions like
+ * (tp + M3) + m3 can be written without intermediate checks.
+ */
+template <typename T, typename U>
+constexpr auto operator+(const std::optional<T> &a, const U &b)
+        -> decltype(*a + b)
+{
+        if (!a) { return std::nullopt; }
+        return *a + b;
+}
+
+template <typename T, typename U>
+constexpr auto operator-(const std::optional<T> &a, const U &b)
+        -> decltype(*a - b)
+{
+        if (!a) { return std::nullopt; }
+        return *a - b;
+}
+
+/* Common intervals, usable as template arguments to tp_add<> below. */
+namespace intervals {
+
+inline constexpr Interval P1(DI_PRIME, IA_PERFECT);
+inline constexpr Interval A1(DI_PRIME, IA_AUGMENTED);
+inline constexpr Interval m2(DI_SECOND, IA_MINOR);
+inline constexpr Interval M2(DI_SECOND, IA_MAJOR);
+inline constexpr Interval m3(DI_THIRD, IA_MINOR);
+inline constexpr Interval M3(DI_THIRD, IA_MAJOR);
+inline constexpr Interval P4(DI_FOURTH, IA_PERFECT);
+inline constexpr Interval A4(DI_FOURTH, IA_AUGMENTED);
+inline constexpr Interval d5(DI_FIFTH, IA_DIMINISHED);
+inline constexpr Interval P5(DI_FIFTH, IA_PERFECT);
+inline constexpr Interval m6(DI_SIXTH, IA_MINOR);
+inline constexpr Interval M6(DI_SIXTH, IA_MAJOR);
+inline constexpr Interval m7(DI_SEVENTH, IA_MINOR);
+inline constexpr Interval M7(DI_SEVENTH, IA_MAJOR);
+inline constexpr Interval P8(DI_PRIME, IA_PERFECT, 1);
+
+} /* namespace intervals */
+
+namespace detail {
+
+/*
+ * Transposition by a constant interval.
+ *
+ * The interval is a constant (dv, cv) offset. Split dv into whole octaves
+ * and a diatonic step 0..6; adding the step to a diatonic point carries at
+ * most one octave. The Music Pitch Class of a diatonic point is
+ * 2 * dt - (dt > 2), so the whole normalization is compares and adds, with
+ * no table lookups and no branches.
+ */
+template <const Interval &TI>
+struct transposition {
+        static_assert(TI.valid(), "invalid interval");
+        static constexpr int dv = diatonic_value(TI.te());
+        static constexpr int cv = chromatic_value(TI.te());
+        static constexpr int octaves = dv < 0 ? (dv - 6) / 7 : dv / 7;
+        static constexpr int step = dv - 7 * octaves;
+
+        static constexpr int mpc(int dt)
+        {
+                return 2 * dt - (dt > 2);
+        }
+
+        /* Returns non-zero on success. tp_sum is always written. */
+        static constexpr int apply(const tonal_pitch &tp, tonal_pitch &tp_sum)
+        {
+                int dt = tp.diatonic_pitch - DP_C;
+                int pa = tp.pitch_alteration;
+                int o = tp.octave;
+                int ok =
+                        (0 <= dt) & (dt < DP_NONE) &
+                        (0 <= pa) & (pa < PA_NONE);
+                int carry = dt >= 7 - step;
+                int dt_sum = dt + step - 7 * carry;
+
+                o += octaves + carry;
+                pa += mpc(dt) + cv - 12 * (octaves + carry) - mpc(dt_sum);
+                ok &= (0 <= pa) & (pa < PA_NONE);
+
+                tp_sum.diatonic_pitch = dt_sum + DP_C;
+                tp_sum.pitch_alteration = pa;
+                tp_sum.octave = o;
+                return ok;
+        }
+};
+
+} /* namespace detail */
+
+/*
+ * Add a compile time constant interval to a pitch.
+ *
+ *   tonal::tp_add<tonal::intervals::P5>(tp)
+ *
+ * Same result as tp + TI.
+ */
+template <const Interval &TI>
+constexpr std::optional<Pitch> tp_add(const Pitch &tp)
+{
+        Pitch sum;
+
+        if (!detail::transposition<TI>::apply(tp, sum)) { return std::nullopt; }
+        return sum;
+}
+
+/*
+ * As tp_transpose_n() with a compile time constant interval. The loop body
+ * has no branches, so the compiler is free to vectorize it.
+ *
+ * NOTE: tp_sum[i] is written also where status[i] is not TONAL_OK, its value
+ * is then unspecified.
+ */
+template <const Interval &TI>
+int tp_transpose_n(
+        const tonal_pitch *tp,
+        tonal_pitch *tp_sum,
+        int *status,
+        std::size_t n
+)
+{
+        int ok = 1;
+
+        if (status) {
+                for (std::size_t i = 0; i < n; i++) {
+                        int r = detail::transposition<TI>::apply(tp[i], tp_sum[i]);
+                        status[i] = r ? TONAL_OK : TONAL_FAIL;
+                        ok &= r;
+                }
+                /* Error details are computed out of the loop, on failure. */
+                for (std::size_t i = 0; !ok && i < n; i++) {
+                        if (TONAL_OK != status[i]) {
+                                tonal_pitch tmp;
+                                ::tp_add_err(&tp[i], &TI, &tmp, &status[i]);
+                        }
+                }
+        } else {
+                for (std::size_t i = 0; i < n; i++) {
+                        ok &= detail::transposition<TI>::apply(tp[i], tp_sum[i]);
+                }
+        }
+        return ok ? TONAL_OK : TONAL_FAIL;
+}
+
+} /* namespace tonal */
+
+#endif
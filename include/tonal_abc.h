@@ -0,0 +1,150 @@
+/*
+ * Copyright 2016 Martin Aberg
+ *
+ * This file is part of tonal.
+ *
+ * tonal is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * tonal is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * ABC notation
+ *
+ * Reads the notes of ABC tune books as spelled pitches. A tune starts with an
+ * X: line and ends at a blank line. Each note is spelled the way it sounds:
+ * an accidental written on the note wins, then an accidental written earlier
+ * in the same bar on the same letter and octave, then the key signature of
+ * the K: field (tonic, mode and explicit accidentals, as in "K:Dmix ^g").
+ * Bar lines clear the accidentals. Middle C, "C" in ABC, is octave 5 with
+ * octave convention OC_C5 and octave 4 with OC_C4.
+ *
+ * Chord symbols, annotations, decorations, lyrics and other fields are
+ * skipped. Voices (V:) are not told apart.
+ */
+
+#ifndef TONAL_ABC_H_
+#define TONAL_ABC_H_
+
+#include <stddef.h>
+
+#include <tonal.h>
+#include <tonal_arena.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct tonal_abc_note {
+        /* Only valid if error is TONAL_E_OK */
+        struct tonal_pitch pitch;
+        /*
+         * TONAL_E_OK, or TONAL_E_ALTERATION for microtonal or mixed
+         * accidentals and alterations outside the alteration range.
+         */
+        int error;
+        /* Tune in the book, from 0 */
+        int tune;
+        /* Bar within the tune, from 0 */
+        int bar;
+        /* Line number in the document, from 1 */
+        size_t line;
+        /* Position within a [] chord, 0 for the first note and outside chords */
+        int chord;
+        /* Grace note, written in {} */
+        int grace;
+};
+
+/*
+ * Called for each note. Return TONAL_OK to continue, any other value stops
+ * the scan and is returned by the scan function.
+ */
+typedef int (*tonal_abc_fn)(const struct tonal_abc_note *note, void *arg);
+
+/*
+ * Scan size bytes of ABC at doc with octave convention oc, calling fn for each
+ * note of each tune in order. Returns TONAL_OK, TONAL_FAIL on a K: field
+ * which can not be read, or the value returned by fn if it stopped the scan.
+ */
+extern int tonal_abc_scan(
+        const char *doc,
+        size_t size,
+        int oc,
+        tonal_abc_fn fn,
+        void *arg
+);
+
+struct tonal_abc_tune {
+        /* Reference number from the X: field */
+        int x;
+        /* First T: field, not NUL terminated, points into the document */
+        const char *title;
+        size_t title_len;
+        /* Tune text in the document */
+        size_t offset;
+        size_t size;
+        /* Notes of the tune */
+        struct tonal_pitch *pitch;
+        size_t n;
+        size_t max;
+        /*
+         * TONAL_E_OK, the error of the first invalid note, or TONAL_E_FAIL if
+         * the tune could not be read. Tunes which failed have no notes.
+         */
+        int status;
+};
+
+struct tonal_abc_book {
+        struct tonal_abc_tune *tune;
+        size_t ntunes;
+        /* Where the arrays live, NULL for the heap */
+        struct tonal_arena *arena;
+};
+
+/*
+ * Read all tunes of the ABC tune book at doc into book, with up to nthreads
+ * threads reading one tune at a time each. nthreads 0 means one per online
+ * processor. The book must be released with tonal_abc_book_free(), also on
+ * failure, and refers to doc for the titles. Returns TONAL_OK if all tunes
+ * were read.
+ */
+extern int tonal_abc_read_book(
+        const char *doc,
+        size_t size,
+        int oc,
+        int nthreads,
+        struct tonal_abc_book *book
+);
+
+/*
+ * Same as tonal_abc_read_book(), with the tune and pitch arrays allocated
+ * from arena (see tonal_arena.h). Each thread collects a tune in a buffer of
+ * its own, reused from tune to tune, and copies it to the arena when done.
+ * The arrays are released with the arena; tonal_abc_book_free() only clears
+ * book.
+ */
+extern int tonal_abc_read_book_arena(
+        const char *doc,
+        size_t size,
+        int oc,
+        int nthreads,
+        struct tonal_arena *arena,
+        struct tonal_abc_book *book
+);
+
+extern void tonal_abc_book_free(struct tonal_abc_book *book);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
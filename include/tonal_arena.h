@@ -0,0 +1,112 @@
+/*
+ * Copyright 2016 Martin Aberg
+ *
+ * This file is part of tonal.
+ *
+ * tonal is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * tonal is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Arena allocation
+ *
+ * An arena hands out memory from large blocks by bumping a pointer, and
+ * releases all of it at once. tonal_arena_reset() keeps the blocks for the
+ * next piece, so a worker which reads one piece after the other stops calling
+ * malloc() once its arena has grown to the largest piece.
+ *
+ * The readers which build arrays (tonal_kern_read_arena(),
+ * tonal_abc_read_book_arena()) take an arena from the caller. With a NULL
+ * arena, they and the functions here use the heap instead.
+ *
+ * An arena is not thread-safe: use one per thread.
+ */
+
+#ifndef TONAL_ARENA_H_
+#define TONAL_ARENA_H_
+
+#include <stddef.h>
+
+#include <tonal.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct tonal_arena_block;
+
+struct tonal_arena {
+        /* Blocks in use, the current one first */
+        struct tonal_arena_block *block;
+        /* Blocks kept by tonal_arena_reset() */
+        struct tonal_arena_block *spare;
+        size_t block_size;
+        /* Most recent allocation, which may grow in place */
+        void *last;
+        /* Bytes held in blocks, in use or spare */
+        size_t total;
+};
+
+/* Start an arena with blocks of block_size bytes, 0 for 64 KiB. */
+extern int tonal_arena_init(struct tonal_arena *a, size_t block_size);
+
+/* Release all blocks. */
+extern void tonal_arena_free(struct tonal_arena *a);
+
+/* Release all allocations, keeping the blocks for reuse. */
+extern void tonal_arena_reset(struct tonal_arena *a);
+
+/*
+ * Allocate size bytes, aligned for any type. With a NULL arena, same as
+ * malloc(). Returns NULL when out of memory.
+ */
+extern void *tonal_arena_alloc(struct tonal_arena *a, size_t size);
+
+/*
+ * Resize the allocation at p from old to size bytes, in place if it is the
+ * most recent one, else by copying it. With a NULL arena, same as realloc().
+ */
+extern void *tonal_arena_realloc(
+        struct tonal_arena *a,
+        void *p,
+        size_t old,
+        size_t size
+);
+
+/* Sequence builder: a growable pitch array */
+struct tonal_seq {
+        struct tonal_pitch *pitch;
+        size_t n;
+        size_t max;
+        /* Where the array lives, NULL for the heap */
+        struct tonal_arena *arena;
+};
+
+/* Start an empty sequence in arena, or on the heap if arena is NULL. */
+extern int tonal_seq_init(struct tonal_seq *s, struct tonal_arena *arena);
+
+/* Free a sequence on the heap. Arena sequences go with their arena. */
+extern void tonal_seq_free(struct tonal_seq *s);
+
+/* Append tp[0..n). */
+extern int tonal_seq_append(
+        struct tonal_seq *s,
+        const struct tonal_pitch *tp,
+        size_t n
+);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
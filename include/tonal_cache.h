@@ -0,0 +1,114 @@
+/*
+ * Copyright 2016 Martin Aberg
+ *
+ * This file is part of tonal.
+ *
+ * tonal is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * tonal is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Analysis cache
+ *
+ * Stores the results of analyses of pitch sequences in a file, keyed by the
+ * sequence and a kind chosen by the caller for each analysis. The values are
+ * opaque bytes. The file is append-only: records are never changed once
+ * written, so any number of processes may read it while others append, and
+ * a record is only seen once it is complete. Appends are serialized with
+ * flock().
+ *
+ * Each handle maps the file read-only and keeps an index in memory from the
+ * hash of the packed sequence (tonal_cache_hash()) to the records. A lookup
+ * which misses the index checks once whether the file has grown.
+ */
+
+#ifndef TONAL_CACHE_H_
+#define TONAL_CACHE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <tonal.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct tonal_cache_slot;
+
+struct tonal_cache {
+        int fd;
+        /* File opened read-only, tonal_cache_put() fails */
+        int readonly;
+        /* Mapping of the file, reserved past its end to grow into */
+        const char *map;
+        size_t map_size;
+        size_t file_size;
+        /* Bytes of complete records indexed, from the start of the file */
+        size_t size;
+        /* Index, open addressing */
+        struct tonal_cache_slot *slot;
+        size_t nslots;
+        size_t n;
+};
+
+/*
+ * 64-bit hash of the packed pitch sequence tp[0..n). Fails if a pitch is
+ * invalid or its octave is outside -524288 to 524287.
+ */
+extern int tonal_cache_hash(
+        const struct tonal_pitch *tp,
+        size_t n,
+        uint64_t *hash
+);
+
+/*
+ * Open or create the cache file at path. It is opened read-only if it can
+ * not be written. Release with tonal_cache_close().
+ */
+extern int tonal_cache_open(struct tonal_cache *c, const char *path);
+
+extern void tonal_cache_close(struct tonal_cache *c);
+
+/*
+ * Look up the value stored for kind and tp[0..n). On a hit, *value and *size
+ * are set and TONAL_OK is returned. The value points into the mapping and is
+ * valid until the next call with c. Returns TONAL_FAIL on a miss.
+ */
+extern int tonal_cache_get(
+        struct tonal_cache *c,
+        uint32_t kind,
+        const struct tonal_pitch *tp,
+        size_t n,
+        const void **value,
+        size_t *size
+);
+
+/*
+ * Append value for kind and tp[0..n). If the key is already stored, by this
+ * or another process, the earlier value is kept and TONAL_OK returned.
+ */
+extern int tonal_cache_put(
+        struct tonal_cache *c,
+        uint32_t kind,
+        const struct tonal_pitch *tp,
+        size_t n,
+        const void *value,
+        size_t size
+);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,148 @@
+/*
+ * Copyright 2016 Martin Aberg
+ *
+ * This file is part of tonal.
+ *
+ * tonal is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * tonal is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Consonance and dissonance scoring
+ *
+ * The dissonance of a verticality is the sum of the dissonance of each pair
+ * of its sounding pitches. Higher scores are more dissonant. Two models score
+ * a pair:
+ *
+ * - TONAL_CONSONANCE_TABLE looks up the interval class between the two
+ *   pitches, spelled and folded within the octave, in a table set by the
+ *   caller. A diminished fourth may thus score differently from a major
+ *   third. The initial table follows common practice, 0 for the prime and 1
+ *   for the minor second.
+ *
+ * - TONAL_CONSONANCE_ROUGHNESS sums the sensory roughness of the harmonic
+ *   partials of the two tones, after Plomp and Levelt in the parametrization
+ *   of Sethares. It depends on register and not on spelling.
+ *
+ * Link with -lm.
+ */
+
+#ifndef TONAL_CONSONANCE_H_
+#define TONAL_CONSONANCE_H_
+
+#include <stddef.h>
+
+#include <tonal.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Model */
+enum {
+        TONAL_CONSONANCE_TABLE,
+        TONAL_CONSONANCE_ROUGHNESS,
+        TONAL_CONSONANCE_NONE
+};
+
+/* Most voices of a verticality */
+#define TONAL_CONSONANCE_VOICES_MAX 32
+
+/*
+ * Alterations of an interval between two pitches, counted from major or
+ * perfect, range over +-(2 * TONAL_ALTERATION_MAX + 1).
+ */
+#define TONAL_CONSONANCE_ALTERATIONS (4 * TONAL_ALTERATION_MAX + 3)
+
+struct tonal_consonance {
+        int model;
+        /* Roughness: harmonic partials per tone, 1 to 16 */
+        int partials;
+        /* Roughness: octave convention of the pitches, for tp_to_hz() */
+        int oc;
+        /*
+         * Table: score by diatonic interval and alteration, NaN where there
+         * is no interval class. Use tonal_consonance_set() and
+         * tonal_consonance_load() rather than writing it.
+         */
+        double table[DI_NONE][TONAL_CONSONANCE_ALTERATIONS];
+};
+
+/* Initialize c for model, with the common practice table and 6 partials. */
+extern int tonal_consonance_init(struct tonal_consonance *c, int model);
+
+/* Score of the interval class tic */
+extern int tonal_consonance_set(
+        struct tonal_consonance *c,
+        const struct tonal_interval_class *tic,
+        double score
+);
+extern int tonal_consonance_get(
+        const struct tonal_consonance *c,
+        const struct tonal_interval_class *tic,
+        double *score
+);
+
+/*
+ * Set the score of every interval class from score, indexed by tic_to_id()
+ * (tonal_interval.h) and TONAL_TIC_ID_COUNT long. Ids of no interval class
+ * are ignored.
+ */
+extern int tonal_consonance_load(
+        struct tonal_consonance *c,
+        const double *score
+);
+
+/* Dissonance of the pitches tp0 and tp1 sounding together */
+extern int tonal_consonance_pair(
+        const struct tonal_consonance *c,
+        const struct tonal_pitch *tp0,
+        const struct tonal_pitch *tp1,
+        double *score
+);
+
+/*
+ * Score n verticalities of voices voices. Voice v of verticality i is
+ * pitch[v][i]; voices which do not sound have pitch_alteration PA_NONE.
+ *
+ * score[i] := sum of the dissonance of each pair of sounding pitches of
+ * verticality i, 0 if fewer than two sound.
+ *
+ * status as for the batch operations in tonal.h. A pair without an interval
+ * class in the table model gives TONAL_E_RANGE. score[i] is undefined where
+ * verticality i failed.
+ *
+ * In the table model, the pairs are evaluated for 64 verticalities at a time
+ * in vectorized loops. The roughness model is scalar, since it calls exp()
+ * for each pair of partials.
+ */
+extern int tonal_consonance_n(
+        const struct tonal_consonance *c,
+        const struct tonal_pitch *const *pitch,
+        size_t voices,
+        double *score,
+        int *status,
+        size_t n
+);
+
+/*
+ * Frequency in Hz of tp in equal temperament, with MIDI note 69 at 440 Hz
+ * in octave convention oc.
+ */
+extern int tp_to_hz(const struct tonal_pitch *tp, int oc, double *hz);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
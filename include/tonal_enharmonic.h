@@ -0,0 +1,172 @@
+/*
+ * Copyright 2016 Martin Aberg
+ *
+ * This file is part of tonal.
+ *
+ * tonal is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * tonal is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Enharmonics
+ *
+ * Two pitches are enharmonically equal when they sound the same, for example
+ * C#4 and Db4 or B#4 and C5, and two intervals when they span the same
+ * number of semitones in the same direction, for example the augmented
+ * fourth and the diminished fifth. Pitch classes and interval classes are
+ * compared modulo the octave.
+ *
+ * Spellings come from a table of the alteration which each diatonic step
+ * needs for each of the twelve semitones, so no function here searches.
+ */
+
+#ifndef TONAL_ENHARMONIC_H_
+#define TONAL_ENHARMONIC_H_
+
+#include <stddef.h>
+
+#include <tonal.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Most spellings of one pitch, pitch class, interval or interval class: one
+ * per diatonic step, and two with an alteration range of 6 or more.
+ */
+#define TONAL_SPELLINGS_MAX 14
+
+/* Set *equal to 1 if the arguments are enharmonically equal, else to 0. */
+extern int tpc_enh_equal(
+        const struct tonal_pitch_class *tpc0,
+        const struct tonal_pitch_class *tpc1,
+        int *equal
+);
+extern int tp_enh_equal(
+        const struct tonal_pitch *tp0,
+        const struct tonal_pitch *tp1,
+        int *equal
+);
+extern int tic_enh_equal(
+        const struct tonal_interval_class *tic0,
+        const struct tonal_interval_class *tic1,
+        int *equal
+);
+extern int ti_enh_equal(
+        const struct tonal_interval *ti0,
+        const struct tonal_interval *ti1,
+        int *equal
+);
+
+/*
+ * Store all valid spellings of the argument, itself included, in
+ * spelling[0..*n). spelling must have room for TONAL_SPELLINGS_MAX
+ * elements. The spellings with the fewest accidentals come first, then
+ * those with more, each by diatonic step. For intervals, accidentals count
+ * the steps from major or perfect.
+ */
+extern int tpc_enh_spellings(
+        const struct tonal_pitch_class *tpc,
+        struct tonal_pitch_class *spelling,
+        size_t *n
+);
+extern int tp_enh_spellings(
+        const struct tonal_pitch *tp,
+        struct tonal_pitch *spelling,
+        size_t *n
+);
+extern int tic_enh_spellings(
+        const struct tonal_interval_class *tic,
+        struct tonal_interval_class *spelling,
+        size_t *n
+);
+extern int ti_enh_spellings(
+        const struct tonal_interval *ti,
+        struct tonal_interval *spelling,
+        size_t *n
+);
+
+/*
+ * Respell the argument with diatonic pitch (DP_) or diatonic interval (DI_)
+ * target, for example Db4 with DP_C to C#4, or an augmented fourth with
+ * DI_FIFTH to a diminished fifth. Intervals keep their direction when
+ * possible. Returns TONAL_FAIL if the alteration range has no such spelling.
+ */
+extern int tpc_enh_respell(
+        const struct tonal_pitch_class *tpc,
+        int diatonic_pitch,
+        struct tonal_pitch_class *result
+);
+extern int tp_enh_respell(
+        const struct tonal_pitch *tp,
+        int diatonic_pitch,
+        struct tonal_pitch *result
+);
+extern int tic_enh_respell(
+        const struct tonal_interval_class *tic,
+        int diatonic_interval,
+        struct tonal_interval_class *result
+);
+extern int ti_enh_respell(
+        const struct tonal_interval *ti,
+        int diatonic_interval,
+        struct tonal_interval *result
+);
+
+/*
+ * Batch variants, with status as for the batch operations in tonal.h. A
+ * target without a spelling gives TONAL_E_RANGE.
+ */
+
+/* equal[i] := tp0[i] and tp1[i] are enharmonically equal */
+extern int tp_enh_equal_n(
+        const struct tonal_pitch *tp0,
+        const struct tonal_pitch *tp1,
+        int *equal,
+        int *status,
+        size_t n
+);
+
+/* equal[i] := ti0[i] and ti1[i] are enharmonically equal */
+extern int ti_enh_equal_n(
+        const struct tonal_interval *ti0,
+        const struct tonal_interval *ti1,
+        int *equal,
+        int *status,
+        size_t n
+);
+
+/* result[i] := tp[i] respelled with diatonic_pitch[i] */
+extern int tp_enh_respell_n(
+        const struct tonal_pitch *tp,
+        const int *diatonic_pitch,
+        struct tonal_pitch *result,
+        int *status,
+        size_t n
+);
+
+/* result[i] := ti[i] respelled with diatonic_interval[i] */
+extern int ti_enh_respell_n(
+        const struct tonal_interval *ti,
+        const int *diatonic_interval,
+        struct tonal_interval *result,
+        int *status,
+        size_t n
+);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,122 @@
+/*
+ * Copyright 2016 Martin Aberg
+ *
+ * This file is part of tonal.
+ *
+ * tonal is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * tonal is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Corpus ingestion
+ *
+ * Reads many files with many reads in flight and hands each one, as it
+ * completes, to a callback in the calling thread. Built with
+ * -DTONAL_IO_URING on Linux, the open, size, read and close of each file are
+ * io_uring operations, so a file costs no system calls of its own. Without
+ * it, or if the kernel does not offer the operations, a pool of threads
+ * opens and reads the files with pread().
+ *
+ * tonal_ingest_scores() also parses each file by its extension: .krn
+ * (**kern), .abc, .musicxml and .xml.
+ */
+
+#ifndef TONAL_INGEST_H_
+#define TONAL_INGEST_H_
+
+#include <stddef.h>
+
+#include <tonal.h>
+#include <tonal_arena.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum {
+        /* io_uring if available, else threads */
+        TONAL_INGEST_AUTO,
+        TONAL_INGEST_THREADS,
+        TONAL_INGEST_NONE
+};
+
+struct tonal_ingest_file {
+        /* Position in the list of paths */
+        size_t index;
+        const char *path;
+        /* TONAL_OK, or TONAL_FAIL if the file could not be read */
+        int status;
+        /* Contents, NUL terminated, valid during the callback */
+        const char *doc;
+        size_t size;
+};
+
+/*
+ * Called for each file in the order the reads complete. Return TONAL_OK to
+ * continue, any other value stops the ingestion and is returned by it.
+ */
+typedef int (*tonal_ingest_fn)(const struct tonal_ingest_file *file, void *arg);
+
+/*
+ * Read the n files at path[] with up to depth (1 to 4096) files in flight,
+ * calling fn for each. mode is a TONAL_INGEST_ value. Returns TONAL_OK, or the
+ * value returned by fn if it stopped the ingestion. Files which can not be
+ * read are reported to fn with status TONAL_FAIL.
+ */
+extern int tonal_ingest(
+        const char *const *path,
+        size_t n,
+        int depth,
+        int mode,
+        tonal_ingest_fn fn,
+        void *arg
+);
+
+struct tonal_ingest_score {
+        size_t index;
+        const char *path;
+        /*
+         * TONAL_OK, or TONAL_FAIL if the file could not be read, has an
+         * unknown extension, or holds an invalid pitch. pitch holds the
+         * pitches up to the failure.
+         */
+        int status;
+        /* Pitches in document order, valid during the callback */
+        struct tonal_seq pitch;
+};
+
+typedef int (*tonal_ingest_score_fn)(
+        const struct tonal_ingest_score *score,
+        void *arg
+);
+
+/*
+ * Same as tonal_ingest(), parsing each file to its pitches with octave
+ * convention oc. The pitches of each file are built in one arena, reset for
+ * the next file.
+ */
+extern int tonal_ingest_scores(
+        const char *const *path,
+        size_t n,
+        int depth,
+        int mode,
+        int oc,
+        tonal_ingest_score_fn fn,
+        void *arg
+);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
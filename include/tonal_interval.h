@@ -0,0 +1,200 @@
+/*
+ * Copyright 2016 Martin Aberg
+ *
+ * This file is part of tonal.
+ *
+ * tonal is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * tonal is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Interval class operations
+ *
+ * Inversion, folding of compound intervals and ordered and unordered
+ * interval classes, computed from the interval fields without going through
+ * interval arithmetic. Spelling is kept throughout: a major third inverts to
+ * a minor sixth and an augmented fourth to a diminished fifth.
+ */
+
+#ifndef TONAL_INTERVAL_H_
+#define TONAL_INTERVAL_H_
+
+#include <stddef.h>
+
+#include <tonal.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Dense interval class ids
+ *
+ * An interval class has the id diatonic_interval * IA_NONE +
+ * interval_alteration, from 0 to TONAL_TIC_ID_COUNT - 1, for indexing
+ * tables by spelled interval class. Some ids, such as that of a major fifth,
+ * belong to no interval class.
+ */
+#define TONAL_TIC_ID_COUNT (DI_NONE * IA_NONE)
+
+extern int tic_to_id(const struct tonal_interval_class *tic, int *id);
+extern int id_to_tic(int id, struct tonal_interval_class *tic);
+
+/*
+ * Inversion
+ *
+ * tic1 := the interval class which completes tic0 to an octave: M3 to m6,
+ * A4 to d5, P1 to P1, A1 to d1.
+ *
+ * ti1 := the interval which completes the simple part of ti0 to an octave,
+ * in the direction of ti0: M3 and M10 to m6, P1 to P8, and P8 and P15 to
+ * P1. An augmented octave inverts to an augmented prime the other way.
+ */
+extern int tic_inv(
+        const struct tonal_interval_class *tic0,
+        struct tonal_interval_class *tic1
+);
+extern int ti_inv(
+        const struct tonal_interval *ti0,
+        struct tonal_interval *ti1
+);
+
+/*
+ * ti1 := ti0 folded within the octave, M10 to M3 and P8 to P1. Diminished
+ * octaves are left as they are.
+ */
+extern int ti_simple(
+        const struct tonal_interval *ti0,
+        struct tonal_interval *ti1
+);
+
+/*
+ * Ordered interval class: the interval class reached upwards, so that down
+ * M3 has the class m6. Adding it to a pitch class gives the pitch class ti
+ * leads to.
+ */
+extern int ti_ordered_class(
+        const struct tonal_interval *ti,
+        struct tonal_interval_class *tic
+);
+
+/*
+ * Unordered interval class: of an interval class and its inversion, the one
+ * from prime to fourth, and of the primes the unaltered or augmented one.
+ * M3 and m6 have the class M3, A4 and d5 the class A4.
+ */
+extern int tic_unordered_class(
+        const struct tonal_interval_class *tic0,
+        struct tonal_interval_class *tic1
+);
+extern int ti_unordered_class(
+        const struct tonal_interval *ti,
+        struct tonal_interval_class *tic
+);
+
+/*
+ * Interval size
+ *
+ * *semitones := signed number of semitones of ti, -4 for down M3 and 11 for
+ * up d8.
+ *
+ * *steps := signed number of diatonic steps of ti, -2 for down M3 and 7 for
+ * up d8.
+ */
+extern int ti_semitones(const struct tonal_interval *ti, int *semitones);
+extern int ti_steps(const struct tonal_interval *ti, int *steps);
+
+/*
+ * *order := -1, 0 or 1 as ti0 is smaller than, equal to or larger than ti1.
+ * Intervals are ordered by signed size in semitones, and intervals of the
+ * same size by steps, so that A4 comes before d5. Only the prime may be
+ * equal to an interval which differs from it, in direction.
+ */
+extern int ti_compare(
+        const struct tonal_interval *ti0,
+        const struct tonal_interval *ti1,
+        int *order
+);
+
+/* Batch variants, with status as for the batch operations in tonal.h */
+
+/* tic1[i] := inversion of tic0[i] */
+extern int tic_inv_n(
+        const struct tonal_interval_class *tic0,
+        struct tonal_interval_class *tic1,
+        int *status,
+        size_t n
+);
+
+/* ti1[i] := inversion of ti0[i] */
+extern int ti_inv_n(
+        const struct tonal_interval *ti0,
+        struct tonal_interval *ti1,
+        int *status,
+        size_t n
+);
+
+/* ti1[i] := ti0[i] folded within the octave */
+extern int ti_simple_n(
+        const struct tonal_interval *ti0,
+        struct tonal_interval *ti1,
+        int *status,
+        size_t n
+);
+
+/* tic[i] := ordered interval class of ti[i] */
+extern int ti_ordered_class_n(
+        const struct tonal_interval *ti,
+        struct tonal_interval_class *tic,
+        int *status,
+        size_t n
+);
+
+/* tic[i] := unordered interval class of ti[i] */
+extern int ti_unordered_class_n(
+        const struct tonal_interval *ti,
+        struct tonal_interval_class *tic,
+        int *status,
+        size_t n
+);
+
+/* semitones[i] := semitones of ti[i] */
+extern int ti_semitones_n(
+        const struct tonal_interval *ti,
+        int *semitones,
+        int *status,
+        size_t n
+);
+
+/* steps[i] := steps of ti[i] */
+extern int ti_steps_n(
+        const struct tonal_interval *ti,
+        int *steps,
+        int *status,
+        size_t n
+);
+
+/* order[i] := order of ti0[i] and ti1[i] */
+extern int ti_compare_n(
+        const struct tonal_interval *ti0,
+        const struct tonal_interval *ti1,
+        int *order,
+        int *status,
+        size_t n
+);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,171 @@
+/*
+ * Copyright 2016 Martin Aberg
+ *
+ * This file is part of tonal.
+ *
+ * tonal is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * tonal is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Humdrum **kern pitches
+ *
+ * A kern pitch is a letter repeated once per octave away from middle C and
+ * followed by accidentals: "c" is middle C, "cc" the octave above, "B" the
+ * B below middle C and "BB-" the B flat below that. "#" is sharp, "-" flat and
+ * "n" natural. Middle C is octave 5 with octave convention OC_C5 and octave 4
+ * with OC_C4.
+ *
+ * The reader walks a Humdrum file line by line and tab by tab, follows the
+ * spine manipulators (*^, *v, *x, *+, *-) and reports the pitches of the
+ * **kern spines. Other spines, durations and all other signifiers are skipped.
+ * Notes of a split spine (*^) belong to the track of the spine they were
+ * split from.
+ */
+
+#ifndef TONAL_KERN_H_
+#define TONAL_KERN_H_
+
+#include <stddef.h>
+#include <stdio.h>
+
+#include <tonal.h>
+#include <tonal_arena.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct tonal_kern_note {
+        /* Only valid if error is TONAL_E_OK */
+        struct tonal_pitch pitch;
+        /*
+         * TONAL_E_OK, TONAL_E_ALTERATION for accidentals outside the
+         * alteration range or mixed sharps and flats, TONAL_E_FAIL for a
+         * token with more than one pitch name.
+         */
+        int error;
+        /* **kern spine, numbered 0, 1, ... in order of their exclusive interpretation */
+        int track;
+        /* Field of the line, from 0 */
+        int column;
+        /* Line number, from 1 */
+        size_t line;
+        /* Position within a chord (space separated), 0 for the first note */
+        int chord;
+};
+
+/*
+ * Called for each pitch. Return TONAL_OK to continue, any other value stops
+ * the scan and is returned by the scan function.
+ */
+typedef int (*tonal_kern_fn)(const struct tonal_kern_note *note, void *arg);
+
+/*
+ * Scan size bytes of Humdrum at doc with octave convention oc, calling fn for
+ * each pitch of the **kern spines. Returns TONAL_OK, TONAL_FAIL if a line
+ * does not match the spines, or the value returned by fn if it stopped the
+ * scan.
+ */
+extern int tonal_kern_scan(
+        const char *doc,
+        size_t size,
+        int oc,
+        tonal_kern_fn fn,
+        void *arg
+);
+
+struct tonal_kern_track {
+        struct tonal_pitch *pitch;
+        size_t n;
+        size_t max;
+};
+
+/* Pitches of each **kern spine, in the order of tonal_kern_note.track */
+struct tonal_kern_score {
+        struct tonal_kern_track *track;
+        int ntracks;
+        /* Where the arrays live, NULL for the heap */
+        struct tonal_arena *arena;
+};
+
+/*
+ * Read the pitches of a Humdrum document into score, which must be released
+ * with tonal_kern_score_free() also on failure. Fails on any invalid pitch.
+ */
+extern int tonal_kern_read(
+        const char *doc,
+        size_t size,
+        int oc,
+        struct tonal_kern_score *score
+);
+
+/*
+ * Same as tonal_kern_read(), with the arrays allocated from arena (see
+ * tonal_arena.h). They are released with the arena; tonal_kern_score_free()
+ * only clears score.
+ */
+extern int tonal_kern_read_arena(
+        const char *doc,
+        size_t size,
+        int oc,
+        struct tonal_arena *arena,
+        struct tonal_kern_score *score
+);
+
+/* Same as tonal_kern_read(), on the file at path mapped into memory. */
+extern int tonal_kern_read_file(
+        const char *path,
+        int oc,
+        struct tonal_kern_score *score
+);
+
+extern void tonal_kern_score_free(struct tonal_kern_score *score);
+
+/*
+ * Parse the kern token at str (len characters), such as "8.cc#L", into tp.
+ * Returns TONAL_FAIL for tokens without a pitch, such as rests.
+ */
+extern int tonal_kern_parse(
+        const char *str,
+        size_t len,
+        int oc,
+        struct tonal_pitch *tp
+);
+
+/*
+ * Format tp as a kern pitch to buf, NUL terminated. Returns TONAL_FAIL if the
+ * argument is invalid or buf is too small.
+ */
+extern int tonal_kern_snprint(
+        char *buf,
+        size_t size,
+        const struct tonal_pitch *tp,
+        int oc
+);
+
+/*
+ * Write score as a Humdrum file with one **kern spine per track and one pitch
+ * per record. Shorter tracks are padded with null tokens.
+ */
+extern int tonal_kern_write(
+        FILE *stream,
+        const struct tonal_kern_score *score,
+        int oc
+);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,119 @@
+/*
+ * Copyright 2016 Martin Aberg
+ *
+ * This file is part of tonal.
+ *
+ * tonal is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * tonal is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * LilyPond writer
+ *
+ * Writes pitches as LilyPond note names (Dutch: "c", "fis", "es", "beses")
+ * with octave marks into a growable buffer. In absolute mode "c'" is middle
+ * C, octave 5 with octave convention OC_C5 and octave 4 with OC_C4. In
+ * relative mode each pitch is marked relative to the previous one, as
+ * \relative expects: without marks a note is placed less than a fifth, in
+ * diatonic steps, from the previous note.
+ *
+ * LilyPond has no names for triple accidentals, so with TONAL_ALTERATION_MAX
+ * above 2 those pitches fail.
+ */
+
+#ifndef TONAL_LILY_H_
+#define TONAL_LILY_H_
+
+#include <stddef.h>
+
+#include <tonal.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum {
+        TONAL_LILY_ABSOLUTE,
+        TONAL_LILY_RELATIVE,
+        TONAL_LILY_NONE
+};
+
+struct tonal_lily {
+        /* Output so far, NUL terminated */
+        char *buf;
+        size_t len;
+        size_t max;
+        int mode;
+        int oc;
+        /* Relative mode: the pitch the next one is placed from */
+        struct tonal_pitch prev;
+};
+
+/*
+ * Start writing in mode (TONAL_LILY_). In relative mode, ref is the pitch
+ * given to \relative, which the caller writes. Release with
+ * tonal_lily_free().
+ */
+extern int tonal_lily_init(
+        struct tonal_lily *w,
+        int mode,
+        const struct tonal_pitch *ref,
+        int oc
+);
+
+extern void tonal_lily_free(struct tonal_lily *w);
+
+/* Append text, such as durations, bar checks or commands. */
+extern int tonal_lily_append(struct tonal_lily *w, const char *str);
+
+/* Append one pitch. */
+extern int tonal_lily_pitch(struct tonal_lily *w, const struct tonal_pitch *tp);
+
+/*
+ * Append n pitches, each followed by suffix, for example "8 " for eighth
+ * notes. On failure, the pitches before the failing one have been written.
+ */
+extern int tonal_lily_pitches(
+        struct tonal_lily *w,
+        const struct tonal_pitch *tp,
+        size_t n,
+        const char *suffix
+);
+
+/*
+ * Append a chord of n pitches, "<c e g>". In relative mode each pitch is
+ * placed from the one before it in the chord, and the next pitch after the
+ * chord from the first pitch of the chord.
+ */
+extern int tonal_lily_chord(
+        struct tonal_lily *w,
+        const struct tonal_pitch *tp,
+        size_t n
+);
+
+/*
+ * Format tp as an absolute LilyPond pitch to buf, NUL terminated. Returns
+ * TONAL_FAIL if the argument is invalid or buf is too small.
+ */
+extern int tonal_lily_snprint(
+        char *buf,
+        size_t size,
+        const struct tonal_pitch *tp,
+        int oc
+);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
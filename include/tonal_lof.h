@@ -0,0 +1,99 @@
+/*
+ * Copyright 2016 Martin Aberg
+ *
+ * This file is part of tonal.
+ *
+ * tonal is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * tonal is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Line of fifths
+ *
+ * Spelled pitch classes lie on a line, a perfect fifth apart:
+ *
+ *   ... Bbb Fb Cb Gb Db Ab Eb Bb F C G D A E B F# C# G# D# A# E# B# Fx ...
+ *                                  0
+ *
+ * C is 0, G is 1 and F is -1, and a sharp adds 7. Interval classes lie on
+ * the same line with the perfect prime at 0, the perfect fifth at 1 and the
+ * perfect fourth at -1, so that the interval class from one pitch class up
+ * to another is the difference of their positions. Enharmonic spellings are
+ * 12 apart.
+ */
+
+#ifndef TONAL_LOF_H_
+#define TONAL_LOF_H_
+
+#include <stddef.h>
+
+#include <tonal.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Positions of Fbb and B## with the default alteration range */
+#define TONAL_LOF_MIN (-1 - 7 * TONAL_ALTERATION_MAX)
+#define TONAL_LOF_MAX (5 + 7 * TONAL_ALTERATION_MAX)
+
+/* Position of tpc or tic on the line of fifths */
+extern int tpc_to_lof(const struct tonal_pitch_class *tpc, int *lof);
+extern int tic_to_lof(const struct tonal_interval_class *tic, int *lof);
+
+/*
+ * Pitch class or interval class at position lof. Returns TONAL_FAIL if it is
+ * outside the alteration range, or, for interval classes, has no quality
+ * (a doubly diminished fourth by default).
+ */
+extern int lof_to_tpc(int lof, struct tonal_pitch_class *tpc);
+extern int lof_to_tic(int lof, struct tonal_interval_class *tic);
+
+/*
+ * Number of fifths between two pitch classes, 0 for equal ones, 12 for
+ * enharmonic ones.
+ */
+extern int tpc_lof_distance(
+        const struct tonal_pitch_class *tpc0,
+        const struct tonal_pitch_class *tpc1,
+        int *distance
+);
+
+/*
+ * lof[i] := position of the pitch class of tp[i], status as for the batch
+ * operations in tonal.h
+ */
+extern int tp_to_lof_n(
+        const struct tonal_pitch *tp,
+        int *lof,
+        int *status,
+        size_t n
+);
+
+/*
+ * Center of gravity of the n pitches at tp: their mean position on the line
+ * of fifths. A passage in a key has its center near the key, between the
+ * tonic and the dominant, and spelling algorithms pick the spelling of a new
+ * note nearest to it. Returns TONAL_FAIL if n is 0 or a pitch is invalid.
+ */
+extern int tp_lof_center_n(
+        const struct tonal_pitch *tp,
+        size_t n,
+        double *center
+);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
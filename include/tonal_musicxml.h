@@ -0,0 +1,105 @@
+/*
+ * Copyright 2016 Martin Aberg
+ *
+ * This file is part of tonal.
+ *
+ * tonal is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * tonal is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * MusicXML pitch scanner
+ *
+ * Extracts the pitched notes of an uncompressed MusicXML document
+ * (score-partwise or score-timewise) in one forward pass, without building a
+ * tree and without copying the document. Only the elements needed for the
+ * pitch and its position are looked at; everything else is skipped.
+ *
+ * The document is assumed to be well formed. Rests and unpitched notes are
+ * not reported. Compressed MusicXML (.mxl) must be unpacked first.
+ */
+
+#ifndef TONAL_MUSICXML_H_
+#define TONAL_MUSICXML_H_
+
+#include <stddef.h>
+
+#include <tonal.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct tonal_musicxml_note {
+        /*
+         * Pitch from <step>, <alter> and <octave>. Only valid if error is
+         * TONAL_E_OK.
+         */
+        struct tonal_pitch pitch;
+        /*
+         * TONAL_E_OK, or why the pitch could not be represented:
+         * TONAL_E_DIATONIC for a bad <step>, TONAL_E_ALTERATION for an <alter>
+         * which is not an integer in the alteration range (microtones),
+         * TONAL_E_FAIL for a missing <step> or a bad or missing <octave>.
+         */
+        int error;
+        /* Part, numbered 0, 1, ... in order of the <score-part> list */
+        int part;
+        /* Part id attribute, not NUL terminated, points into the document */
+        const char *part_id;
+        size_t part_id_len;
+        /* Measure, numbered 0, 1, ... in document order within the part */
+        int measure;
+        /* From <voice>, 1 if not given */
+        int voice;
+        /* From <duration> in divisions, 0 if not given (grace notes) */
+        int duration;
+        /* Note has <chord/>, it starts together with the previous note. */
+        int chord;
+        /* Byte offset of the <note> element in the document */
+        size_t offset;
+};
+
+/*
+ * Called for each pitched note. Return TONAL_OK to continue, any other value
+ * stops the scan and is returned by the scan function.
+ */
+typedef int (*tonal_musicxml_fn)(
+        const struct tonal_musicxml_note *note,
+        void *arg
+);
+
+/*
+ * Scan size bytes of MusicXML at doc, calling fn for each pitched note.
+ * Returns TONAL_OK, TONAL_FAIL if the document is truncated or malformed, or
+ * the value returned by fn if it stopped the scan.
+ */
+extern int tonal_musicxml_scan(
+        const char *doc,
+        size_t size,
+        tonal_musicxml_fn fn,
+        void *arg
+);
+
+/* Same as tonal_musicxml_scan(), on the file at path mapped into memory. */
+extern int tonal_musicxml_scan_file(
+        const char *path,
+        tonal_musicxml_fn fn,
+        void *arg
+);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,107 @@
+/*
+ * Copyright 2016 Martin Aberg
+ *
+ * This file is part of tonal.
+ *
+ * tonal is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * tonal is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Pitch rope
+ *
+ * An editable sequence of pitches, such as the notes of a score in an
+ * editor, with pitch class histograms of any range. The pitches are kept in
+ * chunks of at most a few hundred, each with its own histogram, and a Fenwick
+ * tree over the chunks gives the note count and histogram of any prefix of
+ * chunks. Edits move pitches within one chunk and update the tree in
+ * O(log chunks); range queries scan at most two partial chunks.
+ *
+ * An analysis over windows of the sequence, such as key finding from pitch
+ * class profiles, only needs to recompute the windows which overlap an edit.
+ */
+
+#ifndef TONAL_ROPE_H_
+#define TONAL_ROPE_H_
+
+#include <stddef.h>
+
+#include <tonal.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct tonal_rope_chunk;
+struct tonal_rope_node;
+
+struct tonal_rope {
+        struct tonal_rope_chunk **chunk;
+        size_t nchunks;
+        size_t max;
+        /* Fenwick tree over the chunks, 1-based */
+        struct tonal_rope_node *tree;
+        /* Number of pitches */
+        size_t size;
+};
+
+/* Start with an empty sequence. Release with tonal_rope_free(). */
+extern int tonal_rope_init(struct tonal_rope *r);
+
+extern void tonal_rope_free(struct tonal_rope *r);
+
+/*
+ * Insert tp[0..n) before position pos, 0 to r->size. On failure nothing is
+ * inserted.
+ */
+extern int tonal_rope_insert(
+        struct tonal_rope *r,
+        size_t pos,
+        const struct tonal_pitch *tp,
+        size_t n
+);
+
+/* Remove the n pitches from position pos. */
+extern int tonal_rope_erase(struct tonal_rope *r, size_t pos, size_t n);
+
+/* Replace the pitch at position pos. */
+extern int tonal_rope_set(
+        struct tonal_rope *r,
+        size_t pos,
+        const struct tonal_pitch *tp
+);
+
+/* Copy the n pitches from position pos to tp. */
+extern int tonal_rope_get(
+        const struct tonal_rope *r,
+        size_t pos,
+        struct tonal_pitch *tp,
+        size_t n
+);
+
+/*
+ * Count the pitches in positions begin to end (not included) per MIDI pitch
+ * class, hist[0] for C, B# and Dbb, and so on.
+ */
+extern int tonal_rope_histogram(
+        const struct tonal_rope *r,
+        size_t begin,
+        size_t end,
+        size_t hist[12]
+);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,136 @@
+/*
+ * Copyright 2016 Martin Aberg
+ *
+ * This file is part of tonal.
+ *
+ * tonal is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * tonal is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Call statistics
+ *
+ * When tonal.c and tonal_stats.c are compiled with -DTONAL_STATS, every call
+ * to the arithmetic and batch functions is counted: number of calls, number
+ * of failures per reason (TONAL_E_) and, for the batch functions, number of
+ * elements and a histogram of batch sizes. Counters are kept per thread and
+ * summed by tonal_stats_snapshot().
+ *
+ * The readers (tonal_musicxml.c, tonal_kern.c, tonal_abc.c) and
+ * tonal_consonance_n() are counted too when their files are compiled with
+ * -DTONAL_STATS. The elements of a reader are the bytes of the document, and
+ * a call which does not return TONAL_OK counts as one TONAL_E_FAIL. The
+ * elements of tonal_consonance_n() are verticalities.
+ *
+ * Adding -DTONAL_STATS_LATENCY also times each call of the batch functions
+ * and readers (clock_gettime(CLOCK_MONOTONIC)) into a per-thread log-linear
+ * histogram, from which tonal_stats_percentile() reads p50, p99 and so on.
+ *
+ * Without TONAL_STATS the counting compiles to nothing, and
+ * tonal_stats_snapshot() returns TONAL_FAIL.
+ */
+
+#ifndef TONAL_STATS_H_
+#define TONAL_STATS_H_
+
+#include <stdio.h>
+
+#include <tonal.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Counted functions */
+enum {
+        TONAL_STATS_TP_ADD,
+        TONAL_STATS_TI_ADD,
+        TONAL_STATS_TP_SUB,
+        TONAL_STATS_TI_SUB,
+        TONAL_STATS_TP_TO_MNN,
+        TONAL_STATS_TP_ADD_N,
+        TONAL_STATS_TP_TRANSPOSE_N,
+        TONAL_STATS_TP_SUB_N,
+        TONAL_STATS_TP_TO_MNN_N,
+        TONAL_STATS_MUSICXML_SCAN,
+        TONAL_STATS_KERN_SCAN,
+        TONAL_STATS_ABC_SCAN,
+        TONAL_STATS_ABC_READ_BOOK,
+        TONAL_STATS_CONSONANCE_N,
+        TONAL_STATS_NONE
+};
+
+/* Function names, indexed by TONAL_STATS_. */
+extern const char *const tonal_stats_fn_str[];
+
+/*
+ * Batch size histogram: bucket 0 counts empty batches, bucket b > 0 counts
+ * batches of 2^(b-1) to 2^b - 1 elements. The last bucket also counts all
+ * larger batches.
+ */
+#define TONAL_STATS_BATCH_BUCKETS 24
+
+/*
+ * Latency histogram: log-linear over nanoseconds, 2^TONAL_STATS_LATENCY_SUB
+ * buckets per power of two, so a bucket is at most 1/8 of its values wide.
+ * Values up to 2^TONAL_STATS_LATENCY_SUB ns have a bucket each. The last
+ * bucket also counts all larger values (above 2^40 ns).
+ */
+#define TONAL_STATS_LATENCY_SUB 3
+#define TONAL_STATS_LATENCY_BUCKETS \
+        ((40 - TONAL_STATS_LATENCY_SUB + 1) << TONAL_STATS_LATENCY_SUB)
+
+struct tonal_stats_fn {
+        /* Number of calls */
+        unsigned long long calls;
+        /* Number of failed elements, indexed by TONAL_E_ */
+        unsigned long long failures[TONAL_E_NONE];
+        /* Number of elements, equal to calls for the scalar functions */
+        unsigned long long elements;
+        /* Batch sizes, only for the batch functions */
+        unsigned long long batch[TONAL_STATS_BATCH_BUCKETS];
+        /* Call latency, only with TONAL_STATS_LATENCY */
+        unsigned long long latency[TONAL_STATS_LATENCY_BUCKETS];
+};
+
+struct tonal_stats {
+        struct tonal_stats_fn fn[TONAL_STATS_NONE];
+};
+
+/*
+ * Sum the counters of all threads, including threads which have exited,
+ * into stats. Returns TONAL_FAIL if statistics are not compiled in.
+ */
+extern int tonal_stats_snapshot(struct tonal_stats *stats);
+
+/*
+ * Latency in nanoseconds below which a fraction q (0 to 1) of the timed calls
+ * of a function completed, for example q = 0.99 for p99. The result is the
+ * upper bound of the histogram bucket, 0 if no calls were timed.
+ */
+extern unsigned long long tonal_stats_percentile(
+        const struct tonal_stats_fn *fn,
+        double q
+);
+
+/* Print the functions which have been called, one line per function. */
+extern int tonal_stats_print(FILE *stream, const struct tonal_stats *stats);
+
+/* Print all counters as one JSON object. */
+extern int tonal_stats_print_json(FILE *stream, const struct tonal_stats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,385 @@
+/*
+ * Copyright 2016 Martin Aberg
+ *
+ * This file is part of tonal.
+ *
+ * tonal is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * tonal is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Range adaptors for tonal (C++20).
+ *
+ *   pitches | tonal::views::transpose(ti)    std::optional<Pitch>
+ *   pitches | tonal::views::intervals        std::optional<Interval>
+ *   pitches | tonal::views::to_mnn           std::optional<int>
+ *
+ * The views are lazy. When the underlying range is contiguous and holds
+ * Pitch or struct tonal_pitch, elements are computed a chunk at a time by
+ * the batch functions of the C API (tp_transpose_n, tp_sub_n, tp_to_mnn_n).
+ * The chunk is computed when an element of it is first read, into a buffer
+ * which the copies of an iterator share, so iterators stay cheap to copy.
+ * Other ranges are computed element by element with the operators of
+ * tonal.hpp, and may also hold std::optional<Pitch> so that views can be
+ * chained.
+ *
+ * views::intervals yields the interval from each pitch to the next, that is
+ * p[i + 1] - p[i], and has one element less than the underlying range.
+ */
+
+#ifndef TONAL_VIEWS_HPP_
+#define TONAL_VIEWS_HPP_
+
+#include <algorithm>
+#include <climits>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <ranges>
+#include <type_traits>
+#include <utility>
+
+#include <tonal.hpp>
+
+namespace tonal {
+
+namespace detail {
+
+constexpr std::optional<Pitch> get_pitch(const Pitch &tp)
+{
+        return tp;
+}
+
+constexpr std::optional<Pitch> get_pitch(const tonal_pitch &tp)
+{
+        return Pitch(tp);
+}
+
+constexpr std::optional<Pitch> get_pitch(const std::optional<Pitch> &tp)
+{
+        return tp;
+}
+
+template <typename R>
+concept batchable_range =
+        std::ranges::contiguous_range<R> &&
+        std::ranges::sized_range<R> &&
+        (
+                std::is_same_v<std::ranges::range_value_t<R>, Pitch> ||
+                std::is_same_v<std::ranges::range_value_t<R>, tonal_pitch>
+        );
+
+/*
+ * An operation over a window of one or two consecutive pitches. The batch
+ * function fills res and status for n windows starting at tp.
+ */
+struct transpose_op {
+        using value_type = std::optional<Pitch>;
+        using result_type = tonal_pitch;
+        static constexpr std::size_t window = 1;
+
+        Interval ti;
+
+        value_type one(const std::optional<Pitch> &tp,
+                       const std::optional<Pitch> &) const
+        {
+                return tp + ti;
+        }
+
+        void batch(const tonal_pitch *tp, std::size_t n,
+                   result_type *res, int *status) const
+        {
+                tp_transpose_n(tp, &ti, res, status, n);
+        }
+
+        value_type make(const result_type &res, int status) const
+        {
+                if (TONAL_OK != status) { return std::nullopt; }
+                return Pitch(res);
+        }
+};
+
+struct intervals_op {
+        using value_type = std::optional<Interval>;
+        using result_type = tonal_interval;
+        static constexpr std::size_t window = 2;
+
+        value_type one(const std::optional<Pitch> &tp0,
+                       const std::optional<Pitch> &tp1) const
+        {
+                if (!tp0 || !tp1) { return std::nullopt; }
+                return *tp1 - *tp0;
+        }
+
+        void batch(const tonal_pitch *tp, std::size_t n,
+                   result_type *res, int *status) const
+        {
+                tp_sub_n(tp + 1, tp, res, status, n);
+        }
+
+        value_type make(const result_type &res, int status) const
+        {
+                if (TONAL_OK != status) { return std::nullopt; }
+                return Interval(res);
+        }
+};
+
+struct to_mnn_op {
+        using value_type = std::optional<int>;
+        using result_type = int;
+        static constexpr std::size_t window = 1;
+
+        value_type one(const std::optional<Pitch> &tp,
+                       const std::optional<Pitch> &) const
+        {
+                if (!tp) { return std::nullopt; }
+                return tp->mnn();
+        }
+
+        void batch(const tonal_pitch *tp, std::size_t n,
+                   result_type *res, int *status) const
+        {
+                tp_to_mnn_n(tp, res, n);
+                for (std::size_t i = 0; i < n; i++) {
+                        status[i] = INT_MIN == res[i] ? TONAL_FAIL : TONAL_OK;
+                }
+        }
+
+        value_type make(const result_type &res, int status) const
+        {
+                if (TONAL_OK != status) { return std::nullopt; }
+                return res;
+        }
+};
+
+} /* namespace detail */
+
+template <std::ranges::view V, typename Op>
+        requires std::ranges::forward_range<V>
+class tonal_view : public std::ranges::view_interface<tonal_view<V, Op>> {
+public:
+        using value_type = typename Op::value_type;
+
+        /* Number of elements computed per batch call. */
+        static constexpr std::size_t CHUNK = 256;
+
+        tonal_view() = default;
+        tonal_view(V base, Op op) : base_(std::move(base)), op_(std::move(op)) {}
+
+        /* Results of the batch call for elements begin to begin + n */
+        struct chunk {
+                std::size_t begin = 0;
+                std::size_t n = 0;
+                typename Op::result_type res[CHUNK];
+                int status[CHUNK];
+        };
+
+        /*
+         * Iterator over contiguous ranges, filled a chunk at a time. Copies
+         * share the chunk, which is refilled when an element outside it is
+         * read.
+         */
+        class chunk_iterator {
+        public:
+                using iterator_concept = std::forward_iterator_tag;
+                using iterator_category = std::input_iterator_tag;
+                using value_type = typename Op::value_type;
+                using difference_type = std::ptrdiff_t;
+
+                chunk_iterator() = default;
+                explicit chunk_iterator(const tonal_view *parent) :
+                        parent_(parent)
+                {
+                }
+
+                value_type operator*() const
+                {
+                        if (!chunk_) { chunk_ = std::make_shared<chunk>(); }
+                        if (i_ < chunk_->begin || chunk_->begin + chunk_->n <= i_) {
+                                fill();
+                        }
+                        std::size_t j = i_ - chunk_->begin;
+                        return parent_->op_.make(chunk_->res[j], chunk_->status[j]);
+                }
+
+                chunk_iterator &operator++()
+                {
+                        ++i_;
+                        return *this;
+                }
+
+                chunk_iterator operator++(int)
+                {
+                        chunk_iterator tmp = *this;
+                        ++*this;
+                        return tmp;
+                }
+
+                friend bool operator==(const chunk_iterator &a,
+                                       const chunk_iterator &b)
+                {
+                        return a.i_ == b.i_;
+                }
+
+                friend bool operator==(const chunk_iterator &a,
+                                       std::default_sentinel_t)
+                {
+                        return a.i_ >= a.parent_->size();
+                }
+
+        private:
+                void fill() const
+                {
+                        chunk_->begin = i_;
+                        chunk_->n = std::min(CHUNK, parent_->size() - i_);
+                        parent_->op_.batch(
+                                parent_->data() + i_,
+                                chunk_->n,
+                                chunk_->res,
+                                chunk_->status
+                        );
+                }
+
+                const tonal_view *parent_ = nullptr;
+                std::size_t i_ = 0;
+                mutable std::shared_ptr<chunk> chunk_;
+        };
+
+        /* Iterator over other ranges, computed per element. */
+        class element_iterator {
+                using base_iterator = std::ranges::iterator_t<const V>;
+                using base_sentinel = std::ranges::sentinel_t<const V>;
+        public:
+                using iterator_concept = std::forward_iterator_tag;
+                using iterator_category = std::input_iterator_tag;
+                using value_type = typename Op::value_type;
+                using difference_type = std::ptrdiff_t;
+
+                element_iterator() = default;
+                explicit element_iterator(const tonal_view *parent) :
+                        parent_(parent),
+                        cur_(std::ranges::begin(parent->base_)),
+                        last_(cur_),
+                        end_(std::ranges::end(parent->base_))
+                {
+                        std::ranges::advance(
+                                last_,
+                                static_cast<difference_type>(Op::window - 1),
+                                end_
+                        );
+                }
+
+                value_type operator*() const
+                {
+                        return parent_->op_.one(
+                                detail::get_pitch(*cur_),
+                                detail::get_pitch(*last_)
+                        );
+                }
+
+                element_iterator &operator++()
+                {
+                        ++cur_;
+                        ++last_;
+                        return *this;
+                }
+
+                element_iterator operator++(int)
+                {
+                        element_iterator tmp = *this;
+                        ++*this;
+                        return tmp;
+                }
+
+                friend bool operator==(const element_iterator &a,
+                                       const element_iterator &b)
+                {
+                        return a.cur_ == b.cur_;
+                }
+
+                friend bool operator==(const element_iterator &a,
+                                       std::default_sentinel_t)
+                {
+                        return a.last_ == a.end_;
+                }
+
+        private:
+                const tonal_view *parent_ = nullptr;
+                base_iterator cur_{};
+                base_iterator last_{};
+                base_sentinel end_{};
+        };
+
+        static constexpr bool batched = detail::batchable_range<const V>;
+
+        using iterator =
+                std::conditional_t<batched, chunk_iterator, element_iterator>;
+
+        iterator begin() const { return iterator(this); }
+        std::default_sentinel_t end() const { return std::default_sentinel; }
+
+        std::size_t size() const
+                requires std::ranges::sized_range<const V>
+        {
+                std::size_t n = std::ranges::size(base_);
+                return n < Op::window ? 0 : n - (Op::window - 1);
+        }
+
+        const V &base() const { return base_; }
+
+private:
+        const tonal_pitch *data() const
+                requires batched
+        {
+                return std::ranges::data(base_);
+        }
+
+        V base_ = V();
+        Op op_ = Op();
+};
+
+namespace views {
+
+template <typename Op>
+struct adaptor_closure {
+        Op op;
+
+        template <std::ranges::viewable_range R>
+        friend auto operator|(R &&r, const adaptor_closure &c)
+        {
+                using V = std::views::all_t<R>;
+                return tonal_view<V, Op>(
+                        std::views::all(std::forward<R>(r)),
+                        c.op
+                );
+        }
+};
+
+/* Add ti to each pitch. */
+inline adaptor_closure<detail::transpose_op> transpose(const Interval &ti)
+{
+        return { detail::transpose_op{ ti } };
+}
+
+/* Interval from each pitch to the next. */
+inline constexpr adaptor_closure<detail::intervals_op> intervals{};
+
+/* MIDI Note Number of each pitch. */
+inline constexpr adaptor_closure<detail::to_mnn_op> to_mnn{};
+
+} /* namespace views */
+
+} /* namespace tonal */
+
+#endif
@@ -0,0 +1,19 @@
+# Build the tonal CPython extension module:
+#
+#   $ python3 setup.py build_ext --inplace
+#   $ python3 -m unittest test_tonal
+
+from setuptools import Extension, setup
+
+setup(
+    name='tonal',
+    version='0.1',
+    ext_modules=[
+        Extension(
+            'tonal',
+            sources=['tonalmodule.c', '../tonal.c'],
+            include_dirs=['../include', '..'],
+            extra_compile_args=['-std=c99', '-Wall', '-Wextra'],
+        ),
+    ],
+)
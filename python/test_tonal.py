@@ -0,0 +1,181 @@
+# Unit tests for the tonal CPython extension module
+
+import ctypes
+import threading
+import unittest
+from array import array
+
+import tonal
+
+try:
+    import numpy
+except ImportError:
+    numpy = None
+
+
+def pitches():
+    return [
+        (dp, pa, o)
+        for o in range(3)
+        for dp in range(tonal.DP_B + 1)
+        for pa in range(tonal.PA_ss + 1)
+    ]
+
+
+def flat(tuples):
+    return array('i', [x for t in tuples for x in t])
+
+
+class TestScalar(unittest.TestCase):
+    def test_tp_add(self):
+        # Example 2.1
+        g0 = (tonal.DP_G, tonal.PA_, 0)
+        p4 = (tonal.DI_FOURTH, tonal.IA_PERFECT, 0, tonal.ID_UP)
+        self.assertEqual(tonal.tp_add(g0, p4), (tonal.DP_C, tonal.PA_, 1))
+        e_ss = (tonal.DP_E, tonal.PA_ss, 4)
+        a1 = (tonal.DI_PRIME, tonal.IA_AUGMENTED, 0, tonal.ID_UP)
+        self.assertIsNone(tonal.tp_add(e_ss, a1))
+
+    def test_ti_add_sub(self):
+        # Example 2.2 and 2.3
+        M3 = (tonal.DI_THIRD, tonal.IA_MAJOR, 0, tonal.ID_UP)
+        m3 = (tonal.DI_THIRD, tonal.IA_MINOR, 0, tonal.ID_UP)
+        m7 = (tonal.DI_SEVENTH, tonal.IA_MINOR, 0, tonal.ID_UP)
+        P5 = (tonal.DI_FIFTH, tonal.IA_PERFECT, 0, tonal.ID_UP)
+        self.assertEqual(tonal.ti_add(M3, m3), P5)
+        self.assertEqual(tonal.ti_sub(m7, m3), P5)
+
+    def test_tp_sub(self):
+        c1 = (tonal.DP_C, tonal.PA_, 1)
+        g0 = (tonal.DP_G, tonal.PA_, 0)
+        P4 = (tonal.DI_FOURTH, tonal.IA_PERFECT, 0, tonal.ID_UP)
+        self.assertEqual(tonal.tp_sub(c1, g0), P4)
+
+    def test_tp_to_mnn(self):
+        self.assertEqual(tonal.tp_to_mnn((tonal.DP_C, tonal.PA_, 4)), 48)
+        self.assertEqual(tonal.tp_to_mnn((tonal.DP_C, tonal.PA_, -1)), -12)
+        self.assertIsNone(tonal.tp_to_mnn((tonal.DP_NONE, tonal.PA_, 4)))
+        c4 = (tonal.DP_C, tonal.PA_, 4)
+        self.assertEqual(tonal.tp_to_mnn(c4, tonal.OC_C4), 60)
+
+    def test_bad_argument(self):
+        self.assertRaises(TypeError, tonal.tp_add, (1, 2), (1, 2, 3, 4))
+
+
+class TestBatch(unittest.TestCase):
+    P5 = (tonal.DI_FIFTH, tonal.IA_PERFECT, 0, tonal.ID_UP)
+
+    def test_tp_transpose_n(self):
+        tps = pitches()
+        tp = flat(tps)
+        tp_sum = array('i', bytes(len(tp) * 4))
+        status = array('i', bytes(len(tps) * 4))
+        ret = tonal.tp_transpose_n(tp, self.P5, tp_sum, status)
+        self.assertEqual(ret, tonal.TONAL_FAIL)
+        for i, p in enumerate(tps):
+            ref = tonal.tp_add(p, self.P5)
+            self.assertEqual(status[i] == tonal.TONAL_OK, ref is not None)
+            if ref is not None:
+                self.assertEqual(tuple(tp_sum[3 * i:3 * i + 3]), ref)
+
+    def test_tp_add_n(self):
+        tps = pitches()
+        tp = flat(tps)
+        ti = flat([self.P5] * len(tps))
+        tp_sum = array('i', bytes(len(tp) * 4))
+        tonal.tp_add_n(tp, ti, tp_sum)
+        ref = array('i', bytes(len(tp) * 4))
+        tonal.tp_transpose_n(tp, self.P5, ref)
+        self.assertEqual(tp_sum, ref)
+
+    def test_tp_sub_n(self):
+        tps = pitches()
+        tp = flat(tps)
+        n = len(tps) - 1
+        ti = array('i', bytes(n * 16))
+        status = array('i', bytes(n * 4))
+        view = memoryview(tp)
+        tonal.tp_sub_n(view[3:], view[:-3], ti, status)
+        for i in range(n):
+            ref = tonal.tp_sub(tps[i + 1], tps[i])
+            if ref is None:
+                self.assertEqual(status[i], tonal.TONAL_E_RANGE)
+            else:
+                self.assertEqual(tuple(ti[4 * i:4 * i + 4]), ref)
+
+    def test_tp_to_mnn_n(self):
+        tps = pitches()
+        mnn = array('i', bytes(len(tps) * 4))
+        self.assertEqual(tonal.tp_to_mnn_n(flat(tps), mnn), tonal.TONAL_OK)
+        self.assertEqual(list(mnn), [tonal.tp_to_mnn(p) for p in tps])
+
+    def test_bad_buffer(self):
+        tp = flat(pitches())
+        self.assertRaises(ValueError, tonal.tp_to_mnn_n, tp, array('i'))
+        self.assertRaises(TypeError, tonal.tp_to_mnn_n, array('d', [0] * 3),
+                          array('i', [0]))
+        self.assertRaises(ValueError, tonal.tp_to_mnn_n, array('i', [0] * 4),
+                          array('i', [0] * 2))
+        # Output must be writable.
+        self.assertRaises(BufferError, tonal.tp_to_mnn_n, tp, bytes(1000))
+
+    def test_records(self):
+        class Pitch(ctypes.Structure):
+            _fields_ = [(name, ctypes.c_int32) for name in ('dp', 'pa', 'o')]
+
+        class Floats(ctypes.Structure):
+            _fields_ = [(name, ctypes.c_float) for name in ('a', 'b', 'c')]
+
+        class Chars(ctypes.Structure):
+            _fields_ = [('s', ctypes.c_char * 12)]
+
+        tps = pitches()
+        mnn = array('i', bytes(len(tps) * 4))
+        tp = (Pitch * len(tps))(*tps)
+        self.assertEqual(tonal.tp_to_mnn_n(tp, mnn), tonal.TONAL_OK)
+        self.assertEqual(list(mnn), [tonal.tp_to_mnn(p) for p in tps])
+        # Records of the right size but not of three int32 are rejected.
+        self.assertRaises(TypeError, tonal.tp_to_mnn_n,
+                          (Floats * len(tps))(), mnn)
+        self.assertRaises(TypeError, tonal.tp_to_mnn_n,
+                          (Chars * len(tps))(), mnn)
+
+    def test_threads(self):
+        tp = flat(pitches() * 1000)
+        out = [array('i', bytes(len(tp) * 4)) for _ in range(4)]
+        threads = [
+            threading.Thread(
+                target=tonal.tp_transpose_n, args=(tp, self.P5, o))
+            for o in out
+        ]
+        for t in threads:
+            t.start()
+        for t in threads:
+            t.join()
+        for o in out[1:]:
+            self.assertEqual(o, out[0])
+
+
+@unittest.skipIf(numpy is None, 'numpy not available')
+class TestNumpy(unittest.TestCase):
+    def test_structured(self):
+        dtype = numpy.dtype([('dp', 'i4'), ('pa', 'i4'), ('octave', 'i4')])
+        tp = numpy.array(pitches(), dtype=dtype)
+        tp_sum = numpy.empty_like(tp)
+        P8 = (tonal.DI_PRIME, tonal.IA_PERFECT, 1, tonal.ID_UP)
+        self.assertEqual(tonal.tp_transpose_n(tp, P8, tp_sum), tonal.TONAL_OK)
+        self.assertTrue((tp_sum['octave'] == tp['octave'] + 1).all())
+        floats = numpy.zeros(len(tp), dtype='f4, f4, f4')
+        self.assertRaises(TypeError, tonal.tp_transpose_n, floats, P8, tp_sum)
+        chars = numpy.zeros(len(tp), dtype='S12')
+        self.assertRaises(TypeError, tonal.tp_transpose_n, chars, P8, tp_sum)
+
+    def test_2d(self):
+        tp = numpy.array(pitches(), dtype=numpy.int32)
+        mnn = numpy.empty(len(tp), dtype=numpy.int32)
+        tonal.tp_to_mnn_n(tp, mnn)
+        self.assertEqual(list(mnn), [tonal.tp_to_mnn(tuple(p)) for p in tp])
+
+
+if __name__ == '__main__':
+    unittest.main()
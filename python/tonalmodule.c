@@ -0,0 +1,540 @@
+/*
+ * Copyright 2016 Martin Aberg
+ *
+ * This file is part of tonal.
+ *
+ * tonal is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * tonal is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * CPython extension module for tonal.
+ *
+ * Scalar functions take and return tuples:
+ *   pitch    (diatonic_pitch, pitch_alteration, octave)
+ *   interval (diatonic_interval, interval_alteration, octave, direction)
+ * and return None where the C function returns TONAL_FAIL.
+ *
+ * Batch functions take objects supporting the buffer protocol, for example
+ * NumPy arrays, and operate on them in place without copying. An array of
+ * pitches is C contiguous and either int32 with shape (n, 3), or a
+ * structured array of three int32 fields; intervals likewise with four
+ * fields. The GIL is released while the batch function runs.
+ */
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+
+#include <limits.h>
+#include <string.h>
+
+#include <tonal.h>
+
+static int tp_from_obj(PyObject *obj, struct tonal_pitch *tp)
+{
+        return PyArg_ParseTuple(
+                obj,
+                "iii;pitch must be (diatonic_pitch, pitch_alteration, octave)",
+                &tp->diatonic_pitch,
+                &tp->pitch_alteration,
+                &tp->octave
+        );
+}
+
+static int ti_from_obj(PyObject *obj, struct tonal_interval *ti)
+{
+        return PyArg_ParseTuple(
+                obj,
+                "iiii;interval must be (diatonic_interval, "
+                "interval_alteration, octave, direction)",
+                &ti->diatonic_interval,
+                &ti->interval_alteration,
+                &ti->octave,
+                &ti->interval_direction
+        );
+}
+
+static PyObject *tp_to_obj(int ret, const struct tonal_pitch *tp)
+{
+        if (TONAL_OK != ret) { Py_RETURN_NONE; }
+        return Py_BuildValue(
+                "(iii)",
+                tp->diatonic_pitch,
+                tp->pitch_alteration,
+                tp->octave
+        );
+}
+
+static PyObject *ti_to_obj(int ret, const struct tonal_interval *ti)
+{
+        if (TONAL_OK != ret) { Py_RETURN_NONE; }
+        return Py_BuildValue(
+                "(iiii)",
+                ti->diatonic_interval,
+                ti->interval_alteration,
+                ti->octave,
+                ti->interval_direction
+        );
+}
+
+static PyObject *py_tp_add(PyObject *self, PyObject *args)
+{
+        PyObject *o0, *o1;
+        struct tonal_pitch tp;
+        struct tonal_interval ti;
+        struct tonal_pitch tp_sum;
+
+        (void) self;
+        if (!PyArg_ParseTuple(args, "OO", &o0, &o1)) { return NULL; }
+        if (!tp_from_obj(o0, &tp) || !ti_from_obj(o1, &ti)) { return NULL; }
+        return tp_to_obj(tp_add(&tp, &ti, &tp_sum), &tp_sum);
+}
+
+static PyObject *py_ti_add(PyObject *self, PyObject *args)
+{
+        PyObject *o0, *o1;
+        struct tonal_interval ti0;
+        struct tonal_interval ti1;
+        struct tonal_interval ti_sum;
+
+        (void) self;
+        if (!PyArg_ParseTuple(args, "OO", &o0, &o1)) { return NULL; }
+        if (!ti_from_obj(o0, &ti0) || !ti_from_obj(o1, &ti1)) { return NULL; }
+        return ti_to_obj(ti_add(&ti0, &ti1, &ti_sum), &ti_sum);
+}
+
+static PyObject *py_tp_sub(PyObject *self, PyObject *args)
+{
+        PyObject *o0, *o1;
+        struct tonal_pitch tp0;
+        struct tonal_pitch tp1;
+        struct tonal_interval ti_diff;
+
+        (void) self;
+        if (!PyArg_ParseTuple(args, "OO", &o0, &o1)) { return NULL; }
+        if (!tp_from_obj(o0, &tp0) || !tp_from_obj(o1, &tp1)) { return NULL; }
+        return ti_to_obj(tp_sub(&tp0, &tp1, &ti_diff), &ti_diff);
+}
+
+static PyObject *py_ti_sub(PyObject *self, PyObject *args)
+{
+        PyObject *o0, *o1;
+        struct tonal_interval ti0;
+        struct tonal_interval ti1;
+        struct tonal_interval ti_diff;
+
+        (void) self;
+        if (!PyArg_ParseTuple(args, "OO", &o0, &o1)) { return NULL; }
+        if (!ti_from_obj(o0, &ti0) || !ti_from_obj(o1, &ti1)) { return NULL; }
+        return ti_to_obj(ti_sub(&ti0, &ti1, &ti_diff), &ti_diff);
+}
+
+static PyObject *py_tp_to_mnn(PyObject *self, PyObject *args)
+{
+        PyObject *o0;
+        struct tonal_pitch tp;
+        int oc = OC_C5;
+        int mnn;
+
+        (void) self;
+        if (!PyArg_ParseTuple(args, "O|i", &o0, &oc)) { return NULL; }
+        if (!tp_from_obj(o0, &tp)) { return NULL; }
+        mnn = tp_to_mnn_oc(&tp, oc);
+        if (INT_MIN == mnn) { Py_RETURN_NONE; }
+        return PyLong_FromLong(mnn);
+}
+
+
+/*
+ * Batch argument handling
+ *
+ * An array argument is a buffer of n elements of elemsize bytes. Plain int32
+ * buffers must have a multiple of elemsize / 4 items. Structured buffers
+ * must have records of elemsize / 4 int32 fields, such as the format
+ * "T{<i:dp:<i:pa:<i:octave:}" of a numpy dtype with three 'i4' fields.
+ */
+
+struct array {
+        Py_buffer view;
+        size_t n;
+};
+
+/* Skip a byte order prefix. Returns 0 if it is not the native order. */
+static int skip_byte_order(const char **format)
+{
+        const char *p = *format;
+
+        if ('@' == *p || '=' == *p) {
+                p++;
+        } else if ('<' == *p || '>' == *p || '!' == *p) {
+                /* Explicit byte order must be the native one. */
+                int little = 1;
+                int native_little = *(const char *) &little;
+
+                if (('<' == *p) != native_little) { return 0; }
+                p++;
+        }
+        *format = p;
+        return 1;
+}
+
+/*
+ * Skip one item of int32 code, with an optional byte order and repeat count,
+ * and add its count to *n. Returns 0 if it is something else.
+ */
+static int skip_int32(const char **format, size_t *n)
+{
+        const char *p = *format;
+        size_t count = 0;
+
+        if (!skip_byte_order(&p)) { return 0; }
+        while ('0' <= *p && *p <= '9' && count < 1000) {
+                count = 10 * count + (*p++ - '0');
+        }
+        if ('i' != *p && !('l' == *p && 4 == sizeof (long))) { return 0; }
+        *n += count ? count : 1;
+        *format = p + 1;
+        return 1;
+}
+
+/*
+ * Number of int32 values in an item of format: a sequence of int32 codes,
+ * or a struct "T{...}" of named int32 fields. 0 for any other format.
+ */
+static size_t int32_count(const char *format)
+{
+        const char *p = format;
+        size_t n = 0;
+
+        if (NULL == p || !skip_byte_order(&p)) { return 0; }
+        if ('T' != p[0] || '{' != p[1]) {
+                while (*p) {
+                        if (!skip_int32(&p, &n)) { return 0; }
+                }
+                return n;
+        }
+        for (p += 2; '}' != *p; ) {
+                if (!skip_int32(&p, &n)) { return 0; }
+                if (':' == *p) {
+                        p = strchr(p + 1, ':');
+                        if (NULL == p) { return 0; }
+                        p++;
+                }
+        }
+        return '\0' == p[1] ? n : 0;
+}
+
+static int array_get(
+        PyObject *obj,
+        struct array *a,
+        size_t elemsize,
+        int writable,
+        const char *name
+)
+{
+        int flags = PyBUF_C_CONTIGUOUS | PyBUF_FORMAT;
+
+        if (writable) { flags |= PyBUF_WRITABLE; }
+        if (0 != PyObject_GetBuffer(obj, &a->view, flags)) { return 0; }
+
+        if (
+                !(4 == a->view.itemsize && 1 == int32_count(a->view.format)) &&
+                !(
+                        4 < elemsize &&
+                        (Py_ssize_t) elemsize == a->view.itemsize &&
+                        elemsize / 4 == int32_count(a->view.format)
+                )
+        ) {
+                PyErr_Format(
+                        PyExc_TypeError,
+                        "%s: expected int32 items or records of %zu int32 "
+                        "fields, got format '%s'",
+                        name,
+                        elemsize / 4,
+                        a->view.format ? a->view.format : "B"
+                );
+                PyBuffer_Release(&a->view);
+                return 0;
+        }
+        if (0 != a->view.len % elemsize) {
+                PyErr_Format(
+                        PyExc_ValueError,
+                        "%s: size is not a multiple of %zu bytes",
+                        name,
+                        elemsize
+                );
+                PyBuffer_Release(&a->view);
+                return 0;
+        }
+        a->n = a->view.len / elemsize;
+        return 1;
+}
+
+static int array_check_n(const struct array *a, size_t n, const char *name)
+{
+        if (a->n < n) {
+                PyErr_Format(
+                        PyExc_ValueError,
+                        "%s: holds %zu elements, %zu needed",
+                        name,
+                        a->n,
+                        n
+                );
+                return 0;
+        }
+        return 1;
+}
+
+/*
+ * Optional int32 status array. Returns 0 on error, otherwise sets *status to
+ * NULL or the array data.
+ */
+static int status_get(
+        PyObject *obj,
+        struct array *a,
+        size_t n,
+        int **status
+)
+{
+        *status = NULL;
+        if (NULL == obj || Py_None == obj) { return 1; }
+        if (!array_get(obj, a, sizeof (int), 1, "status")) { return 0; }
+        if (!array_check_n(a, n, "status")) {
+                PyBuffer_Release(&a->view);
+                return 0;
+        }
+        *status = a->view.buf;
+        return 1;
+}
+
+static PyObject *py_tp_transpose_n(PyObject *self, PyObject *args)
+{
+        PyObject *o_tp, *o_ti, *o_sum, *o_status = NULL;
+        struct tonal_interval ti;
+        struct array tp, sum, st;
+        int *status;
+        int ret;
+
+        (void) self;
+        if (!PyArg_ParseTuple(args, "OOO|O", &o_tp, &o_ti, &o_sum, &o_status)) {
+                return NULL;
+        }
+        if (!ti_from_obj(o_ti, &ti)) { return NULL; }
+        if (!array_get(o_tp, &tp, sizeof (struct tonal_pitch), 0, "tp")) {
+                return NULL;
+        }
+        if (!array_get(o_sum, &sum, sizeof (struct tonal_pitch), 1, "tp_sum")) {
+                goto out_tp;
+        }
+        if (!array_check_n(&sum, tp.n, "tp_sum")) { goto out_sum; }
+        if (!status_get(o_status, &st, tp.n, &status)) { goto out_sum; }
+
+        Py_BEGIN_ALLOW_THREADS
+        ret = tp_transpose_n(tp.view.buf, &ti, sum.view.buf, status, tp.n);
+        Py_END_ALLOW_THREADS
+
+        if (status) { PyBuffer_Release(&st.view); }
+        PyBuffer_Release(&sum.view);
+        PyBuffer_Release(&tp.view);
+        return PyLong_FromLong(ret);
+
+out_sum:
+        PyBuffer_Release(&sum.view);
+out_tp:
+        PyBuffer_Release(&tp.view);
+        return NULL;
+}
+
+static PyObject *py_tp_add_n(PyObject *self, PyObject *args)
+{
+        PyObject *o_tp, *o_ti, *o_sum, *o_status = NULL;
+        struct array tp, ti, sum, st;
+        int *status;
+        int ret;
+
+        (void) self;
+        if (!PyArg_ParseTuple(args, "OOO|O", &o_tp, &o_ti, &o_sum, &o_status)) {
+                return NULL;
+        }
+        if (!array_get(o_tp, &tp, sizeof (struct tonal_pitch), 0, "tp")) {
+                return NULL;
+        }
+        if (!array_get(o_ti, &ti, sizeof (struct tonal_interval), 0, "ti")) {
+                goto out_tp;
+        }
+        if (!array_check_n(&ti, tp.n, "ti")) { goto out_ti; }
+        if (!array_get(o_sum, &sum, sizeof (struct tonal_pitch), 1, "tp_sum")) {
+                goto out_ti;
+        }
+        if (!array_check_n(&sum, tp.n, "tp_sum")) { goto out_sum; }
+        if (!status_get(o_status, &st, tp.n, &status)) { goto out_sum; }
+
+        Py_BEGIN_ALLOW_THREADS
+        ret = tp_add_n(tp.view.buf, ti.view.buf, sum.view.buf, status, tp.n);
+        Py_END_ALLOW_THREADS
+
+        if (status) { PyBuffer_Release(&st.view); }
+        PyBuffer_Release(&sum.view);
+        PyBuffer_Release(&ti.view);
+        PyBuffer_Release(&tp.view);
+        return PyLong_FromLong(ret);
+
+out_sum:
+        PyBuffer_Release(&sum.view);
+out_ti:
+        PyBuffer_Release(&ti.view);
+out_tp:
+        PyBuffer_Release(&tp.view);
+        return NULL;
+}
+
+static PyObject *py_tp_sub_n(PyObject *self, PyObject *args)
+{
+        PyObject *o_tp0, *o_tp1, *o_diff, *o_status = NULL;
+        struct array tp0, tp1, diff, st;
+        int *status;
+        int ret;
+
+        (void) self;
+        if (!PyArg_ParseTuple(args, "OOO|O", &o_tp0, &o_tp1, &o_diff, &o_status)) {
+                return NULL;
+        }
+        if (!array_get(o_tp0, &tp0, sizeof (struct tonal_pitch), 0, "tp0")) {
+                return NULL;
+        }
+        if (!array_get(o_tp1, &tp1, sizeof (struct tonal_pitch), 0, "tp1")) {
+                goto out_tp0;
+        }
+        if (!array_check_n(&tp1, tp0.n, "tp1")) { goto out_tp1; }
+        if (!array_get(o_diff, &diff, sizeof (struct tonal_interval), 1, "ti_diff")) {
+                goto out_tp1;
+        }
+        if (!array_check_n(&diff, tp0.n, "ti_diff")) { goto out_diff; }
+        if (!status_get(o_status, &st, tp0.n, &status)) { goto out_diff; }
+
+        Py_BEGIN_ALLOW_THREADS
+        ret = tp_sub_n(tp0.view.buf, tp1.view.buf, diff.view.buf, status, tp0.n);
+        Py_END_ALLOW_THREADS
+
+        if (status) { PyBuffer_Release(&st.view); }
+        PyBuffer_Release(&diff.view);
+        PyBuffer_Release(&tp1.view);
+        PyBuffer_Release(&tp0.view);
+        return PyLong_FromLong(ret);
+
+out_diff:
+        PyBuffer_Release(&diff.view);
+out_tp1:
+        PyBuffer_Release(&tp1.view);
+out_tp0:
+        PyBuffer_Release(&tp0.view);
+        return NULL;
+}
+
+static PyObject *py_tp_to_mnn_n(PyObject *self, PyObject *args)
+{
+        PyObject *o_tp, *o_mnn;
+        struct array tp, mnn;
+        int ret;
+
+        (void) self;
+        if (!PyArg_ParseTuple(args, "OO", &o_tp, &o_mnn)) { return NULL; }
+        if (!array_get(o_tp, &tp, sizeof (struct tonal_pitch), 0, "tp")) {
+                return NULL;
+        }
+        if (!array_get(o_mnn, &mnn, sizeof (int), 1, "mnn")) { goto out_tp; }
+        if (!array_check_n(&mnn, tp.n, "mnn")) { goto out_mnn; }
+
+        Py_BEGIN_ALLOW_THREADS
+        ret = tp_to_mnn_n(tp.view.buf, mnn.view.buf, tp.n);
+        Py_END_ALLOW_THREADS
+
+        PyBuffer_Release(&mnn.view);
+        PyBuffer_Release(&tp.view);
+        return PyLong_FromLong(ret);
+
+out_mnn:
+        PyBuffer_Release(&mnn.view);
+out_tp:
+        PyBuffer_Release(&tp.view);
+        return NULL;
+}
+
+static PyMethodDef tonal_methods[] = {
+        { "tp_add", py_tp_add, METH_VARARGS,
+          "tp_add(tp, ti) -> tp + ti, or None" },
+        { "ti_add", py_ti_add, METH_VARARGS,
+          "ti_add(ti0, ti1) -> ti0 + ti1, or None" },
+        { "tp_sub", py_tp_sub, METH_VARARGS,
+          "tp_sub(tp0, tp1) -> tp0 - tp1, or None" },
+        { "ti_sub", py_ti_sub, METH_VARARGS,
+          "ti_sub(ti0, ti1) -> ti0 - ti1, or None" },
+        { "tp_to_mnn", py_tp_to_mnn, METH_VARARGS,
+          "tp_to_mnn(tp[, oc]) -> MIDI Note Number, or None" },
+        { "tp_add_n", py_tp_add_n, METH_VARARGS,
+          "tp_add_n(tp, ti, tp_sum[, status]) -> TONAL_OK or TONAL_FAIL\n\n"
+          "tp_sum[i] := tp[i] + ti[i]" },
+        { "tp_transpose_n", py_tp_transpose_n, METH_VARARGS,
+          "tp_transpose_n(tp, ti, tp_sum[, status]) -> TONAL_OK or TONAL_FAIL\n\n"
+          "tp_sum[i] := tp[i] + ti, ti is an interval tuple" },
+        { "tp_sub_n", py_tp_sub_n, METH_VARARGS,
+          "tp_sub_n(tp0, tp1, ti_diff[, status]) -> TONAL_OK or TONAL_FAIL\n\n"
+          "ti_diff[i] := tp0[i] - tp1[i]" },
+        { "tp_to_mnn_n", py_tp_to_mnn_n, METH_VARARGS,
+          "tp_to_mnn_n(tp, mnn) -> TONAL_OK or TONAL_FAIL" },
+        { NULL, NULL, 0, NULL }
+};
+
+static struct PyModuleDef tonal_module = {
+        PyModuleDef_HEAD_INIT,
+        "tonal",
+        "Tonal pitch and interval arithmetic.",
+        -1,
+        tonal_methods,
+        NULL, NULL, NULL, NULL
+};
+
+#define ADD_INT(m, x) if (0 != PyModule_AddIntConstant(m, #x, x)) { goto fail; }
+
+PyMODINIT_FUNC PyInit_tonal(void)
+{
+        PyObject *m;
+
+        m = PyModule_Create(&tonal_module);
+        if (NULL == m) { return NULL; }
+
+        ADD_INT(m, DP_C); ADD_INT(m, DP_D); ADD_INT(m, DP_E); ADD_INT(m, DP_F);
+        ADD_INT(m, DP_G); ADD_INT(m, DP_A); ADD_INT(m, DP_B);
+        ADD_INT(m, DP_NONE);
+        ADD_INT(m, PA_bb); ADD_INT(m, PA_b); ADD_INT(m, PA_);
+        ADD_INT(m, PA_s); ADD_INT(m, PA_ss);
+        ADD_INT(m, TONAL_ALTERATION_MAX);
+        ADD_INT(m, DI_PRIME); ADD_INT(m, DI_SECOND); ADD_INT(m, DI_THIRD);
+        ADD_INT(m, DI_FOURTH); ADD_INT(m, DI_FIFTH); ADD_INT(m, DI_SIXTH);
+        ADD_INT(m, DI_SEVENTH);
+        ADD_INT(m, IA_DIMINISHED); ADD_INT(m, IA_MINOR); ADD_INT(m, IA_MAJOR);
+        ADD_INT(m, IA_PERFECT); ADD_INT(m, IA_AUGMENTED);
+        ADD_INT(m, ID_UP); ADD_INT(m, ID_DOWN);
+        ADD_INT(m, OC_C5); ADD_INT(m, OC_C4);
+        ADD_INT(m, TONAL_OK); ADD_INT(m, TONAL_FAIL);
+        ADD_INT(m, TONAL_E_OK); ADD_INT(m, TONAL_E_FAIL);
+        ADD_INT(m, TONAL_E_NULL); ADD_INT(m, TONAL_E_DIATONIC);
+        ADD_INT(m, TONAL_E_ALTERATION); ADD_INT(m, TONAL_E_OCTAVE);
+        ADD_INT(m, TONAL_E_QUALITY); ADD_INT(m, TONAL_E_DIRECTION);
+        ADD_INT(m, TONAL_E_RANGE);
+        return m;
+
+fail:
+        Py_DECREF(m);
+        return NULL;
+}
@@ -0,0 +1,141 @@
+/*
+ * Copyright 2016 Martin Aberg
+ *
+ * This file is part of tonal.
+ *
+ * tonal is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * tonal is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Benchmark the MusicXML pitch scanner.
+ *
+ *   $ make bench_musicxml
+ *   $ ./bench_musicxml [file.musicxml] [rounds]
+ *
+ * Without a file, a synthetic score of typical note markup is scanned.
+ */
+
+#define _POSIX_C_SOURCE 200112L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <tonal_musicxml.h>
+
+static const char NOTE[] =
+        "      <note default-x=\"112.47\" default-y=\"-35.00\">\n"
+        "        <pitch>\n"
+        "          <step>F</step>\n"
+        "          <alter>1</alter>\n"
+        "          <octave>4</octave>\n"
+        "          </pitch>\n"
+        "        <duration>2</duration>\n"
+        "        <voice>1</voice>\n"
+        "        <type>eighth</type>\n"
+        "        <accidental>sharp</accidental>\n"
+        "        <stem>up</stem>\n"
+        "        <beam number=\"1\">begin</beam>\n"
+        "        </note>\n";
+
+static char *synthesize(size_t notes, size_t *size)
+{
+        static const char HEAD[] =
+                "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+                "<score-partwise version=\"3.1\">\n"
+                "  <part-list><score-part id=\"P1\"/></part-list>\n"
+                "  <part id=\"P1\">\n";
+        static const char MEASURE[] = "    <measure number=\"1\">\n";
+        static const char MEASURE_END[] = "    </measure>\n";
+        static const char TAIL[] = "  </part>\n</score-partwise>\n";
+        size_t max = sizeof HEAD + sizeof TAIL +
+                notes * (sizeof NOTE + sizeof MEASURE + sizeof MEASURE_END);
+        char *doc = malloc(max);
+        char *p = doc;
+
+        if (NULL == doc) { return NULL; }
+        p += sprintf(p, "%s", HEAD);
+        for (size_t i = 0; i < notes; i++) {
+                if (0 == i % 8) { p += sprintf(p, "%s", MEASURE); }
+                p += sprintf(p, "%s", NOTE);
+                if (7 == i % 8) { p += sprintf(p, "%s", MEASURE_END); }
+        }
+        p += sprintf(p, "%s%s", MEASURE_END, TAIL);
+        *size = p - doc;
+        return doc;
+}
+
+static char *load(const char *path, size_t *size)
+{
+        FILE *f = fopen(path, "rb");
+        char *doc;
+        long n;
+
+        if (NULL == f) { return NULL; }
+        fseek(f, 0, SEEK_END);
+        n = ftell(f);
+        rewind(f);
+        doc = malloc(n > 0 ? n : 1);
+        if (doc && (size_t) n != fread(doc, 1, n, f)) {
+                free(doc);
+                doc = NULL;
+        }
+        fclose(f);
+        *size = n;
+        return doc;
+}
+
+static int count(const struct tonal_musicxml_note *note, void *arg)
+{
+        unsigned long *n = arg;
+
+        *n += TONAL_E_OK == note->error;
+        return TONAL_OK;
+}
+
+int main(int argc, char **argv)
+{
+        int rounds = argc > 2 ? atoi(argv[2]) : 20;
+        struct timespec t0, t1;
+        unsigned long notes = 0;
+        size_t size;
+        double s;
+        char *doc;
+
+        doc = argc > 1 ? load(argv[1], &size) : synthesize(200000, &size);
+        if (NULL == doc) {
+                fprintf(stderr, "could not load document\n");
+                return 1;
+        }
+
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        for (int r = 0; r < rounds; r++) {
+                if (TONAL_OK != tonal_musicxml_scan(doc, size, count, &notes)) {
+                        fprintf(stderr, "scan failed\n");
+                        return 1;
+                }
+        }
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+        s = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) * 1e-9;
+
+        printf(
+                "%zu bytes, %lu pitches  %8.1f MB/s  %6.1f ns/pitch\n",
+                size,
+                notes / rounds,
+                (double) size * rounds / s * 1e-6,
+                s * 1e9 / notes
+        );
+        free(doc);
+        return 0;
+}
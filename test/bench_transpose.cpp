@@ -0,0 +1,115 @@
+/*
+ * Copyright 2016 Martin Aberg
+ *
+ * This file is part of tonal.
+ *
+ * tonal is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * tonal is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Benchmark batch transposition: run time interval (tp_transpose_n) versus
+ * compile time interval (tonal::tp_transpose_n<TI>).
+ *
+ *   $ make bench_transpose
+ *   $ ./bench_transpose [npitches] [rounds]
+ *
+ * The specialized kernel vectorizes where the target has gather-free strided
+ * loads (x86-64 with AVX2), hence -march=native in the Makefile.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include <tonal.hpp>
+
+using namespace tonal;
+
+typedef int (*kernel)(
+        const tonal_pitch *tp,
+        tonal_pitch *tp_sum,
+        int *status,
+        std::size_t n
+);
+
+static const Interval *runtime_ti;
+
+static int runtime_kernel(
+        const tonal_pitch *tp,
+        tonal_pitch *tp_sum,
+        int *status,
+        std::size_t n
+)
+{
+        return ::tp_transpose_n(tp, runtime_ti, tp_sum, status, n);
+}
+
+static double run(
+        kernel k,
+        const std::vector<tonal_pitch> &tp,
+        std::vector<tonal_pitch> &tp_sum,
+        std::vector<int> &status,
+        int rounds
+)
+{
+        auto t0 = std::chrono::steady_clock::now();
+        for (int r = 0; r < rounds; r++) {
+                k(tp.data(), tp_sum.data(), status.data(), tp.size());
+        }
+        auto t1 = std::chrono::steady_clock::now();
+        std::chrono::duration<double, std::nano> ns = t1 - t0;
+        return ns.count() / ((double) rounds * tp.size());
+}
+
+template <const Interval &TI>
+static void bench(
+        const char *name,
+        const std::vector<tonal_pitch> &tp,
+        int rounds
+)
+{
+        std::vector<tonal_pitch> tp_sum(tp.size());
+        std::vector<int> status(tp.size());
+
+        runtime_ti = &TI;
+        double rt = run(runtime_kernel, tp, tp_sum, status, rounds);
+        double ct = run(tp_transpose_n<TI>, tp, tp_sum, status, rounds);
+        std::printf(
+                "%-4s  runtime %7.3f ns/pitch  specialized %7.3f ns/pitch"
+                "  speedup %5.2fx\n",
+                name, rt, ct, rt / ct
+        );
+}
+
+int main(int argc, char **argv)
+{
+        std::size_t n = argc > 1 ? std::strtoul(argv[1], NULL, 0) : 1 << 20;
+        int rounds = argc > 2 ? std::atoi(argv[2]) : 20;
+        std::vector<tonal_pitch> tp(n);
+
+        std::srand(1);
+        for (tonal_pitch &p : tp) {
+                p = Pitch(
+                        std::rand() % DP_NONE,
+                        PA_b + std::rand() % 3,
+                        1 + std::rand() % 7
+                );
+        }
+
+        bench<intervals::P8>("P8", tp, rounds);
+        bench<intervals::P5>("P5", tp, rounds);
+        bench<intervals::M3>("M3", tp, rounds);
+        return 0;
+}
@@ -0,0 +1,41 @@
+#!/bin/sh
+#
+# Check that tonal.c compiled with -DTONAL_USDT contains the USDT probes
+# used by tools/tonal.bt. Exits 77 (skipped) when sys/sdt.h is not
+# available.
+#
+#   $ make check_usdt
+
+CC=${CC:-cc}
+obj=$(mktemp) || exit 1
+trap 'rm -f "$obj"' EXIT
+
+if ! echo '#include <sys/sdt.h>' | $CC -E - >/dev/null 2>&1; then
+        echo "check_usdt: sys/sdt.h not found, skipped"
+        exit 77
+fi
+
+$CC -O2 -std=c99 -I../include -I.. -DTONAL_USDT -c ../tonal.c -o "$obj" ||
+        exit 1
+
+notes=$(readelf -n "$obj") || exit 1
+fail=0
+for fn in tp_add_n tp_transpose_n tp_sub_n tp_to_mnn_n; do
+        for probe in "${fn}_entry" "${fn}_return"; do
+                if ! echo "$notes" | grep -q "Name: $probe\$"; then
+                        echo "check_usdt: probe tonal:$probe missing"
+                        fail=1
+                fi
+        done
+done
+if ! echo "$notes" | grep -q "Name: fail\$"; then
+        echo "check_usdt: probe tonal:fail missing"
+        fail=1
+fi
+if ! echo "$notes" | grep -q "Provider: tonal"; then
+        echo "check_usdt: no probes with provider tonal"
+        fail=1
+fi
+
+[ 0 = "$fail" ] && echo "check_usdt: ok"
+exit $fail
@@ -420,6 +420,244 @@ static int test_tp_add2(void)
         return 0;
 }
 
+static int test_tp_sub(void)
+{
+        struct tonal_pitch tp0;
+        struct tonal_pitch tp1;
+        struct tonal_interval ti;
+
+        /* Cb4 - C4 is a downward augmented prime. */
+        vtest(TONAL_OK == tp_set(&tp0, DP_C, PA_b, 4));
+        vtest(TONAL_OK == tp_set(&tp1, DP_C, PA_, 4));
+        vtest(TONAL_OK == tp_sub(&tp0, &tp1, &ti));
+        vtest(ti.diatonic_interval == DI_PRIME);
+        vtest(ti.interval_alteration == IA_AUGMENTED);
+        vtest(ti.octave == 0);
+        vtest(ti.interval_direction == ID_DOWN);
+
+        /* The inverse of D##0 is not representable, the difference is. */
+        vtest(TONAL_OK == tp_set(&tp0, DP_D, PA_s, 1));
+        vtest(TONAL_OK == tp_set(&tp1, DP_D, PA_ss, 0));
+        vtest(TONAL_OK == tp_sub(&tp0, &tp1, &ti));
+        vtest(ti.diatonic_interval == DI_PRIME);
+        vtest(ti.interval_alteration == IA_DIMINISHED);
+        vtest(ti.octave == 1);
+        vtest(ti.interval_direction == ID_UP);
+
+        /* Pitches continue below octave 0. */
+        vtest(TONAL_OK == tp_set(&tp0, DP_C, PA_, 0));
+        vtest(TONAL_OK == ti_set(&ti, DI_SECOND, IA_MAJOR, 0, ID_DOWN));
+        vtest(TONAL_OK == tp_add(&tp0, &ti, &tp1));
+        vtest(tp1.diatonic_pitch == DP_B);
+        vtest(tp1.pitch_alteration == PA_b);
+        vtest(tp1.octave == -1);
+        vtest(tp_to_mnn(&tp1) == -2);
+        vtest(TONAL_OK == tp_sub(&tp0, &tp1, &ti));
+        vtest(ti.diatonic_interval == DI_SECOND);
+        vtest(ti.interval_alteration == IA_MAJOR);
+        vtest(ti.interval_direction == ID_UP);
+        return 0;
+}
+
+/* The batch operations agree with the scalar ones. */
+static int test_batch(void)
+{
+        enum { N = DP_NONE * PA_NONE * 3 };
+        struct tonal_pitch tp[N];
+        struct tonal_pitch tp_sum[N];
+        struct tonal_pitch tp_ref;
+        struct tonal_interval ti[N];
+        struct tonal_interval ti_ref;
+        int status[N];
+        int error;
+        int mnn[N];
+        int n;
+
+        n = 0;
+        for (int dp = DP_C; dp <= DP_B; dp++)
+        for (int pa = PA_bb; pa <= PA_ss; pa++)
+        for (int o = 0; o < 3; o++) {
+                vtest(TONAL_OK == tp_set(&tp[n], dp, pa, o));
+                vtest(TONAL_OK == ti_set(
+                        &ti[n],
+                        (dp + pa) % DI_NONE,
+                        pa % 2 ? IA_AUGMENTED : IA_DIMINISHED,
+                        o + 1,
+                        pa % 2 ? ID_DOWN : ID_UP
+                ));
+                n++;
+        }
+
+        vtest(TONAL_FAIL == tp_add_n(tp, ti, tp_sum, status, N));
+        for (int i = 0; i < N; i++) {
+                error = TONAL_E_OK;
+                tp_add_err(&tp[i], &ti[i], &tp_ref, &error);
+                vtest(status[i] == error);
+                if (TONAL_OK == status[i]) {
+                        vtest(0 == memcmp(&tp_sum[i], &tp_ref, sizeof tp_ref));
+                }
+        }
+
+        vtest(TONAL_FAIL == tp_transpose_n(tp, &ti[40], tp_sum, status, N));
+        for (int i = 0; i < N; i++) {
+                error = TONAL_E_OK;
+                tp_add_err(&tp[i], &ti[40], &tp_ref, &error);
+                vtest(status[i] == error);
+                if (TONAL_OK == status[i]) {
+                        vtest(0 == memcmp(&tp_sum[i], &tp_ref, sizeof tp_ref));
+                }
+        }
+
+        tp_sub_n(tp + 1, tp, ti, status, N - 1);
+        for (int i = 0; i < N - 1; i++) {
+                error = TONAL_E_OK;
+                tp_sub_err(&tp[i + 1], &tp[i], &ti_ref, &error);
+                vtest(status[i] == error);
+                if (TONAL_OK == status[i]) {
+                        vtest(0 == memcmp(&ti[i], &ti_ref, sizeof ti_ref));
+                }
+        }
+
+        tp[7].pitch_alteration = PA_NONE;
+        vtest(TONAL_FAIL == tp_to_mnn_n(tp, mnn, N));
+        for (int i = 0; i < N; i++) {
+                vtest(mnn[i] == tp_to_mnn(&tp[i]));
+        }
+
+        vtest(TONAL_OK == tp_add_n(NULL, NULL, NULL, NULL, 0));
+        vtest(TONAL_FAIL == tp_add_n(NULL, ti, tp_sum, NULL, 1));
+        vtest(TONAL_FAIL == tp_add_n(NULL, ti, tp_sum, status, 1));
+        vtest(TONAL_E_NULL == status[0]);
+        return 0;
+}
+
+static int test_octave(void)
+{
+        struct tonal_pitch tp;
+        struct tonal_pitch_class tpc;
+        char buf[16];
+        const char *end;
+
+        /* MNN 0 is C0 or C-1 depending on the convention. */
+        for (int mnn = -30; mnn < 140; mnn++) {
+                vtest(TONAL_OK == tp_from_mnn(&tp, mnn, OC_C5));
+                vtest(mnn == tp_to_mnn(&tp));
+                vtest(mnn == tp_to_mnn_oc(&tp, OC_C5));
+                vtest(TONAL_OK == tp_from_mnn(&tp, mnn, OC_C4));
+                vtest(mnn == tp_to_mnn_oc(&tp, OC_C4));
+                vtest(PA_ == tp.pitch_alteration || PA_s == tp.pitch_alteration);
+        }
+        vtest(TONAL_OK == tp_from_mnn(&tp, 0, OC_C4));
+        vtest(DP_C == tp.diatonic_pitch && PA_ == tp.pitch_alteration);
+        vtest(-1 == tp.octave);
+        vtest(TONAL_OK == tp_from_mnn(&tp, 60, OC_C4));
+        vtest(4 == tp.octave);
+        vtest(TONAL_OK == tp_from_mnn(&tp, 61, OC_C5));
+        vtest(DP_C == tp.diatonic_pitch && PA_s == tp.pitch_alteration);
+        vtest(5 == tp.octave);
+        vtest(TONAL_OK == tp_from_mnn(&tp, -1, OC_C5));
+        vtest(DP_B == tp.diatonic_pitch && -1 == tp.octave);
+        vtest(TONAL_FAIL == tp_from_mnn(&tp, 60, OC_NONE));
+        vtest(INT_MIN == tp_to_mnn_oc(&tp, OC_NONE));
+
+        /* Format and parse */
+        vtest(TONAL_OK == tp_set(&tp, DP_E, PA_bb, -1));
+        vtest(TONAL_OK == tp_snprint(buf, sizeof buf, &tp));
+        vtest(0 == strcmp(buf, "Ebb-1"));
+        vtest(TONAL_FAIL == tp_snprint(buf, 5, &tp));
+        vtest(TONAL_OK == tp_snprint(buf, 6, &tp));
+        vtest(TONAL_OK == tpc_snprint(buf, sizeof buf, (struct tonal_pitch_class *) &tp));
+        vtest(0 == strcmp(buf, "Ebb"));
+
+        vtest(TONAL_OK == tp_parse("F##12 ", &tp, &end));
+        vtest(DP_F == tp.diatonic_pitch && PA_ss == tp.pitch_alteration);
+        vtest(12 == tp.octave);
+        vtest(' ' == *end);
+        vtest(TONAL_OK == tp_parse("bb-2", &tp, NULL));
+        vtest(DP_B == tp.diatonic_pitch && PA_b == tp.pitch_alteration);
+        vtest(-2 == tp.octave);
+        vtest(TONAL_FAIL == tp_parse("H4", &tp, NULL));
+        vtest(TONAL_FAIL == tp_parse("C", &tp, NULL));
+        vtest(TONAL_FAIL == tp_parse("C-", &tp, NULL));
+        vtest(TONAL_FAIL == tp_parse("C###4", &tp, NULL));
+        vtest(TONAL_FAIL == tp_parse("C99999999999", &tp, NULL));
+        vtest(TONAL_OK == tpc_parse("Ab4", &tpc, &end));
+        vtest(DP_A == tpc.diatonic_pitch && PA_b == tpc.pitch_alteration);
+        vtest('4' == *end);
+
+        /* Round trip */
+        for (int dp = DP_C; dp < DP_NONE; dp++)
+        for (int pa = 0; pa < PA_NONE; pa++)
+        for (int o = -3; o < 12; o++) {
+                struct tonal_pitch tp1;
+
+                vtest(TONAL_OK == tp_set(&tp, dp, pa, o));
+                vtest(TONAL_OK == tp_snprint(buf, sizeof buf, &tp));
+                vtest(TONAL_OK == tp_parse(buf, &tp1, &end));
+                vtest('\0' == *end);
+                vtest(0 == memcmp(&tp, &tp1, sizeof tp));
+        }
+        return 0;
+}
+
+static int test_error(void)
+{
+        struct tonal_pitch tp;
+        struct tonal_pitch tp_sum;
+        struct tonal_interval ti;
+        struct tonal_interval ti_res;
+        int error;
+
+        /* Success leaves error untouched. */
+        error = -1;
+        tp_set(&tp, DP_C, PA_, 4);
+        ti_set(&ti, DI_FIFTH, IA_PERFECT, 0, ID_UP);
+        vtest(TONAL_OK == tp_add_err(&tp, &ti, &tp_sum, &error));
+        vtest(-1 == error);
+        vtest(TONAL_OK == tp_add_err(&tp, &ti, &tp_sum, NULL));
+
+        vtest(TONAL_FAIL == tp_add_err(NULL, &ti, &tp_sum, &error));
+        vtest(TONAL_E_NULL == error);
+        vtest(TONAL_FAIL == tp_add_err(&tp, &ti, NULL, &error));
+        vtest(TONAL_E_NULL == error);
+
+        tp.diatonic_pitch = DP_NONE;
+        vtest(TONAL_FAIL == tp_add_err(&tp, &ti, &tp_sum, &error));
+        vtest(TONAL_E_DIATONIC == error);
+        tp_set(&tp, DP_C, PA_, 4);
+        tp.pitch_alteration = PA_NONE;
+        vtest(TONAL_FAIL == tp_add_err(&tp, &ti, &tp_sum, &error));
+        vtest(TONAL_E_ALTERATION == error);
+        tp_set(&tp, DP_C, PA_, 4);
+        ti.octave = -1;
+        vtest(TONAL_FAIL == tp_add_err(&tp, &ti, &tp_sum, &error));
+        vtest(TONAL_E_OCTAVE == error);
+        ti.octave = 0;
+
+        ti.interval_alteration = IA_MAJOR;
+        vtest(TONAL_FAIL == tp_add_err(&tp, &ti, &tp_sum, &error));
+        vtest(TONAL_E_QUALITY == error);
+        ti_set(&ti, DI_FIFTH, IA_PERFECT, 0, ID_UP);
+        ti.interval_direction = ID_NONE;
+        vtest(TONAL_FAIL == ti_add_err(&ti, &ti, &ti_res, &error));
+        vtest(TONAL_E_DIRECTION == error);
+
+        /* Valid operands, result out of range */
+        tp_set(&tp, DP_E, PA_ss, 4);
+        ti_set(&ti, DI_PRIME, IA_AUGMENTED, 0, ID_UP);
+        vtest(TONAL_FAIL == tp_add_err(&tp, &ti, &tp_sum, &error));
+        vtest(TONAL_E_RANGE == error);
+        vtest(TONAL_FAIL == ti_add_err(&ti, &ti, &ti_res, &error));
+        vtest(TONAL_E_RANGE == error);
+        ti_set(&ti, DI_FOURTH, IA_AUGMENTED, 0, ID_UP);
+        ti_set(&ti_res, DI_FOURTH, IA_DIMINISHED, 0, ID_UP);
+        vtest(TONAL_FAIL == ti_sub_err(&ti, &ti_res, &ti_res, &error));
+        vtest(TONAL_E_RANGE == error);
+
+        vtest(0 == strcmp(tonal_error_str[TONAL_E_RANGE], "Result not representable"));
+        return 0;
+}
+
 int main(void)
 {
         test_dt_get_mpc_value();
@@ -453,6 +691,12 @@ int main(void)
         test_tp_add1();
         test_tp_add2();
 
+        test_tp_sub();
+
+        test_batch();
+        test_error();
+        test_octave();
+
         vtest_report();
         vtest_end();
 
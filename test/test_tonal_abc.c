@@ -0,0 +1,304 @@
+/*
+ * Copyright 2016 Martin Aberg
+ *
+ * This file is part of tonal.
+ *
+ * tonal is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * tonal is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Unit tests for the ABC reader */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <tonal_abc.h>
+#include <vtest.h>
+
+static const char BOOK[] =
+        "%abc-2.1\n"
+        "%%pagewidth 21cm\n"
+        "\n"
+        "X:1\n"
+        "T:Speed the Plough\n"
+        "M:4/4\n"
+        "L:1/8\n"
+        "K:G\n"
+        "GFf|^c c C c' =c c|\n"
+        "[F^f]f {g}_B,2 \"Am\"!trill!B z|] % end\n"
+        "\n"
+        "Free text with CDEF is not music.\n"
+        "\n"
+        "X:2\n"
+        "T:Dorian\n"
+        "K:D dor\r\n"
+        "F C [K:Bb] B E e|e ^^f __g|\n"
+        "K:C exp ^f\n"
+        "w:lyrics A B C\n"
+        "F G\n"
+        "\n"
+        "X:3\n"
+        "K:H\n"
+        "C\n"
+        "\n"
+        "X:4\n"
+        "K:Am\n"
+        "^/C E\n";
+
+struct notes {
+        struct tonal_abc_note note[64];
+        int n;
+};
+
+static int collect(const struct tonal_abc_note *note, void *arg)
+{
+        struct notes *notes = arg;
+
+        if (64 <= notes->n) { return TONAL_FAIL; }
+        notes->note[notes->n++] = *note;
+        return TONAL_OK;
+}
+
+static int is_pitch(const struct tonal_pitch *tp, int dp, int pa, int o)
+{
+        return dp == tp->diatonic_pitch &&
+                pa == tp->pitch_alteration &&
+                o == tp->octave;
+}
+
+static int test_scan(void)
+{
+        struct notes notes = { .n = 0 };
+        struct tonal_abc_note *n = notes.note;
+
+        /* Stops at the K: field of tune 3. */
+        vtest(TONAL_FAIL == tonal_abc_scan(
+                BOOK, sizeof BOOK - 1, OC_C4, collect, &notes
+        ));
+        vtest(25 == notes.n);
+
+        /* Key signature, and another octave */
+        vtest(is_pitch(&n[0].pitch, DP_G, PA_, 4));
+        vtest(0 == n[0].tune && 0 == n[0].bar && 9 == n[0].line);
+        vtest(is_pitch(&n[1].pitch, DP_F, PA_s, 4));
+        vtest(is_pitch(&n[2].pitch, DP_F, PA_s, 5));
+
+        /* Bar accidentals apply to the same octave only. */
+        vtest(is_pitch(&n[3].pitch, DP_C, PA_s, 5));
+        vtest(1 == n[3].bar);
+        vtest(is_pitch(&n[4].pitch, DP_C, PA_s, 5));
+        vtest(is_pitch(&n[5].pitch, DP_C, PA_, 4));
+        vtest(is_pitch(&n[6].pitch, DP_C, PA_, 6));
+        vtest(is_pitch(&n[7].pitch, DP_C, PA_, 5));
+        vtest(is_pitch(&n[8].pitch, DP_C, PA_, 5));
+
+        /* Chord, grace note, chord symbol and decoration */
+        vtest(is_pitch(&n[9].pitch, DP_F, PA_s, 4));
+        vtest(2 == n[9].bar && 0 == n[9].chord && 10 == n[9].line);
+        vtest(is_pitch(&n[10].pitch, DP_F, PA_s, 5));
+        vtest(1 == n[10].chord);
+        vtest(is_pitch(&n[11].pitch, DP_F, PA_s, 5));
+        vtest(0 == n[11].chord);
+        vtest(is_pitch(&n[12].pitch, DP_G, PA_, 5));
+        vtest(n[12].grace);
+        vtest(is_pitch(&n[13].pitch, DP_B, PA_b, 3));
+        vtest(!n[13].grace);
+        vtest(is_pitch(&n[14].pitch, DP_B, PA_, 4));
+
+        /* Modes, inline key change, double accidentals, explicit key */
+        vtest(is_pitch(&n[15].pitch, DP_F, PA_, 4));
+        vtest(1 == n[15].tune && 0 == n[15].bar && 17 == n[15].line);
+        vtest(is_pitch(&n[16].pitch, DP_C, PA_, 4));
+        vtest(is_pitch(&n[17].pitch, DP_B, PA_b, 4));
+        vtest(is_pitch(&n[18].pitch, DP_E, PA_b, 4));
+        vtest(is_pitch(&n[19].pitch, DP_E, PA_b, 5));
+        vtest(is_pitch(&n[20].pitch, DP_E, PA_b, 5));
+        vtest(1 == n[20].bar);
+        vtest(is_pitch(&n[21].pitch, DP_F, PA_ss, 5));
+        vtest(is_pitch(&n[22].pitch, DP_G, PA_bb, 5));
+        vtest(is_pitch(&n[23].pitch, DP_F, PA_s, 4));
+        vtest(is_pitch(&n[24].pitch, DP_G, PA_, 4));
+
+        /* Microtones */
+        notes.n = 0;
+        vtest(TONAL_OK == tonal_abc_scan(
+                strstr(BOOK, "X:4"), strlen(strstr(BOOK, "X:4")), OC_C5,
+                collect, &notes
+        ));
+        vtest(2 == notes.n);
+        vtest(TONAL_E_ALTERATION == n[0].error);
+        vtest(is_pitch(&n[1].pitch, DP_E, PA_, 5));
+
+        vtest(TONAL_FAIL == tonal_abc_scan(BOOK, 4, OC_NONE, collect, &notes));
+        vtest(TONAL_FAIL == tonal_abc_scan(BOOK, 4, OC_C4, NULL, &notes));
+        return 0;
+}
+
+static int test_keys(void)
+{
+        static const struct {
+                const char *abc;
+                int pa[DP_NONE];
+        } KEYS[] = {
+                { "X:1\nK:\nCDEFGAB\n", { PA_, PA_, PA_, PA_, PA_, PA_, PA_ } },
+                { "X:1\nK:Bb\nCDEFGAB\n", { PA_, PA_, PA_b, PA_, PA_, PA_, PA_b } },
+                { "X:1\nK:C#\nCDEFGAB\n", { PA_s, PA_s, PA_s, PA_s, PA_s, PA_s, PA_s } },
+                { "X:1\nK:Cb\nCDEFGAB\n", { PA_b, PA_b, PA_b, PA_b, PA_b, PA_b, PA_b } },
+                { "X:1\nK:C#lyd\nCDEFGAB\n", { PA_s, PA_s, PA_s, PA_ss, PA_s, PA_s, PA_s } },
+                { "X:1\nK:F#m\nCDEFGAB\n", { PA_s, PA_, PA_, PA_s, PA_s, PA_, PA_ } },
+                { "X:1\nK:E Phrygian\nCDEFGAB\n", { PA_, PA_, PA_, PA_, PA_, PA_, PA_ } },
+                { "X:1\nK:G Mix clef=bass\nCDEFGAB\n", { PA_, PA_, PA_, PA_, PA_, PA_, PA_ } },
+                { "X:1\nK:Ebloc\nCDEFGAB\n", { PA_b, PA_b, PA_b, PA_b, PA_b, PA_b, PA_bb } },
+                { "X:1\nK:Hp\nCDEFGAB\n", { PA_s, PA_, PA_, PA_s, PA_, PA_, PA_ } },
+                { "X:1\nK:D exp _b ^c\nCDEFGAB\n", { PA_s, PA_, PA_, PA_, PA_, PA_, PA_b } },
+                { "X:1\nK:^g\nCDEFGAB\n", { PA_, PA_, PA_, PA_, PA_s, PA_, PA_ } },
+        };
+
+        for (size_t k = 0; k < sizeof KEYS / sizeof KEYS[0]; k++) {
+                struct notes notes = { .n = 0 };
+
+                vtest(TONAL_OK == tonal_abc_scan(
+                        KEYS[k].abc, strlen(KEYS[k].abc), OC_C4, collect, &notes
+                ));
+                vtest(DP_NONE == notes.n);
+                for (int i = 0; i < notes.n; i++) {
+                        vtest(is_pitch(&notes.note[i].pitch, i, KEYS[k].pa[i], 4));
+                }
+        }
+        return 0;
+}
+
+static int same_book(
+        const struct tonal_abc_book *a,
+        const struct tonal_abc_book *b
+)
+{
+        if (a->ntunes != b->ntunes) { return 0; }
+        for (size_t i = 0; i < a->ntunes; i++) {
+                const struct tonal_abc_tune *ta = &a->tune[i];
+                const struct tonal_abc_tune *tb = &b->tune[i];
+
+                if (
+                        ta->x != tb->x ||
+                        ta->status != tb->status ||
+                        ta->n != tb->n ||
+                        (ta->n && 0 != memcmp(ta->pitch, tb->pitch, ta->n * sizeof *ta->pitch))
+                ) {
+                        return 0;
+                }
+        }
+        return 1;
+}
+
+static int test_book(void)
+{
+        struct tonal_abc_book book;
+        struct tonal_abc_book ref;
+        const struct tonal_abc_tune *t;
+
+        vtest(TONAL_FAIL == tonal_abc_read_book(BOOK, sizeof BOOK - 1, OC_C4, 1, &ref));
+        vtest(4 == ref.ntunes);
+        t = ref.tune;
+        vtest(1 == t[0].x);
+        vtest(16 == t[0].title_len);
+        vtest(0 == memcmp(t[0].title, "Speed the Plough", 16));
+        vtest(0 == memcmp(BOOK + t[0].offset, "X:1\n", 4));
+        vtest(TONAL_E_OK == t[0].status);
+        vtest(15 == t[0].n);
+        vtest(is_pitch(&t[0].pitch[14], DP_B, PA_, 4));
+        vtest(TONAL_E_OK == t[1].status);
+        vtest(10 == t[1].n);
+        vtest(TONAL_E_FAIL == t[2].status);
+        vtest(0 == t[2].n && NULL == t[2].title);
+        vtest(TONAL_E_ALTERATION == t[3].status);
+        vtest(4 == t[3].x);
+
+        for (int nthreads = 0; nthreads < 6; nthreads++) {
+                vtest(TONAL_FAIL == tonal_abc_read_book(
+                        BOOK, sizeof BOOK - 1, OC_C4, nthreads, &book
+                ));
+                vtest(same_book(&ref, &book));
+                tonal_abc_book_free(&book);
+        }
+        tonal_abc_book_free(&ref);
+        vtest(0 == ref.ntunes);
+
+        vtest(TONAL_OK == tonal_abc_read_book("", 0, OC_C4, 4, &book));
+        vtest(0 == book.ntunes);
+        tonal_abc_book_free(&book);
+        vtest(TONAL_FAIL == tonal_abc_read_book(BOOK, 4, OC_C4, -1, &book));
+        tonal_abc_book_free(&book);
+        return 0;
+}
+
+/* Many tunes, one thread against several */
+static int test_book_threads(void)
+{
+        static const char TUNE[] =
+                "X:%d\nT:Reel %d\nK:%s\n|:d2fd A2FA|dfed cAGF|=c2e^c dB_BA:|\n\n";
+        static const char *KEYS[] = { "D", "Gm", "Amix", "Bb", "E dor" };
+        enum { N = 2000 };
+        struct tonal_abc_book book;
+        struct tonal_abc_book ref;
+        struct tonal_arena arena;
+        size_t total = 0;
+        size_t size = 0;
+        char *doc;
+
+        doc = malloc(N * 100);
+        vtest(NULL != doc);
+        if (NULL == doc) { return 1; }
+        for (int i = 0; i < N; i++) {
+                size += sprintf(doc + size, TUNE, i + 1, i + 1, KEYS[i % 5]);
+        }
+
+        vtest(TONAL_OK == tonal_abc_read_book(doc, size, OC_C4, 1, &ref));
+        vtest(N == ref.ntunes);
+        vtest(N == ref.tune[N - 1].x);
+        vtest(21 == ref.tune[N - 1].n);
+        vtest(TONAL_OK == tonal_abc_read_book(doc, size, OC_C4, 4, &book));
+        vtest(same_book(&ref, &book));
+        tonal_abc_book_free(&book);
+
+        /* The same into an arena, reused for a second read */
+        vtest(TONAL_OK == tonal_arena_init(&arena, 0));
+        for (int round = 0; round < 2; round++) {
+                vtest(TONAL_OK == tonal_abc_read_book_arena(
+                        doc, size, OC_C4, 4, &arena, &book
+                ));
+                vtest(same_book(&ref, &book));
+                tonal_abc_book_free(&book);
+                tonal_arena_reset(&arena);
+                /* No new blocks the second time */
+                if (0 == round) { total = arena.total; }
+        }
+        vtest(0 < total && total == arena.total);
+        tonal_arena_free(&arena);
+        tonal_abc_book_free(&ref);
+        free(doc);
+        return 0;
+}
+
+int main(void)
+{
+        test_scan();
+        test_keys();
+        test_book();
+        test_book_threads();
+
+        vtest_report();
+        vtest_end();
+
+        return 0;
+}
@@ -0,0 +1,125 @@
+/*
+ * Copyright 2016 Martin Aberg
+ *
+ * This file is part of tonal.
+ *
+ * tonal is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * tonal is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Unit tests for the arena and the sequence builder */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <tonal_arena.h>
+#include <vtest.h>
+
+static int test_arena(void)
+{
+        struct tonal_arena a;
+        char *p;
+        char *q;
+        char *big;
+        size_t total;
+
+        vtest(TONAL_OK == tonal_arena_init(&a, 1024));
+        vtest(0 == a.total);
+
+        p = tonal_arena_alloc(&a, 3);
+        q = tonal_arena_alloc(&a, 8);
+        vtest(NULL != p && NULL != q);
+        vtest(0 == (uintptr_t) q % sizeof (void *));
+        vtest(1024 == a.total);
+        memset(q, 'x', 8);
+
+        /* The last allocation grows in place, others move. */
+        vtest(q == tonal_arena_realloc(&a, q, 8, 100));
+        vtest('x' == q[7]);
+        p = tonal_arena_realloc(&a, p, 3, 16);
+        vtest(NULL != p && p != q);
+
+        /* Large allocations get their own block. */
+        big = tonal_arena_alloc(&a, 4096);
+        vtest(NULL != big);
+        vtest(1024 + 4096 <= a.total);
+        memset(big, 0, 4096);
+        p = tonal_arena_alloc(&a, 8);
+        vtest(NULL != p);
+
+        /* A reset keeps the standard blocks only. */
+        tonal_arena_reset(&a);
+        total = a.total;
+        vtest(1024 == total);
+        for (int i = 0; i < 100; i++) {
+                p = tonal_arena_alloc(&a, 10);
+                vtest(NULL != p);
+        }
+        tonal_arena_reset(&a);
+        for (int i = 0; i < 100; i++) { tonal_arena_alloc(&a, 10); }
+        vtest(2 * 1024 == a.total);
+        tonal_arena_free(&a);
+        vtest(0 == a.total);
+
+        /* Without an arena, the heap */
+        p = tonal_arena_alloc(NULL, 10);
+        vtest(NULL != p);
+        p = tonal_arena_realloc(NULL, p, 10, 20);
+        vtest(NULL != p);
+        free(p);
+        return 0;
+}
+
+static int test_seq(void)
+{
+        struct tonal_pitch tp[100];
+        struct tonal_arena a;
+        struct tonal_seq s;
+        struct tonal_seq heap;
+
+        for (int i = 0; i < 100; i++) { tp_set(&tp[i], i % 7, PA_, i / 7); }
+
+        vtest(TONAL_OK == tonal_arena_init(&a, 0));
+        vtest(TONAL_OK == tonal_seq_init(&s, &a));
+        vtest(TONAL_OK == tonal_seq_init(&heap, NULL));
+        for (int i = 0; i < 1000; i++) {
+                vtest(TONAL_OK == tonal_seq_append(&s, &tp[i % 100], 1));
+                vtest(TONAL_OK == tonal_seq_append(&heap, tp, i % 3));
+        }
+        vtest(TONAL_OK == tonal_seq_append(&s, tp, 100));
+        vtest(1100 == s.n);
+        vtest(s.n <= s.max);
+        vtest(0 == memcmp(&s.pitch[1000], tp, sizeof tp));
+        vtest(0 == memcmp(&s.pitch[999], &tp[99], sizeof *tp));
+        vtest(999 == heap.n);
+        vtest(0 == memcmp(&heap.pitch[997], tp, 2 * sizeof *tp));
+        vtest(TONAL_FAIL == tonal_seq_append(&s, NULL, 1));
+        vtest(TONAL_OK == tonal_seq_append(&s, NULL, 0));
+        tonal_seq_free(&s);
+        tonal_seq_free(&heap);
+        vtest(0 == s.n && NULL == s.pitch);
+        tonal_arena_free(&a);
+        return 0;
+}
+
+int main(void)
+{
+        test_arena();
+        test_seq();
+
+        vtest_report();
+        vtest_end();
+
+        return 0;
+}
@@ -0,0 +1,195 @@
+/*
+ * Copyright 2016 Martin Aberg
+ *
+ * This file is part of tonal.
+ *
+ * tonal is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * tonal is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Unit tests for the analysis cache */
+
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <tonal_cache.h>
+#include <vtest.h>
+
+enum { KIND_KEY, KIND_CENSUS };
+
+static char path[] = "/tmp/test_tonal_cache.XXXXXX";
+
+static const struct tonal_pitch TUNE[] = {
+        { DP_D, PA_, 4 }, { DP_F, PA_s, 4 }, { DP_A, PA_, 4 },
+        { DP_D, PA_, 5 }, { DP_C, PA_s, 5 }, { DP_A, PA_, 4 },
+        { DP_B, PA_b, -1 },
+};
+
+static int is_value(struct tonal_cache *c, int kind, const struct tonal_pitch *tp, size_t n, const char *str)
+{
+        const void *value;
+        size_t size;
+
+        if (TONAL_OK != tonal_cache_get(c, kind, tp, n, &value, &size)) {
+                return 0;
+        }
+        return strlen(str) == size && 0 == memcmp(value, str, size);
+}
+
+static int test_hash(void)
+{
+        struct tonal_pitch tp[2];
+        uint64_t h0;
+        uint64_t h1;
+
+        vtest(TONAL_OK == tonal_cache_hash(TUNE, 7, &h0));
+        vtest(TONAL_OK == tonal_cache_hash(TUNE, 7, &h1));
+        vtest(h0 == h1);
+        vtest(TONAL_OK == tonal_cache_hash(TUNE, 6, &h1));
+        vtest(h0 != h1);
+        vtest(TONAL_OK == tonal_cache_hash(TUNE + 1, 6, &h1));
+        vtest(h0 != h1);
+        vtest(TONAL_OK == tonal_cache_hash(NULL, 0, &h1));
+        /* Files are shared between builds of any TONAL_ALTERATION_MAX. */
+        vtest(0x807454cdb781c62eULL == h0);
+
+        /* Enharmonics are different sequences. */
+        tp[0] = TUNE[1];
+        tp[1] = TUNE[1];
+        tp[1].diatonic_pitch = DP_G;
+        tp[1].pitch_alteration = PA_b;
+        vtest(TONAL_OK == tonal_cache_hash(&tp[0], 1, &h0));
+        vtest(TONAL_OK == tonal_cache_hash(&tp[1], 1, &h1));
+        vtest(h0 != h1);
+
+        tp[0].pitch_alteration = PA_NONE;
+        vtest(TONAL_FAIL == tonal_cache_hash(tp, 1, &h0));
+        tp[0] = TUNE[0];
+        tp[0].octave = 1 << 20;
+        vtest(TONAL_FAIL == tonal_cache_hash(tp, 1, &h0));
+        vtest(TONAL_FAIL == tonal_cache_hash(NULL, 1, &h0));
+        return 0;
+}
+
+static int test_store(void)
+{
+        struct tonal_cache c0;
+        struct tonal_cache c1;
+        struct tonal_pitch tp;
+        const void *value;
+        size_t size;
+        char buf[32];
+
+        vtest(TONAL_OK == tonal_cache_open(&c0, path));
+        vtest(TONAL_FAIL == tonal_cache_get(&c0, KIND_KEY, TUNE, 7, &value, &size));
+        vtest(TONAL_OK == tonal_cache_put(&c0, KIND_KEY, TUNE, 7, "D major", 7));
+        vtest(is_value(&c0, KIND_KEY, TUNE, 7, "D major"));
+        /* Kind and sequence are both part of the key. */
+        vtest(!is_value(&c0, KIND_CENSUS, TUNE, 7, "D major"));
+        vtest(!is_value(&c0, KIND_KEY, TUNE, 6, "D major"));
+        vtest(TONAL_OK == tonal_cache_put(&c0, KIND_CENSUS, TUNE, 7, "3-11B", 5));
+        vtest(TONAL_OK == tonal_cache_put(&c0, KIND_KEY, TUNE, 6, "", 0));
+        vtest(is_value(&c0, KIND_KEY, TUNE, 6, ""));
+        vtest(TONAL_OK == tonal_cache_put(&c0, KIND_KEY, NULL, 0, "none", 4));
+        vtest(is_value(&c0, KIND_KEY, NULL, 0, "none"));
+
+        /* The first value stays. */
+        vtest(TONAL_OK == tonal_cache_put(&c0, KIND_KEY, TUNE, 7, "B minor", 7));
+        vtest(is_value(&c0, KIND_KEY, TUNE, 7, "D major"));
+
+        /* A second reader sees what the first appends. */
+        vtest(TONAL_OK == tonal_cache_open(&c1, path));
+        vtest(is_value(&c1, KIND_CENSUS, TUNE, 7, "3-11B"));
+        tp = TUNE[0];
+        vtest(!is_value(&c1, KIND_KEY, &tp, 1, "D"));
+        vtest(TONAL_OK == tonal_cache_put(&c0, KIND_KEY, &tp, 1, "D", 1));
+        vtest(is_value(&c1, KIND_KEY, &tp, 1, "D"));
+        vtest(TONAL_OK == tonal_cache_put(&c1, KIND_KEY, &tp, 1, "d", 1));
+        vtest(is_value(&c1, KIND_KEY, &tp, 1, "D"));
+        tonal_cache_close(&c1);
+
+        /* Many records grow the index. */
+        for (int i = 0; i < 3000; i++) {
+                tp.octave = i;
+                snprintf(buf, sizeof buf, "%d", i);
+                if (TONAL_OK != tonal_cache_put(&c0, KIND_KEY, &tp, 1, buf, strlen(buf))) {
+                        break;
+                }
+        }
+        tp.octave = 2999;
+        vtest(is_value(&c0, KIND_KEY, &tp, 1, "2999"));
+        tonal_cache_close(&c0);
+
+        /* And it is all there when opened again. */
+        vtest(TONAL_OK == tonal_cache_open(&c0, path));
+        vtest(is_value(&c0, KIND_KEY, TUNE, 7, "D major"));
+        tp.octave = 1234;
+        vtest(is_value(&c0, KIND_KEY, &tp, 1, "1234"));
+        tp.pitch_alteration = PA_NONE;
+        vtest(TONAL_FAIL == tonal_cache_put(&c0, KIND_KEY, &tp, 1, "x", 1));
+        tonal_cache_close(&c0);
+        return 0;
+}
+
+/* A writer which died mid-record leaves a tail which is written over. */
+static int test_torn(void)
+{
+        static const char GARBAGE[] = "TNCR\0\0\0\0 half a record";
+        struct tonal_cache c;
+        FILE *f;
+
+        f = fopen(path, "ab");
+        vtest(NULL != f);
+        fwrite(GARBAGE, 1, sizeof GARBAGE, f);
+        fclose(f);
+
+        vtest(TONAL_OK == tonal_cache_open(&c, path));
+        vtest(is_value(&c, KIND_KEY, TUNE, 7, "D major"));
+        vtest(!is_value(&c, KIND_KEY, TUNE, 3, "after"));
+        vtest(TONAL_OK == tonal_cache_put(&c, KIND_KEY, TUNE, 3, "after", 5));
+        tonal_cache_close(&c);
+
+        vtest(TONAL_OK == tonal_cache_open(&c, path));
+        vtest(is_value(&c, KIND_KEY, TUNE, 3, "after"));
+        tonal_cache_close(&c);
+
+        /* Not a cache file */
+        f = fopen(path, "wb");
+        fputs("not a cache file", f);
+        fclose(f);
+        vtest(TONAL_FAIL == tonal_cache_open(&c, path));
+        tonal_cache_close(&c);
+        return 0;
+}
+
+int main(void)
+{
+        int fd;
+
+        fd = mkstemp(path);
+        if (fd < 0) { return 1; }
+        close(fd);
+
+        test_hash();
+        test_store();
+        test_torn();
+        unlink(path);
+
+        vtest_report();
+        vtest_end();
+
+        return 0;
+}
@@ -0,0 +1,239 @@
+/*
+ * Copyright 2016 Martin Aberg
+ *
+ * This file is part of tonal.
+ *
+ * tonal is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * tonal is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Unit tests for consonance scoring */
+
+#include <math.h>
+
+#include <tonal_consonance.h>
+#include <tonal_interval.h>
+#include <vtest.h>
+
+static int near(double a, double b)
+{
+        return fabs(a - b) < 1e-9;
+}
+
+static int test_table(void)
+{
+        struct tonal_consonance c;
+        struct tonal_interval_class tic;
+        double score;
+        double scores[TONAL_TIC_ID_COUNT];
+        int id;
+
+        vtest(TONAL_OK == tonal_consonance_init(&c, TONAL_CONSONANCE_TABLE));
+        tic_set(&tic, DI_THIRD, IA_MAJOR);
+        vtest(TONAL_OK == tonal_consonance_get(&c, &tic, &score) && 0.2 == score);
+        tic_set(&tic, DI_FOURTH, IA_DIMINISHED);
+        vtest(TONAL_OK == tonal_consonance_get(&c, &tic, &score) && 0.9 == score);
+        tic_set(&tic, DI_PRIME, IA_PERFECT);
+        vtest(TONAL_OK == tonal_consonance_get(&c, &tic, &score) && 0.0 == score);
+
+        vtest(TONAL_OK == tonal_consonance_set(&c, &tic, 0.5));
+        vtest(TONAL_OK == tonal_consonance_get(&c, &tic, &score) && 0.5 == score);
+        tic.interval_alteration = IA_MAJOR;
+        vtest(TONAL_FAIL == tonal_consonance_set(&c, &tic, 0.5));
+        vtest(TONAL_FAIL == tonal_consonance_get(&c, &tic, &score));
+        vtest(TONAL_FAIL == tonal_consonance_init(&c, TONAL_CONSONANCE_NONE));
+        vtest(TONAL_FAIL == tonal_consonance_init(NULL, TONAL_CONSONANCE_TABLE));
+
+        /* A table by id, each interval class scoring its id */
+        for (id = 0; id < TONAL_TIC_ID_COUNT; id++) { scores[id] = id; }
+        vtest(TONAL_OK == tonal_consonance_load(&c, scores));
+        for (id = 0; id < TONAL_TIC_ID_COUNT; id++) {
+                if (TONAL_OK != id_to_tic(id, &tic)) { continue; }
+                vtest(TONAL_OK == tonal_consonance_get(&c, &tic, &score));
+                vtest(id == score);
+        }
+        vtest(TONAL_FAIL == tonal_consonance_load(&c, NULL));
+        return 0;
+}
+
+static int test_pair(void)
+{
+        struct tonal_consonance c;
+        struct tonal_pitch tp0, tp1;
+        struct tonal_interval ti;
+        struct tonal_interval_class tic;
+        double score, expected;
+        int ret;
+
+        tonal_consonance_init(&c, TONAL_CONSONANCE_TABLE);
+        tp_set(&tp0, DP_C, PA_, 4);
+        tp_set(&tp1, DP_E, PA_, 4);
+        vtest(TONAL_OK == tonal_consonance_pair(&c, &tp0, &tp1, &score) && 0.2 == score);
+        vtest(TONAL_OK == tonal_consonance_pair(&c, &tp1, &tp0, &score) && 0.2 == score);
+        tp_set(&tp1, DP_F, PA_b, 4);
+        vtest(TONAL_OK == tonal_consonance_pair(&c, &tp0, &tp1, &score) && 0.9 == score);
+        tp_set(&tp1, DP_E, PA_, 6);
+        vtest(TONAL_OK == tonal_consonance_pair(&c, &tp0, &tp1, &score) && 0.2 == score);
+        tp_set(&tp1, DP_B, PA_, 3);
+        vtest(TONAL_OK == tonal_consonance_pair(&c, &tp0, &tp1, &score) && 1.0 == score);
+
+        /* Augmented seventh with four sharps */
+        tp_set(&tp0, DP_C, PA_bb, 4);
+        tp_set(&tp1, DP_B, PA_ss, 4);
+        vtest(TONAL_FAIL == tonal_consonance_pair(&c, &tp0, &tp1, &score));
+        tp1.pitch_alteration = PA_NONE;
+        vtest(TONAL_FAIL == tonal_consonance_pair(&c, &tp0, &tp1, &score));
+        vtest(TONAL_FAIL == tonal_consonance_pair(&c, &tp0, NULL, &score));
+
+        /* The interval class of tp_sub, spelled and taken upwards */
+        for (int dp0 = DP_C; dp0 <= DP_B; dp0++) {
+        for (int pa0 = 0; pa0 < PA_NONE; pa0++) {
+        for (int dp1 = DP_C; dp1 <= DP_B; dp1++) {
+        for (int pa1 = 0; pa1 < PA_NONE; pa1++) {
+        for (int o1 = 3; o1 <= 5; o1++) {
+                tp_set(&tp0, dp0, pa0, 4);
+                tp_set(&tp1, dp1, pa1, o1);
+                ret = tonal_consonance_pair(&c, &tp0, &tp1, &score);
+                if (TONAL_OK != tp_sub(&tp1, &tp0, &ti)) {
+                        vtest(TONAL_FAIL == ret);
+                        continue;
+                }
+                vtest(TONAL_OK == ret);
+                tic_set(&tic, ti.diatonic_interval, ti.interval_alteration);
+                vtest(TONAL_OK == tonal_consonance_get(&c, &tic, &expected));
+                vtest(expected == score);
+        }
+        }
+        }
+        }
+        }
+        return 0;
+}
+
+static int test_roughness(void)
+{
+        struct tonal_consonance c;
+        struct tonal_pitch tp0, tp1;
+        double hz;
+        double m2, M3, P5, P1, d4;
+
+        tp_set(&tp0, DP_A, PA_, 5);
+        vtest(TONAL_OK == tp_to_hz(&tp0, OC_C5, &hz) && near(440.0, hz));
+        tp_set(&tp0, DP_A, PA_, 4);
+        vtest(TONAL_OK == tp_to_hz(&tp0, OC_C4, &hz) && near(440.0, hz));
+        tp_set(&tp0, DP_C, PA_, 4);
+        vtest(TONAL_OK == tp_to_hz(&tp0, OC_C4, &hz) && fabs(hz - 261.6256) < 1e-4);
+        vtest(TONAL_FAIL == tp_to_hz(&tp0, OC_NONE, &hz));
+        vtest(TONAL_FAIL == tp_to_hz(&tp0, OC_C4, NULL));
+
+        vtest(TONAL_OK == tonal_consonance_init(&c, TONAL_CONSONANCE_ROUGHNESS));
+        c.oc = OC_C4;
+        tp_set(&tp1, DP_C, PA_, 4);
+        vtest(TONAL_OK == tonal_consonance_pair(&c, &tp0, &tp1, &P1));
+        tp_set(&tp1, DP_D, PA_b, 4);
+        vtest(TONAL_OK == tonal_consonance_pair(&c, &tp0, &tp1, &m2));
+        tp_set(&tp1, DP_E, PA_, 4);
+        vtest(TONAL_OK == tonal_consonance_pair(&c, &tp0, &tp1, &M3));
+        tp_set(&tp1, DP_F, PA_b, 4);
+        vtest(TONAL_OK == tonal_consonance_pair(&c, &tp0, &tp1, &d4));
+        tp_set(&tp1, DP_G, PA_, 4);
+        vtest(TONAL_OK == tonal_consonance_pair(&c, &tp0, &tp1, &P5));
+        vtest(P1 < P5 && P5 < M3 && M3 < m2);
+        vtest(near(M3, d4));
+
+        c.partials = 0;
+        vtest(TONAL_FAIL == tonal_consonance_pair(&c, &tp0, &tp1, &P5));
+        return 0;
+}
+
+#define N 150
+
+static int test_batch(void)
+{
+        struct tonal_consonance c;
+        struct tonal_pitch v0[N], v1[N], v2[N];
+        const struct tonal_pitch *pitch[3] = { v0, v1, v2 };
+        const struct tonal_pitch *many[TONAL_CONSONANCE_VOICES_MAX + 1];
+        double score[N];
+        int status[N];
+        double x, sum;
+
+        /* C major triads, every third one with the fifth silent */
+        for (int i = 0; i < N; i++) {
+                tp_set(&v0[i], DP_C, PA_, 3);
+                tp_set(&v1[i], DP_E, PA_, 4);
+                tp_set(&v2[i], DP_G, PA_, 4);
+                if (0 == i % 3) { v2[i].pitch_alteration = PA_NONE; }
+        }
+        tp_set(&v1[100], DP_F, PA_b, 4);
+
+        for (int model = 0; model < TONAL_CONSONANCE_NONE; model++) {
+                tonal_consonance_init(&c, model);
+                vtest(TONAL_OK == tonal_consonance_n(&c, pitch, 3, score, status, N));
+                for (int i = 0; i < N; i++) {
+                        vtest(TONAL_E_OK == status[i]);
+                        tonal_consonance_pair(&c, &v0[i], &v1[i], &sum);
+                        if (PA_NONE != v2[i].pitch_alteration) {
+                                tonal_consonance_pair(&c, &v0[i], &v2[i], &x);
+                                sum += x;
+                                tonal_consonance_pair(&c, &v1[i], &v2[i], &x);
+                                sum += x;
+                        }
+                        vtest(near(sum, score[i]));
+                }
+        }
+
+        tonal_consonance_init(&c, TONAL_CONSONANCE_TABLE);
+        vtest(TONAL_OK == tonal_consonance_n(&c, pitch, 3, score, status, N));
+        vtest(near(0.2 + 0.1 + 0.2, score[1]));
+        vtest(near(0.9 + 0.1 + 0.8, score[100]));
+        vtest(near(0.2, score[0]));
+
+        /* One voice, nothing sounds together. */
+        vtest(TONAL_OK == tonal_consonance_n(&c, pitch, 1, score, status, N));
+        vtest(0.0 == score[5]);
+
+        v1[70].diatonic_pitch = DP_B + 1;
+        tp_set(&v0[71], DP_C, PA_bb, 4);
+        tp_set(&v1[71], DP_B, PA_ss, 4);
+        vtest(TONAL_FAIL == tonal_consonance_n(&c, pitch, 3, score, status, N));
+        vtest(TONAL_E_DIATONIC == status[70]);
+        vtest(TONAL_E_RANGE == status[71]);
+        vtest(TONAL_E_OK == status[72] && TONAL_E_OK == status[69]);
+        vtest(TONAL_FAIL == tonal_consonance_n(&c, pitch, 3, score, NULL, N));
+
+        vtest(TONAL_OK == tonal_consonance_n(&c, pitch, 3, score, status, 0));
+        vtest(TONAL_FAIL == tonal_consonance_n(&c, NULL, 3, score, status, 2));
+        vtest(TONAL_E_NULL == status[0] && TONAL_E_NULL == status[1]);
+        pitch[1] = NULL;
+        vtest(TONAL_FAIL == tonal_consonance_n(&c, pitch, 3, score, status, 2));
+        vtest(TONAL_E_NULL == status[1]);
+        for (int v = 0; v <= TONAL_CONSONANCE_VOICES_MAX; v++) { many[v] = v0; }
+        vtest(TONAL_FAIL == tonal_consonance_n(&c, many, TONAL_CONSONANCE_VOICES_MAX + 1, score, status, 2));
+        vtest(TONAL_OK == tonal_consonance_n(&c, many, TONAL_CONSONANCE_VOICES_MAX, score, status, 2));
+        vtest(0.0 == score[1]);
+        return 0;
+}
+
+int main(void)
+{
+        test_table();
+        test_pair();
+        test_roughness();
+        test_batch();
+
+        vtest_report();
+        vtest_end();
+
+        return 0;
+}
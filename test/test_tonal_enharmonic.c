@@ -0,0 +1,338 @@
+/*
+ * Copyright 2016 Martin Aberg
+ *
+ * This file is part of tonal.
+ *
+ * tonal is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * tonal is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Unit tests for enharmonic equality, spellings and respelling */
+
+#include <stdlib.h>
+
+#include <tonal_enharmonic.h>
+#include <vtest.h>
+
+static int test_equal(void)
+{
+        struct tonal_pitch_class tpc0, tpc1;
+        struct tonal_pitch tp0, tp1;
+        struct tonal_interval_class tic0, tic1;
+        struct tonal_interval ti0, ti1;
+        int eq;
+
+        tpc_set(&tpc0, DP_C, PA_s);
+        tpc_set(&tpc1, DP_D, PA_b);
+        vtest(TONAL_OK == tpc_enh_equal(&tpc0, &tpc1, &eq) && 1 == eq);
+        tpc_set(&tpc1, DP_D, PA_);
+        vtest(TONAL_OK == tpc_enh_equal(&tpc0, &tpc1, &eq) && 0 == eq);
+        tpc_set(&tpc0, DP_B, PA_s);
+        tpc_set(&tpc1, DP_C, PA_);
+        vtest(TONAL_OK == tpc_enh_equal(&tpc0, &tpc1, &eq) && 1 == eq);
+        tpc1.pitch_alteration = PA_NONE;
+        vtest(TONAL_FAIL == tpc_enh_equal(&tpc0, &tpc1, &eq));
+        vtest(TONAL_FAIL == tpc_enh_equal(&tpc0, &tpc0, NULL));
+
+        /* B#4 is C5, not C4. */
+        tp_set(&tp0, DP_B, PA_s, 4);
+        tp_set(&tp1, DP_C, PA_, 5);
+        vtest(TONAL_OK == tp_enh_equal(&tp0, &tp1, &eq) && 1 == eq);
+        tp1.octave = 4;
+        vtest(TONAL_OK == tp_enh_equal(&tp0, &tp1, &eq) && 0 == eq);
+        tp_set(&tp0, DP_A, PA_bb, -1);
+        tp_set(&tp1, DP_G, PA_, -1);
+        vtest(TONAL_OK == tp_enh_equal(&tp0, &tp1, &eq) && 1 == eq);
+        vtest(TONAL_FAIL == tp_enh_equal(NULL, &tp1, &eq));
+
+        tic_set(&tic0, DI_FOURTH, IA_AUGMENTED);
+        tic_set(&tic1, DI_FIFTH, IA_DIMINISHED);
+        vtest(TONAL_OK == tic_enh_equal(&tic0, &tic1, &eq) && 1 == eq);
+        tic_set(&tic1, DI_FIFTH, IA_PERFECT);
+        vtest(TONAL_OK == tic_enh_equal(&tic0, &tic1, &eq) && 0 == eq);
+        tic_set(&tic0, DI_PRIME, IA_PERFECT);
+        tic_set(&tic1, DI_SEVENTH, IA_AUGMENTED);
+        vtest(TONAL_OK == tic_enh_equal(&tic0, &tic1, &eq) && 1 == eq);
+        tic1.interval_alteration = IA_PERFECT;
+        vtest(TONAL_FAIL == tic_enh_equal(&tic0, &tic1, &eq));
+
+        /* Direction counts for intervals. */
+        ti_set(&ti0, DI_FOURTH, IA_AUGMENTED, 0, ID_UP);
+        ti_set(&ti1, DI_FIFTH, IA_DIMINISHED, 0, ID_UP);
+        vtest(TONAL_OK == ti_enh_equal(&ti0, &ti1, &eq) && 1 == eq);
+        ti1.interval_direction = ID_DOWN;
+        vtest(TONAL_OK == ti_enh_equal(&ti0, &ti1, &eq) && 0 == eq);
+        ti_set(&ti0, DI_PRIME, IA_PERFECT, 1, ID_DOWN);
+        ti_set(&ti1, DI_SECOND, IA_DIMINISHED, 1, ID_DOWN);
+        vtest(TONAL_OK == ti_enh_equal(&ti0, &ti1, &eq) && 1 == eq);
+        ti1.octave = -1;
+        vtest(TONAL_FAIL == ti_enh_equal(&ti0, &ti1, &eq));
+        return 0;
+}
+
+static int test_spellings(void)
+{
+        struct tonal_pitch_class tpc;
+        struct tonal_pitch_class tpcs[TONAL_SPELLINGS_MAX];
+        struct tonal_pitch tp;
+        struct tonal_pitch tps[TONAL_SPELLINGS_MAX];
+        struct tonal_interval_class tic;
+        struct tonal_interval_class tics[TONAL_SPELLINGS_MAX];
+        struct tonal_interval ti;
+        struct tonal_interval tis[TONAL_SPELLINGS_MAX];
+        size_t n;
+
+        /* Plainest first */
+        tpc_set(&tpc, DP_D, PA_bb);
+        vtest(TONAL_OK == tpc_enh_spellings(&tpc, tpcs, &n));
+        vtest(3 == n);
+        vtest(DP_C == tpcs[0].diatonic_pitch && PA_ == tpcs[0].pitch_alteration);
+        vtest(DP_B == tpcs[1].diatonic_pitch && PA_s == tpcs[1].pitch_alteration);
+        vtest(DP_D == tpcs[2].diatonic_pitch && PA_bb == tpcs[2].pitch_alteration);
+
+        tpc_set(&tpc, DP_A, PA_b);
+        vtest(TONAL_OK == tpc_enh_spellings(&tpc, tpcs, &n));
+        vtest(2 == n);
+        vtest(DP_G == tpcs[0].diatonic_pitch && PA_s == tpcs[0].pitch_alteration);
+        vtest(DP_A == tpcs[1].diatonic_pitch && PA_b == tpcs[1].pitch_alteration);
+
+        tp_set(&tp, DP_C, PA_, 5);
+        vtest(TONAL_OK == tp_enh_spellings(&tp, tps, &n));
+        vtest(3 == n);
+        vtest(DP_C == tps[0].diatonic_pitch && 5 == tps[0].octave);
+        vtest(DP_B == tps[1].diatonic_pitch && PA_s == tps[1].pitch_alteration);
+        vtest(4 == tps[1].octave);
+        vtest(DP_D == tps[2].diatonic_pitch && 5 == tps[2].octave);
+        vtest(TONAL_FAIL == tp_enh_spellings(&tp, NULL, &n));
+        vtest(TONAL_FAIL == tp_enh_spellings(&tp, tps, NULL));
+
+        /* Not every alteration makes an interval. */
+        tic_set(&tic, DI_FOURTH, IA_AUGMENTED);
+        vtest(TONAL_OK == tic_enh_spellings(&tic, tics, &n));
+        vtest(2 == n);
+        vtest(DI_FOURTH == tics[0].diatonic_interval);
+        vtest(IA_AUGMENTED == tics[0].interval_alteration);
+        vtest(DI_FIFTH == tics[1].diatonic_interval);
+        vtest(IA_DIMINISHED == tics[1].interval_alteration);
+
+        tic_set(&tic, DI_PRIME, IA_PERFECT);
+        vtest(TONAL_OK == tic_enh_spellings(&tic, tics, &n));
+        vtest(3 == n);
+        vtest(DI_PRIME == tics[0].diatonic_interval);
+        vtest(DI_SEVENTH == tics[1].diatonic_interval);
+        vtest(IA_AUGMENTED == tics[1].interval_alteration);
+        vtest(DI_SECOND == tics[2].diatonic_interval);
+        vtest(IA_DIMINISHED == tics[2].interval_alteration);
+
+        /* Unison: also diminished seconds both ways */
+        ti_set(&ti, DI_PRIME, IA_PERFECT, 0, ID_UP);
+        vtest(TONAL_OK == ti_enh_spellings(&ti, tis, &n));
+        vtest(3 == n);
+        vtest(DI_PRIME == tis[0].diatonic_interval);
+        for (size_t i = 1; i < n; i++) {
+                vtest(DI_SECOND == tis[i].diatonic_interval);
+                vtest(IA_DIMINISHED == tis[i].interval_alteration);
+                vtest(0 == tis[i].octave);
+        }
+        vtest(tis[1].interval_direction != tis[2].interval_direction);
+
+        ti_set(&ti, DI_FOURTH, IA_AUGMENTED, 1, ID_DOWN);
+        vtest(TONAL_OK == ti_enh_spellings(&ti, tis, &n));
+        vtest(2 == n);
+        vtest(DI_FIFTH == tis[0].diatonic_interval || DI_FIFTH == tis[1].diatonic_interval);
+        for (size_t i = 0; i < n; i++) {
+                vtest(1 == tis[i].octave);
+                vtest(ID_DOWN == tis[i].interval_direction);
+        }
+        return 0;
+}
+
+/* Spellings against trying every pitch near tp */
+static int test_spellings_all(void)
+{
+        struct tonal_pitch tp;
+        struct tonal_pitch other;
+        struct tonal_pitch tps[TONAL_SPELLINGS_MAX];
+        size_t n;
+        size_t count;
+        int mnn;
+        int eq;
+
+        for (int dp = DP_C; dp <= DP_B; dp++) {
+                for (int pa = 0; pa < PA_NONE; pa++) {
+                        tp_set(&tp, dp, pa, 4);
+                        mnn = tp_to_mnn(&tp);
+                        count = 0;
+                        for (int dp1 = DP_C; dp1 <= DP_B; dp1++) {
+                                for (int pa1 = 0; pa1 < PA_NONE; pa1++) {
+                                        for (int o = 2; o <= 6; o++) {
+                                                tp_set(&other, dp1, pa1, o);
+                                                count += mnn == tp_to_mnn(&other);
+                                        }
+                                }
+                        }
+                        vtest(TONAL_OK == tp_enh_spellings(&tp, tps, &n));
+                        vtest(count == n);
+                        for (size_t i = 0; i < n; i++) {
+                                vtest(mnn == tp_to_mnn(&tps[i]));
+                                vtest(TONAL_OK == tp_enh_equal(&tp, &tps[i], &eq) && eq);
+                                if (0 < i) {
+                                        vtest(
+                                                abs(tps[i - 1].pitch_alteration - PA_) <=
+                                                abs(tps[i].pitch_alteration - PA_)
+                                        );
+                                }
+                        }
+                }
+        }
+        return 0;
+}
+
+static int test_respell(void)
+{
+        struct tonal_pitch_class tpc;
+        struct tonal_pitch tp;
+        struct tonal_interval_class tic;
+        struct tonal_interval ti;
+
+        tpc_set(&tpc, DP_D, PA_b);
+        vtest(TONAL_OK == tpc_enh_respell(&tpc, DP_C, &tpc));
+        vtest(DP_C == tpc.diatonic_pitch && PA_s == tpc.pitch_alteration);
+        vtest(TONAL_FAIL == tpc_enh_respell(&tpc, DP_E, &tpc));
+        vtest(TONAL_FAIL == tpc_enh_respell(&tpc, DP_NONE, &tpc));
+
+        tp_set(&tp, DP_C, PA_, 5);
+        vtest(TONAL_OK == tp_enh_respell(&tp, DP_B, &tp));
+        vtest(DP_B == tp.diatonic_pitch && PA_s == tp.pitch_alteration);
+        vtest(4 == tp.octave);
+        vtest(TONAL_OK == tp_enh_respell(&tp, DP_D, &tp));
+        vtest(DP_D == tp.diatonic_pitch && PA_bb == tp.pitch_alteration);
+        vtest(5 == tp.octave);
+        vtest(TONAL_FAIL == tp_enh_respell(&tp, DP_F, &tp));
+
+        tic_set(&tic, DI_FOURTH, IA_AUGMENTED);
+        vtest(TONAL_OK == tic_enh_respell(&tic, DI_FIFTH, &tic));
+        vtest(DI_FIFTH == tic.diatonic_interval);
+        vtest(IA_DIMINISHED == tic.interval_alteration);
+        tic_set(&tic, DI_THIRD, IA_MAJOR);
+        vtest(TONAL_OK == tic_enh_respell(&tic, DI_FOURTH, &tic));
+        vtest(IA_DIMINISHED == tic.interval_alteration);
+        /* A doubly augmented second would be needed. */
+        vtest(TONAL_FAIL == tic_enh_respell(&tic, DI_SECOND, &tic));
+
+        ti_set(&ti, DI_FOURTH, IA_AUGMENTED, 1, ID_UP);
+        vtest(TONAL_OK == ti_enh_respell(&ti, DI_FIFTH, &ti));
+        vtest(DI_FIFTH == ti.diatonic_interval);
+        vtest(IA_DIMINISHED == ti.interval_alteration);
+        vtest(1 == ti.octave && ID_UP == ti.interval_direction);
+
+        ti_set(&ti, DI_FOURTH, IA_AUGMENTED, 0, ID_DOWN);
+        vtest(TONAL_OK == ti_enh_respell(&ti, DI_FIFTH, &ti));
+        vtest(DI_FIFTH == ti.diatonic_interval);
+        vtest(IA_DIMINISHED == ti.interval_alteration);
+        vtest(0 == ti.octave && ID_DOWN == ti.interval_direction);
+
+        /* Keeps the direction of a unison when it can */
+        ti_set(&ti, DI_PRIME, IA_PERFECT, 0, ID_DOWN);
+        vtest(TONAL_OK == ti_enh_respell(&ti, DI_SECOND, &ti));
+        vtest(DI_SECOND == ti.diatonic_interval);
+        vtest(IA_DIMINISHED == ti.interval_alteration);
+        vtest(ID_DOWN == ti.interval_direction);
+        vtest(TONAL_OK == ti_enh_respell(&ti, DI_PRIME, &ti));
+        vtest(IA_PERFECT == ti.interval_alteration);
+
+        vtest(TONAL_FAIL == ti_enh_respell(&ti, DI_THIRD, &ti));
+        vtest(TONAL_FAIL == ti_enh_respell(&ti, DI_NONE, &ti));
+        vtest(TONAL_FAIL == ti_enh_respell(&ti, DI_PRIME, NULL));
+        return 0;
+}
+
+static int test_batch(void)
+{
+        struct tonal_pitch tp0[4];
+        struct tonal_pitch tp1[4];
+        struct tonal_pitch tpr[4];
+        struct tonal_interval ti0[3];
+        struct tonal_interval ti1[3];
+        struct tonal_interval tir[3];
+        int dp[4] = { DP_B, DP_D, DP_E, DP_C };
+        int di[3] = { DI_FIFTH, DI_SIXTH, DI_FOURTH };
+        int eq[4];
+        int status[4];
+
+        tp_set(&tp0[0], DP_C, PA_, 5);
+        tp_set(&tp0[1], DP_C, PA_s, 5);
+        tp_set(&tp0[2], DP_C, PA_, 5);
+        tp_set(&tp0[3], DP_C, PA_, 5);
+        tp0[3].diatonic_pitch = DP_NONE;
+        tp_set(&tp1[0], DP_B, PA_s, 4);
+        tp_set(&tp1[1], DP_D, PA_b, 4);
+        tp_set(&tp1[2], DP_D, PA_bb, 5);
+        tp_set(&tp1[3], DP_C, PA_, 5);
+
+        vtest(TONAL_FAIL == tp_enh_equal_n(tp0, tp1, eq, status, 4));
+        vtest(1 == eq[0] && 0 == eq[1] && 1 == eq[2] && 0 == eq[3]);
+        vtest(TONAL_E_OK == status[0] && TONAL_E_OK == status[2]);
+        vtest(TONAL_E_DIATONIC == status[3]);
+        vtest(TONAL_OK == tp_enh_equal_n(tp0, tp1, eq, NULL, 3));
+
+        vtest(TONAL_FAIL == tp_enh_respell_n(tp0, dp, tpr, status, 4));
+        vtest(TONAL_E_OK == status[0] && TONAL_E_OK == status[1]);
+        vtest(DP_B == tpr[0].diatonic_pitch && 4 == tpr[0].octave);
+        vtest(DP_D == tpr[1].diatonic_pitch && PA_b == tpr[1].pitch_alteration);
+        vtest(TONAL_E_RANGE == status[2]);
+        vtest(TONAL_E_DIATONIC == status[3]);
+        dp[0] = DP_NONE;
+        vtest(TONAL_FAIL == tp_enh_respell_n(tp0, dp, tpr, status, 1));
+        vtest(TONAL_E_DIATONIC == status[0]);
+
+        ti_set(&ti0[0], DI_FOURTH, IA_AUGMENTED, 0, ID_UP);
+        ti_set(&ti0[1], DI_FIFTH, IA_AUGMENTED, 2, ID_DOWN);
+        ti_set(&ti0[2], DI_THIRD, IA_MAJOR, 0, ID_UP);
+        ti_set(&ti1[0], DI_FIFTH, IA_DIMINISHED, 0, ID_UP);
+        ti_set(&ti1[1], DI_SIXTH, IA_MINOR, 2, ID_DOWN);
+        ti_set(&ti1[2], DI_THIRD, IA_MAJOR, 0, ID_DOWN);
+        vtest(TONAL_OK == ti_enh_equal_n(ti0, ti1, eq, status, 3));
+        vtest(1 == eq[0] && 1 == eq[1] && 0 == eq[2]);
+
+        vtest(TONAL_OK == ti_enh_respell_n(ti0, di, tir, status, 3));
+        for (int i = 0; i < 3; i++) {
+                vtest(TONAL_E_OK == status[i]);
+                vtest(di[i] == tir[i].diatonic_interval);
+                vtest(ti0[i].octave == tir[i].octave);
+                vtest(ti0[i].interval_direction == tir[i].interval_direction);
+        }
+        vtest(IA_MINOR == tir[1].interval_alteration);
+        ti0[2].octave = -1;
+        vtest(TONAL_FAIL == ti_enh_respell_n(ti0, di, tir, status, 3));
+        vtest(TONAL_E_OCTAVE == status[2]);
+
+        vtest(TONAL_OK == ti_enh_equal_n(NULL, NULL, NULL, NULL, 0));
+        vtest(TONAL_FAIL == ti_enh_equal_n(ti0, NULL, eq, status, 2));
+        vtest(TONAL_E_NULL == status[0] && TONAL_E_NULL == status[1]);
+        return 0;
+}
+
+int main(void)
+{
+        test_equal();
+        test_spellings();
+        test_spellings_all();
+        test_respell();
+        test_batch();
+
+        vtest_report();
+        vtest_end();
+
+        return 0;
+}
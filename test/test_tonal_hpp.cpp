@@ -0,0 +1,205 @@
+/*
+ * Copyright 2016 Martin Aberg
+ *
+ * This file is part of tonal.
+ *
+ * tonal is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * tonal is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Unit tests for the C++ value types in tonal.hpp */
+
+#include <cstring>
+
+#include <tonal.hpp>
+#include <vtest.h>
+
+using namespace tonal;
+
+/* Compile time evaluation */
+constexpr Interval M3(DI_THIRD, IA_MAJOR);
+constexpr Interval m3(DI_THIRD, IA_MINOR);
+constexpr Interval P5(DI_FIFTH, IA_PERFECT);
+constexpr Interval P8(DI_PRIME, IA_PERFECT, 1);
+
+static_assert(sizeof (Pitch) == sizeof (struct tonal_pitch), "layout");
+static_assert(sizeof (Interval) == sizeof (struct tonal_interval), "layout");
+
+/* Example 2.1 */
+static_assert(
+        Pitch(DP_G, PA_, 0) + Interval(DI_FOURTH, IA_PERFECT) ==
+        Pitch(DP_C, PA_, 1),
+        "G0 + P4 == C1"
+);
+/* Example 2.2 */
+static_assert(M3 + m3 == P5, "M3 + m3 == P5");
+/* Example 2.3 */
+static_assert(Interval(DI_SEVENTH, IA_MINOR) - m3 == P5, "m7 - m3 == P5");
+/* Example 2.4 */
+static_assert(
+        Pitch(DP_C, PA_, 1) - Pitch(DP_G, PA_, 0) ==
+        Interval(DI_FOURTH, IA_PERFECT),
+        "C1 - G0 == P4"
+);
+/* Chord template */
+static_assert(
+        Pitch(DP_E, PA_b, 4) + m3 + M3 == Pitch(DP_B, PA_b, 4),
+        "Eb minor triad fifth"
+);
+static_assert(Pitch(DP_C, PA_, 4) + P8 - P8 == Pitch(DP_C, PA_, 4), "");
+#if 2 == TONAL_ALTERATION_MAX
+static_assert(!(Pitch(DP_E, PA_ss, 4) + Interval(DI_PRIME, IA_AUGMENTED)), "");
+#else
+static_assert(
+        Pitch(DP_E, PA_ss, 4) + Interval(DI_PRIME, IA_AUGMENTED) ==
+        Pitch(DP_E, PA_ALTERATION(3), 4),
+        "E## + A1 == E###"
+);
+static_assert(
+        Interval(DI_FOURTH, IA_AUGMENTED) + Interval(DI_PRIME, IA_AUGMENTED) ==
+        Interval(DI_FOURTH, IA_AUGMENTED_N(2)),
+        "A4 + A1 == AA4"
+);
+#endif
+static_assert(Pitch(DP_C, PA_, 0) - P8 == Pitch(DP_C, PA_, -1), "C0 - P8");
+static_assert(Pitch(DP_C, PA_, -1).mnn(OC_C4) == 0, "C-1 is MNN 0");
+static_assert(
+        PitchClass(DP_D, PA_) - PitchClass(DP_C, PA_) ==
+        IntervalClass(DI_SECOND, IA_MAJOR),
+        ""
+);
+static_assert(
+        PitchClass(DP_C, PA_) - PitchClass(DP_D, PA_) ==
+        IntervalClass(DI_SEVENTH, IA_MINOR),
+        ""
+);
+static_assert(
+        PitchClass(DP_B, PA_) + IntervalClass(DI_SECOND, IA_MINOR) ==
+        PitchClass(DP_C, PA_),
+        ""
+);
+static_assert(Pitch(DP_C, PA_, 4).mnn() == 48, "");
+static_assert(!Interval::make(DI_PRIME, IA_DIMINISHED, 0, ID_UP), "");
+
+template <typename T, typename C>
+static bool same(const std::optional<T> &a, int ret, const C &c)
+{
+        if (!a) { return TONAL_OK != ret; }
+        return TONAL_OK == ret && 0 == std::memcmp(&*a, &c, sizeof c);
+}
+
+/* Compare against the C implementation for all intervals up to two octaves. */
+static int test_against_c(void)
+{
+        for (int dp = DP_C; dp <= DP_B; dp++)
+        for (int pa = 0; pa < PA_NONE; pa++)
+        for (int o = 0; o < 3; o++)
+        for (int di = DI_PRIME; di <= DI_SEVENTH; di++)
+        for (int ia = 0; ia < IA_NONE; ia++)
+        for (int io = 0; io < 3; io++)
+        for (int id = ID_UP; id <= ID_DOWN; id++) {
+                struct tonal_pitch tp;
+                struct tonal_interval ti;
+                struct tonal_pitch tp_sum;
+                struct tonal_interval ti_res;
+                int ret;
+
+                tp_set(&tp, dp, pa, o);
+                if (TONAL_OK != ti_set(&ti, di, ia, io, id)) {
+                        vtest(!Interval(di, ia, io, id).valid());
+                        continue;
+                }
+                Pitch p(tp);
+                Interval i(ti);
+
+                ret = tp_add(&tp, &ti, &tp_sum);
+                vtest(same(p + i, ret, tp_sum));
+
+                ret = ti_add(&ti, &ti, &ti_res);
+                vtest(same(i + i, ret, ti_res));
+
+                ret = ti_sub(&ti, &ti, &ti_res);
+                vtest(same(i - i, ret, ti_res));
+
+                if (TONAL_OK == tp_add(&tp, &ti, &tp_sum)) {
+                        ret = tp_sub(&tp_sum, &tp, &ti_res);
+                        vtest(same(Pitch(tp_sum) - p, ret, ti_res));
+                }
+        }
+        return 0;
+}
+
+/* Compile time intervals give the same results as run time intervals. */
+template <const Interval &TI>
+static int test_tp_add_const(void)
+{
+        enum { N = DP_NONE * PA_NONE * 3 + 2 };
+        struct tonal_pitch tp[N];
+        struct tonal_pitch tp_sum[N];
+        struct tonal_pitch tp_ref[N];
+        int status[N];
+        int status_ref[N];
+        int n;
+
+        n = 0;
+        for (int dp = DP_C; dp <= DP_B; dp++)
+        for (int pa = 0; pa < PA_NONE; pa++)
+        for (int o = 0; o < 3; o++) {
+                tp_set(&tp[n++], dp, pa, o);
+        }
+        /* Invalid input */
+        tp[n++] = Pitch(DP_NONE, PA_, 1);
+        tp[n++] = Pitch(DP_C, PA_NONE, 1);
+
+        int ret = tp_transpose_n<TI>(tp, tp_sum, status, N);
+        int ret_ref = tp_transpose_n(tp, &TI, tp_ref, status_ref, N);
+        vtest(ret == ret_ref);
+        for (int i = 0; i < N; i++) {
+                std::optional<Pitch> sum = tp_add<TI>(Pitch(tp[i]));
+                vtest(sum == Pitch(tp[i]) + TI);
+                vtest(status[i] == status_ref[i]);
+                if (TONAL_OK == status[i]) {
+                        vtest(sum == Pitch(tp_sum[i]));
+                        vtest(0 == std::memcmp(&tp_sum[i], &tp_ref[i], sizeof tp_ref[i]));
+                }
+        }
+        return 0;
+}
+
+static constexpr Interval M9_down(DI_SECOND, IA_MAJOR, 1, ID_DOWN);
+
+static_assert(
+        tp_add<intervals::P5>(Pitch(DP_B, PA_, 3)) == Pitch(DP_F, PA_s, 4),
+        "B3 + P5 == F#4"
+);
+
+int main(void)
+{
+        test_against_c();
+
+        test_tp_add_const<intervals::P1>();
+        test_tp_add_const<intervals::A1>();
+        test_tp_add_const<intervals::m2>();
+        test_tp_add_const<intervals::M3>();
+        test_tp_add_const<intervals::A4>();
+        test_tp_add_const<intervals::d5>();
+        test_tp_add_const<intervals::P5>();
+        test_tp_add_const<intervals::M7>();
+        test_tp_add_const<intervals::P8>();
+        test_tp_add_const<M9_down>();
+
+        vtest_report();
+        vtest_end();
+
+        return 0;
+}
@@ -0,0 +1,251 @@
+/*
+ * Copyright 2016 Martin Aberg
+ *
+ * This file is part of tonal.
+ *
+ * tonal is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * tonal is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Unit tests for corpus ingestion, with io_uring and with threads */
+
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <tonal_ingest.h>
+#include <vtest.h>
+
+#define NFILES 300
+
+static const char KERN[] =
+        "**kern\t**kern\n"
+        "4c\t4CC\n"
+        "4d#\t.\n"
+        "*-\t*-\n";
+
+static const char ABC[] =
+        "X:1\n"
+        "K:C\n"
+        "C ^D e|\n";
+
+static const char MUSICXML[] =
+        "<score-partwise version=\"3.1\"><part id=\"P1\"><measure number=\"1\">"
+        "<note><pitch><step>B</step><alter>-1</alter><octave>3</octave></pitch></note>"
+        "</measure></part></score-partwise>\n";
+
+static char dir[] = "/tmp/test_tonal_ingest.XXXXXX";
+static char *path[NFILES];
+
+static void write_file(size_t i, const char *name, const char *doc)
+{
+        FILE *f;
+
+        path[i] = malloc(strlen(dir) + strlen(name) + 2);
+        sprintf(path[i], "%s/%s", dir, name);
+        if (NULL == doc) { return; }
+        f = fopen(path[i], "w");
+        fputs(doc, f);
+        fclose(f);
+}
+
+struct count {
+        size_t calls;
+        size_t seen[NFILES];
+        int bad;
+        size_t stop_after;
+        int stop;
+};
+
+static int count_file(const struct tonal_ingest_file *file, void *arg)
+{
+        struct count *c = arg;
+        char name[32];
+
+        c->calls++;
+        c->seen[file->index]++;
+        if (file->path != path[file->index]) { c->bad = 1; }
+        if (file->index < 3 || file->index == 4) {
+                /* The scores below */
+        } else if (file->index == 3) {
+                if (TONAL_FAIL != file->status || 0 != file->size) { c->bad = 1; }
+        } else {
+                sprintf(name, "%zu\n", file->index);
+                if (TONAL_OK != file->status || 0 != strcmp(name, file->doc)) {
+                        c->bad = 1;
+                }
+        }
+        if (c->stop_after && c->stop_after == c->calls) { return c->stop; }
+        return TONAL_OK;
+}
+
+static int test_ingest(int mode)
+{
+        struct count c;
+        static const int DEPTH[] = { 1, 3, 64, 4096 };
+
+        for (size_t d = 0; d < sizeof DEPTH / sizeof DEPTH[0]; d++) {
+                memset(&c, 0, sizeof c);
+                vtest(TONAL_OK == tonal_ingest(
+                        (const char *const *) path, NFILES, DEPTH[d], mode, count_file, &c
+                ));
+                vtest(NFILES == c.calls);
+                vtest(0 == c.bad);
+                for (size_t i = 0; i < NFILES; i++) { vtest(1 == c.seen[i]); }
+        }
+
+        /* fn stops it. */
+        memset(&c, 0, sizeof c);
+        c.stop_after = 10;
+        c.stop = 7;
+        vtest(7 == tonal_ingest(
+                (const char *const *) path, NFILES, 16, mode, count_file, &c
+        ));
+        vtest(10 == c.calls);
+
+        /* Any stop value, including those of the TONAL_E_ range */
+        memset(&c, 0, sizeof c);
+        c.stop_after = 2;
+        c.stop = TONAL_E_NONE;
+        vtest(TONAL_E_NONE == tonal_ingest(
+                (const char *const *) path, NFILES, 1, mode, count_file, &c
+        ));
+        vtest(2 == c.calls);
+
+        memset(&c, 0, sizeof c);
+        vtest(TONAL_OK == tonal_ingest(NULL, 0, 1, mode, count_file, &c));
+        vtest(0 == c.calls);
+        vtest(TONAL_FAIL == tonal_ingest(NULL, 1, 1, mode, count_file, &c));
+        vtest(TONAL_FAIL == tonal_ingest(
+                (const char *const *) path, 1, 1, mode, NULL, &c
+        ));
+        vtest(TONAL_FAIL == tonal_ingest(
+                (const char *const *) path, 1, 0, mode, count_file, &c
+        ));
+        vtest(TONAL_FAIL == tonal_ingest(
+                (const char *const *) path, 1, 4097, mode, count_file, &c
+        ));
+        vtest(TONAL_FAIL == tonal_ingest(
+                (const char *const *) path, 1, 1, TONAL_INGEST_NONE, count_file, &c
+        ));
+        return 0;
+}
+
+struct scores {
+        int oc;
+        size_t calls;
+        int status[5];
+        size_t n[5];
+        int mnn[5][3];
+};
+
+static int keep_score(const struct tonal_ingest_score *score, void *arg)
+{
+        struct scores *s = arg;
+
+        s->calls++;
+        if (5 <= score->index) { return TONAL_OK; }
+        s->status[score->index] = score->status;
+        s->n[score->index] = score->pitch.n;
+        for (size_t i = 0; i < score->pitch.n && i < 3; i++) {
+                s->mnn[score->index][i] = tp_to_mnn_oc(&score->pitch.pitch[i], s->oc);
+        }
+        return TONAL_OK;
+}
+
+static int test_scores(int mode)
+{
+        struct scores s;
+
+        memset(&s, 0, sizeof s);
+        s.oc = OC_C4;
+        vtest(TONAL_OK == tonal_ingest_scores(
+                (const char *const *) path, NFILES, 8, mode, OC_C4, keep_score, &s
+        ));
+        vtest(NFILES == s.calls);
+
+        /* **kern, spine by spine on each line */
+        vtest(TONAL_OK == s.status[0]);
+        vtest(3 == s.n[0]);
+        vtest(60 == s.mnn[0][0]);
+        vtest(36 == s.mnn[0][1]);
+        vtest(63 == s.mnn[0][2]);
+
+        vtest(TONAL_OK == s.status[1]);
+        vtest(3 == s.n[1]);
+        vtest(60 == s.mnn[1][0]);
+        vtest(63 == s.mnn[1][1]);
+        vtest(76 == s.mnn[1][2]);
+
+        vtest(TONAL_OK == s.status[2]);
+        vtest(1 == s.n[2]);
+        vtest(58 == s.mnn[2][0]);
+
+        /* Missing, unknown extension */
+        vtest(TONAL_FAIL == s.status[3]);
+        vtest(0 == s.n[3]);
+        vtest(TONAL_FAIL == s.status[4]);
+
+        /* Same notes with the other octave convention */
+        memset(&s, 0, sizeof s);
+        s.oc = OC_C5;
+        vtest(TONAL_OK == tonal_ingest_scores(
+                (const char *const *) path, 3, 2, mode, OC_C5, keep_score, &s
+        ));
+        vtest(3 == s.calls);
+        vtest(60 == s.mnn[0][0]);
+        vtest(76 == s.mnn[1][2]);
+        vtest(58 == s.mnn[2][0]);
+
+        vtest(TONAL_FAIL == tonal_ingest_scores(
+                (const char *const *) path, 3, 2, mode, 7, keep_score, &s
+        ));
+        return 0;
+}
+
+int main(void)
+{
+        char name[32];
+        char doc[32];
+
+        if (NULL == mkdtemp(dir)) { return 1; }
+        write_file(0, "a.krn", KERN);
+        write_file(1, "b.ABC", ABC);
+        write_file(2, "c.musicxml", MUSICXML);
+        write_file(3, "missing.krn", NULL);
+        write_file(4, "e.txt", "text\n");
+        for (size_t i = 5; i < NFILES; i++) {
+                /* Each holds its number and a newline. */
+                sprintf(name, "%zu.txt", i);
+                sprintf(doc, "%zu\n", i);
+                write_file(i, name, doc);
+        }
+
+        test_ingest(TONAL_INGEST_AUTO);
+        test_ingest(TONAL_INGEST_THREADS);
+        test_scores(TONAL_INGEST_AUTO);
+        test_scores(TONAL_INGEST_THREADS);
+
+        for (size_t i = 0; i < NFILES; i++) {
+                unlink(path[i]);
+                free(path[i]);
+        }
+        rmdir(dir);
+
+        vtest_report();
+        vtest_end();
+
+        return 0;
+}
@@ -0,0 +1,361 @@
+/*
+ * Copyright 2016 Martin Aberg
+ *
+ * This file is part of tonal.
+ *
+ * tonal is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * tonal is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Unit tests for interval class operations */
+
+#include <string.h>
+
+#include <tonal_interval.h>
+#include "tonal_priv.h"
+#include <vtest.h>
+
+static int tic_eq(const struct tonal_interval_class *tic, int di, int ia)
+{
+        return di == tic->diatonic_interval && ia == tic->interval_alteration;
+}
+
+static int test_ids(void)
+{
+        struct tonal_interval_class tic;
+        int id;
+        int count = 0;
+
+        for (int di = 0; di < DI_NONE; di++) {
+                for (int ia = 0; ia < IA_NONE; ia++) {
+                        int valid = TONAL_OK == tic_set(&tic, di, ia);
+
+                        tic.diatonic_interval = di;
+                        tic.interval_alteration = ia;
+                        if (valid) {
+                                vtest(TONAL_OK == tic_to_id(&tic, &id));
+                                vtest(0 <= id && id < TONAL_TIC_ID_COUNT);
+                                vtest(TONAL_OK == id_to_tic(id, &tic));
+                                vtest(tic_eq(&tic, di, ia));
+                                count++;
+                        } else {
+                                vtest(TONAL_FAIL == tic_to_id(&tic, &id));
+                                vtest(TONAL_FAIL == id_to_tic(di * IA_NONE + ia, &tic));
+                        }
+                }
+        }
+        vtest(14 * TONAL_ALTERATION_MAX - 3 == count);
+        vtest(TONAL_FAIL == id_to_tic(-1, &tic));
+        vtest(TONAL_FAIL == id_to_tic(TONAL_TIC_ID_COUNT, &tic));
+        vtest(TONAL_FAIL == tic_to_id(NULL, &id));
+        return 0;
+}
+
+static int test_inv(void)
+{
+        struct tonal_interval_class tic0, tic1, tic2;
+        struct tonal_interval ti0, ti1, ti2, octave;
+
+        tic_set(&tic0, DI_THIRD, IA_MAJOR);
+        vtest(TONAL_OK == tic_inv(&tic0, &tic1));
+        vtest(tic_eq(&tic1, DI_SIXTH, IA_MINOR));
+        tic_set(&tic0, DI_FOURTH, IA_AUGMENTED);
+        vtest(TONAL_OK == tic_inv(&tic0, &tic1));
+        vtest(tic_eq(&tic1, DI_FIFTH, IA_DIMINISHED));
+        tic_set(&tic0, DI_PRIME, IA_PERFECT);
+        vtest(TONAL_OK == tic_inv(&tic0, &tic1));
+        vtest(tic_eq(&tic1, DI_PRIME, IA_PERFECT));
+        tic_set(&tic0, DI_SEVENTH, IA_AUGMENTED);
+        vtest(TONAL_OK == tic_inv(&tic0, &tic1));
+        vtest(tic_eq(&tic1, DI_SECOND, IA_DIMINISHED));
+        tic0.interval_alteration = IA_PERFECT;
+        vtest(TONAL_FAIL == tic_inv(&tic0, &tic1));
+        vtest(TONAL_FAIL == tic_inv(NULL, &tic1));
+
+        ti_set(&ti0, DI_THIRD, IA_MAJOR, 1, ID_DOWN);
+        vtest(TONAL_OK == ti_inv(&ti0, &ti1));
+        vtest(tic_eq((struct tonal_interval_class *) &ti1, DI_SIXTH, IA_MINOR));
+        vtest(0 == ti1.octave && ID_DOWN == ti1.interval_direction);
+        ti_set(&ti0, DI_PRIME, IA_PERFECT, 2, ID_UP);
+        vtest(TONAL_OK == ti_inv(&ti0, &ti1));
+        vtest(0 == ti1.octave);
+
+        /*
+         * Every simple interval and its inversion make an octave, and so do
+         * the octaves and their inversions.
+         */
+        ti_set(&octave, DI_PRIME, IA_PERFECT, 1, ID_UP);
+        for (int di = 0; di < DI_NONE; di++) {
+                for (int ia = 0; ia < IA_NONE; ia++) {
+                        if (TONAL_OK != ti_set(&ti0, di, ia, 0, ID_UP)) {
+                                ti0.diatonic_interval = di;
+                                ti0.interval_alteration = ia;
+                                ti0.octave = 0;
+                                ti0.interval_direction = ID_UP;
+                                vtest(TONAL_FAIL == ti_inv(&ti0, &ti1));
+                                continue;
+                        }
+                        vtest(TONAL_OK == ti_inv(&ti0, &ti1));
+                        vtest(TONAL_OK == ti_sub(&octave, &ti0, &ti2));
+                        vtest(0 == memcmp(&ti1, &ti2, sizeof ti1));
+
+                        ti0.octave = 2;
+                        vtest(TONAL_OK == ti_inv(&ti0, &ti1));
+                        ti0.octave = DI_PRIME == di;
+                        vtest(TONAL_OK == ti_sub(&octave, &ti0, &ti2));
+                        vtest(0 == memcmp(&ti1, &ti2, sizeof ti1));
+
+                        /* Involution on interval classes */
+                        tic_set(&tic0, di, ia);
+                        vtest(TONAL_OK == tic_inv(&tic0, &tic1));
+                        vtest(TONAL_OK == tic_inv(&tic1, &tic2));
+                        vtest(tic_eq(&tic2, di, ia));
+                }
+        }
+        return 0;
+}
+
+static int test_classes(void)
+{
+        struct tonal_interval ti0, ti1;
+        struct tonal_interval_class tic, tic1;
+        struct tonal_pitch tp0, tp1, tp2;
+
+        ti_set(&ti0, DI_THIRD, IA_MAJOR, 1, ID_DOWN);
+        vtest(TONAL_OK == ti_simple(&ti0, &ti1));
+        vtest(0 == ti1.octave && ID_DOWN == ti1.interval_direction);
+        vtest(tic_eq((struct tonal_interval_class *) &ti1, DI_THIRD, IA_MAJOR));
+
+        vtest(TONAL_OK == ti_ordered_class(&ti0, &tic));
+        vtest(tic_eq(&tic, DI_SIXTH, IA_MINOR));
+        vtest(TONAL_OK == ti_unordered_class(&ti0, &tic));
+        vtest(tic_eq(&tic, DI_THIRD, IA_MAJOR));
+
+        tic_set(&tic, DI_FIFTH, IA_DIMINISHED);
+        vtest(TONAL_OK == tic_unordered_class(&tic, &tic1));
+        vtest(tic_eq(&tic1, DI_FOURTH, IA_AUGMENTED));
+        tic_set(&tic, DI_PRIME, IA_DIMINISHED);
+        vtest(TONAL_OK == tic_unordered_class(&tic, &tic1));
+        vtest(tic_eq(&tic1, DI_PRIME, IA_AUGMENTED));
+        tic_set(&tic, DI_FOURTH, IA_PERFECT);
+        vtest(TONAL_OK == tic_unordered_class(&tic, &tic1));
+        vtest(tic_eq(&tic1, DI_FOURTH, IA_PERFECT));
+
+        ti_set(&ti0, DI_PRIME, IA_DIMINISHED, 1, ID_UP);
+        vtest(TONAL_OK == ti_simple(&ti0, &ti1));
+        vtest(1 == ti1.octave);
+        ti_set(&ti0, DI_PRIME, IA_AUGMENTED, 1, ID_UP);
+        vtest(TONAL_OK == ti_inv(&ti0, &ti1));
+        vtest(IA_AUGMENTED == ti1.interval_alteration);
+        vtest(0 == ti1.octave && ID_DOWN == ti1.interval_direction);
+        ti0.octave = 0;
+        ti0.interval_alteration = IA_DIMINISHED;
+        vtest(TONAL_FAIL == ti_simple(&ti0, &ti1));
+
+        ti0.octave = -1;
+        vtest(TONAL_FAIL == ti_simple(&ti0, &ti1));
+        vtest(TONAL_FAIL == ti_ordered_class(&ti0, &tic));
+        vtest(TONAL_FAIL == ti_unordered_class(&ti0, NULL));
+
+        /*
+         * The ordered class leads to the same pitch class as the interval,
+         * going up.
+         */
+        tp_set(&tp0, DP_E, PA_b, 4);
+        for (int dir = ID_UP; dir <= ID_DOWN; dir++) {
+                for (int di = 0; di < DI_NONE; di++) {
+                        for (int ia = 0; ia < IA_NONE; ia++) {
+                                if (TONAL_OK != ti_set(&ti0, di, ia, 1, dir)) {
+                                        continue;
+                                }
+                                if (TONAL_OK != tp_add(&tp0, &ti0, &tp1)) {
+                                        continue;
+                                }
+                                vtest(TONAL_OK == ti_ordered_class(&ti0, &tic));
+                                ti_set(&ti1, tic.diatonic_interval, tic.interval_alteration, 1, ID_UP);
+                                vtest(TONAL_OK == tp_add(&tp0, &ti1, &tp2));
+                                vtest(tp1.diatonic_pitch == tp2.diatonic_pitch);
+                                vtest(tp1.pitch_alteration == tp2.pitch_alteration);
+
+                                vtest(TONAL_OK == ti_unordered_class(&ti0, &tic));
+                                vtest(tic.diatonic_interval <= DI_FOURTH);
+                        }
+                }
+        }
+        return 0;
+}
+
+static int test_size(void)
+{
+        struct tonal_interval ti0, ti1;
+        struct tonal_element te;
+        int semitones, steps, order;
+        int prev_semitones = INT_MIN;
+        int prev_steps = INT_MIN;
+
+        ti_set(&ti0, DI_THIRD, IA_MAJOR, 0, ID_DOWN);
+        vtest(TONAL_OK == ti_semitones(&ti0, &semitones) && -4 == semitones);
+        vtest(TONAL_OK == ti_steps(&ti0, &steps) && -2 == steps);
+        ti_set(&ti0, DI_PRIME, IA_DIMINISHED, 1, ID_UP);
+        vtest(TONAL_OK == ti_semitones(&ti0, &semitones) && 11 == semitones);
+        vtest(TONAL_OK == ti_steps(&ti0, &steps) && 7 == steps);
+        ti_set(&ti0, DI_SIXTH, IA_AUGMENTED, 2, ID_UP);
+        vtest(TONAL_OK == ti_semitones(&ti0, &semitones) && 34 == semitones);
+        ti_set(&ti0, DI_SECOND, IA_DIMINISHED, 0, ID_UP);
+        vtest(TONAL_OK == ti_semitones(&ti0, &semitones) && 0 == semitones);
+
+        ti_set(&ti0, DI_FOURTH, IA_AUGMENTED, 0, ID_UP);
+        ti_set(&ti1, DI_FIFTH, IA_DIMINISHED, 0, ID_UP);
+        vtest(TONAL_OK == ti_compare(&ti0, &ti1, &order) && -1 == order);
+        vtest(TONAL_OK == ti_compare(&ti1, &ti0, &order) && 1 == order);
+        vtest(TONAL_OK == ti_compare(&ti1, &ti1, &order) && 0 == order);
+        ti_set(&ti0, DI_PRIME, IA_PERFECT, 0, ID_UP);
+        ti_set(&ti1, DI_PRIME, IA_PERFECT, 0, ID_DOWN);
+        vtest(TONAL_OK == ti_compare(&ti0, &ti1, &order) && 0 == order);
+        ti_set(&ti1, DI_SECOND, IA_MINOR, 0, ID_DOWN);
+        vtest(TONAL_OK == ti_compare(&ti0, &ti1, &order) && 1 == order);
+
+        ti1.octave = -1;
+        vtest(TONAL_FAIL == ti_semitones(&ti1, &semitones));
+        vtest(TONAL_FAIL == ti_steps(&ti1, &steps));
+        vtest(TONAL_FAIL == ti_compare(&ti0, &ti1, &order));
+        vtest(TONAL_FAIL == ti_semitones(&ti0, NULL));
+
+        /*
+         * Sizes agree with the tonal element of the interval, and the order
+         * is by size, then steps.
+         */
+        for (int dir = ID_UP; dir <= ID_DOWN; dir++) {
+                for (int octave = 0; octave < 3; octave++) {
+                        for (int di = 0; di < DI_NONE; di++) {
+                                for (int ia = 0; ia < IA_NONE; ia++) {
+                                        if (TONAL_OK != ti_set(&ti0, di, ia, octave, dir)) {
+                                                continue;
+                                        }
+                                        vtest(TONAL_OK == ti_to_te(&ti0, &te));
+                                        vtest(TONAL_OK == ti_semitones(&ti0, &semitones));
+                                        vtest(TONAL_OK == ti_steps(&ti0, &steps));
+                                        vtest(te_get_chromatic_value(&te) == semitones);
+                                        vtest(te_get_diatonic_value(&te) == steps);
+                                }
+                        }
+                }
+        }
+        for (int s = -40; s <= 40; s++) {
+                for (int octave = 0; octave < 4; octave++) {
+                        for (int di = 0; di < DI_NONE; di++) {
+                                for (int ia = 0; ia < IA_NONE; ia++) {
+                                        if (TONAL_OK != ti_set(&ti0, di, ia, octave, ID_UP)) {
+                                                continue;
+                                        }
+                                        ti_semitones(&ti0, &semitones);
+                                        if (semitones != s) { continue; }
+                                        ti_steps(&ti0, &steps);
+                                        vtest(
+                                                prev_semitones < s ||
+                                                prev_steps < steps
+                                        );
+                                        if (TONAL_OK == ti_set(&ti1, di, ia, octave, ID_DOWN)) {
+                                                vtest(TONAL_OK == ti_compare(&ti1, &ti0, &order));
+                                                vtest((0 < s || (0 == s && 0 < steps) ? -1 : 0 > s) == order);
+                                        }
+                                        prev_semitones = s;
+                                        prev_steps = steps;
+                                }
+                        }
+                }
+        }
+        return 0;
+}
+
+static int test_batch(void)
+{
+        struct tonal_interval ti0[3], ti1[3];
+        struct tonal_interval_class tic0[3], tic1[3];
+        int status[3];
+        int order[3];
+
+        ti_set(&ti0[0], DI_THIRD, IA_MAJOR, 1, ID_UP);
+        ti_set(&ti0[1], DI_FIFTH, IA_PERFECT, 0, ID_DOWN);
+        ti_set(&ti0[2], DI_SECOND, IA_MINOR, 2, ID_UP);
+
+        vtest(TONAL_OK == ti_inv_n(ti0, ti1, status, 3));
+        vtest(tic_eq((struct tonal_interval_class *) &ti1[0], DI_SIXTH, IA_MINOR));
+        vtest(tic_eq((struct tonal_interval_class *) &ti1[1], DI_FOURTH, IA_PERFECT));
+        vtest(ID_DOWN == ti1[1].interval_direction);
+        vtest(tic_eq((struct tonal_interval_class *) &ti1[2], DI_SEVENTH, IA_MAJOR));
+        for (int i = 0; i < 3; i++) { vtest(TONAL_E_OK == status[i]); }
+
+        vtest(TONAL_OK == ti_simple_n(ti0, ti1, status, 3));
+        vtest(0 == ti1[0].octave && 0 == ti1[2].octave);
+
+        vtest(TONAL_OK == ti_ordered_class_n(ti0, tic0, status, 3));
+        vtest(tic_eq(&tic0[0], DI_THIRD, IA_MAJOR));
+        vtest(tic_eq(&tic0[1], DI_FOURTH, IA_PERFECT));
+        vtest(TONAL_OK == ti_unordered_class_n(ti0, tic0, status, 3));
+        vtest(tic_eq(&tic0[1], DI_FOURTH, IA_PERFECT));
+        vtest(tic_eq(&tic0[2], DI_SECOND, IA_MINOR));
+
+        vtest(TONAL_OK == tic_inv_n(tic0, tic1, status, 3));
+        vtest(tic_eq(&tic1[0], DI_SIXTH, IA_MINOR));
+
+        ti0[1].interval_alteration = IA_MAJOR;
+        ti0[2].interval_direction = ID_NONE;
+        vtest(TONAL_FAIL == ti_inv_n(ti0, ti1, status, 3));
+        vtest(TONAL_E_OK == status[0]);
+        vtest(TONAL_E_QUALITY == status[1]);
+        vtest(TONAL_E_DIRECTION == status[2]);
+        vtest(TONAL_FAIL == ti_unordered_class_n(ti0, tic0, NULL, 3));
+        tic0[0].diatonic_interval = DI_NONE;
+        vtest(TONAL_FAIL == tic_inv_n(tic0, tic1, status, 3));
+        vtest(TONAL_E_DIATONIC == status[0] && TONAL_E_OK == status[1]);
+
+        ti_set(&ti0[1], DI_FIFTH, IA_PERFECT, 0, ID_DOWN);
+        ti_set(&ti0[2], DI_SECOND, IA_MINOR, 2, ID_UP);
+        ti_set(&ti1[0], DI_FOURTH, IA_AUGMENTED, 1, ID_UP);
+        ti_set(&ti1[1], DI_FIFTH, IA_PERFECT, 0, ID_DOWN);
+        ti_set(&ti1[2], DI_PRIME, IA_PERFECT, 2, ID_UP);
+        vtest(TONAL_OK == ti_semitones_n(ti0, order, status, 3));
+        vtest(16 == order[0] && -7 == order[1] && 25 == order[2]);
+        vtest(TONAL_OK == ti_steps_n(ti0, order, status, 3));
+        vtest(9 == order[0] && -4 == order[1] && 15 == order[2]);
+        vtest(TONAL_OK == ti_compare_n(ti0, ti1, order, status, 3));
+        vtest(-1 == order[0] && 0 == order[1] && 1 == order[2]);
+
+        ti1[1].interval_direction = ID_NONE;
+        vtest(TONAL_FAIL == ti_compare_n(ti0, ti1, order, status, 3));
+        vtest(TONAL_E_OK == status[0] && TONAL_E_DIRECTION == status[1]);
+        vtest(TONAL_FAIL == ti_semitones_n(ti1, order, status, 3));
+        vtest(TONAL_E_DIRECTION == status[1] && TONAL_E_OK == status[2]);
+        vtest(TONAL_FAIL == ti_steps_n(ti0, NULL, status, 3));
+        vtest(TONAL_E_NULL == status[2]);
+
+        vtest(TONAL_OK == ti_simple_n(ti0, ti1, status, 0));
+        vtest(TONAL_FAIL == ti_simple_n(NULL, ti1, status, 2));
+        vtest(TONAL_E_NULL == status[0] && TONAL_E_NULL == status[1]);
+        return 0;
+}
+
+int main(void)
+{
+        test_ids();
+        test_inv();
+        test_classes();
+        test_size();
+        test_batch();
+
+        vtest_report();
+        vtest_end();
+
+        return 0;
+}
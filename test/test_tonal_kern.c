@@ -0,0 +1,261 @@
+/*
+ * Copyright 2016 Martin Aberg
+ *
+ * This file is part of tonal.
+ *
+ * tonal is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * tonal is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Unit tests for the Humdrum **kern reader and writer */
+
+#include <stdio.h>
+#include <string.h>
+
+#include <tonal_kern.h>
+#include <vtest.h>
+
+static const char CHORALE[] =
+        "!!!COM: Bach, Johann Sebastian\n"
+        "**kern\t**kern\t**dynam\n"
+        "*ICvox\t*ICvox\t*\n"
+        "*k[f#]\t*k[f#]\t*\n"
+        "=1-\t=1-\t=1-\n"
+        "4GG\t4d\tp\n"
+        "8AA#L\t(8cc#\t.\n"
+        "8BB-J\t8d-)\t.\n"
+        "!\t!melisma\t!\n"
+        "4r\t4e 4gn 4b\t.\n"
+        "*\t*^\t*\n"
+        "4C\t4ee\t4ddd---\t.\n"
+        "*\t*v\t*v\t*\n"
+        "*x\t*x\t*\n"
+        ".\t4e\tf\r\n"
+        "==\t==\t==\n"
+        "*-\t*-\t*-\n";
+
+struct notes {
+        struct tonal_kern_note note[32];
+        int n;
+};
+
+static int collect(const struct tonal_kern_note *note, void *arg)
+{
+        struct notes *notes = arg;
+
+        if (32 <= notes->n) { return TONAL_FAIL; }
+        notes->note[notes->n++] = *note;
+        return TONAL_OK;
+}
+
+static int is_pitch(const struct tonal_pitch *tp, int dp, int pa, int o)
+{
+        return dp == tp->diatonic_pitch &&
+                pa == tp->pitch_alteration &&
+                o == tp->octave;
+}
+
+static int test_parse(void)
+{
+        struct tonal_pitch tp;
+        char buf[16];
+
+        vtest(TONAL_OK == tonal_kern_parse("c", 1, OC_C4, &tp));
+        vtest(is_pitch(&tp, DP_C, PA_, 4));
+        vtest(TONAL_OK == tonal_kern_parse("c", 1, OC_C5, &tp));
+        vtest(is_pitch(&tp, DP_C, PA_, 5));
+        vtest(60 == tp_to_mnn(&tp));
+        vtest(TONAL_OK == tonal_kern_parse("8.cc#L", 6, OC_C4, &tp));
+        vtest(is_pitch(&tp, DP_C, PA_s, 5));
+        vtest(TONAL_OK == tonal_kern_parse("[2BB--", 6, OC_C4, &tp));
+        vtest(is_pitch(&tp, DP_B, PA_bb, 2));
+        vtest(TONAL_OK == tonal_kern_parse("4B", 2, OC_C4, &tp));
+        vtest(is_pitch(&tp, DP_B, PA_, 3));
+        vtest(TONAL_OK == tonal_kern_parse("16fn", 4, OC_C4, &tp));
+        vtest(is_pitch(&tp, DP_F, PA_, 4));
+        /* Only len characters are looked at. */
+        vtest(TONAL_OK == tonal_kern_parse("4g#", 2, OC_C4, &tp));
+        vtest(is_pitch(&tp, DP_G, PA_, 4));
+
+        vtest(TONAL_FAIL == tonal_kern_parse("4r", 2, OC_C4, &tp));
+        vtest(TONAL_FAIL == tonal_kern_parse(".", 1, OC_C4, &tp));
+        vtest(TONAL_FAIL == tonal_kern_parse("cd", 2, OC_C4, &tp));
+        vtest(TONAL_FAIL == tonal_kern_parse("cC", 2, OC_C4, &tp));
+        vtest(TONAL_FAIL == tonal_kern_parse("c#-", 3, OC_C4, &tp));
+        vtest(TONAL_FAIL == tonal_kern_parse("c###", 4, OC_C4, &tp));
+        vtest(TONAL_FAIL == tonal_kern_parse("c", 1, OC_NONE, &tp));
+
+        vtest(TONAL_OK == tp_set(&tp, DP_E, PA_b, 5));
+        vtest(TONAL_OK == tonal_kern_snprint(buf, sizeof buf, &tp, OC_C4));
+        vtest(0 == strcmp(buf, "ee-"));
+        vtest(TONAL_OK == tonal_kern_snprint(buf, sizeof buf, &tp, OC_C5));
+        vtest(0 == strcmp(buf, "e-"));
+        vtest(TONAL_FAIL == tonal_kern_snprint(buf, 3, &tp, OC_C4));
+        vtest(TONAL_OK == tonal_kern_snprint(buf, 4, &tp, OC_C4));
+        vtest(TONAL_OK == tp_set(&tp, DP_F, PA_ss, -1));
+        vtest(TONAL_OK == tonal_kern_snprint(buf, sizeof buf, &tp, OC_C4));
+        vtest(0 == strcmp(buf, "FFFFF##"));
+        tp.octave = 1000;
+        vtest(TONAL_FAIL == tonal_kern_snprint(buf, sizeof buf, &tp, OC_C4));
+
+        /* Round trip */
+        for (int dp = DP_C; dp < DP_NONE; dp++)
+        for (int pa = 0; pa < PA_NONE; pa++)
+        for (int o = -3; o < 12; o++)
+        for (int oc = OC_C5; oc < OC_NONE; oc++) {
+                struct tonal_pitch tp1;
+
+                vtest(TONAL_OK == tp_set(&tp, dp, pa, o));
+                vtest(TONAL_OK == tonal_kern_snprint(buf, sizeof buf, &tp, oc));
+                vtest(TONAL_OK == tonal_kern_parse(buf, strlen(buf), oc, &tp1));
+                vtest(0 == memcmp(&tp, &tp1, sizeof tp));
+        }
+        return 0;
+}
+
+static int test_scan(void)
+{
+        struct notes notes = { .n = 0 };
+        struct tonal_kern_note *n = notes.note;
+
+        vtest(TONAL_OK == tonal_kern_scan(
+                CHORALE, sizeof CHORALE - 1, OC_C4, collect, &notes
+        ));
+        vtest(13 == notes.n);
+
+        vtest(is_pitch(&n[0].pitch, DP_G, PA_, 2));
+        vtest(0 == n[0].track && 0 == n[0].column && 6 == n[0].line);
+        vtest(is_pitch(&n[1].pitch, DP_D, PA_, 4));
+        vtest(1 == n[1].track && 1 == n[1].column);
+        vtest(is_pitch(&n[2].pitch, DP_A, PA_s, 2));
+        vtest(is_pitch(&n[3].pitch, DP_C, PA_s, 5));
+        vtest(is_pitch(&n[4].pitch, DP_B, PA_b, 2));
+        vtest(is_pitch(&n[5].pitch, DP_D, PA_b, 4));
+
+        /* Chord after a rest */
+        vtest(is_pitch(&n[6].pitch, DP_E, PA_, 4));
+        vtest(0 == n[6].chord && 10 == n[6].line);
+        vtest(is_pitch(&n[7].pitch, DP_G, PA_, 4));
+        vtest(1 == n[7].chord);
+        vtest(2 == n[8].chord);
+
+        /* Split spine, both halves in track 1 */
+        vtest(is_pitch(&n[9].pitch, DP_C, PA_, 3));
+        vtest(0 == n[9].track);
+        vtest(is_pitch(&n[10].pitch, DP_E, PA_, 5));
+        vtest(1 == n[10].track && 1 == n[10].column);
+        vtest(TONAL_E_ALTERATION == n[11].error);
+        vtest(1 == n[11].track && 2 == n[11].column);
+
+        /* Exchanged spines */
+        vtest(is_pitch(&n[12].pitch, DP_E, PA_, 4));
+        vtest(0 == n[12].track && 1 == n[12].column);
+        return 0;
+}
+
+static int test_errors(void)
+{
+        struct notes notes = { .n = 0 };
+        static const char BAD_FIELDS[] = "**kern\t**kern\n4c\n*-\t*-\n";
+        static const char NO_SPINES[] = "4c\n";
+        static const char BAD_MANIP[] = "**kern\n*\t*\n";
+
+        vtest(TONAL_FAIL == tonal_kern_scan(
+                BAD_FIELDS, sizeof BAD_FIELDS - 1, OC_C4, collect, &notes
+        ));
+        vtest(TONAL_FAIL == tonal_kern_scan(
+                NO_SPINES, sizeof NO_SPINES - 1, OC_C4, collect, &notes
+        ));
+        vtest(TONAL_FAIL == tonal_kern_scan(
+                BAD_MANIP, sizeof BAD_MANIP - 1, OC_C4, collect, &notes
+        ));
+        /* Fields before the mismatch have been reported. */
+        vtest(1 == notes.n);
+        vtest(TONAL_OK == tonal_kern_scan("", 0, OC_C4, collect, &notes));
+        vtest(TONAL_FAIL == tonal_kern_scan(CHORALE, 4, OC_NONE, collect, &notes));
+        vtest(TONAL_FAIL == tonal_kern_scan(CHORALE, 4, OC_C4, NULL, &notes));
+        return 0;
+}
+
+static int test_read_write(void)
+{
+        static const char DOC[] =
+                "**kern\t**kern\n"
+                "4c\t4e-\n"
+                "4dd#\t.\n"
+                "4BB\t.\n"
+                "*-\t*-\n";
+        static const char OUT[] =
+                "**kern\t**kern\n"
+                "c\te-\n"
+                "dd#\t.\n"
+                "BB\t.\n"
+                "*-\t*-\n";
+        struct tonal_kern_score score;
+        struct tonal_arena arena;
+        char buf[128];
+        size_t n;
+        FILE *f;
+
+        vtest(TONAL_OK == tonal_kern_read(DOC, sizeof DOC - 1, OC_C4, &score));
+        vtest(2 == score.ntracks);
+        vtest(3 == score.track[0].n);
+        vtest(1 == score.track[1].n);
+        vtest(is_pitch(&score.track[0].pitch[1], DP_D, PA_s, 5));
+        vtest(is_pitch(&score.track[1].pitch[0], DP_E, PA_b, 4));
+
+        f = tmpfile();
+        vtest(TONAL_OK == tonal_kern_write(f, &score, OC_C4));
+        rewind(f);
+        n = fread(buf, 1, sizeof buf - 1, f);
+        buf[n] = '\0';
+        fclose(f);
+        vtest(0 == strcmp(buf, OUT));
+        tonal_kern_score_free(&score);
+        vtest(0 == score.ntracks);
+
+        vtest(TONAL_OK == tonal_arena_init(&arena, 256));
+        vtest(TONAL_OK == tonal_kern_read_arena(
+                DOC, sizeof DOC - 1, OC_C4, &arena, &score
+        ));
+        vtest(2 == score.ntracks);
+        vtest(3 == score.track[0].n);
+        vtest(is_pitch(&score.track[0].pitch[2], DP_B, PA_, 2));
+        vtest(is_pitch(&score.track[1].pitch[0], DP_E, PA_b, 4));
+        tonal_kern_score_free(&score);
+        tonal_arena_free(&arena);
+
+        /* Invalid pitches fail the read. */
+        vtest(TONAL_FAIL == tonal_kern_read(
+                CHORALE, sizeof CHORALE - 1, OC_C4, &score
+        ));
+        tonal_kern_score_free(&score);
+        vtest(TONAL_FAIL == tonal_kern_read_file(
+                "/nonexistent/score.krn", OC_C4, &score
+        ));
+        tonal_kern_score_free(&score);
+        return 0;
+}
+
+int main(void)
+{
+        test_parse();
+        test_scan();
+        test_errors();
+        test_read_write();
+
+        vtest_report();
+        vtest_end();
+
+        return 0;
+}
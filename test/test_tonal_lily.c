@@ -0,0 +1,183 @@
+/*
+ * Copyright 2016 Martin Aberg
+ *
+ * This file is part of tonal.
+ *
+ * tonal is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * tonal is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Unit tests for the LilyPond writer */
+
+#include <string.h>
+
+#include <tonal_lily.h>
+#include <vtest.h>
+
+static struct tonal_pitch pitch(int dp, int pa, int o)
+{
+        struct tonal_pitch tp = { dp, pa, o };
+
+        return tp;
+}
+
+static int test_snprint(void)
+{
+        struct tonal_pitch tp;
+        char buf[16];
+
+        tp = pitch(DP_C, PA_, 4);
+        vtest(TONAL_OK == tonal_lily_snprint(buf, sizeof buf, &tp, OC_C4));
+        vtest(0 == strcmp(buf, "c'"));
+        vtest(TONAL_OK == tonal_lily_snprint(buf, sizeof buf, &tp, OC_C5));
+        vtest(0 == strcmp(buf, "c"));
+        tp = pitch(DP_F, PA_s, 6);
+        vtest(TONAL_OK == tonal_lily_snprint(buf, sizeof buf, &tp, OC_C4));
+        vtest(0 == strcmp(buf, "fis'''"));
+        tp = pitch(DP_E, PA_b, 2);
+        vtest(TONAL_OK == tonal_lily_snprint(buf, sizeof buf, &tp, OC_C4));
+        vtest(0 == strcmp(buf, "es,"));
+        tp = pitch(DP_A, PA_bb, 3);
+        vtest(TONAL_OK == tonal_lily_snprint(buf, sizeof buf, &tp, OC_C4));
+        vtest(0 == strcmp(buf, "ases"));
+        tp = pitch(DP_B, PA_bb, 3);
+        vtest(TONAL_OK == tonal_lily_snprint(buf, sizeof buf, &tp, OC_C4));
+        vtest(0 == strcmp(buf, "beses"));
+        tp = pitch(DP_G, PA_ss, -1);
+        vtest(TONAL_OK == tonal_lily_snprint(buf, sizeof buf, &tp, OC_C4));
+        vtest(0 == strcmp(buf, "gisis,,,,"));
+
+        /* Too small a buffer, invalid pitch or convention */
+        vtest(TONAL_FAIL == tonal_lily_snprint(buf, 9, &tp, OC_C4));
+        tp = pitch(DP_NONE, PA_, 4);
+        vtest(TONAL_FAIL == tonal_lily_snprint(buf, sizeof buf, &tp, OC_C4));
+        tp = pitch(DP_C, PA_, 4);
+        vtest(TONAL_FAIL == tonal_lily_snprint(buf, sizeof buf, &tp, -1));
+        tp = pitch(DP_C, PA_, 100);
+        vtest(TONAL_FAIL == tonal_lily_snprint(buf, sizeof buf, &tp, OC_C4));
+        vtest(TONAL_FAIL == tonal_lily_snprint(NULL, 0, &tp, OC_C4));
+        return 0;
+}
+
+static int test_absolute(void)
+{
+        struct tonal_pitch tp[] = {
+                pitch(DP_G, PA_, 3),
+                pitch(DP_B, PA_b, 3),
+                pitch(DP_D, PA_, 5),
+        };
+        struct tonal_lily w;
+
+        vtest(TONAL_OK == tonal_lily_init(&w, TONAL_LILY_ABSOLUTE, NULL, OC_C4));
+        vtest(0 == strcmp(w.buf, ""));
+        vtest(TONAL_OK == tonal_lily_append(&w, "{ "));
+        vtest(TONAL_OK == tonal_lily_pitches(&w, tp, 3, "4 "));
+        vtest(TONAL_OK == tonal_lily_chord(&w, tp, 3));
+        vtest(TONAL_OK == tonal_lily_append(&w, "2 }"));
+        vtest(0 == strcmp(w.buf, "{ g4 bes4 d''4 <g bes d''>2 }"));
+        vtest(strlen(w.buf) == w.len);
+        tonal_lily_free(&w);
+        vtest(NULL == w.buf);
+
+        vtest(TONAL_FAIL == tonal_lily_init(&w, TONAL_LILY_NONE, NULL, OC_C4));
+        tonal_lily_free(&w);
+        vtest(TONAL_FAIL == tonal_lily_init(&w, TONAL_LILY_RELATIVE, NULL, OC_C4));
+        tonal_lily_free(&w);
+        return 0;
+}
+
+static int test_relative(void)
+{
+        /* \relative c' { c d e f g a b c g c,, <c e g> g' } */
+        struct tonal_pitch tp[] = {
+                pitch(DP_C, PA_, 4),
+                pitch(DP_D, PA_, 4),
+                pitch(DP_E, PA_, 4),
+                pitch(DP_F, PA_, 4),
+                pitch(DP_G, PA_, 4),
+                pitch(DP_A, PA_, 4),
+                pitch(DP_B, PA_, 4),
+                pitch(DP_C, PA_, 5),
+                pitch(DP_G, PA_, 4),
+                pitch(DP_C, PA_, 3),
+        };
+        struct tonal_pitch chord[] = {
+                pitch(DP_C, PA_, 3),
+                pitch(DP_E, PA_, 3),
+                pitch(DP_G, PA_, 3),
+        };
+        struct tonal_pitch ref = pitch(DP_C, PA_, 4);
+        struct tonal_pitch tp1;
+        struct tonal_lily w;
+
+        vtest(TONAL_OK == tonal_lily_init(&w, TONAL_LILY_RELATIVE, &ref, OC_C4));
+        vtest(TONAL_OK == tonal_lily_pitches(&w, tp, 10, " "));
+        vtest(TONAL_OK == tonal_lily_chord(&w, chord, 3));
+        vtest(TONAL_OK == tonal_lily_append(&w, " "));
+        /* A fifth up from the chord's c, not from its g */
+        tp1 = pitch(DP_G, PA_, 3);
+        vtest(TONAL_OK == tonal_lily_pitch(&w, &tp1));
+        vtest(0 == strcmp(w.buf, "c d e f g a b c g c,, <c e g> g'"));
+
+        /* Accidentals do not count: b sharp to c flat is a step up. */
+        tonal_lily_free(&w);
+        ref = pitch(DP_B, PA_s, 3);
+        vtest(TONAL_OK == tonal_lily_init(&w, TONAL_LILY_RELATIVE, &ref, OC_C4));
+        tp1 = pitch(DP_C, PA_b, 4);
+        vtest(TONAL_OK == tonal_lily_pitch(&w, &tp1));
+        tp1 = pitch(DP_F, PA_s, 3);
+        vtest(TONAL_OK == tonal_lily_pitch(&w, &tp1));
+        vtest(0 == strcmp(w.buf, "cesfis,"));
+
+        /* A failed chord leaves nothing behind. */
+        chord[1].diatonic_pitch = DP_NONE;
+        vtest(TONAL_FAIL == tonal_lily_chord(&w, chord, 3));
+        vtest(0 == strcmp(w.buf, "cesfis,"));
+        /* Nor moves the reference to its c: g is a step up from f sharp. */
+        tp1 = pitch(DP_G, PA_, 3);
+        vtest(TONAL_OK == tonal_lily_pitch(&w, &tp1));
+        vtest(0 == strcmp(w.buf, "cesfis,g"));
+        tonal_lily_free(&w);
+        return 0;
+}
+
+static int test_grow(void)
+{
+        static struct tonal_pitch tp[20000];
+        struct tonal_lily w;
+        size_t i;
+
+        for (i = 0; i < 20000; i++) {
+                tp[i] = pitch(i % 7, PA_s, 4);
+        }
+        vtest(TONAL_OK == tonal_lily_init(&w, TONAL_LILY_ABSOLUTE, NULL, OC_C4));
+        vtest(TONAL_OK == tonal_lily_pitches(&w, tp, 20000, "8 "));
+        vtest(20000 * strlen("cis'8 ") == w.len);
+        vtest(0 == strncmp(w.buf, "cis'8 dis'8 eis'8 ", 18));
+        vtest(w.len < w.max);
+        tonal_lily_free(&w);
+        return 0;
+}
+
+int main(void)
+{
+        test_snprint();
+        test_absolute();
+        test_relative();
+        test_grow();
+
+        vtest_report();
+        vtest_end();
+
+        return 0;
+}
@@ -0,0 +1,167 @@
+/*
+ * Copyright 2016 Martin Aberg
+ *
+ * This file is part of tonal.
+ *
+ * tonal is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * tonal is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Unit tests for the line of fifths */
+
+#include <tonal_lof.h>
+#include <vtest.h>
+
+static int test_tpc(void)
+{
+        struct tonal_pitch_class tpc;
+        struct tonal_pitch_class back;
+        int lof;
+        int prev;
+        int count = 0;
+
+        tpc_set(&tpc, DP_C, PA_);
+        vtest(TONAL_OK == tpc_to_lof(&tpc, &lof) && 0 == lof);
+        tpc_set(&tpc, DP_G, PA_);
+        vtest(TONAL_OK == tpc_to_lof(&tpc, &lof) && 1 == lof);
+        tpc_set(&tpc, DP_F, PA_);
+        vtest(TONAL_OK == tpc_to_lof(&tpc, &lof) && -1 == lof);
+        tpc_set(&tpc, DP_F, PA_s);
+        vtest(TONAL_OK == tpc_to_lof(&tpc, &lof) && 6 == lof);
+        tpc_set(&tpc, DP_B, PA_b);
+        vtest(TONAL_OK == tpc_to_lof(&tpc, &lof) && -2 == lof);
+        tpc_set(&tpc, DP_F, PA_bb);
+        vtest(TONAL_OK == tpc_to_lof(&tpc, &lof) && TONAL_LOF_MIN == lof);
+        tpc_set(&tpc, DP_B, PA_ss);
+        vtest(TONAL_OK == tpc_to_lof(&tpc, &lof) && TONAL_LOF_MAX == lof);
+        vtest(TONAL_FAIL == tpc_to_lof(&tpc, NULL));
+        vtest(TONAL_FAIL == tpc_to_lof(NULL, &lof));
+
+        /* Each position once, a fifth apart */
+        for (lof = TONAL_LOF_MIN; lof <= TONAL_LOF_MAX; lof++) {
+                vtest(TONAL_OK == lof_to_tpc(lof, &tpc));
+                vtest(TONAL_OK == tpc_to_lof(&tpc, &prev) && lof == prev);
+                if (TONAL_LOF_MIN < lof) {
+                        vtest(TONAL_OK == lof_to_tpc(lof - 1, &back));
+                        vtest(
+                                (back.diatonic_pitch - DP_C + 4) % 7 ==
+                                tpc.diatonic_pitch - DP_C
+                        );
+                }
+                count++;
+        }
+        vtest(7 * PA_NONE == count);
+        vtest(TONAL_FAIL == lof_to_tpc(TONAL_LOF_MIN - 1, &tpc));
+        vtest(TONAL_FAIL == lof_to_tpc(TONAL_LOF_MAX + 1, &tpc));
+        vtest(TONAL_FAIL == lof_to_tpc(0, NULL));
+        return 0;
+}
+
+static int test_tic(void)
+{
+        struct tonal_interval_class tic;
+        struct tonal_pitch_class tpc0, tpc1;
+        struct tonal_pitch tp0, tp1;
+        struct tonal_interval ti;
+        int lof, lof0, lof1;
+        int d;
+
+        tic_set(&tic, DI_PRIME, IA_PERFECT);
+        vtest(TONAL_OK == tic_to_lof(&tic, &lof) && 0 == lof);
+        tic_set(&tic, DI_FIFTH, IA_PERFECT);
+        vtest(TONAL_OK == tic_to_lof(&tic, &lof) && 1 == lof);
+        tic_set(&tic, DI_THIRD, IA_MINOR);
+        vtest(TONAL_OK == tic_to_lof(&tic, &lof) && -3 == lof);
+        tic_set(&tic, DI_FOURTH, IA_AUGMENTED);
+        vtest(TONAL_OK == tic_to_lof(&tic, &lof) && 6 == lof);
+        tic_set(&tic, DI_FIFTH, IA_DIMINISHED);
+        vtest(TONAL_OK == tic_to_lof(&tic, &lof) && -6 == lof);
+        tic_set(&tic, DI_SEVENTH, IA_DIMINISHED);
+        vtest(TONAL_OK == tic_to_lof(&tic, &lof) && -9 == lof);
+
+        vtest(TONAL_OK == lof_to_tic(4, &tic));
+        vtest(DI_THIRD == tic.diatonic_interval && IA_MAJOR == tic.interval_alteration);
+        vtest(TONAL_OK == lof_to_tic(-5, &tic));
+        vtest(DI_SECOND == tic.diatonic_interval && IA_MINOR == tic.interval_alteration);
+        /* Doubly diminished fourth */
+        vtest(TONAL_FAIL == lof_to_tic(-15, &tic));
+
+        /* The interval between two pitch classes is their difference. */
+        for (int dp0 = DP_C; dp0 <= DP_B; dp0++) {
+                for (int dp1 = DP_C; dp1 <= DP_B; dp1++) {
+                        tp_set(&tp0, dp0, PA_, 4);
+                        tp_set(&tp1, dp1, PA_, 5);
+                        vtest(TONAL_OK == tp_sub(&tp1, &tp0, &ti));
+                        vtest(TONAL_OK == tic_to_lof((struct tonal_interval_class *) &ti, &lof));
+                        tpc_set(&tpc0, dp0, PA_);
+                        tpc_set(&tpc1, dp1, PA_);
+                        tpc_to_lof(&tpc0, &lof0);
+                        tpc_to_lof(&tpc1, &lof1);
+                        vtest(lof1 - lof0 == lof);
+                        vtest(TONAL_OK == tpc_lof_distance(&tpc0, &tpc1, &d));
+                        vtest(d == (lof < 0 ? -lof : lof));
+                }
+        }
+
+        /* Enharmonic pitch classes are 12 apart. */
+        tpc_set(&tpc0, DP_G, PA_s);
+        tpc_set(&tpc1, DP_A, PA_b);
+        vtest(TONAL_OK == tpc_lof_distance(&tpc0, &tpc1, &d) && 12 == d);
+        vtest(TONAL_FAIL == tpc_lof_distance(&tpc0, &tpc1, NULL));
+        return 0;
+}
+
+static int test_batch(void)
+{
+        struct tonal_pitch tp[5];
+        int lof[5];
+        int status[5];
+        double center;
+
+        /* Notes of G major, centered between G and D */
+        tp_set(&tp[0], DP_G, PA_, 3);
+        tp_set(&tp[1], DP_B, PA_, 3);
+        tp_set(&tp[2], DP_D, PA_, 4);
+        tp_set(&tp[3], DP_F, PA_s, 4);
+        tp_set(&tp[4], DP_C, PA_, 5);
+        vtest(TONAL_OK == tp_to_lof_n(tp, lof, status, 5));
+        vtest(1 == lof[0] && 5 == lof[1] && 2 == lof[2] && 6 == lof[3] && 0 == lof[4]);
+        for (int i = 0; i < 5; i++) { vtest(TONAL_E_OK == status[i]); }
+
+        vtest(TONAL_OK == tp_lof_center_n(tp, 5, &center));
+        vtest(2.8 == center);
+
+        tp[2].pitch_alteration = PA_NONE;
+        vtest(TONAL_FAIL == tp_to_lof_n(tp, lof, status, 5));
+        vtest(TONAL_E_ALTERATION == status[2] && TONAL_E_OK == status[3]);
+        vtest(6 == lof[3]);
+        vtest(TONAL_FAIL == tp_to_lof_n(tp, lof, NULL, 5));
+        vtest(TONAL_FAIL == tp_lof_center_n(tp, 5, &center));
+        vtest(TONAL_FAIL == tp_lof_center_n(tp, 0, &center));
+        vtest(TONAL_OK == tp_to_lof_n(tp, lof, status, 0));
+        vtest(TONAL_FAIL == tp_to_lof_n(NULL, lof, status, 2));
+        vtest(TONAL_E_NULL == status[1]);
+        return 0;
+}
+
+int main(void)
+{
+        test_tpc();
+        test_tic();
+        test_batch();
+
+        vtest_report();
+        vtest_end();
+
+        return 0;
+}
@@ -0,0 +1,242 @@
+/*
+ * Copyright 2016 Martin Aberg
+ *
+ * This file is part of tonal.
+ *
+ * tonal is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * tonal is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Unit tests for the MusicXML pitch scanner */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <tonal_musicxml.h>
+#include <vtest.h>
+
+static const char PARTWISE[] =
+        "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"no\"?>\n"
+        "<!DOCTYPE score-partwise PUBLIC\n"
+        "    \"-//Recordare//DTD MusicXML 3.1 Partwise//EN\"\n"
+        "    \"http://www.musicxml.org/dtds/partwise.dtd\">\n"
+        "<score-partwise version=\"3.1\">\n"
+        "  <part-list>\n"
+        "    <score-part id=\"P1\"><part-name>Voice</part-name></score-part>\n"
+        "    <score-part id='P2'><part-name>a > b</part-name></score-part>\n"
+        "  </part-list>\n"
+        "  <part id=\"P1\">\n"
+        "    <measure number=\"1\">\n"
+        "      <attributes><divisions>2</divisions></attributes>\n"
+        "      <note default-x=\"80\">\n"
+        "        <pitch><step>E</step><alter>-1</alter><octave>4</octave></pitch>\n"
+        "        <duration>2</duration><voice>1</voice><type>quarter</type>\n"
+        "        <notations><tied type=\"start\"/></notations>\n"
+        "      </note>\n"
+        "      <!-- <note><pitch><step>X</step></pitch></note> -->\n"
+        "      <note><rest/><duration>2</duration></note>\n"
+        "      <backup><duration>4</duration></backup>\n"
+        "      <note>\n"
+        "        <grace/>\n"
+        "        <pitch>\n"
+        "          <step> G </step>\n"
+        "          <octave>3</octave>\n"
+        "        </pitch>\n"
+        "        <voice>2</voice>\n"
+        "      </note>\n"
+        "    </measure>\n"
+        "    <measure number=\"2\">\n"
+        "      <note><pitch><step>C</step><alter>1.0</alter><octave>5</octave></pitch>"
+        "<duration>4</duration></note>\n"
+        "      <note><chord/><pitch><step>E</step><alter>0.5</alter><octave>5</octave>"
+        "</pitch><duration>4</duration></note>\n"
+        "    </measure>\n"
+        "  </part>\n"
+        "  <part id='P2'>\n"
+        "    <measure number=\"1\">\n"
+        "      <direction><sound tempo=\"60\"/><words><![CDATA[<note>]]></words></direction>\n"
+        "      <note><pitch><step>H</step><octave>2</octave></pitch></note>\n"
+        "      <note><unpitched><display-step>F</display-step>"
+        "<display-octave>4</display-octave></unpitched></note>\n"
+        "      <note><pitch><step>B</step><alter>-2</alter><octave>-1</octave></pitch>"
+        "<duration>8</duration></note>\n"
+        "    </measure>\n"
+        "  </part>\n"
+        "</score-partwise>\n";
+
+static const char TIMEWISE[] =
+        "<score-timewise>\n"
+        "  <part-list>\n"
+        "    <score-part id=\"P1\"/><score-part id=\"P2\"/>\n"
+        "  </part-list>\n"
+        "  <measure number=\"1\">\n"
+        "    <part id=\"P2\"><note><pitch><step>A</step><octave>3</octave></pitch></note></part>\n"
+        "    <part id=\"P1\"><note><pitch><step>A</step><octave>4</octave></pitch></note></part>\n"
+        "  </measure>\n"
+        "  <measure number=\"2\">\n"
+        "    <part id=\"P1\"><note><pitch><step>B</step><octave>4</octave></pitch></note></part>\n"
+        "  </measure>\n"
+        "</score-timewise>\n";
+
+#define MAXNOTES 16
+
+struct notes {
+        struct tonal_musicxml_note note[MAXNOTES];
+        int n;
+        /* Stop after this many notes, if not 0 */
+        int stop;
+};
+
+static int collect(const struct tonal_musicxml_note *note, void *arg)
+{
+        struct notes *notes = arg;
+
+        if (MAXNOTES <= notes->n) { return TONAL_FAIL; }
+        notes->note[notes->n++] = *note;
+        if (notes->stop && notes->stop == notes->n) { return 2; }
+        return TONAL_OK;
+}
+
+static int is_pitch(const struct tonal_musicxml_note *note, int dp, int pa, int o)
+{
+        return TONAL_E_OK == note->error &&
+                dp == note->pitch.diatonic_pitch &&
+                pa == note->pitch.pitch_alteration &&
+                o == note->pitch.octave;
+}
+
+static int test_partwise(void)
+{
+        struct notes notes = { .n = 0 };
+        struct tonal_musicxml_note *n = notes.note;
+
+        vtest(TONAL_OK == tonal_musicxml_scan(
+                PARTWISE, sizeof PARTWISE - 1, collect, &notes
+        ));
+        vtest(6 == notes.n);
+
+        vtest(is_pitch(&n[0], DP_E, PA_b, 4));
+        vtest(0 == n[0].part);
+        vtest(2 == n[0].part_id_len && 0 == memcmp(n[0].part_id, "P1", 2));
+        vtest(0 == n[0].measure);
+        vtest(1 == n[0].voice);
+        vtest(2 == n[0].duration);
+        vtest(!n[0].chord);
+        vtest(0 == memcmp(PARTWISE + n[0].offset, "<note ", 6));
+
+        /* Grace note */
+        vtest(is_pitch(&n[1], DP_G, PA_, 3));
+        vtest(2 == n[1].voice);
+        vtest(0 == n[1].duration);
+
+        vtest(is_pitch(&n[2], DP_C, PA_s, 5));
+        vtest(1 == n[2].measure);
+        vtest(4 == n[2].duration);
+
+        /* Quarter tone */
+        vtest(TONAL_E_ALTERATION == n[3].error);
+        vtest(n[3].chord);
+
+        /* Second part, measures numbered from 0 again */
+        vtest(TONAL_E_DIATONIC == n[4].error);
+        vtest(1 == n[4].part);
+        vtest(2 == n[4].part_id_len && 0 == memcmp(n[4].part_id, "P2", 2));
+        vtest(0 == n[4].measure);
+
+        vtest(is_pitch(&n[5], DP_B, PA_bb, -1));
+        vtest(8 == n[5].duration);
+        return 0;
+}
+
+static int test_timewise(void)
+{
+        struct notes notes = { .n = 0 };
+        struct tonal_musicxml_note *n = notes.note;
+
+        vtest(TONAL_OK == tonal_musicxml_scan(
+                TIMEWISE, sizeof TIMEWISE - 1, collect, &notes
+        ));
+        vtest(3 == notes.n);
+        vtest(is_pitch(&n[0], DP_A, PA_, 3));
+        vtest(1 == n[0].part && 0 == n[0].measure);
+        vtest(is_pitch(&n[1], DP_A, PA_, 4));
+        vtest(0 == n[1].part && 0 == n[1].measure);
+        vtest(is_pitch(&n[2], DP_B, PA_, 4));
+        vtest(0 == n[2].part && 1 == n[2].measure);
+        return 0;
+}
+
+static int test_errors(void)
+{
+        struct notes notes = { .n = 0 };
+        size_t cut;
+
+        /* The callback stops the scan. */
+        notes.stop = 2;
+        vtest(2 == tonal_musicxml_scan(
+                PARTWISE, sizeof PARTWISE - 1, collect, &notes
+        ));
+        vtest(2 == notes.n);
+
+        /* Truncated inside a tag or inside a note text */
+        cut = strstr(PARTWISE, "<step> G") - PARTWISE;
+        vtest(TONAL_FAIL == tonal_musicxml_scan(PARTWISE, cut + 3, collect, &notes));
+        vtest(TONAL_FAIL == tonal_musicxml_scan(PARTWISE, cut + 7, collect, &notes));
+        cut = strstr(PARTWISE, "<!--") - PARTWISE;
+        vtest(TONAL_FAIL == tonal_musicxml_scan(PARTWISE, cut + 10, collect, &notes));
+
+        notes.n = 0;
+        notes.stop = 0;
+        vtest(TONAL_OK == tonal_musicxml_scan("", 0, collect, &notes));
+        vtest(TONAL_OK == tonal_musicxml_scan("text", 4, collect, &notes));
+        vtest(0 == notes.n);
+        vtest(TONAL_FAIL == tonal_musicxml_scan(NULL, 1, collect, &notes));
+        vtest(TONAL_FAIL == tonal_musicxml_scan(PARTWISE, 1, NULL, &notes));
+        vtest(TONAL_FAIL == tonal_musicxml_scan_file(
+                "/nonexistent/score.musicxml", collect, &notes
+        ));
+        return 0;
+}
+
+static int test_file(void)
+{
+        struct notes notes = { .n = 0 };
+        char path[] = "test_tonal_musicxml.tmp";
+        FILE *f;
+
+        f = fopen(path, "w");
+        vtest(NULL != f);
+        if (NULL == f) { return 1; }
+        fwrite(TIMEWISE, 1, sizeof TIMEWISE - 1, f);
+        fclose(f);
+
+        vtest(TONAL_OK == tonal_musicxml_scan_file(path, collect, &notes));
+        vtest(3 == notes.n);
+        vtest(is_pitch(&notes.note[2], DP_B, PA_, 4));
+        remove(path);
+        return 0;
+}
+
+int main(void)
+{
+        test_partwise();
+        test_timewise();
+        test_errors();
+        test_file();
+
+        vtest_report();
+        vtest_end();
+
+        return 0;
+}
@@ -0,0 +1,195 @@
+/*
+ * Copyright 2016 Martin Aberg
+ *
+ * This file is part of tonal.
+ *
+ * tonal is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * tonal is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Unit tests for the pitch rope, against a plain array */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <tonal_rope.h>
+#include <vtest.h>
+
+#define MAX 20000
+
+static struct tonal_pitch model[MAX];
+static size_t nmodel;
+
+static unsigned long rnd(void)
+{
+        static unsigned long long x = 88172645463325252ULL;
+
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        return x >> 11;
+}
+
+static struct tonal_pitch random_pitch(void)
+{
+        struct tonal_pitch tp;
+
+        tp.diatonic_pitch = rnd() % DP_NONE;
+        tp.pitch_alteration = PA_ + (int) (rnd() % 5) - 2;
+        tp.octave = rnd() % 11 - 1;
+        return tp;
+}
+
+static int is_equal(const struct tonal_pitch *a, const struct tonal_pitch *b)
+{
+        return a->diatonic_pitch == b->diatonic_pitch &&
+                a->pitch_alteration == b->pitch_alteration &&
+                a->octave == b->octave;
+}
+
+static int check_histogram(const struct tonal_rope *r, size_t begin, size_t end)
+{
+        size_t hist[12];
+        size_t want[12] = { 0 };
+        int mnn;
+
+        for (size_t i = begin; i < end; i++) {
+                mnn = tp_to_mnn(&model[i]);
+                want[(mnn % 12 + 12) % 12]++;
+        }
+        if (TONAL_OK != tonal_rope_histogram(r, begin, end, hist)) { return 0; }
+        return 0 == memcmp(hist, want, sizeof hist);
+}
+
+static int check_all(const struct tonal_rope *r)
+{
+        static struct tonal_pitch tp[MAX];
+
+        if (r->size != nmodel) { return 0; }
+        if (TONAL_OK != tonal_rope_get(r, 0, tp, nmodel)) { return 0; }
+        for (size_t i = 0; i < nmodel; i++) {
+                if (!is_equal(&tp[i], &model[i])) { return 0; }
+        }
+        return 1;
+}
+
+static int test_basic(void)
+{
+        struct tonal_pitch tp[3];
+        struct tonal_rope r;
+        size_t hist[12];
+
+        vtest(TONAL_OK == tonal_rope_init(&r));
+        vtest(0 == r.size);
+        vtest(TONAL_OK == tonal_rope_histogram(&r, 0, 0, hist));
+        vtest(0 == hist[0]);
+
+        tp_set(&tp[0], DP_C, PA_, 4);
+        tp_set(&tp[1], DP_B, PA_s, 3);
+        tp_set(&tp[2], DP_E, PA_b, 4);
+        vtest(TONAL_OK == tonal_rope_insert(&r, 0, tp, 3));
+        vtest(TONAL_OK == tonal_rope_histogram(&r, 0, 3, hist));
+        vtest(2 == hist[0] && 1 == hist[3]);
+        vtest(TONAL_OK == tonal_rope_histogram(&r, 1, 3, hist));
+        vtest(1 == hist[0] && 1 == hist[3]);
+
+        tp_set(&tp[0], DP_D, PA_s, 2);
+        vtest(TONAL_OK == tonal_rope_set(&r, 0, &tp[0]));
+        vtest(TONAL_OK == tonal_rope_histogram(&r, 0, 3, hist));
+        vtest(1 == hist[0] && 2 == hist[3]);
+
+        /* Invalid arguments change nothing. */
+        tp[1].diatonic_pitch = DP_NONE;
+        vtest(TONAL_FAIL == tonal_rope_insert(&r, 0, tp, 2));
+        vtest(TONAL_FAIL == tonal_rope_set(&r, 0, &tp[1]));
+        vtest(TONAL_FAIL == tonal_rope_insert(&r, 4, tp, 1));
+        vtest(TONAL_FAIL == tonal_rope_set(&r, 3, &tp[0]));
+        vtest(TONAL_FAIL == tonal_rope_erase(&r, 2, 2));
+        vtest(TONAL_FAIL == tonal_rope_histogram(&r, 2, 1, hist));
+        vtest(TONAL_FAIL == tonal_rope_histogram(&r, 0, 4, hist));
+        vtest(3 == r.size);
+
+        vtest(TONAL_OK == tonal_rope_erase(&r, 0, 3));
+        vtest(0 == r.size);
+        tonal_rope_free(&r);
+        return 0;
+}
+
+static int test_random(void)
+{
+        struct tonal_pitch tp[1000];
+        struct tonal_rope r;
+        size_t pos;
+        size_t n;
+        size_t begin;
+        size_t end;
+        int ok = 1;
+
+        vtest(TONAL_OK == tonal_rope_init(&r));
+        nmodel = 0;
+        for (int op = 0; op < 4000; op++) {
+                pos = rnd() % (nmodel + 1);
+                switch (rnd() % 4) {
+                case 0:
+                case 1:
+                        n = rnd() % (rnd() % 8 ? 8 : 1000) + 1;
+                        if (MAX < nmodel + n) { break; }
+                        for (size_t i = 0; i < n; i++) { tp[i] = random_pitch(); }
+                        ok &= TONAL_OK == tonal_rope_insert(&r, pos, tp, n);
+                        memmove(&model[pos + n], &model[pos], (nmodel - pos) * sizeof *model);
+                        memcpy(&model[pos], tp, n * sizeof *tp);
+                        nmodel += n;
+                        break;
+                case 2:
+                        n = rnd() % (rnd() % 8 ? 8 : 1000);
+                        if (nmodel - pos < n) { n = nmodel - pos; }
+                        ok &= TONAL_OK == tonal_rope_erase(&r, pos, n);
+                        memmove(&model[pos], &model[pos + n], (nmodel - pos - n) * sizeof *model);
+                        nmodel -= n;
+                        break;
+                case 3:
+                        if (pos == nmodel) { break; }
+                        tp[0] = random_pitch();
+                        ok &= TONAL_OK == tonal_rope_set(&r, pos, &tp[0]);
+                        model[pos] = tp[0];
+                        break;
+                }
+                begin = rnd() % (nmodel + 1);
+                end = begin + rnd() % (nmodel - begin + 1);
+                ok &= check_histogram(&r, begin, end);
+                if (0 == op % 100) { ok &= check_all(&r); }
+        }
+        vtest(ok);
+        vtest(check_all(&r));
+        vtest(check_histogram(&r, 0, nmodel));
+
+        /* Down to nothing and back */
+        vtest(TONAL_OK == tonal_rope_erase(&r, 0, nmodel));
+        nmodel = 0;
+        vtest(check_all(&r));
+        vtest(TONAL_OK == tonal_rope_insert(&r, 0, tp, 1));
+        vtest(1 == r.size);
+        tonal_rope_free(&r);
+        return 0;
+}
+
+int main(void)
+{
+        test_basic();
+        test_random();
+
+        vtest_report();
+        vtest_end();
+
+        return 0;
+}
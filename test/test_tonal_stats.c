@@ -0,0 +1,256 @@
+/*
+ * Copyright 2016 Martin Aberg
+ *
+ * This file is part of tonal.
+ *
+ * tonal is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * tonal is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Unit tests for call statistics, built with -DTONAL_STATS and
+ * -DTONAL_STATS_LATENCY
+ */
+
+#define _POSIX_C_SOURCE 200112L
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <tonal.h>
+#include <tonal_consonance.h>
+#include <tonal_kern.h>
+#include <tonal_stats.h>
+#include <vtest.h>
+
+enum { NTHREADS = 4, NCALLS = 1000 };
+
+static void *worker(void *arg)
+{
+        struct tonal_pitch tp;
+        struct tonal_pitch tp_sum;
+        struct tonal_interval ti;
+
+        (void) arg;
+        tp_set(&tp, DP_E, PA_s, 4);
+        ti_set(&ti, DI_PRIME, IA_AUGMENTED, 0, ID_UP);
+        for (int i = 0; i < NCALLS; i++) {
+                tp_add(&tp, &ti, &tp_sum);
+        }
+        /* E## + A1 */
+        tp.pitch_alteration = PA_ss;
+        tp_add(&tp, &ti, &tp_sum);
+        return NULL;
+}
+
+static int test_threads(void)
+{
+        struct tonal_stats s0;
+        struct tonal_stats s1;
+        pthread_t t[NTHREADS];
+        const struct tonal_stats_fn *f0 = &s0.fn[TONAL_STATS_TP_ADD];
+        const struct tonal_stats_fn *f1 = &s1.fn[TONAL_STATS_TP_ADD];
+
+        vtest(TONAL_OK == tonal_stats_snapshot(&s0));
+        for (int i = 0; i < NTHREADS; i++) {
+                vtest(0 == pthread_create(&t[i], NULL, worker, NULL));
+        }
+        for (int i = 0; i < NTHREADS; i++) {
+                pthread_join(t[i], NULL);
+        }
+        /* All workers have exited, their counts are retired. */
+        vtest(TONAL_OK == tonal_stats_snapshot(&s1));
+        vtest(f1->calls - f0->calls == NTHREADS * (NCALLS + 1));
+        vtest(f1->elements - f0->elements == NTHREADS * (NCALLS + 1));
+        vtest(f1->failures[TONAL_E_RANGE] - f0->failures[TONAL_E_RANGE] == NTHREADS);
+        vtest(f1->failures[TONAL_E_OK] == 0);
+        return 0;
+}
+
+static int test_batch(void)
+{
+        enum { N = 100 };
+        struct tonal_pitch tp[N];
+        int mnn[N];
+        struct tonal_stats s0;
+        struct tonal_stats s1;
+        const struct tonal_stats_fn *f0 = &s0.fn[TONAL_STATS_TP_TO_MNN_N];
+        const struct tonal_stats_fn *f1 = &s1.fn[TONAL_STATS_TP_TO_MNN_N];
+
+        for (int i = 0; i < N; i++) {
+                tp_set(&tp[i], DP_C, PA_, i);
+        }
+        tp[10].diatonic_pitch = DP_NONE;
+        tp[20].pitch_alteration = PA_NONE;
+
+        vtest(TONAL_OK == tonal_stats_snapshot(&s0));
+        tp_to_mnn_n(tp, mnn, N);
+        tp_to_mnn_n(tp, mnn, 1);
+        tp_to_mnn_n(tp, mnn, 0);
+        tp_to_mnn_n(NULL, mnn, 1);
+        vtest(TONAL_OK == tonal_stats_snapshot(&s1));
+
+        vtest(f1->calls - f0->calls == 4);
+        vtest(f1->elements - f0->elements == N + 1 + 0 + 1);
+        vtest(f1->batch[0] - f0->batch[0] == 1);
+        vtest(f1->batch[1] - f0->batch[1] == 2);
+        /* 64 <= 100 < 128 */
+        vtest(f1->batch[7] - f0->batch[7] == 1);
+        vtest(f1->failures[TONAL_E_DIATONIC] - f0->failures[TONAL_E_DIATONIC] == 1);
+        vtest(f1->failures[TONAL_E_ALTERATION] - f0->failures[TONAL_E_ALTERATION] == 1);
+        vtest(f1->failures[TONAL_E_NULL] - f0->failures[TONAL_E_NULL] == 1);
+        return 0;
+}
+
+static int count_notes(const struct tonal_kern_note *note, void *arg)
+{
+        (void) note;
+        ++*(int *) arg;
+        return TONAL_OK;
+}
+
+static int test_readers(void)
+{
+        enum { N = 100 };
+        static const char DOC[] = "**kern\t**kern\n4c\t4e\n4d\t4f\n*-\t*-\n";
+        static const char BAD[] = "4c\n";
+        struct tonal_consonance c;
+        struct tonal_pitch v0[N], v1[N];
+        const struct tonal_pitch *pitch[2] = { v0, v1 };
+        double score[N];
+        int status[N];
+        int notes = 0;
+        struct tonal_stats s0;
+        struct tonal_stats s1;
+        const struct tonal_stats_fn *k0 = &s0.fn[TONAL_STATS_KERN_SCAN];
+        const struct tonal_stats_fn *k1 = &s1.fn[TONAL_STATS_KERN_SCAN];
+        const struct tonal_stats_fn *c0 = &s0.fn[TONAL_STATS_CONSONANCE_N];
+        const struct tonal_stats_fn *c1 = &s1.fn[TONAL_STATS_CONSONANCE_N];
+        unsigned long long timed;
+
+        for (int i = 0; i < N; i++) {
+                tp_set(&v0[i], DP_C, PA_, 4);
+                tp_set(&v1[i], DP_E, PA_, 4);
+        }
+        v1[30].diatonic_pitch = DP_NONE;
+        tonal_consonance_init(&c, TONAL_CONSONANCE_TABLE);
+
+        vtest(TONAL_OK == tonal_stats_snapshot(&s0));
+        vtest(TONAL_OK == tonal_kern_scan(DOC, sizeof DOC - 1, OC_C4, count_notes, &notes));
+        vtest(TONAL_FAIL == tonal_kern_scan(BAD, sizeof BAD - 1, OC_C4, count_notes, &notes));
+        vtest(TONAL_FAIL == tonal_consonance_n(&c, pitch, 2, score, status, N));
+        vtest(TONAL_FAIL == tonal_consonance_n(&c, NULL, 2, score, status, 1));
+        vtest(TONAL_OK == tonal_stats_snapshot(&s1));
+
+        vtest(4 == notes);
+        vtest(k1->calls - k0->calls == 2);
+        vtest(k1->elements - k0->elements == sizeof DOC - 1 + sizeof BAD - 1);
+        vtest(k1->failures[TONAL_E_FAIL] - k0->failures[TONAL_E_FAIL] == 1);
+        vtest(c1->calls - c0->calls == 2);
+        vtest(c1->elements - c0->elements == N + 1);
+        vtest(c1->failures[TONAL_E_DIATONIC] - c0->failures[TONAL_E_DIATONIC] == 1);
+        vtest(c1->failures[TONAL_E_NULL] - c0->failures[TONAL_E_NULL] == 1);
+        timed = 0;
+        for (int b = 0; b < TONAL_STATS_LATENCY_BUCKETS; b++) {
+                timed += c1->latency[b] - c0->latency[b];
+        }
+        vtest(2 == timed);
+        return 0;
+}
+
+static int test_latency(void)
+{
+        enum { N = 64 };
+        struct tonal_pitch tp[N];
+        struct tonal_pitch tp_sum[N];
+        struct tonal_interval ti;
+        struct tonal_stats s;
+        struct tonal_stats_fn f;
+        const struct tonal_stats_fn *fs = &s.fn[TONAL_STATS_TP_TRANSPOSE_N];
+        unsigned long long timed;
+
+        for (int i = 0; i < N; i++) {
+                tp_set(&tp[i], DP_C + i % 7, PA_, 4);
+        }
+        ti_set(&ti, DI_THIRD, IA_MAJOR, 0, ID_UP);
+        for (int i = 0; i < 1000; i++) {
+                tp_transpose_n(tp, &ti, tp_sum, NULL, N);
+        }
+        vtest(TONAL_OK == tonal_stats_snapshot(&s));
+        timed = 0;
+        for (int b = 0; b < TONAL_STATS_LATENCY_BUCKETS; b++) {
+                timed += fs->latency[b];
+        }
+        vtest(timed == fs->calls);
+        vtest(0 < tonal_stats_percentile(fs, 0.5));
+        vtest(tonal_stats_percentile(fs, 0.5) <= tonal_stats_percentile(fs, 0.99));
+        vtest(tonal_stats_percentile(fs, 0.99) <= tonal_stats_percentile(fs, 0.999));
+
+        /* Buckets below 8 ns are exact, bucket 100 holds 24576 to 26623 ns. */
+        memset(&f, 0, sizeof f);
+        vtest(0 == tonal_stats_percentile(&f, 0.5));
+        f.latency[5] = 990;
+        f.latency[100] = 10;
+        vtest(5 == tonal_stats_percentile(&f, 0.5));
+        vtest(5 == tonal_stats_percentile(&f, 0.99));
+        vtest(26623 == tonal_stats_percentile(&f, 0.999));
+        vtest(26623 == tonal_stats_percentile(&f, 1));
+        vtest(5 == tonal_stats_percentile(&f, 0));
+        return 0;
+}
+
+static int test_print(void)
+{
+        struct tonal_stats s;
+        char buf[8192];
+        FILE *f;
+        size_t len;
+
+        tonal_stats_snapshot(&s);
+
+        f = tmpfile();
+        vtest(TONAL_OK == tonal_stats_print_json(f, &s));
+        rewind(f);
+        len = fread(buf, 1, sizeof buf - 1, f);
+        buf[len] = '\0';
+        fclose(f);
+        vtest('{' == buf[0]);
+        vtest(0 == strcmp(buf + len - 2, "}\n"));
+        vtest(NULL != strstr(buf, "\"tp_sub_n\":{\"calls\":0,"));
+
+        f = tmpfile();
+        vtest(TONAL_OK == tonal_stats_print(f, &s));
+        rewind(f);
+        len = fread(buf, 1, sizeof buf - 1, f);
+        buf[len] = '\0';
+        fclose(f);
+        vtest(0 == strncmp(buf, "tp_add ", 7));
+        vtest(NULL == strstr(buf, "tp_sub_n"));
+
+        vtest(TONAL_FAIL == tonal_stats_print(stdout, NULL));
+        return 0;
+}
+
+int main(void)
+{
+        test_threads();
+        test_batch();
+        test_readers();
+        test_latency();
+        test_print();
+
+        vtest_report();
+        vtest_end();
+
+        return 0;
+}
@@ -0,0 +1,162 @@
+/*
+ * Copyright 2016 Martin Aberg
+ *
+ * This file is part of tonal.
+ *
+ * tonal is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * tonal is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Unit tests for the range adaptors in tonal_views.hpp */
+
+#include <list>
+#include <span>
+#include <vector>
+
+#include <tonal_views.hpp>
+#include <vtest.h>
+
+using namespace tonal;
+
+/* Enough pitches to span several chunks. */
+static std::vector<Pitch> make_pitches(void)
+{
+        std::vector<Pitch> v;
+        for (int o = 0; o < 20; o++)
+        for (int dp = DP_C; dp <= DP_B; dp++)
+        for (int pa = PA_bb; pa <= PA_ss; pa++) {
+                v.push_back(Pitch(dp, pa, o));
+        }
+        return v;
+}
+
+static_assert(tonal_view<std::span<Pitch>, detail::to_mnn_op>::batched);
+static_assert(!tonal_view<
+        std::ranges::ref_view<std::list<Pitch>>, detail::to_mnn_op
+>::batched);
+/* The chunk is not part of the iterator. */
+static_assert(sizeof (std::ranges::iterator_t<
+        tonal_view<std::span<Pitch>, detail::transpose_op>
+>) <= 4 * sizeof (void *));
+static_assert(std::forward_iterator<std::ranges::iterator_t<
+        tonal_view<std::span<Pitch>, detail::transpose_op>
+>>);
+
+static int test_transpose(void)
+{
+        const Interval M3(DI_THIRD, IA_MAJOR);
+        std::vector<Pitch> v = make_pitches();
+        std::list<Pitch> l(v.begin(), v.end());
+        size_t i;
+
+        i = 0;
+        for (std::optional<Pitch> tp : v | views::transpose(M3)) {
+                vtest(tp == v[i] + M3);
+                i++;
+        }
+        vtest(i == v.size());
+
+        i = 0;
+        for (std::optional<Pitch> tp : l | views::transpose(M3)) {
+                vtest(tp == v[i] + M3);
+                i++;
+        }
+        vtest(i == v.size());
+
+        std::vector<tonal_pitch> c(v.begin(), v.end());
+        std::span<const tonal_pitch> s(c);
+        vtest((s | views::transpose(M3)).size() == v.size());
+        vtest(*(s | views::transpose(M3)).begin() == v[0] + M3);
+        return 0;
+}
+
+static int test_intervals(void)
+{
+        std::vector<Pitch> v = make_pitches();
+        size_t i;
+
+        i = 0;
+        for (std::optional<Interval> ti : v | views::intervals) {
+                vtest(ti == v[i + 1] - v[i]);
+                i++;
+        }
+        vtest(i + 1 == v.size());
+
+        std::vector<Pitch> one(1);
+        vtest((one | views::intervals).empty());
+        std::vector<Pitch> none;
+        vtest((none | views::intervals).empty());
+        return 0;
+}
+
+static int test_to_mnn(void)
+{
+        std::vector<Pitch> v = make_pitches();
+        size_t i;
+
+        v[300].pitch_alteration = PA_NONE;
+        i = 0;
+        for (std::optional<int> mnn : v | views::to_mnn) {
+                vtest(mnn == v[i].mnn());
+                i++;
+        }
+        vtest(i == v.size());
+        vtest(!*std::ranges::next((v | views::to_mnn).begin(), 300));
+
+        /* Copies in different chunks, read in turn, refill their chunk. */
+        auto view = v | views::to_mnn;
+        auto a = view.begin();
+        auto b = std::ranges::next(a, 300);
+        auto c = a;
+        for (i = 0; i + 300 < v.size(); i++, a++, b++) {
+                vtest(*a == v[i].mnn());
+                vtest(*b == v[i + 300].mnn());
+        }
+        vtest(*c == v[0].mnn());
+        vtest(b == view.end());
+        return 0;
+}
+
+/* Views chain through the element-wise path. */
+static int test_pipeline(void)
+{
+        const Interval P5(DI_FIFTH, IA_PERFECT);
+        const Interval P4d(DI_FOURTH, IA_PERFECT, 0, ID_DOWN);
+        std::vector<Pitch> v = make_pitches();
+        size_t i;
+
+        i = 0;
+        for (
+                std::optional<int> mnn :
+                v | views::transpose(P5) | views::transpose(P4d) | views::to_mnn
+        ) {
+                std::optional<Pitch> tp = v[i] + P5 + P4d;
+                vtest(mnn == (tp ? tp->mnn() : std::nullopt));
+                i++;
+        }
+        vtest(i == v.size());
+        return 0;
+}
+
+int main(void)
+{
+        test_transpose();
+        test_intervals();
+        test_to_mnn();
+        test_pipeline();
+
+        vtest_report();
+        vtest_end();
+
+        return 0;
+}
@@ -0,0 +1,129 @@
+/*
+ * Copyright 2016 Martin Aberg
+ *
+ * This file is part of tonal.
+ *
+ * tonal is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * tonal is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Unit tests for the wide alteration range, built with -DTONAL_ALTERATION_MAX=3 */
+
+#include <string.h>
+
+#include <tonal.h>
+#include <vtest.h>
+
+#if 3 != TONAL_ALTERATION_MAX
+#error "Build with -DTONAL_ALTERATION_MAX=3"
+#endif
+
+/* Print to a string with one of the *_print functions. */
+#define SPRINT(buf, fn, x) do { \
+        FILE *f_ = tmpfile(); \
+        size_t n_; \
+        vtest(TONAL_OK == fn(f_, x)); \
+        rewind(f_); \
+        n_ = fread(buf, 1, sizeof buf - 1, f_); \
+        buf[n_] = '\0'; \
+        fclose(f_); \
+} while (0)
+
+static int test_enums(void)
+{
+        vtest(0 == PA_ALTERATION(-3));
+        vtest(1 == PA_bb);
+        vtest(PA_NONE == PA_ALTERATION(4));
+        vtest(0 == IA_DIMINISHED_N(2));
+        vtest(1 == IA_DIMINISHED);
+        vtest(IA_NONE == IA_AUGMENTED_N(3));
+        vtest(0 == strcmp(pitch_alteration_str[PA_ALTERATION(-3)], "bbb"));
+        vtest(0 == strcmp(pitch_alteration_str[PA_ALTERATION(3)], "###"));
+        vtest(0 == strcmp(pitch_alteration_str[PA_], ""));
+        vtest(0 == strcmp(pitch_alteration_str[PA_NONE], "NONE"));
+        vtest(0 == strcmp(
+                interval_alteration_str[IA_DIMINISHED_N(2)],
+                "Doubly Diminished"
+        ));
+        vtest(0 == strcmp(
+                interval_alteration_str[IA_AUGMENTED_N(2)],
+                "Doubly Augmented"
+        ));
+        vtest(0 == strcmp(interval_alteration_str[IA_NONE], "NONE"));
+        return 0;
+}
+
+static int test_arithmetic(void)
+{
+        struct tonal_pitch tp;
+        struct tonal_pitch tp_sum;
+        struct tonal_interval ti0;
+        struct tonal_interval ti1;
+        struct tonal_interval ti;
+        char buf[64];
+
+        /* A4 + A1 == AA4 */
+        vtest(TONAL_OK == ti_set(&ti0, DI_FOURTH, IA_AUGMENTED, 0, ID_UP));
+        vtest(TONAL_OK == ti_set(&ti1, DI_PRIME, IA_AUGMENTED, 0, ID_UP));
+        vtest(TONAL_OK == ti_add(&ti0, &ti1, &ti));
+        vtest(DI_FOURTH == ti.diatonic_interval);
+        vtest(IA_AUGMENTED_N(2) == ti.interval_alteration);
+        SPRINT(buf, ti_print, &ti);
+        vtest(0 == strcmp(buf, "Up 0 Octave(s) + Doubly Augmented Fourth"));
+
+        /* d5 - A1 == dd5 */
+        vtest(TONAL_OK == ti_set(&ti0, DI_FIFTH, IA_DIMINISHED, 0, ID_UP));
+        vtest(TONAL_OK == ti_sub(&ti0, &ti1, &ti));
+        vtest(DI_FIFTH == ti.diatonic_interval);
+        vtest(IA_DIMINISHED_N(2) == ti.interval_alteration);
+
+        /* E## + A1 == E### */
+        vtest(TONAL_OK == tp_set(&tp, DP_E, PA_ss, 4));
+        vtest(TONAL_OK == tp_add(&tp, &ti1, &tp_sum));
+        vtest(PA_ALTERATION(3) == tp_sum.pitch_alteration);
+        vtest(tp_to_mnn(&tp_sum) == tp_to_mnn(&tp) + 1);
+        SPRINT(buf, tp_print, &tp_sum);
+        vtest(0 == strcmp(buf, "E###4"));
+        /* E### + A1 is out of range again. */
+        vtest(TONAL_FAIL == tp_add(&tp_sum, &ti1, &tp));
+
+        /* C### - Cbbb == AAAA1, beyond the interval range */
+        vtest(TONAL_OK == tp_set(&tp, DP_C, PA_ALTERATION(3), 4));
+        vtest(TONAL_OK == tp_set(&tp_sum, DP_C, PA_ALTERATION(-3), 4));
+        vtest(TONAL_FAIL == tp_sub(&tp, &tp_sum, &ti));
+        /* C### - C# == AA1 */
+        vtest(TONAL_OK == tp_set(&tp_sum, DP_C, PA_s, 4));
+        vtest(TONAL_OK == tp_sub(&tp, &tp_sum, &ti));
+        vtest(DI_PRIME == ti.diatonic_interval);
+        vtest(IA_AUGMENTED_N(2) == ti.interval_alteration);
+        vtest(ID_UP == ti.interval_direction);
+
+        /* A prime is never diminished, not even doubly. */
+        vtest(TONAL_FAIL == ti_set(&ti, DI_PRIME, IA_DIMINISHED_N(2), 0, ID_UP));
+        vtest(TONAL_OK == ti_set(&ti, DI_PRIME, IA_DIMINISHED_N(2), 1, ID_UP));
+        /* No doubly diminished third up the alteration range of intervals. */
+        vtest(TONAL_OK == ti_set(&ti, DI_THIRD, IA_DIMINISHED_N(2), 0, ID_UP));
+        vtest(TONAL_FAIL == ti_set(&ti, DI_THIRD, IA_MINOR - 3, 0, ID_UP));
+        return 0;
+}
+
+int main(void)
+{
+        test_enums();
+        test_arithmetic();
+
+        vtest_report();
+        vtest_end();
+
+        return 0;
+}
@@ -27,40 +27,97 @@
 #include <assert.h>
 #include <limits.h>
 #include <stdio.h>
-#include <string.h>
 
 #include <tonal.h>
 #include "tonal_priv.h"
 
 #define NELEM(x) ((int) ((sizeof x) / (sizeof x[0])))
 
-const char *diatonic_pitch_str[] = {
+const char *const diatonic_pitch_str[] = {
         "C", "D", "E", "F", "G", "A", "B",
         "NONE"
 };
 
-const char *pitch_alteration_str[] = {
+#if TONAL_ALTERATION_MAX < 2 || 8 < TONAL_ALTERATION_MAX
+#error "TONAL_ALTERATION_MAX must be from 2 to 8"
+#endif
+
+#define CAT_(a, b) a ## b
+#define CAT(a, b) CAT_(a, b)
+
+/*
+ * String representations beyond double flats and sharps, and beyond single
+ * diminished and augmented, for each TONAL_ALTERATION_MAX.
+ */
+#define FLATS_2
+#define FLATS_3 "bbb",
+#define FLATS_4 "bbbb", FLATS_3
+#define FLATS_5 "bbbbb", FLATS_4
+#define FLATS_6 "bbbbbb", FLATS_5
+#define FLATS_7 "bbbbbbb", FLATS_6
+#define FLATS_8 "bbbbbbbb", FLATS_7
+#define SHARPS_2
+#define SHARPS_3 "###",
+#define SHARPS_4 SHARPS_3 "####",
+#define SHARPS_5 SHARPS_4 "#####",
+#define SHARPS_6 SHARPS_5 "######",
+#define SHARPS_7 SHARPS_6 "#######",
+#define SHARPS_8 SHARPS_7 "########",
+#define DIMINISHED_2
+#define DIMINISHED_3 "Doubly Diminished",
+#define DIMINISHED_4 "Triply Diminished", DIMINISHED_3
+#define DIMINISHED_5 "Quadruply Diminished", DIMINISHED_4
+#define DIMINISHED_6 "Quintuply Diminished", DIMINISHED_5
+#define DIMINISHED_7 "Sextuply Diminished", DIMINISHED_6
+#define DIMINISHED_8 "Septuply Diminished", DIMINISHED_7
+#define AUGMENTED_2
+#define AUGMENTED_3 "Doubly Augmented",
+#define AUGMENTED_4 AUGMENTED_3 "Triply Augmented",
+#define AUGMENTED_5 AUGMENTED_4 "Quadruply Augmented",
+#define AUGMENTED_6 AUGMENTED_5 "Quintuply Augmented",
+#define AUGMENTED_7 AUGMENTED_6 "Sextuply Augmented",
+#define AUGMENTED_8 AUGMENTED_7 "Septuply Augmented",
+
+const char *const pitch_alteration_str[] = {
+        CAT(FLATS_, TONAL_ALTERATION_MAX)
         "bb", "b", "", "#", "##",
+        CAT(SHARPS_, TONAL_ALTERATION_MAX)
         "NONE"
 };
 
-const char *diatonic_interval_str[] = {
+const char *const diatonic_interval_str[] = {
         "Prime", "Second", "Third", "Fourth", "Fifth", "Sixth", "Seventh",
         "NONE"
 };
 
-const char *interval_alteration_str[] = {
+const char *const interval_alteration_str[] = {
+        CAT(DIMINISHED_, TONAL_ALTERATION_MAX)
         "Diminished", "Minor", "Major", "Perfect", "Augmented",
+        CAT(AUGMENTED_, TONAL_ALTERATION_MAX)
         "NONE"
 };
 
-const char *interval_direction_str[] = {
+const char *const interval_direction_str[] = {
         "Up", "Down",
         "NONE"
 };
 
+const char *const tonal_error_str[] = {
+        "OK",
+        "Failure",
+        "NULL pointer",
+        "Invalid diatonic pitch or interval",
+        "Alteration out of range",
+        "Negative interval octave",
+        "Invalid interval quality",
+        "Invalid interval direction",
+        "Result not representable",
+        "NONE"
+};
+
 
-static const int TIC_TO_TC_TABLE[DI_NONE][IA_NONE] = {
+/* Tonal Class alteration for IA_DIMINISHED to IA_AUGMENTED */
+static const int TIC_TO_TC_TABLE[DI_NONE][5] = {
 /*              DIM    MINOR    MAJOR     PERF      AUG */
 /* PRIME   */ { -1,     'x',     'x',       0,       1 },
 /* SECOND  */ { -2,      -1,       0,     'x',       1 },
@@ -71,6 +128,57 @@ static const int TIC_TO_TC_TABLE[DI_NONE][IA_NONE] = {
 /* SEVENTH */ { -2,      -1,       0,     'x',       1 },
 };
 
+/* Interval Alteration for Tonal Class alteration -2 to 2 */
+static const int TC_TO_TIC_TABLE[DI_NONE][5] = {
+/*                    -2               -1              0             1        2 */
+/* PRIME   */ { IA_NONE,       IA_DIMINISHED, IA_PERFECT, IA_AUGMENTED, IA_NONE },
+/* SECOND  */ { IA_DIMINISHED, IA_MINOR,      IA_MAJOR,   IA_AUGMENTED, IA_NONE },
+/* THIRD   */ { IA_DIMINISHED, IA_MINOR,      IA_MAJOR,   IA_AUGMENTED, IA_NONE },
+/* FOURTH  */ { IA_NONE,       IA_DIMINISHED, IA_PERFECT, IA_AUGMENTED, IA_NONE },
+/* FIFTH   */ { IA_NONE,       IA_DIMINISHED, IA_PERFECT, IA_AUGMENTED, IA_NONE },
+/* SIXTH   */ { IA_DIMINISHED, IA_MINOR,      IA_MAJOR,   IA_AUGMENTED, IA_NONE },
+/* SEVENTH */ { IA_DIMINISHED, IA_MINOR,      IA_MAJOR,   IA_AUGMENTED, IA_NONE },
+};
+
+/*
+ * Tonal Class alteration of a valid diatonic interval and interval
+ * alteration, or 'x' if there is no such interval. Multiply diminished and
+ * augmented intervals continue the DIM and AUG columns one step at a time.
+ */
+static inline int tic_get_alteration(int di, int ia)
+{
+#if 2 < TONAL_ALTERATION_MAX
+        if (ia < IA_DIMINISHED) {
+                return TIC_TO_TC_TABLE[di][0] - (IA_DIMINISHED - ia);
+        }
+        if (IA_AUGMENTED < ia) {
+                return 1 + (ia - IA_AUGMENTED);
+        }
+#endif
+        return TIC_TO_TC_TABLE[di][ia - IA_DIMINISHED];
+}
+
+/*
+ * Interval alteration of a valid diatonic interval and Tonal Class
+ * alteration, IA_NONE if there is no such interval.
+ */
+static inline int tc_get_interval_alteration(int di, int a)
+{
+#if 2 < TONAL_ALTERATION_MAX
+        int ia;
+
+        if (1 < a) {
+                ia = IA_AUGMENTED + (a - 1);
+                return ia < IA_NONE ? ia : IA_NONE;
+        }
+        if (a < TIC_TO_TC_TABLE[di][0]) {
+                ia = IA_DIMINISHED - (TIC_TO_TC_TABLE[di][0] - a);
+                return 0 <= ia ? ia : IA_NONE;
+        }
+#endif
+        return TC_TO_TIC_TABLE[di][a + 2];
+}
+
 static inline int validate_diatonic_point(int dt)
 {
         if (0 <= dt && dt <= 6) { return TONAL_OK; }
@@ -79,7 +187,9 @@ static inline int validate_diatonic_point(int dt)
 
 static inline int validate_alteration(int a)
 {
-        if (-2 <= a && a <= 2) { return TONAL_OK; }
+        if (-TONAL_ALTERATION_MAX <= a && a <= TONAL_ALTERATION_MAX) {
+                return TONAL_OK;
+        }
         return TONAL_FAIL;
 }
 
@@ -112,7 +222,7 @@ static inline int validate_diatonic_pitch(int dp)
 
 static inline int validate_pitch_alteration(int pa)
 {
-        if (PA_bb <= pa && pa <= PA_ss) { return TONAL_OK; }
+        if (0 <= pa && pa < PA_NONE) { return TONAL_OK; }
         return TONAL_FAIL;
 }
 
@@ -135,10 +245,6 @@ static inline int validate_tp(const struct tonal_pitch *tp)
 {
         if (NULL == tp) { return TONAL_FAIL; }
 
-        /* NOTE: Restricts the tonal pitch octave to positive. */
-        if (tp->octave < 0) {
-                return TONAL_FAIL;
-        }
         return validate_tpc((const struct tonal_pitch_class *) tp);
 }
 
@@ -150,7 +256,7 @@ static inline int validate_diatonic_interval(int di)
 
 static inline int validate_interval_alteration(int ia)
 {
-        if (IA_DIMINISHED <= ia && ia <= IA_AUGMENTED) { return TONAL_OK; }
+        if (0 <= ia && ia < IA_NONE) { return TONAL_OK; }
         return TONAL_FAIL;
 }
 
@@ -171,7 +277,7 @@ static inline int validate_tic(const struct tonal_interval_class *tic)
         ret = validate_interval_alteration(ia);
         if (TONAL_OK != ret) { return ret; }
 
-        if ('x' == TIC_TO_TC_TABLE[di][ia]) {
+        if ('x' == tic_get_alteration(di, ia)) {
                 return TONAL_FAIL;
         }
 
@@ -202,6 +308,7 @@ static inline int validate_ti(const struct tonal_interval *ti)
         if (NULL == ti) { return TONAL_FAIL; }
 
         ret = validate_tic((const struct tonal_interval_class *) ti);
+        if (TONAL_OK != ret) { return ret; }
 
         ret = validate_interval_octave(ti->octave);
         if (TONAL_OK != ret) { return ret; }
@@ -215,7 +322,7 @@ static inline int validate_ti(const struct tonal_interval *ti)
         if (
                 0 == ti->octave &&
                 DI_PRIME == ti->diatonic_interval &&
-                IA_DIMINISHED == ti->interval_alteration
+                ti->interval_alteration <= IA_DIMINISHED
         ) {
                 return TONAL_FAIL;
         }
@@ -234,7 +341,10 @@ int dt_get_mpc_value(int dt)
         return DT_TO_MPC_TABLE[dt];
 }
 
-/* Extends Music Pitch Class to {-2..13}. */
+/*
+ * Extends Music Pitch Class to {-2..13}, or by TONAL_ALTERATION_MAX below 0
+ * and above 11.
+ */
 int tc_get_mpc_value(const struct tonal_class *tc)
 {
         int ret;
@@ -244,7 +354,7 @@ int tc_get_mpc_value(const struct tonal_class *tc)
         if (TONAL_OK != ret) { return INT_MIN; }
 
         mpc = dt_get_mpc_value(tc->diatonic_point) + tc->alteration;
-        assert(-2 <= mpc && mpc <= 13);
+        assert(-TONAL_ALTERATION_MAX <= mpc && mpc <= 11 + TONAL_ALTERATION_MAX);
         return mpc;
 }
 
@@ -287,19 +397,16 @@ static int te_from_dv_cv(struct tonal_element *te, int dv, int cv)
         cv = cv - o * 12;
 
         /* NOTE: Magic numbers */
-        if (cv < -2 || 13 < cv) {
+        if (cv < -TONAL_ALTERATION_MAX || 11 + TONAL_ALTERATION_MAX < cv) {
                 return TONAL_FAIL;
         }
 
         assert(TONAL_OK == validate_diatonic_point(dv));
-        te->diatonic_point = dv;
-        te->alteration = 0;
-        te->octave = 0;
-
-        a = cv - te_get_chromatic_value(te);
+        a = cv - DT_TO_MPC_TABLE[dv];
         ret = validate_alteration(a);
         if (TONAL_OK != ret) { return ret; }
 
+        te->diatonic_point = dv;
         te->alteration = a;
         te->octave = o;
         assert(TONAL_OK == validate_te(te));
@@ -354,6 +461,8 @@ int te_sub(
 )
 {
         int ret;
+        int dv;
+        int cv;
 
         ret = validate_te(te0);
         if (TONAL_OK != ret) { return ret; }
@@ -363,14 +472,13 @@ int te_sub(
 
         if (NULL == te2) { return TONAL_FAIL; }
 
-        struct tonal_element te_tmp;
-
-        memcpy(&te_tmp, te1, sizeof te_tmp);
-
-        ret = te_inv(&te_tmp);
-        if (TONAL_OK != ret) { return ret; }
-
-        ret = te_add(te0, &te_tmp, te2);
+        /*
+         * Equal to te0 + te_inv(te1), but without the intermediate inverse
+         * which may not be representable even when the difference is.
+         */
+        dv = te_get_diatonic_value(te0) - te_get_diatonic_value(te1);
+        cv = te_get_chromatic_value(te0) - te_get_chromatic_value(te1);
+        ret = te_from_dv_cv(te2, dv, cv);
         return ret;
 }
 
@@ -414,7 +522,7 @@ int tic_to_tc(const struct tonal_interval_class *tic, struct tonal_class *tc)
          * it at run time instead.
          */
         assert(0 == DI_PRIME);          assert(6 == DI_SEVENTH);
-        assert(0 == IA_DIMINISHED);     assert(4 == IA_AUGMENTED);
+        assert(4 == IA_AUGMENTED - IA_DIMINISHED);
 
         int ret;
         int tic_di;
@@ -428,7 +536,7 @@ int tic_to_tc(const struct tonal_interval_class *tic, struct tonal_class *tc)
         tic_di = tic->diatonic_interval;
         tic_ia = tic->interval_alteration;
         tc->diatonic_point = tic_di - DI_PRIME;
-        tc->alteration = TIC_TO_TC_TABLE[tic_di][tic_ia];
+        tc->alteration = tic_get_alteration(tic_di, tic_ia);
 
         assert(TONAL_OK == validate_tc(tc));
         return TONAL_OK;
@@ -447,36 +555,12 @@ int tc_to_tic(const struct tonal_class *tc, struct tonal_interval_class *tic)
         if (NULL == tic) { return TONAL_FAIL; }
 
         tic_di = tc->diatonic_point + DI_PRIME;
-        tic->diatonic_interval = tic_di;
         tc_a = tc->alteration;
 
-        switch (tic_di) {
-                case DI_PRIME:
-                case DI_FOURTH:
-                case DI_FIFTH:
-                        switch (tc_a) {
-                                case -1: tic_ia = IA_DIMINISHED; break;
-                                case  0: tic_ia = IA_PERFECT;    break;
-                                case  1: tic_ia = IA_AUGMENTED;  break;
-                                default: return TONAL_FAIL;      break;
-                        }
-                        break;
-                case DI_SECOND:
-                case DI_THIRD:
-                case DI_SIXTH:
-                case DI_SEVENTH:
-                        switch (tc_a) {
-                                case -2: tic_ia = IA_DIMINISHED; break;
-                                case -1: tic_ia = IA_MINOR;      break;
-                                case  0: tic_ia = IA_MAJOR;      break;
-                                case  1: tic_ia = IA_AUGMENTED;  break;
-                                default: return TONAL_FAIL;      break;
-                        }
-                        break;
-                default:
-                        assert(!"Unknown diatonic_interval");
-        }
+        tic_ia = tc_get_interval_alteration(tic_di, tc_a);
+        if (IA_NONE == tic_ia) { return TONAL_FAIL; }
 
+        tic->diatonic_interval = tic_di;
         tic->interval_alteration = tic_ia;
 
         assert(TONAL_OK == validate_tic(tic));
@@ -505,7 +589,7 @@ int tp_to_te(const struct tonal_pitch *tp, struct tonal_element *te)
         return TONAL_OK;
 }
 
-int tp_to_mnn(
+static inline int tp_to_mnn_impl(
         const struct tonal_pitch *tp
 )
 {
@@ -537,8 +621,8 @@ int te_to_tp(const struct tonal_element *te, struct tonal_pitch *tp)
 
         tp->octave = te->octave;
 
-        assert(TONAL_OK == validate_tp(tp));
-        return TONAL_OK;
+        /* The element may be below the lowest representable pitch. */
+        return validate_tp(tp);
 }
 
 int ti_to_te(const struct tonal_interval *ti, struct tonal_element *te)
@@ -583,7 +667,14 @@ int te_to_ti(const struct tonal_element *te, struct tonal_interval *ti)
 
         tic = (struct tonal_interval_class *) ti;
 
-        if (te->octave >= 0) {
+        /*
+         * An element at octave 0 with a flattened diatonic point 0 lies below
+         * the prime: it is a downward augmented prime, not a diminished one.
+         */
+        if (
+                te->octave > 0 ||
+                (0 == te->octave && !(0 == te->diatonic_point && te->alteration < 0))
+        ) {
                 tc = (struct tonal_class *) te;
                 ret = tc_to_tic(tc, tic);
                 if (TONAL_OK != ret) { return ret; }
@@ -671,6 +762,150 @@ int tp_print(FILE *stream, const struct tonal_pitch *tp)
         return ret < 0 ? TONAL_FAIL : TONAL_OK;
 }
 
+int tpc_snprint(
+        char *buf,
+        size_t size,
+        const struct tonal_pitch_class *tpc
+)
+{
+        int ret;
+
+        if (NULL == buf) { return TONAL_FAIL; }
+
+        ret = validate_tpc(tpc);
+        if (TONAL_OK != ret) { return ret; }
+
+        ret = snprintf(
+                buf,
+                size,
+                "%s%s",
+                diatonic_pitch_str[tpc->diatonic_pitch],
+                pitch_alteration_str[tpc->pitch_alteration]
+        );
+        TONAL_PROBE2(tpc_snprint_return, buf, ret);
+        return ret < 0 || (size_t) ret >= size ? TONAL_FAIL : TONAL_OK;
+}
+
+int tp_snprint(
+        char *buf,
+        size_t size,
+        const struct tonal_pitch *tp
+)
+{
+        int ret;
+
+        if (NULL == buf) { return TONAL_FAIL; }
+
+        ret = validate_tp(tp);
+        if (TONAL_OK != ret) { return ret; }
+
+        ret = snprintf(
+                buf,
+                size,
+                "%s%s%d",
+                diatonic_pitch_str[tp->diatonic_pitch],
+                pitch_alteration_str[tp->pitch_alteration],
+                tp->octave
+        );
+        TONAL_PROBE2(tp_snprint_return, buf, ret);
+        return ret < 0 || (size_t) ret >= size ? TONAL_FAIL : TONAL_OK;
+}
+
+/* Parse the pitch class at the start of str. Returns the end or NULL. */
+static const char *parse_tpc(const char *str, struct tonal_pitch_class *tpc)
+{
+        static const int LETTER_TO_DP[7] = {
+                DP_A, DP_B, DP_C, DP_D, DP_E, DP_F, DP_G
+        };
+        int dp;
+        int a;
+
+        if ('A' <= *str && *str <= 'G') {
+                dp = LETTER_TO_DP[*str - 'A'];
+        } else if ('a' <= *str && *str <= 'g') {
+                dp = LETTER_TO_DP[*str - 'a'];
+        } else {
+                return NULL;
+        }
+        str++;
+
+        a = 0;
+        if ('#' == *str) {
+                for (; '#' == *str; str++) { a++; }
+        } else {
+                for (; 'b' == *str; str++) { a--; }
+        }
+        if (TONAL_OK != validate_alteration(a)) { return NULL; }
+
+        tpc->diatonic_pitch = dp;
+        tpc->pitch_alteration = PA_ALTERATION(a);
+        return str;
+}
+
+/* Parse a possibly negative decimal octave. Returns the end or NULL. */
+static const char *parse_octave(const char *str, int *octave)
+{
+        int neg;
+        int o;
+
+        neg = '-' == *str;
+        if (neg) { str++; }
+        if (*str < '0' || '9' < *str) { return NULL; }
+
+        o = 0;
+        for (; '0' <= *str && *str <= '9'; str++) {
+                if ((INT_MAX - (*str - '0')) / 10 < o) { return NULL; }
+                o = 10 * o + (*str - '0');
+        }
+        *octave = neg ? -o : o;
+        return str;
+}
+
+int tpc_parse(
+        const char *str,
+        struct tonal_pitch_class *tpc,
+        const char **end
+)
+{
+        struct tonal_pitch_class tmp;
+        const char *p;
+
+        if (NULL == str || NULL == tpc) { return TONAL_FAIL; }
+
+        p = parse_tpc(str, &tmp);
+        TONAL_PROBE2(tpc_parse_return, str, NULL != p);
+        if (NULL == p) { return TONAL_FAIL; }
+
+        *tpc = tmp;
+        if (end) { *end = p; }
+        return TONAL_OK;
+}
+
+int tp_parse(
+        const char *str,
+        struct tonal_pitch *tp,
+        const char **end
+)
+{
+        struct tonal_pitch_class tpc;
+        int octave;
+        const char *p;
+
+        if (NULL == str || NULL == tp) { return TONAL_FAIL; }
+
+        p = parse_tpc(str, &tpc);
+        if (p) { p = parse_octave(p, &octave); }
+        TONAL_PROBE2(tp_parse_return, str, NULL != p);
+        if (NULL == p) { return TONAL_FAIL; }
+
+        tp->diatonic_pitch = tpc.diatonic_pitch;
+        tp->pitch_alteration = tpc.pitch_alteration;
+        tp->octave = octave;
+        if (end) { *end = p; }
+        assert(TONAL_OK == validate_tp(tp));
+        return TONAL_OK;
+}
+
 int tic_print(FILE *stream, const struct tonal_interval_class *tic)
 {
         int ret;
@@ -778,7 +1013,7 @@ int tic_set(
         ret = validate_interval_alteration(interval_alteration);
         if (TONAL_OK != ret) { return ret; }
 
-        if ('x' == TIC_TO_TC_TABLE[diatonic_interval][interval_alteration]) {
+        if ('x' == tic_get_alteration(diatonic_interval, interval_alteration)) {
                 return TONAL_FAIL;
         }
 
@@ -810,7 +1045,7 @@ int ti_set(
         return validate_ti(ti);
 }
 
-int tp_add(
+static inline int tp_add_impl(
         const struct tonal_pitch *tp,
         const struct tonal_interval *ti,
         struct tonal_pitch *tp_sum
@@ -834,7 +1069,7 @@ int tp_add(
         return ret;
 }
 
-int ti_add(
+static inline int ti_add_impl(
         const struct tonal_interval *ti0,
         const struct tonal_interval *ti1,
         struct tonal_interval *ti_sum
@@ -858,7 +1093,7 @@ int ti_add(
         return ret;
 }
 
-int tp_sub(
+static inline int tp_sub_impl(
         const struct tonal_pitch *tp0,
         const struct tonal_pitch *tp1,
         struct tonal_interval *ti_diff
@@ -882,7 +1117,7 @@ int tp_sub(
         return ret;
 }
 
-int ti_sub(
+static inline int ti_sub_impl(
         const struct tonal_interval *ti0,
         const struct tonal_interval *ti1,
         struct tonal_interval *ti_diff
@@ -906,3 +1141,583 @@ int ti_sub(
         return ret;
 }
 
+
+/*
+ * Error details
+ *
+ * The validation functions only tell valid from invalid. These functions
+ * tell why, and are only called once an operation has failed.
+ */
+
+int tp_error(const struct tonal_pitch *tp)
+{
+        if (NULL == tp) { return TONAL_E_NULL; }
+        if (TONAL_OK != validate_diatonic_pitch(tp->diatonic_pitch)) {
+                return TONAL_E_DIATONIC;
+        }
+        if (TONAL_OK != validate_pitch_alteration(tp->pitch_alteration)) {
+                return TONAL_E_ALTERATION;
+        }
+        return TONAL_E_OK;
+}
+
+int ti_error(const struct tonal_interval *ti)
+{
+        if (NULL == ti) { return TONAL_E_NULL; }
+        if (TONAL_OK != validate_diatonic_interval(ti->diatonic_interval)) {
+                return TONAL_E_DIATONIC;
+        }
+        if (TONAL_OK != validate_interval_octave(ti->octave)) {
+                return TONAL_E_OCTAVE;
+        }
+        if (TONAL_OK != validate_interval_direction(ti->interval_direction)) {
+                return TONAL_E_DIRECTION;
+        }
+        if (TONAL_OK != validate_ti(ti)) { return TONAL_E_QUALITY; }
+        return TONAL_E_OK;
+}
+
+/* Reason for failure of an operation on two operands. */
+static int op_error(int e0, int e1, const void *result)
+{
+        if (TONAL_E_OK != e0) { return e0; }
+        if (TONAL_E_OK != e1) { return e1; }
+        if (NULL == result) { return TONAL_E_NULL; }
+        return TONAL_E_RANGE;
+}
+
+
+/*
+ * Public arithmetic functions
+ *
+ * Wrappers which count calls and record failures when compiled with
+ * TONAL_STATS or TONAL_USDT.
+ */
+
+int tp_add(
+        const struct tonal_pitch *tp,
+        const struct tonal_interval *ti,
+        struct tonal_pitch *tp_sum
+)
+{
+        int ret;
+
+        TONAL_STATS_CALL(TONAL_STATS_TP_ADD);
+        ret = tp_add_impl(tp, ti, tp_sum);
+        if (TONAL_OK != ret) {
+                TONAL_FAILED(
+                        TONAL_STATS_TP_ADD,
+                        op_error(tp_error(tp), ti_error(ti), tp_sum)
+                );
+        }
+        return ret;
+}
+
+int ti_add(
+        const struct tonal_interval *ti0,
+        const struct tonal_interval *ti1,
+        struct tonal_interval *ti_sum
+)
+{
+        int ret;
+
+        TONAL_STATS_CALL(TONAL_STATS_TI_ADD);
+        ret = ti_add_impl(ti0, ti1, ti_sum);
+        if (TONAL_OK != ret) {
+                TONAL_FAILED(
+                        TONAL_STATS_TI_ADD,
+                        op_error(ti_error(ti0), ti_error(ti1), ti_sum)
+                );
+        }
+        return ret;
+}
+
+int tp_sub(
+        const struct tonal_pitch *tp0,
+        const struct tonal_pitch *tp1,
+        struct tonal_interval *ti_diff
+)
+{
+        int ret;
+
+        TONAL_STATS_CALL(TONAL_STATS_TP_SUB);
+        ret = tp_sub_impl(tp0, tp1, ti_diff);
+        if (TONAL_OK != ret) {
+                TONAL_FAILED(
+                        TONAL_STATS_TP_SUB,
+                        op_error(tp_error(tp0), tp_error(tp1), ti_diff)
+                );
+        }
+        return ret;
+}
+
+int ti_sub(
+        const struct tonal_interval *ti0,
+        const struct tonal_interval *ti1,
+        struct tonal_interval *ti_diff
+)
+{
+        int ret;
+
+        TONAL_STATS_CALL(TONAL_STATS_TI_SUB);
+        ret = ti_sub_impl(ti0, ti1, ti_diff);
+        if (TONAL_OK != ret) {
+                TONAL_FAILED(
+                        TONAL_STATS_TI_SUB,
+                        op_error(ti_error(ti0), ti_error(ti1), ti_diff)
+                );
+        }
+        return ret;
+}
+
+int tp_to_mnn(
+        const struct tonal_pitch *tp
+)
+{
+        int ret;
+
+        TONAL_STATS_CALL(TONAL_STATS_TP_TO_MNN);
+        ret = tp_to_mnn_impl(tp);
+        if (INT_MIN == ret) {
+                TONAL_FAILED(TONAL_STATS_TP_TO_MNN, tp_error(tp));
+        }
+        return ret;
+}
+
+int tp_to_mnn_oc(
+        const struct tonal_pitch *tp,
+        int oc
+)
+{
+        int mnn;
+
+        mnn = tp_to_mnn(tp);
+        if (INT_MIN == mnn) { return INT_MIN; }
+
+        switch (oc) {
+                case OC_C5: return mnn;
+                case OC_C4: return mnn + 12;
+        }
+        return INT_MIN;
+}
+
+/* Spelling of each Music Pitch Class, with sharps */
+static const struct tonal_pitch_class MPC_TO_TPC_TABLE[12] = {
+        { DP_C, PA_ }, { DP_C, PA_s }, { DP_D, PA_ }, { DP_D, PA_s },
+        { DP_E, PA_ }, { DP_F, PA_ }, { DP_F, PA_s }, { DP_G, PA_ },
+        { DP_G, PA_s }, { DP_A, PA_ }, { DP_A, PA_s }, { DP_B, PA_ },
+};
+
+int tp_from_mnn(
+        struct tonal_pitch *tp,
+        int mnn,
+        int oc
+)
+{
+        int o;
+        int mpc;
+
+        if (NULL == tp) { return TONAL_FAIL; }
+
+        switch (oc) {
+                case OC_C5: break;
+                case OC_C4: mnn -= 12; break;
+                default: return TONAL_FAIL;
+        }
+
+        /* Floor division */
+        o = mnn < 0 ? -((11 - mnn) / 12) : mnn / 12;
+        mpc = mnn - 12 * o;
+        assert(0 <= mpc && mpc < 12);
+
+        tp->diatonic_pitch = MPC_TO_TPC_TABLE[mpc].diatonic_pitch;
+        tp->pitch_alteration = MPC_TO_TPC_TABLE[mpc].pitch_alteration;
+        tp->octave = o;
+        assert(TONAL_OK == validate_tp(tp));
+        return TONAL_OK;
+}
+
+/* Set all n elements of status, if not NULL, to error. */
+static void fill_status(int *status, size_t n, int error)
+{
+        for (size_t i = 0; status && i < n; i++) {
+                status[i] = error;
+        }
+}
+
+int tp_add_err(
+        const struct tonal_pitch *tp,
+        const struct tonal_interval *ti,
+        struct tonal_pitch *tp_sum,
+        int *error
+)
+{
+        int ret;
+
+        ret = tp_add(tp, ti, tp_sum);
+        if (TONAL_OK != ret && error) {
+                *error = op_error(tp_error(tp), ti_error(ti), tp_sum);
+        }
+        return ret;
+}
+
+int ti_add_err(
+        const struct tonal_interval *ti0,
+        const struct tonal_interval *ti1,
+        struct tonal_interval *ti_sum,
+        int *error
+)
+{
+        int ret;
+
+        ret = ti_add(ti0, ti1, ti_sum);
+        if (TONAL_OK != ret && error) {
+                *error = op_error(ti_error(ti0), ti_error(ti1), ti_sum);
+        }
+        return ret;
+}
+
+int tp_sub_err(
+        const struct tonal_pitch *tp0,
+        const struct tonal_pitch *tp1,
+        struct tonal_interval *ti_diff,
+        int *error
+)
+{
+        int ret;
+
+        ret = tp_sub(tp0, tp1, ti_diff);
+        if (TONAL_OK != ret && error) {
+                *error = op_error(tp_error(tp0), tp_error(tp1), ti_diff);
+        }
+        return ret;
+}
+
+int ti_sub_err(
+        const struct tonal_interval *ti0,
+        const struct tonal_interval *ti1,
+        struct tonal_interval *ti_diff,
+        int *error
+)
+{
+        int ret;
+
+        ret = ti_sub(ti0, ti1, ti_diff);
+        if (TONAL_OK != ret && error) {
+                *error = op_error(ti_error(ti0), ti_error(ti1), ti_diff);
+        }
+        return ret;
+}
+
+
+/*
+ * Batch operations
+ *
+ * The batch kernels compute the diatonic and chromatic values directly from
+ * the public structures instead of going through the Tonal Element
+ * conversion functions. The results are the same as for the scalar
+ * functions.
+ */
+
+static inline int tp_get_dv_cv(const struct tonal_pitch *tp, int *dv, int *cv)
+{
+        int ret;
+        int dt;
+
+        ret = validate_tp(tp);
+        if (TONAL_OK != ret) { return ret; }
+
+        dt = tp->diatonic_pitch - DP_C;
+        *dv = 7 * tp->octave + dt;
+        *cv = 12 * tp->octave + DT_TO_MPC_TABLE[dt] + tp->pitch_alteration - PA_;
+        return TONAL_OK;
+}
+
+static inline int ti_get_dv_cv(
+        const struct tonal_interval *ti,
+        int *dv,
+        int *cv
+)
+{
+        int ret;
+        int dt;
+        int d;
+        int c;
+
+        ret = validate_ti(ti);
+        if (TONAL_OK != ret) { return ret; }
+
+        dt = ti->diatonic_interval - DI_PRIME;
+        d = 7 * ti->octave + dt;
+        c = 12 * ti->octave + DT_TO_MPC_TABLE[dt] +
+                tic_get_alteration(ti->diatonic_interval, ti->interval_alteration);
+        if (ID_DOWN == ti->interval_direction) {
+                d = -d;
+                c = -c;
+        }
+        *dv = d;
+        *cv = c;
+        return TONAL_OK;
+}
+
+static inline int tp_from_dv_cv(struct tonal_pitch *tp, int dv, int cv)
+{
+        int ret;
+        struct tonal_element te;
+
+        ret = te_from_dv_cv(&te, dv, cv);
+        if (TONAL_OK != ret) { return ret; }
+
+        tp->diatonic_pitch = te.diatonic_point + DP_C;
+        tp->pitch_alteration = te.alteration + PA_;
+        tp->octave = te.octave;
+        return validate_tp(tp);
+}
+
+static inline int tp_add_one(
+        const struct tonal_pitch *tp,
+        int ti_dv,
+        int ti_cv,
+        struct tonal_pitch *tp_sum
+)
+{
+        int ret;
+        int dv;
+        int cv;
+
+        ret = tp_get_dv_cv(tp, &dv, &cv);
+        if (TONAL_OK != ret) { return ret; }
+
+        return tp_from_dv_cv(tp_sum, dv + ti_dv, cv + ti_cv);
+}
+
+static inline int tp_add_n_impl(
+        const struct tonal_pitch *tp,
+        const struct tonal_interval *ti,
+        struct tonal_pitch *tp_sum,
+        int *status,
+        size_t n
+)
+{
+        int ret;
+        int fail;
+        int dv;
+        int cv;
+
+        if (0 == n) { return TONAL_OK; }
+        if (NULL == tp || NULL == ti || NULL == tp_sum) {
+                fill_status(status, n, TONAL_E_NULL);
+                TONAL_FAILED(TONAL_STATS_TP_ADD_N, TONAL_E_NULL);
+                return TONAL_FAIL;
+        }
+
+        fail = 0;
+        for (size_t i = 0; i < n; i++) {
+                ret = ti_get_dv_cv(&ti[i], &dv, &cv);
+                if (TONAL_OK == ret) {
+                        ret = tp_add_one(&tp[i], dv, cv, &tp_sum[i]);
+                }
+                if (TONAL_OK != ret && (status || TONAL_RECORD_FAILURES)) {
+                        ret = op_error(tp_error(&tp[i]), ti_error(&ti[i]), tp_sum);
+                        TONAL_FAILED(TONAL_STATS_TP_ADD_N, ret);
+                }
+                if (status) { status[i] = ret; }
+                fail |= ret;
+        }
+        return fail ? TONAL_FAIL : TONAL_OK;
+}
+
+static inline int tp_transpose_n_impl(
+        const struct tonal_pitch *tp,
+        const struct tonal_interval *ti,
+        struct tonal_pitch *tp_sum,
+        int *status,
+        size_t n
+)
+{
+        int ret;
+        int fail;
+        int dv;
+        int cv;
+
+        if (0 == n) { return TONAL_OK; }
+        if (NULL == tp || NULL == tp_sum) {
+                fill_status(status, n, TONAL_E_NULL);
+                TONAL_FAILED(TONAL_STATS_TP_TRANSPOSE_N, TONAL_E_NULL);
+                return TONAL_FAIL;
+        }
+
+        ret = ti_get_dv_cv(ti, &dv, &cv);
+        if (TONAL_OK != ret) {
+                TONAL_FAILED(TONAL_STATS_TP_TRANSPOSE_N, ti_error(ti));
+                fill_status(status, n, ti_error(ti));
+                return ret;
+        }
+
+        fail = 0;
+        for (size_t i = 0; i < n; i++) {
+                ret = tp_add_one(&tp[i], dv, cv, &tp_sum[i]);
+                if (TONAL_OK != ret && (status || TONAL_RECORD_FAILURES)) {
+                        ret = op_error(tp_error(&tp[i]), TONAL_E_OK, tp_sum);
+                        TONAL_FAILED(TONAL_STATS_TP_TRANSPOSE_N, ret);
+                }
+                if (status) { status[i] = ret; }
+                fail |= ret;
+        }
+        return fail ? TONAL_FAIL : TONAL_OK;
+}
+
+static inline int tp_sub_n_impl(
+        const struct tonal_pitch *tp0,
+        const struct tonal_pitch *tp1,
+        struct tonal_interval *ti_diff,
+        int *status,
+        size_t n
+)
+{
+        int ret;
+        int fail;
+        int dv0, cv0;
+        int dv1, cv1;
+        struct tonal_element te;
+
+        if (0 == n) { return TONAL_OK; }
+        if (NULL == tp0 || NULL == tp1 || NULL == ti_diff) {
+                fill_status(status, n, TONAL_E_NULL);
+                TONAL_FAILED(TONAL_STATS_TP_SUB_N, TONAL_E_NULL);
+                return TONAL_FAIL;
+        }
+
+        fail = 0;
+        for (size_t i = 0; i < n; i++) {
+                ret = tp_get_dv_cv(&tp0[i], &dv0, &cv0);
+                if (TONAL_OK == ret) {
+                        ret = tp_get_dv_cv(&tp1[i], &dv1, &cv1);
+                }
+                if (TONAL_OK == ret) {
+                        ret = te_from_dv_cv(&te, dv0 - dv1, cv0 - cv1);
+                }
+                if (TONAL_OK == ret) {
+                        ret = te_to_ti(&te, &ti_diff[i]);
+                }
+                if (TONAL_OK != ret && (status || TONAL_RECORD_FAILURES)) {
+                        ret = op_error(tp_error(&tp0[i]), tp_error(&tp1[i]), ti_diff);
+                        TONAL_FAILED(TONAL_STATS_TP_SUB_N, ret);
+                }
+                if (status) { status[i] = ret; }
+                fail |= ret;
+        }
+        return fail ? TONAL_FAIL : TONAL_OK;
+}
+
+static inline int tp_to_mnn_n_impl(
+        const struct tonal_pitch *tp,
+        int *mnn,
+        size_t n
+)
+{
+        int ret;
+        int fail;
+        int dv;
+        int cv;
+
+        if (0 == n) { return TONAL_OK; }
+        if (NULL == tp || NULL == mnn) {
+                TONAL_FAILED(TONAL_STATS_TP_TO_MNN_N, TONAL_E_NULL);
+                return TONAL_FAIL;
+        }
+
+        fail = 0;
+        for (size_t i = 0; i < n; i++) {
+                ret = tp_get_dv_cv(&tp[i], &dv, &cv);
+                mnn[i] = TONAL_OK == ret ? cv : INT_MIN;
+                if (TONAL_OK != ret) {
+                        TONAL_FAILED(TONAL_STATS_TP_TO_MNN_N, tp_error(&tp[i]));
+                }
+                fail |= ret;
+        }
+        return fail ? TONAL_FAIL : TONAL_OK;
+}
+
+
+/*
+ * Public batch functions
+ *
+ * Wrappers which count calls when compiled with TONAL_STATS, measure latency
+ * with TONAL_STATS_LATENCY, and mark entry and return with tracepoints when
+ * compiled with TONAL_USDT.
+ */
+
+int tp_add_n(
+        const struct tonal_pitch *tp,
+        const struct tonal_interval *ti,
+        struct tonal_pitch *tp_sum,
+        int *status,
+        size_t n
+)
+{
+        int ret;
+
+        TONAL_STATS_BATCH(TONAL_STATS_TP_ADD_N, n);
+        TONAL_STATS_TIMER(t0);
+        TONAL_PROBE2(tp_add_n_entry, tp, n);
+        ret = tp_add_n_impl(tp, ti, tp_sum, status, n);
+        TONAL_STATS_ELAPSED(TONAL_STATS_TP_ADD_N, t0);
+        TONAL_PROBE2(tp_add_n_return, n, ret);
+        return ret;
+}
+
+int tp_transpose_n(
+        const struct tonal_pitch *tp,
+        const struct tonal_interval *ti,
+        struct tonal_pitch *tp_sum,
+        int *status,
+        size_t n
+)
+{
+        int ret;
+
+        TONAL_STATS_BATCH(TONAL_STATS_TP_TRANSPOSE_N, n);
+        TONAL_STATS_TIMER(t0);
+        TONAL_PROBE2(tp_transpose_n_entry, tp, n);
+        ret = tp_transpose_n_impl(tp, ti, tp_sum, status, n);
+        TONAL_STATS_ELAPSED(TONAL_STATS_TP_TRANSPOSE_N, t0);
+        TONAL_PROBE2(tp_transpose_n_return, n, ret);
+        return ret;
+}
+
+int tp_sub_n(
+        const struct tonal_pitch *tp0,
+        const struct tonal_pitch *tp1,
+        struct tonal_interval *ti_diff,
+        int *status,
+        size_t n
+)
+{
+        int ret;
+
+        TONAL_STATS_BATCH(TONAL_STATS_TP_SUB_N, n);
+        TONAL_STATS_TIMER(t0);
+        TONAL_PROBE2(tp_sub_n_entry, tp0, n);
+        ret = tp_sub_n_impl(tp0, tp1, ti_diff, status, n);
+        TONAL_STATS_ELAPSED(TONAL_STATS_TP_SUB_N, t0);
+        TONAL_PROBE2(tp_sub_n_return, n, ret);
+        return ret;
+}
+
+int tp_to_mnn_n(
+        const struct tonal_pitch *tp,
+        int *mnn,
+        size_t n
+)
+{
+        int ret;
+
+        TONAL_STATS_BATCH(TONAL_STATS_TP_TO_MNN_N, n);
+        TONAL_STATS_TIMER(t0);
+        TONAL_PROBE2(tp_to_mnn_n_entry, tp, n);
+        ret = tp_to_mnn_n_impl(tp, mnn, n);
+        TONAL_STATS_ELAPSED(TONAL_STATS_TP_TO_MNN_N, t0);
+        TONAL_PROBE2(tp_to_mnn_n_return, n, ret);
+        return ret;
+}
@@ -0,0 +1,850 @@
+/*
+ * Copyright 2016 Martin Aberg
+ *
+ * This file is part of tonal.
+ *
+ * tonal is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * tonal is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * ABC notation, see tonal_abc.h.
+ *
+ * A tune book is first split into tunes, which only looks at the start of each
+ * line. The tunes are independent, so tonal_abc_read_book() hands them out to
+ * worker threads one at a time and each result lands in its own slot.
+ *
+ * The accidentals of the current bar are kept per letter and octave and
+ * stamped with a bar number, so a bar line clears them all by bumping the
+ * number.
+ */
+
+#define _POSIX_C_SOURCE 200112L
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <tonal_abc.h>
+#include "tonal_priv.h"
+
+/* Octaves around middle C for which bar accidentals are kept */
+#define NOCT 16
+
+struct abc {
+        /* Octave of middle C */
+        int base;
+        tonal_abc_fn fn;
+        void *arg;
+        /* Alteration of each diatonic pitch in the key signature */
+        int key[DP_NONE];
+        /* Bar accidentals, valid where bar_gen equals gen */
+        int bar_alter[DP_NONE][NOCT];
+        unsigned bar_gen[DP_NONE][NOCT];
+        unsigned gen;
+        /* Notes or rests since the last bar line */
+        int content;
+        int in_chord;
+        struct tonal_abc_note note;
+};
+
+static int middle_c(int oc, int *base)
+{
+        switch (oc) {
+                case OC_C5: *base = 5; return TONAL_OK;
+                case OC_C4: *base = 4; return TONAL_OK;
+        }
+        return TONAL_FAIL;
+}
+
+static inline int is_space(char c)
+{
+        return ' ' == c || '\t' == c;
+}
+
+static inline int is_alpha(char c)
+{
+        return ('a' <= c && c <= 'z') || ('A' <= c && c <= 'Z');
+}
+
+static inline int is_digit(char c)
+{
+        return '0' <= c && c <= '9';
+}
+
+static inline int is_name(char c)
+{
+        return ('a' <= c && c <= 'g') || ('A' <= c && c <= 'G');
+}
+
+static inline int to_lower(char c)
+{
+        return 'A' <= c && c <= 'Z' ? c - 'A' + 'a' : c;
+}
+
+static int name_to_dp(char c)
+{
+        static const char NAMES[] = "cdefgab";
+
+        return strchr(NAMES, to_lower(c)) - NAMES;
+}
+
+static const char *next_line(const char *p, const char *end)
+{
+        const char *nl = memchr(p, '\n', end - p);
+
+        return nl ? nl + 1 : end;
+}
+
+/* End of the line at p, without the line break */
+static const char *line_end(const char *p, const char *end)
+{
+        const char *nl = memchr(p, '\n', end - p);
+
+        if (NULL == nl) { nl = end; }
+        if (p < nl && '\r' == nl[-1]) { nl--; }
+        return nl;
+}
+
+static int is_field(const char *p, const char *end)
+{
+        return 2 <= end - p && is_alpha(p[0]) && ':' == p[1];
+}
+
+static int is_blank(const char *p, const char *end)
+{
+        for (; p < end && '\n' != *p; p++) {
+                if (!is_space(*p) && '\r' != *p) { return 0; }
+        }
+        return 1;
+}
+
+/*
+ * Key signature
+ *
+ * Position on the line of fifths of each tonic letter relative to C, and of
+ * each mode relative to major.
+ */
+static const int TONIC_FIFTHS[DP_NONE] = { 0, 2, 4, -1, 1, 3, 5 };
+
+static const struct {
+        const char *name;
+        int fifths;
+} MODES[] = {
+        { "maj", 0 }, { "ion", 0 }, { "mix", -1 }, { "dor", -2 },
+        { "min", -3 }, { "aeo", -3 }, { "phr", -4 }, { "loc", -5 },
+        { "lyd", 1 },
+};
+
+/* Order in which sharps are added to a key signature, flats in reverse */
+static const int SHARPS[DP_NONE] = { DP_F, DP_C, DP_G, DP_D, DP_A, DP_E, DP_B };
+
+static void key_from_fifths(int key[DP_NONE], int fifths)
+{
+        memset(key, 0, DP_NONE * sizeof *key);
+        for (int i = 0; i < fifths; i++) {
+                key[SHARPS[i % DP_NONE]]++;
+        }
+        for (int i = 0; i < -fifths; i++) {
+                key[SHARPS[DP_NONE - 1 - i % DP_NONE]]--;
+        }
+}
+
+/*
+ * Accidentals at p: "^", "^^", "_", "__" or "=". Returns the alteration, or
+ * sets *error for microtonal or mixed accidentals.
+ */
+static const char *parse_accidental(
+        const char *p,
+        const char *end,
+        int *alter,
+        int *error
+)
+{
+        int up = 0;
+        int down = 0;
+        int natural = 0;
+
+        for (; p < end && ('^' == *p || '_' == *p || '=' == *p); p++) {
+                up += '^' == *p;
+                down += '_' == *p;
+                natural += '=' == *p;
+        }
+        if ((up && down) || (natural && (up || down || 1 < natural))) {
+                *error = TONAL_E_ALTERATION;
+        }
+        /* Microtones such as ^/ and _3/2 */
+        for (; p < end && ('/' == *p || is_digit(*p)); p++) {
+                *error = TONAL_E_ALTERATION;
+        }
+        *alter = up - down;
+        return p;
+}
+
+/*
+ * Mode at p, such as "m", "min", "Mix" or "dorian": only the first three
+ * letters count. Adds its fifths relative to major. A word which is not a
+ * mode is left alone.
+ */
+static const char *parse_mode(const char *p, const char *end, int *fifths)
+{
+        const char *m = p;
+        const char *w;
+
+        while (m < end && is_space(*m)) { m++; }
+        for (w = m; w < end && is_alpha(*w); w++) {
+                ;
+        }
+        if (1 == w - m && 'm' == to_lower(*m)) {
+                *fifths -= 3;
+                return w;
+        }
+        if (w - m < 3 || (w < end && !is_space(*w))) { return p; }
+        for (size_t i = 0; i < sizeof MODES / sizeof MODES[0]; i++) {
+                if (
+                        to_lower(m[0]) == MODES[i].name[0] &&
+                        to_lower(m[1]) == MODES[i].name[1] &&
+                        to_lower(m[2]) == MODES[i].name[2]
+                ) {
+                        *fifths += MODES[i].fifths;
+                        return w;
+                }
+        }
+        return p;
+}
+
+/* The value of a K: field, [p, end), into key. */
+static int parse_key(const char *p, const char *end, int key[DP_NONE])
+{
+        int fifths = 0;
+
+        while (p < end && is_space(*p)) { p++; }
+        while (p < end && is_space(end[-1])) { end--; }
+
+        if (p == end || (4 <= end - p && 0 == memcmp(p, "none", 4))) {
+                key_from_fifths(key, 0);
+                p += p == end ? 0 : 4;
+        } else if (2 <= end - p && 0 == memcmp(p, "HP", 2)) {
+                /* Highland pipes, no signature */
+                key_from_fifths(key, 0);
+                p += 2;
+        } else if (2 <= end - p && 0 == memcmp(p, "Hp", 2)) {
+                /* Highland pipes, F# and C# marked */
+                key_from_fifths(key, 2);
+                p += 2;
+        } else if (is_name(*p)) {
+                fifths = TONIC_FIFTHS[name_to_dp(*p++)];
+                if (p < end && '#' == *p) {
+                        fifths += 7;
+                        p++;
+                } else if (p < end && 'b' == *p) {
+                        fifths -= 7;
+                        p++;
+                }
+
+                p = parse_mode(p, end, &fifths);
+                key_from_fifths(key, fifths);
+        } else if ('^' == *p || '_' == *p || '=' == *p) {
+                /* Explicit accidentals only */
+                key_from_fifths(key, 0);
+        } else {
+                return TONAL_FAIL;
+        }
+
+        /* Explicit accidentals, "exp", and clef and other settings */
+        while (p < end) {
+                const char *t;
+                const char *te;
+
+                while (p < end && is_space(*p)) { p++; }
+                for (te = p; te < end && !is_space(*te); te++) {
+                        ;
+                }
+                t = p;
+                p = te;
+                if (t == te) {
+                        break;
+                } else if (3 == te - t && 0 == memcmp(t, "exp", 3)) {
+                        key_from_fifths(key, 0);
+                } else if ('^' == *t || '_' == *t || '=' == *t) {
+                        int alter;
+                        int error = TONAL_E_OK;
+
+                        t = parse_accidental(t, te, &alter, &error);
+                        if (TONAL_E_OK != error || te - t != 1 || !is_name(*t)) {
+                                return TONAL_FAIL;
+                        }
+                        key[name_to_dp(*t)] = alter;
+                }
+        }
+        return TONAL_OK;
+}
+
+static void bar_line(struct abc *a)
+{
+        if (a->content) {
+                a->note.bar++;
+                a->content = 0;
+        }
+        if (0 == ++a->gen) {
+                memset(a->bar_gen, 0, sizeof a->bar_gen);
+                a->gen = 1;
+        }
+}
+
+/* Note at *pp: accidentals, letter and octave marks */
+static int note(struct abc *a, const char **pp, const char *end)
+{
+        struct tonal_abc_note *n = &a->note;
+        const char *p = *pp;
+        int error = TONAL_E_OK;
+        int explicit;
+        int alter;
+        int octave;
+        int dp;
+        int o;
+        int ret;
+
+        explicit = !is_name(*p);
+        p = parse_accidental(p, end, &alter, &error);
+        if (p == end || !is_name(*p)) {
+                /* Stray accidental */
+                *pp = p;
+                return TONAL_OK;
+        }
+        dp = name_to_dp(*p);
+        octave = a->base + ('a' <= *p);
+        for (p++; p < end && (',' == *p || '\'' == *p); p++) {
+                octave += ',' == *p ? -1 : 1;
+        }
+        *pp = p;
+
+        o = octave - a->base + NOCT / 2;
+        if (o < 0 || NOCT <= o) {
+                o = -1;
+        }
+        if (explicit) {
+                if (0 <= o && TONAL_E_OK == error) {
+                        a->bar_alter[dp][o] = alter;
+                        a->bar_gen[dp][o] = a->gen;
+                }
+        } else if (0 <= o && a->gen == a->bar_gen[dp][o]) {
+                alter = a->bar_alter[dp][o];
+        } else {
+                alter = a->key[dp];
+        }
+        if (TONAL_E_OK == error && TONAL_ALTERATION_MAX < abs(alter)) {
+                error = TONAL_E_ALTERATION;
+        }
+
+        n->error = error;
+        if (TONAL_E_OK == error) {
+                n->pitch.diatonic_pitch = dp;
+                n->pitch.pitch_alteration = PA_ALTERATION(alter);
+                n->pitch.octave = octave;
+        }
+        a->content = 1;
+        ret = a->fn(n, a->arg);
+        if (a->in_chord) { n->chord++; }
+        return ret;
+}
+
+/* One line of music, [p, end) */
+static int music(struct abc *a, const char *p, const char *end)
+{
+        while (p < end) {
+                const char *q;
+                char c = *p;
+                int ret;
+
+                switch (c) {
+                case '%':
+                        return TONAL_OK;
+                case '"':
+                        /* Chord symbol or annotation */
+                        q = memchr(p + 1, '"', end - p - 1);
+                        p = q ? q + 1 : end;
+                        break;
+                case '!':
+                case '+':
+                        /* Decoration */
+                        q = memchr(p + 1, c, end - p - 1);
+                        p = q ? q + 1 : p + 1;
+                        break;
+                case '{':
+                case '}':
+                        a->note.grace = '{' == c;
+                        p++;
+                        break;
+                case '[':
+                        if (3 <= end - p && is_alpha(p[1]) && ':' == p[2]) {
+                                /* Inline field */
+                                q = memchr(p, ']', end - p);
+                                if ('K' == p[1]) {
+                                        ret = parse_key(p + 3, q ? q : end, a->key);
+                                        if (TONAL_OK != ret) { return ret; }
+                                }
+                                p = q ? q + 1 : end;
+                        } else if (2 <= end - p && '|' == p[1]) {
+                                bar_line(a);
+                                for (p += 2; p < end && ('|' == *p || ':' == *p); p++) {
+                                        ;
+                                }
+                        } else if (2 <= end - p && is_digit(p[1])) {
+                                /* Repeat ending */
+                                p++;
+                        } else {
+                                a->in_chord = 1;
+                                a->note.chord = 0;
+                                p++;
+                        }
+                        break;
+                case ']':
+                        a->in_chord = 0;
+                        a->note.chord = 0;
+                        p++;
+                        break;
+                case '|':
+                case ':':
+                        bar_line(a);
+                        while (p < end && ('|' == *p || ':' == *p || ']' == *p)) {
+                                p++;
+                        }
+                        break;
+                case 'z':
+                case 'Z':
+                case 'x':
+                case 'X':
+                        /* Rest */
+                        a->content = 1;
+                        p++;
+                        break;
+                case '^':
+                case '_':
+                case '=':
+                        ret = note(a, &p, end);
+                        if (TONAL_OK != ret) { return ret; }
+                        break;
+                default:
+                        if (is_name(c)) {
+                                ret = note(a, &p, end);
+                                if (TONAL_OK != ret) { return ret; }
+                        } else {
+                                p++;
+                        }
+                        break;
+                }
+        }
+        return TONAL_OK;
+}
+
+/*
+ * Find the next tune at or after *pp: from an X: line to a blank line, the
+ * next X: line or the end. *line is the line number at *pp and is advanced
+ * along. Returns 0 if there are no more tunes.
+ */
+static int next_tune(
+        const char **pp,
+        const char *end,
+        size_t *line,
+        const char **tune,
+        const char **tune_end,
+        size_t *tune_line
+)
+{
+        const char *p = *pp;
+
+        while (p < end && !(2 <= end - p && 'X' == p[0] && ':' == p[1])) {
+                p = next_line(p, end);
+                (*line)++;
+        }
+        if (p == end) { return 0; }
+
+        *tune = p;
+        *tune_line = *line;
+        do {
+                p = next_line(p, end);
+                (*line)++;
+        } while (
+                p < end &&
+                !is_blank(p, end) &&
+                !('X' == p[0] && 2 <= end - p && ':' == p[1])
+        );
+        *tune_end = p;
+        *pp = p;
+        return 1;
+}
+
+/* One tune, [p, end), starting at line number line */
+static int scan_tune(
+        struct abc *a,
+        const char *p,
+        const char *end,
+        size_t line,
+        struct tonal_abc_tune *tune
+)
+{
+        key_from_fifths(a->key, 0);
+        a->content = 0;
+        a->in_chord = 0;
+        a->note.bar = 0;
+        a->note.chord = 0;
+        a->note.grace = 0;
+        a->note.line = line;
+        /* Forget the accidentals of the previous tune. */
+        bar_line(a);
+
+        for (; p < end; p = next_line(p, end), a->note.line++) {
+                const char *le = line_end(p, end);
+                int ret = TONAL_OK;
+
+                if (p < le && '%' == *p) {
+                        continue;
+                }
+                if (!is_field(p, le)) {
+                        ret = music(a, p, le);
+                } else if ('K' == *p) {
+                        ret = parse_key(p + 2, le, a->key);
+                } else if (tune && 'T' == *p && NULL == tune->title) {
+                        const char *t = p + 2;
+
+                        while (t < le && is_space(*t)) { t++; }
+                        tune->title = t;
+                        tune->title_len = le - t;
+                } else if (tune && 'X' == *p) {
+                        const char *t = p + 2;
+
+                        while (t < le && is_space(*t)) { t++; }
+                        for (tune->x = 0; t < le && is_digit(*t) && tune->x < 100000000; t++) {
+                                tune->x = 10 * tune->x + (*t - '0');
+                        }
+                }
+                if (TONAL_OK != ret) { return ret; }
+        }
+        return TONAL_OK;
+}
+
+static int abc_init(struct abc *a, int oc, tonal_abc_fn fn, void *arg)
+{
+        int ret;
+
+        memset(a, 0, sizeof *a);
+        ret = middle_c(oc, &a->base);
+        if (TONAL_OK != ret) { return ret; }
+        a->fn = fn;
+        a->arg = arg;
+        a->gen = 1;
+        return TONAL_OK;
+}
+
+static int abc_scan_impl(
+        const char *doc,
+        size_t size,
+        int oc,
+        tonal_abc_fn fn,
+        void *arg
+)
+{
+        struct abc a;
+        const char *p = doc;
+        const char *end = doc + size;
+        const char *tune;
+        const char *tune_end;
+        size_t line = 1;
+        size_t tune_line;
+        int ret;
+
+        if ((NULL == doc && size) || NULL == fn) { return TONAL_FAIL; }
+
+        ret = abc_init(&a, oc, fn, arg);
+        if (TONAL_OK != ret) { return ret; }
+        a.note.tune = 0;
+        while (TONAL_OK == ret && next_tune(&p, end, &line, &tune, &tune_end, &tune_line)) {
+                ret = scan_tune(&a, tune, tune_end, tune_line, NULL);
+                a.note.tune++;
+        }
+        return ret;
+}
+
+int tonal_abc_scan(
+        const char *doc,
+        size_t size,
+        int oc,
+        tonal_abc_fn fn,
+        void *arg
+)
+{
+        int ret;
+
+        TONAL_STATS_BATCH(TONAL_STATS_ABC_SCAN, size);
+        TONAL_STATS_TIMER(t0);
+        ret = abc_scan_impl(doc, size, oc, fn, arg);
+        TONAL_STATS_ELAPSED(TONAL_STATS_ABC_SCAN, t0);
+        if (TONAL_OK != ret) {
+                TONAL_FAILED(TONAL_STATS_ABC_SCAN, TONAL_E_FAIL);
+        }
+        TONAL_PROBE2(abc_scan_return, size, ret);
+        return ret;
+}
+
+/* Append each note to a tune, stop at the first invalid one */
+static int collect(const struct tonal_abc_note *note, void *arg)
+{
+        struct tonal_abc_tune *t = arg;
+
+        if (TONAL_E_OK != note->error) { return note->error; }
+
+        if (t->n == t->max) {
+                size_t max = t->max ? 2 * t->max : 64;
+                struct tonal_pitch *pitch;
+
+                pitch = realloc(t->pitch, max * sizeof *pitch);
+                if (NULL == pitch) { return TONAL_FAIL; }
+                t->pitch = pitch;
+                t->max = max;
+        }
+        t->pitch[t->n++] = note->pitch;
+        return TONAL_OK;
+}
+
+struct book_job {
+        const char *doc;
+        int oc;
+        struct tonal_abc_book *book;
+        /* Serializes allocations from book->arena */
+        pthread_mutex_t lock;
+        /* Line number of each tune */
+        size_t *line;
+        /* Next tune to read */
+        size_t next;
+};
+
+/*
+ * Move the notes collected in scratch to the arena. The arena is only
+ * locked for the allocation.
+ */
+static int move_to_arena(
+        struct book_job *job,
+        struct tonal_abc_tune *scratch,
+        struct tonal_abc_tune *t
+)
+{
+        struct tonal_pitch *pitch;
+
+        pthread_mutex_lock(&job->lock);
+        pitch = tonal_arena_alloc(job->book->arena, scratch->n * sizeof *pitch);
+        pthread_mutex_unlock(&job->lock);
+        if (NULL == pitch) { return TONAL_FAIL; }
+        memcpy(pitch, scratch->pitch, scratch->n * sizeof *pitch);
+        t->pitch = pitch;
+        t->n = scratch->n;
+        t->max = scratch->n;
+        return TONAL_OK;
+}
+
+/*
+ * Read tune i. With an arena, the notes are collected in scratch, else in
+ * the tune.
+ */
+static void read_tune(struct book_job *job, struct tonal_abc_tune *scratch, size_t i)
+{
+        struct tonal_abc_tune *t = &job->book->tune[i];
+        struct tonal_abc_tune *dst = job->book->arena ? scratch : t;
+        struct abc a;
+        int ret;
+
+        scratch->n = 0;
+        ret = abc_init(&a, job->oc, collect, dst);
+        if (TONAL_OK == ret) {
+                a.note.tune = (int) i;
+                ret = scan_tune(
+                        &a,
+                        job->doc + t->offset,
+                        job->doc + t->offset + t->size,
+                        job->line[i],
+                        t
+                );
+        }
+        if (TONAL_OK == ret && dst == scratch) {
+                ret = move_to_arena(job, scratch, t);
+        }
+        t->status = ret;
+        if (TONAL_OK != ret) {
+                if (dst == t) { free(t->pitch); }
+                t->pitch = NULL;
+                t->n = 0;
+                t->max = 0;
+        }
+}
+
+static void *book_worker(void *arg)
+{
+        struct book_job *job = arg;
+        struct tonal_abc_tune scratch;
+        size_t i;
+
+        memset(&scratch, 0, sizeof scratch);
+        while ((i = __atomic_fetch_add(&job->next, 1, __ATOMIC_RELAXED)) < job->book->ntunes) {
+                read_tune(job, &scratch, i);
+        }
+        free(scratch.pitch);
+        return NULL;
+}
+
+int tonal_abc_read_book(
+        const char *doc,
+        size_t size,
+        int oc,
+        int nthreads,
+        struct tonal_abc_book *book
+)
+{
+        return tonal_abc_read_book_arena(doc, size, oc, nthreads, NULL, book);
+}
+
+static int read_book_impl(
+        const char *doc,
+        size_t size,
+        int oc,
+        int nthreads,
+        struct tonal_arena *arena,
+        struct tonal_abc_book *book
+)
+{
+        struct book_job job;
+        pthread_t *threads;
+        const char *p = doc;
+        const char *end = doc + size;
+        const char *tune;
+        const char *tune_end;
+        size_t line = 1;
+        size_t tune_line;
+        size_t max = 0;
+        int base;
+        int ret;
+        int started = 0;
+
+        if (NULL == book) { return TONAL_FAIL; }
+        book->tune = NULL;
+        book->ntunes = 0;
+        book->arena = arena;
+        if ((NULL == doc && size) || nthreads < 0) { return TONAL_FAIL; }
+        ret = middle_c(oc, &base);
+        if (TONAL_OK != ret) { return ret; }
+
+        memset(&job, 0, sizeof job);
+        job.doc = doc;
+        job.oc = oc;
+        job.book = book;
+
+        /* Split into tunes */
+        while (next_tune(&p, end, &line, &tune, &tune_end, &tune_line)) {
+                struct tonal_abc_tune *t;
+
+                if (book->ntunes == max) {
+                        size_t *l;
+
+                        max = max ? 2 * max : 64;
+                        t = tonal_arena_realloc(
+                                arena,
+                                book->tune,
+                                book->ntunes * sizeof *t,
+                                max * sizeof *t
+                        );
+                        if (NULL == t) { goto out; }
+                        book->tune = t;
+                        l = realloc(job.line, max * sizeof *l);
+                        if (NULL == l) { goto out; }
+                        job.line = l;
+                }
+                t = &book->tune[book->ntunes];
+                memset(t, 0, sizeof *t);
+                t->offset = tune - doc;
+                t->size = tune_end - tune;
+                job.line[book->ntunes++] = tune_line;
+        }
+
+        if (0 == nthreads) {
+                long n = sysconf(_SC_NPROCESSORS_ONLN);
+
+                nthreads = n < 1 ? 1 : n > 256 ? 256 : (int) n;
+        }
+        if ((size_t) nthreads > book->ntunes) {
+                nthreads = book->ntunes ? (int) book->ntunes : 1;
+        }
+
+        /* The calling thread is one of the workers. */
+        pthread_mutex_init(&job.lock, NULL);
+        threads = NULL;
+        if (1 < nthreads) {
+                threads = malloc((nthreads - 1) * sizeof *threads);
+        }
+        for (; threads && started < nthreads - 1; started++) {
+                if (0 != pthread_create(&threads[started], NULL, book_worker, &job)) {
+                        break;
+                }
+        }
+        book_worker(&job);
+        for (int i = 0; i < started; i++) {
+                pthread_join(threads[i], NULL);
+        }
+        free(threads);
+        pthread_mutex_destroy(&job.lock);
+
+        ret = TONAL_OK;
+        for (size_t i = 0; i < book->ntunes; i++) {
+                if (TONAL_OK != book->tune[i].status) { ret = TONAL_FAIL; }
+        }
+        free(job.line);
+        TONAL_PROBE2(abc_read_book_return, book->ntunes, ret);
+        return ret;
+
+out:
+        free(job.line);
+        return TONAL_FAIL;
+}
+
+int tonal_abc_read_book_arena(
+        const char *doc,
+        size_t size,
+        int oc,
+        int nthreads,
+        struct tonal_arena *arena,
+        struct tonal_abc_book *book
+)
+{
+        int ret;
+
+        TONAL_STATS_BATCH(TONAL_STATS_ABC_READ_BOOK, size);
+        TONAL_STATS_TIMER(t0);
+        ret = read_book_impl(doc, size, oc, nthreads, arena, book);
+        TONAL_STATS_ELAPSED(TONAL_STATS_ABC_READ_BOOK, t0);
+        if (TONAL_OK != ret) {
+                TONAL_FAILED(TONAL_STATS_ABC_READ_BOOK, TONAL_E_FAIL);
+        }
+        return ret;
+}
+
+void tonal_abc_book_free(struct tonal_abc_book *book)
+{
+        if (NULL == book) { return; }
+
+        if (NULL == book->arena) {
+                for (size_t i = 0; i < book->ntunes; i++) {
+                        free(book->tune[i].pitch);
+                }
+                free(book->tune);
+        }
+        book->tune = NULL;
+        book->ntunes = 0;
+}
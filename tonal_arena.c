@@ -0,0 +1,243 @@
+/*
+ * Copyright 2016 Martin Aberg
+ *
+ * This file is part of tonal.
+ *
+ * tonal is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * tonal is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Arena allocation, see tonal_arena.h.
+ *
+ * Allocations larger than a quarter block get a block of their own, placed
+ * after the current block so that it keeps serving small allocations. Only
+ * blocks of the standard size are kept as spares.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <tonal_arena.h>
+#include "tonal_priv.h"
+
+#define DEFAULT_BLOCK_SIZE (64 * 1024)
+
+union align {
+        long double d;
+        long long l;
+        void *p;
+};
+
+#define ALIGN sizeof (union align)
+#define ROUND(size) (((size) + ALIGN - 1) / ALIGN * ALIGN)
+
+struct tonal_arena_block {
+        struct tonal_arena_block *next;
+        size_t size;
+        size_t used;
+        union align data[];
+};
+
+static char *data(struct tonal_arena_block *b)
+{
+        return (char *) b->data;
+}
+
+static struct tonal_arena_block *new_block(struct tonal_arena *a, size_t size)
+{
+        struct tonal_arena_block *b;
+
+        if (SIZE_MAX - sizeof *b < size) { return NULL; }
+        b = malloc(sizeof *b + size);
+        if (NULL == b) { return NULL; }
+        b->size = size;
+        b->used = 0;
+        a->total += size;
+        return b;
+}
+
+int tonal_arena_init(struct tonal_arena *a, size_t block_size)
+{
+        if (NULL == a) { return TONAL_FAIL; }
+
+        memset(a, 0, sizeof *a);
+        a->block_size = ROUND(block_size ? block_size : DEFAULT_BLOCK_SIZE);
+        return TONAL_OK;
+}
+
+static void free_blocks(struct tonal_arena_block *b)
+{
+        struct tonal_arena_block *next;
+
+        for (; b; b = next) {
+                next = b->next;
+                free(b);
+        }
+}
+
+void tonal_arena_free(struct tonal_arena *a)
+{
+        if (NULL == a) { return; }
+
+        free_blocks(a->block);
+        free_blocks(a->spare);
+        a->block = NULL;
+        a->spare = NULL;
+        a->last = NULL;
+        a->total = 0;
+}
+
+void tonal_arena_reset(struct tonal_arena *a)
+{
+        struct tonal_arena_block *b;
+        struct tonal_arena_block *next;
+
+        if (NULL == a) { return; }
+
+        for (b = a->block; b; b = next) {
+                next = b->next;
+                if (b->size != a->block_size) {
+                        a->total -= b->size;
+                        free(b);
+                        continue;
+                }
+                b->used = 0;
+                b->next = a->spare;
+                a->spare = b;
+        }
+        a->block = NULL;
+        a->last = NULL;
+}
+
+void *tonal_arena_alloc(struct tonal_arena *a, size_t size)
+{
+        struct tonal_arena_block *b;
+
+        if (NULL == a) { return malloc(size); }
+        if (SIZE_MAX - ALIGN < size) { return NULL; }
+
+        size = ROUND(size);
+        b = a->block;
+        if (NULL == b || b->size - b->used < size) {
+                if (a->block_size / 4 < size) {
+                        /* A block of its own */
+                        b = new_block(a, size);
+                        if (NULL == b) { return NULL; }
+                        b->used = size;
+                        if (a->block) {
+                                b->next = a->block->next;
+                                a->block->next = b;
+                        } else {
+                                b->next = NULL;
+                                a->block = b;
+                        }
+                        a->last = data(b);
+                        return a->last;
+                }
+                b = a->spare;
+                if (b) {
+                        a->spare = b->next;
+                } else {
+                        b = new_block(a, a->block_size);
+                        if (NULL == b) { return NULL; }
+                }
+                b->next = a->block;
+                a->block = b;
+        }
+        a->last = data(b) + b->used;
+        b->used += size;
+        return a->last;
+}
+
+void *tonal_arena_realloc(
+        struct tonal_arena *a,
+        void *p,
+        size_t old,
+        size_t size
+)
+{
+        struct tonal_arena_block *b;
+        size_t off;
+        void *q;
+
+        if (NULL == a) { return realloc(p, size); }
+        if (NULL == p) { return tonal_arena_alloc(a, size); }
+
+        b = a->block;
+        if (p == a->last && b && data(b) <= (char *) p && (char *) p < data(b) + b->size) {
+                off = (char *) p - data(b);
+                if (size <= b->size - off) {
+                        b->used = off + ROUND(size);
+                        return p;
+                }
+        }
+        q = tonal_arena_alloc(a, size);
+        if (NULL == q) { return NULL; }
+        memcpy(q, p, old < size ? old : size);
+        return q;
+}
+
+int tonal_seq_init(struct tonal_seq *s, struct tonal_arena *arena)
+{
+        if (NULL == s) { return TONAL_FAIL; }
+
+        s->pitch = NULL;
+        s->n = 0;
+        s->max = 0;
+        s->arena = arena;
+        return TONAL_OK;
+}
+
+void tonal_seq_free(struct tonal_seq *s)
+{
+        if (NULL == s) { return; }
+
+        if (NULL == s->arena) { free(s->pitch); }
+        s->pitch = NULL;
+        s->n = 0;
+        s->max = 0;
+}
+
+int tonal_seq_append(
+        struct tonal_seq *s,
+        const struct tonal_pitch *tp,
+        size_t n
+)
+{
+        struct tonal_pitch *pitch;
+        size_t max;
+
+        if (NULL == s || (NULL == tp && n)) { return TONAL_FAIL; }
+
+        if (s->max - s->n < n) {
+                max = s->max ? s->max : 64;
+                while (max - s->n < n) {
+                        if (SIZE_MAX / 2 / sizeof *pitch < max) { return TONAL_FAIL; }
+                        max *= 2;
+                }
+                pitch = tonal_arena_realloc(
+                        s->arena,
+                        s->pitch,
+                        s->max * sizeof *pitch,
+                        max * sizeof *pitch
+                );
+                if (NULL == pitch) { return TONAL_FAIL; }
+                s->pitch = pitch;
+                s->max = max;
+        }
+        if (n) { memcpy(&s->pitch[s->n], tp, n * sizeof *tp); }
+        s->n += n;
+        return TONAL_OK;
+}
@@ -0,0 +1,480 @@
+/*
+ * Copyright 2016 Martin Aberg
+ *
+ * This file is part of tonal.
+ *
+ * tonal is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * tonal is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Analysis cache, see tonal_cache.h.
+ *
+ * The file is a header followed by records, each 8-byte aligned:
+ *
+ *   struct record, npitch packed pitches (uint32_t), size value bytes
+ *
+ * A packed pitch holds the diatonic pitch in bits 0 to 3, the alteration
+ * from natural (pitch_alteration - PA_) as a signed byte in bits 4 to 11 and
+ * the octave plus OCTAVE_BIAS in bits 12 to 31. It does not depend on
+ * TONAL_ALTERATION_MAX, so builds with different ranges share a file.
+ *
+ * A record is complete when its check, a hash of the pitches and the value,
+ * matches. Indexing stops at the first record which is not complete: either
+ * it is being written, or a writer died while writing it. Writers hold the
+ * lock and write the next record where the complete ones end, over any such
+ * leftover, so the file never shrinks under a reader.
+ *
+ * The hashes follow xxHash64 (rounds, primes and avalanche).
+ */
+
+#define _DEFAULT_SOURCE
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <tonal_cache.h>
+#include "tonal_priv.h"
+
+#define P1 0x9E3779B185EBCA87ULL
+#define P2 0xC2B2AE3D27D4EB4FULL
+#define P3 0x165667B19E3779F9ULL
+#define P4 0x85EBCA77C2B2AE63ULL
+#define P5 0x27D4EB2F165667C5ULL
+
+#define RECORD_MAGIC 0x52434e54u
+#define VERSION 2
+/* Octaves are packed in 20 bits. */
+#define OCTAVE_BIAS (1 << 19)
+
+static const char MAGIC[8] = { 't', 'o', 'n', 'a', 'l', 'c', 'a', 'c' };
+
+struct header {
+        char magic[8];
+        uint32_t version;
+        uint32_t zero;
+};
+
+struct record {
+        uint32_t magic;
+        uint32_t kind;
+        /* tonal_cache_hash() of the pitches */
+        uint64_t hash;
+        uint32_t npitch;
+        uint32_t size;
+        /* Hash of the packed pitches and the value */
+        uint64_t check;
+};
+
+struct tonal_cache_slot {
+        uint64_t hash;
+        uint32_t kind;
+        /* Offset of the record, 0 for an empty slot */
+        size_t off;
+};
+
+static uint64_t rotl(uint64_t x, int r)
+{
+        return (x << r) | (x >> (64 - r));
+}
+
+static uint64_t round64(uint64_t h, uint64_t k)
+{
+        k *= P2;
+        k = rotl(k, 31);
+        k *= P1;
+        h ^= k;
+        return rotl(h, 27) * P1 + P4;
+}
+
+static uint64_t round32(uint64_t h, uint32_t k)
+{
+        h ^= k * P1;
+        return rotl(h, 23) * P2 + P3;
+}
+
+static uint64_t avalanche(uint64_t h)
+{
+        h ^= h >> 33;
+        h *= P2;
+        h ^= h >> 29;
+        h *= P3;
+        h ^= h >> 32;
+        return h;
+}
+
+static uint64_t hash_bytes(const char *p, size_t len, uint64_t seed)
+{
+        uint64_t h = seed + P5 + len;
+        uint64_t k;
+        uint32_t w;
+
+        for (; 8 <= len; p += 8, len -= 8) {
+                memcpy(&k, p, 8);
+                h = round64(h, k);
+        }
+        if (4 <= len) {
+                memcpy(&w, p, 4);
+                h = round32(h, w);
+                p += 4;
+                len -= 4;
+        }
+        for (; len; p++, len--) {
+                h ^= (unsigned char) *p * P5;
+                h = rotl(h, 11) * P1;
+        }
+        return avalanche(h);
+}
+
+static int pack(const struct tonal_pitch *tp, uint32_t *word)
+{
+        struct tonal_pitch valid;
+        int ret;
+
+        ret = tp_set(&valid, tp->diatonic_pitch, tp->pitch_alteration, tp->octave);
+        if (TONAL_OK != ret) { return ret; }
+        if (tp->octave < -OCTAVE_BIAS || OCTAVE_BIAS <= tp->octave) {
+                return TONAL_FAIL;
+        }
+        *word = (uint32_t) tp->diatonic_pitch |
+                ((uint32_t) (tp->pitch_alteration - PA_) & 0xff) << 4 |
+                (uint32_t) (tp->octave + OCTAVE_BIAS) << 12;
+        return TONAL_OK;
+}
+
+/* Rounds over pairs of packed pitches, packed on the fly */
+int tonal_cache_hash(
+        const struct tonal_pitch *tp,
+        size_t n,
+        uint64_t *hash
+)
+{
+        uint64_t h = P5 + 4 * n;
+        uint32_t w0;
+        uint32_t w1;
+        size_t i;
+        int ret;
+
+        if ((NULL == tp && n) || NULL == hash) { return TONAL_FAIL; }
+
+        for (i = 0; i + 1 < n; i += 2) {
+                ret = pack(&tp[i], &w0);
+                if (TONAL_OK != ret) { return ret; }
+                ret = pack(&tp[i + 1], &w1);
+                if (TONAL_OK != ret) { return ret; }
+                h = round64(h, (uint64_t) w1 << 32 | w0);
+        }
+        if (i < n) {
+                ret = pack(&tp[i], &w0);
+                if (TONAL_OK != ret) { return ret; }
+                h = round32(h, w0);
+        }
+        *hash = avalanche(h);
+        return TONAL_OK;
+}
+
+static size_t record_size(uint32_t npitch, uint32_t size)
+{
+        size_t len = sizeof (struct record) + 4 * (size_t) npitch + size;
+
+        return (len + 7) & ~(size_t) 7;
+}
+
+/* Record at off if it is complete, else NULL */
+static const struct record *get_record(const struct tonal_cache *c, size_t off)
+{
+        const struct record *rec;
+        size_t len;
+
+        if (c->file_size - off < sizeof *rec) { return NULL; }
+        rec = (const struct record *) (c->map + off);
+        if (RECORD_MAGIC != rec->magic) { return NULL; }
+        len = record_size(rec->npitch, rec->size);
+        if (c->file_size - off < len) { return NULL; }
+        if (rec->check != hash_bytes(
+                (const char *) (rec + 1),
+                4 * (size_t) rec->npitch + rec->size,
+                rec->hash
+        )) {
+                return NULL;
+        }
+        return rec;
+}
+
+static int insert(struct tonal_cache *c, uint64_t hash, uint32_t kind, size_t off)
+{
+        struct tonal_cache_slot *slot;
+        size_t nslots;
+        size_t i;
+
+        if (c->nslots <= 2 * (c->n + 1)) {
+                nslots = c->nslots ? 2 * c->nslots : 1024;
+                slot = calloc(nslots, sizeof *slot);
+                if (NULL == slot) { return TONAL_FAIL; }
+                for (size_t j = 0; j < c->nslots; j++) {
+                        if (0 == c->slot[j].off) { continue; }
+                        i = c->slot[j].hash & (nslots - 1);
+                        while (slot[i].off) { i = (i + 1) & (nslots - 1); }
+                        slot[i] = c->slot[j];
+                }
+                free(c->slot);
+                c->slot = slot;
+                c->nslots = nslots;
+        }
+        i = hash & (c->nslots - 1);
+        while (c->slot[i].off) { i = (i + 1) & (c->nslots - 1); }
+        c->slot[i].hash = hash;
+        c->slot[i].kind = kind;
+        c->slot[i].off = off;
+        c->n++;
+        return TONAL_OK;
+}
+
+/* Record stored for kind and tp[0..n), or NULL */
+static const struct record *lookup(
+        const struct tonal_cache *c,
+        uint64_t hash,
+        uint32_t kind,
+        const struct tonal_pitch *tp,
+        size_t n
+)
+{
+        const struct tonal_cache_slot *s;
+        const struct record *rec;
+        const char *p;
+        uint32_t w0;
+        uint32_t w1;
+        size_t i;
+        size_t j;
+
+        if (0 == c->nslots) { return NULL; }
+        for (i = hash & (c->nslots - 1); c->slot[i].off; i = (i + 1) & (c->nslots - 1)) {
+                s = &c->slot[i];
+                if (s->hash != hash || s->kind != kind) { continue; }
+                rec = (const struct record *) (c->map + s->off);
+                if (rec->npitch != n) { continue; }
+                p = (const char *) (rec + 1);
+                for (j = 0; j < n; j++) {
+                        memcpy(&w0, p + 4 * j, 4);
+                        pack(&tp[j], &w1);
+                        if (w0 != w1) { break; }
+                }
+                if (j == n) { return rec; }
+        }
+        return NULL;
+}
+
+/* Map what the file holds now and index the new complete records. */
+static int refresh(struct tonal_cache *c)
+{
+        const struct record *rec;
+        struct header head;
+        struct stat st;
+        size_t size;
+        void *p;
+
+        if (0 != fstat(c->fd, &st)) { return TONAL_FAIL; }
+        if ((size_t) st.st_size < c->file_size) { return TONAL_FAIL; }
+        if ((size_t) st.st_size > c->map_size) {
+                /*
+                 * Pages past the end of the file are not touched, they
+                 * only save remapping on each append.
+                 */
+                size = 2 * c->map_size;
+                if (size < (size_t) st.st_size) { size = st.st_size; }
+                p = mmap(NULL, size, PROT_READ, MAP_SHARED, c->fd, 0);
+                if (MAP_FAILED == p) { return TONAL_FAIL; }
+                if (c->map_size) { munmap((void *) c->map, c->map_size); }
+                c->map = p;
+                c->map_size = size;
+        }
+        c->file_size = st.st_size;
+        if (0 == c->size) {
+                if (c->file_size < sizeof head) { return TONAL_OK; }
+                memcpy(&head, c->map, sizeof head);
+                if (0 != memcmp(head.magic, MAGIC, sizeof MAGIC) || VERSION != head.version) {
+                        return TONAL_FAIL;
+                }
+                c->size = sizeof head;
+        }
+        while (NULL != (rec = get_record(c, c->size))) {
+                if (TONAL_OK != insert(c, rec->hash, rec->kind, c->size)) {
+                        return TONAL_FAIL;
+                }
+                c->size += record_size(rec->npitch, rec->size);
+        }
+        return TONAL_OK;
+}
+
+static int write_all(int fd, const char *buf, size_t len, off_t off)
+{
+        ssize_t n;
+
+        while (len) {
+                n = pwrite(fd, buf, len, off);
+                if (n <= 0) { return TONAL_FAIL; }
+                buf += n;
+                len -= n;
+                off += n;
+        }
+        return TONAL_OK;
+}
+
+int tonal_cache_open(struct tonal_cache *c, const char *path)
+{
+        int ret;
+
+        if (NULL == c || NULL == path) { return TONAL_FAIL; }
+
+        memset(c, 0, sizeof *c);
+        c->fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0666);
+        if (c->fd < 0) {
+                c->fd = open(path, O_RDONLY | O_CLOEXEC);
+                c->readonly = 1;
+        }
+        if (c->fd < 0) { return TONAL_FAIL; }
+
+        ret = refresh(c);
+        if (TONAL_OK != ret) {
+                tonal_cache_close(c);
+                return ret;
+        }
+        return TONAL_OK;
+}
+
+void tonal_cache_close(struct tonal_cache *c)
+{
+        if (NULL == c) { return; }
+
+        if (c->map_size) { munmap((void *) c->map, c->map_size); }
+        if (0 <= c->fd) { close(c->fd); }
+        free(c->slot);
+        memset(c, 0, sizeof *c);
+        c->fd = -1;
+}
+
+int tonal_cache_get(
+        struct tonal_cache *c,
+        uint32_t kind,
+        const struct tonal_pitch *tp,
+        size_t n,
+        const void **value,
+        size_t *size
+)
+{
+        const struct record *rec;
+        uint64_t hash;
+        int ret;
+
+        if (NULL == c || c->fd < 0 || NULL == value || NULL == size) {
+                return TONAL_FAIL;
+        }
+        ret = tonal_cache_hash(tp, n, &hash);
+        if (TONAL_OK != ret) { return ret; }
+
+        rec = lookup(c, hash, kind, tp, n);
+        if (NULL == rec) {
+                /* Another process may have added it. */
+                ret = refresh(c);
+                if (TONAL_OK != ret) { return ret; }
+                rec = lookup(c, hash, kind, tp, n);
+        }
+        if (NULL == rec) { return TONAL_FAIL; }
+
+        *value = (const char *) (rec + 1) + 4 * (size_t) rec->npitch;
+        *size = rec->size;
+        return TONAL_OK;
+}
+
+/* Write the record in buf after the complete ones, holding the lock. */
+static int append(
+        struct tonal_cache *c,
+        const char *buf,
+        size_t len,
+        const struct tonal_pitch *tp,
+        size_t n
+)
+{
+        const struct record *rec = (const struct record *) buf;
+        struct header head;
+        int ret;
+
+        ret = refresh(c);
+        if (TONAL_OK != ret) { return ret; }
+        if (0 == c->size) {
+                /* New file, or a writer died before the header was out */
+                memcpy(head.magic, MAGIC, sizeof MAGIC);
+                head.version = VERSION;
+                head.zero = 0;
+                ret = write_all(c->fd, (const char *) &head, sizeof head, 0);
+                if (TONAL_OK != ret) { return ret; }
+                ret = refresh(c);
+                if (TONAL_OK != ret) { return ret; }
+        }
+        if (lookup(c, rec->hash, rec->kind, tp, n)) { return TONAL_OK; }
+        ret = write_all(c->fd, buf, len, c->size);
+        if (TONAL_OK != ret) { return ret; }
+        return refresh(c);
+}
+
+int tonal_cache_put(
+        struct tonal_cache *c,
+        uint32_t kind,
+        const struct tonal_pitch *tp,
+        size_t n,
+        const void *value,
+        size_t size
+)
+{
+        struct record *rec;
+        uint32_t *word;
+        uint64_t hash;
+        size_t len;
+        char *buf;
+        int ret;
+
+        if (NULL == c || c->fd < 0 || c->readonly || (NULL == value && size)) {
+                return TONAL_FAIL;
+        }
+        if (UINT32_MAX < n || UINT32_MAX < size) { return TONAL_FAIL; }
+        ret = tonal_cache_hash(tp, n, &hash);
+        if (TONAL_OK != ret) { return ret; }
+        if (lookup(c, hash, kind, tp, n)) { return TONAL_OK; }
+
+        len = record_size(n, size);
+        buf = calloc(1, len);
+        if (NULL == buf) { return TONAL_FAIL; }
+        rec = (struct record *) buf;
+        word = (uint32_t *) (rec + 1);
+        for (size_t i = 0; i < n; i++) { pack(&tp[i], &word[i]); }
+        if (size) { memcpy(word + n, value, size); }
+        rec->magic = RECORD_MAGIC;
+        rec->kind = kind;
+        rec->hash = hash;
+        rec->npitch = n;
+        rec->size = size;
+        rec->check = hash_bytes((const char *) word, 4 * n + size, hash);
+
+        if (0 != flock(c->fd, LOCK_EX)) {
+                free(buf);
+                return TONAL_FAIL;
+        }
+        ret = append(c, buf, len, tp, n);
+        flock(c->fd, LOCK_UN);
+        free(buf);
+        return ret;
+}
@@ -0,0 +1,501 @@
+/*
+ * Copyright 2016 Martin Aberg
+ *
+ * This file is part of tonal.
+ *
+ * tonal is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * tonal is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Consonance and dissonance scoring, see tonal_consonance.h.
+ *
+ * Each pitch is reduced once to its diatonic and chromatic value. The
+ * interval between two pitches is then the difference of the values, taken
+ * upwards, and its diatonic interval and alteration index the table
+ * directly, without building a tonal_interval.
+ *
+ * tonal_consonance_n() works on blocks of BLOCK verticalities: it converts
+ * the pitches of each voice of the block to values, then runs over the
+ * pairs of voices with an inner loop over the block, on contiguous arrays.
+ */
+
+#include <assert.h>
+#include <math.h>
+#include <string.h>
+
+#include <tonal_consonance.h>
+#include <tonal_interval.h>
+#include "tonal_priv.h"
+
+/* Verticalities per block */
+#define BLOCK 64
+
+/* Offset of alteration 0 in the table */
+#define A0 (2 * TONAL_ALTERATION_MAX + 1)
+
+/* Semitones of the major or perfect diatonic intervals and of C to B */
+static const int DT_TO_SEMITONES_TABLE[7] = { 0, 2, 4, 5, 7, 9, 11 };
+
+/*
+ * Common practice dissonance for alterations -2 to 2 from major or perfect.
+ * Other alterations score 1.
+ */
+static const double DEFAULT_TABLE[DI_NONE][5] = {
+/*                  -2      -1       0       1       2 */
+/* PRIME   */ {   1.00,   1.00,   0.00,   1.00,   1.00 },
+/* SECOND  */ {   1.00,   1.00,   0.70,   0.80,   1.00 },
+/* THIRD   */ {   0.90,   0.20,   0.20,   0.90,   1.00 },
+/* FOURTH  */ {   1.00,   0.90,   0.40,   0.80,   1.00 },
+/* FIFTH   */ {   1.00,   0.80,   0.10,   0.80,   1.00 },
+/* SIXTH   */ {   0.90,   0.25,   0.25,   0.80,   1.00 },
+/* SEVENTH */ {   0.70,   0.60,   0.90,   1.00,   1.00 },
+};
+
+/* Sethares' fit of the Plomp-Levelt curve */
+#define PL_XSTAR 0.24
+#define PL_S1 0.0207
+#define PL_S2 18.96
+#define PL_B1 3.51
+#define PL_B2 5.75
+/* Amplitude of each partial relative to the one below */
+#define PL_DECAY 0.88
+
+#define PARTIALS_MAX 16
+
+static inline int tp_valid(const struct tonal_pitch *tp)
+{
+        return
+                DP_C <= tp->diatonic_pitch && tp->diatonic_pitch <= DP_B &&
+                0 <= tp->pitch_alteration && tp->pitch_alteration < PA_NONE;
+}
+
+/* Diatonic and chromatic value of a valid pitch */
+static inline void tp_values(const struct tonal_pitch *tp, int *dv, int *cv)
+{
+        int dt = tp->diatonic_pitch - DP_C;
+
+        *dv = 7 * tp->octave + dt;
+        *cv = 12 * tp->octave + DT_TO_SEMITONES_TABLE[dt] +
+                tp->pitch_alteration - PA_;
+}
+
+/* Table score of the interval between pitches of values dv0, cv0 and dv1, cv1 */
+static inline double pair_table(
+        const struct tonal_consonance *c,
+        int dv0, int cv0,
+        int dv1, int cv1
+)
+{
+        int d = dv1 - dv0;
+        int s = cv1 - cv0;
+        int q;
+        int di;
+        int a;
+
+        if (d < 0 || (0 == d && s < 0)) {
+                d = -d;
+                s = -s;
+        }
+        q = d / 7;
+        di = d - 7 * q;
+        a = s - 12 * q - DT_TO_SEMITONES_TABLE[di];
+        assert(-A0 <= a && a <= A0);
+        return c->table[di][a + A0];
+}
+
+static double pair_roughness(double f0, double f1, int partials)
+{
+        double r = 0.0;
+        double amp0 = 1.0;
+
+        for (int p = 1; p <= partials; p++, amp0 *= PL_DECAY) {
+                double amp1 = 1.0;
+
+                for (int q = 1; q <= partials; q++, amp1 *= PL_DECAY) {
+                        double fp = p * f0;
+                        double fq = q * f1;
+                        double fmin = fp < fq ? fp : fq;
+                        double df = fabs(fp - fq);
+                        double s = PL_XSTAR / (PL_S1 * fmin + PL_S2);
+
+                        r += (amp0 < amp1 ? amp0 : amp1) *
+                                (exp(-PL_B1 * s * df) - exp(-PL_B2 * s * df));
+                }
+        }
+        return r;
+}
+
+static inline int validate_consonance(const struct tonal_consonance *c)
+{
+        if (NULL == c) { return TONAL_FAIL; }
+        if (c->model < 0 || TONAL_CONSONANCE_NONE <= c->model) {
+                return TONAL_FAIL;
+        }
+        if (
+                TONAL_CONSONANCE_ROUGHNESS == c->model &&
+                (c->partials < 1 || PARTIALS_MAX < c->partials)
+        ) {
+                return TONAL_FAIL;
+        }
+        return TONAL_OK;
+}
+
+int tp_to_hz(const struct tonal_pitch *tp, int oc, double *hz)
+{
+        int mnn;
+
+        if (NULL == hz) { return TONAL_FAIL; }
+
+        mnn = tp_to_mnn_oc(tp, oc);
+        if (INT_MIN == mnn) { return TONAL_FAIL; }
+
+        *hz = 440.0 * pow(2.0, (mnn - 69) / 12.0);
+        return TONAL_OK;
+}
+
+int tonal_consonance_init(struct tonal_consonance *c, int model)
+{
+        int ret;
+        struct tonal_class tc;
+        struct tonal_interval_class tic;
+
+        if (NULL == c) { return TONAL_FAIL; }
+        if (model < 0 || TONAL_CONSONANCE_NONE <= model) { return TONAL_FAIL; }
+
+        c->model = model;
+        c->partials = 6;
+        c->oc = OC_C5;
+        for (int di = 0; di < DI_NONE; di++) {
+                for (int a = -A0; a <= A0; a++) {
+                        c->table[di][a + A0] = NAN;
+                        if (a < -TONAL_ALTERATION_MAX || TONAL_ALTERATION_MAX < a) {
+                                continue;
+                        }
+                        tc.diatonic_point = di;
+                        tc.alteration = a;
+                        ret = tc_to_tic(&tc, &tic);
+                        if (TONAL_OK != ret) { continue; }
+                        c->table[di][a + A0] =
+                                -2 <= a && a <= 2 ? DEFAULT_TABLE[di][a + 2] : 1.0;
+                }
+        }
+        return TONAL_OK;
+}
+
+int tonal_consonance_set(
+        struct tonal_consonance *c,
+        const struct tonal_interval_class *tic,
+        double score
+)
+{
+        int ret;
+        struct tonal_class tc;
+
+        if (NULL == c) { return TONAL_FAIL; }
+
+        ret = tic_to_tc(tic, &tc);
+        if (TONAL_OK != ret) { return ret; }
+
+        c->table[tc.diatonic_point][tc.alteration + A0] = score;
+        return TONAL_OK;
+}
+
+int tonal_consonance_get(
+        const struct tonal_consonance *c,
+        const struct tonal_interval_class *tic,
+        double *score
+)
+{
+        int ret;
+        struct tonal_class tc;
+
+        if (NULL == c || NULL == score) { return TONAL_FAIL; }
+
+        ret = tic_to_tc(tic, &tc);
+        if (TONAL_OK != ret) { return ret; }
+
+        *score = c->table[tc.diatonic_point][tc.alteration + A0];
+        return TONAL_OK;
+}
+
+int tonal_consonance_load(
+        struct tonal_consonance *c,
+        const double *score
+)
+{
+        struct tonal_interval_class tic;
+
+        if (NULL == c || NULL == score) { return TONAL_FAIL; }
+
+        for (int id = 0; id < TONAL_TIC_ID_COUNT; id++) {
+                if (TONAL_OK != id_to_tic(id, &tic)) { continue; }
+                tonal_consonance_set(c, &tic, score[id]);
+        }
+        return TONAL_OK;
+}
+
+int tonal_consonance_pair(
+        const struct tonal_consonance *c,
+        const struct tonal_pitch *tp0,
+        const struct tonal_pitch *tp1,
+        double *score
+)
+{
+        int ret;
+        int dv0, cv0;
+        int dv1, cv1;
+        double f0, f1;
+        double x;
+
+        ret = validate_consonance(c);
+        if (TONAL_OK != ret) { return ret; }
+
+        if (NULL == tp0 || NULL == tp1 || NULL == score) { return TONAL_FAIL; }
+        if (!tp_valid(tp0) || !tp_valid(tp1)) { return TONAL_FAIL; }
+
+        if (TONAL_CONSONANCE_ROUGHNESS == c->model) {
+                ret = tp_to_hz(tp0, c->oc, &f0);
+                if (TONAL_OK != ret) { return ret; }
+
+                ret = tp_to_hz(tp1, c->oc, &f1);
+                if (TONAL_OK != ret) { return ret; }
+
+                *score = pair_roughness(f0, f1, c->partials);
+                return TONAL_OK;
+        }
+
+        tp_values(tp0, &dv0, &cv0);
+        tp_values(tp1, &dv1, &cv1);
+        x = pair_table(c, dv0, cv0, dv1, cv1);
+        if (isnan(x)) { return TONAL_FAIL; }
+
+        *score = x;
+        return TONAL_OK;
+}
+
+/*
+ * Values of the pitches of one voice in a block of m verticalities, padded
+ * with silence to BLOCK. A pitch which is not valid is silent and sets its
+ * reason in st, if there is none yet.
+ */
+static void block_values(
+        const struct tonal_pitch *tp,
+        size_t m,
+        int *dv,
+        int *cv,
+        int *on,
+        int *st
+)
+{
+        for (size_t k = 0; k < BLOCK; k++) {
+                dv[k] = 0;
+                cv[k] = 0;
+                on[k] = k < m && tp_valid(&tp[k]);
+                if (on[k]) {
+                        tp_values(&tp[k], &dv[k], &cv[k]);
+                } else if (
+                        k < m &&
+                        PA_NONE != tp[k].pitch_alteration &&
+                        TONAL_E_OK == st[k]
+                ) {
+                        st[k] = tp_error(&tp[k]);
+                }
+        }
+}
+
+/*
+ * The pair loops run over whole blocks without branches, so that the index
+ * computation vectorizes at -O2. It reproduces pair_table(): the interval is
+ * taken upwards by multiplying with the sign, and the semitones of the
+ * diatonic interval are (12 * di + 5) / 7 instead of a table lookup. A
+ * silent pair looks up the first entry and adds it with weight 0. The loads
+ * from the table stay scalar. Table entries without an interval class are
+ * NaN, so the sum tells whether a pair had none.
+ */
+static void block_table(
+        const struct tonal_consonance *c,
+        const struct tonal_pitch *const *pitch,
+        size_t voices,
+        size_t i0,
+        size_t m,
+        double *score,
+        int *st
+)
+{
+        int dv[TONAL_CONSONANCE_VOICES_MAX][BLOCK];
+        int cv[TONAL_CONSONANCE_VOICES_MAX][BLOCK];
+        int on[TONAL_CONSONANCE_VOICES_MAX][BLOCK];
+        int index[BLOCK];
+        int both[BLOCK];
+        double acc[BLOCK];
+        const double *table = &c->table[0][0];
+
+        for (size_t v = 0; v < voices; v++) {
+                block_values(&pitch[v][i0], m, dv[v], cv[v], on[v], st);
+        }
+        for (size_t k = 0; k < BLOCK; k++) { acc[k] = 0.0; }
+
+        for (size_t v0 = 0; v0 < voices; v0++) {
+                for (size_t v1 = v0 + 1; v1 < voices; v1++) {
+                        const int *dv0 = dv[v0], *cv0 = cv[v0], *on0 = on[v0];
+                        const int *dv1 = dv[v1], *cv1 = cv[v1], *on1 = on[v1];
+
+                        for (size_t k = 0; k < BLOCK; k++) {
+                                int d = dv1[k] - dv0[k];
+                                int s = cv1[k] - cv0[k];
+                                int sign = 1 - 2 * ((d < 0) | ((0 == d) & (s < 0)));
+                                unsigned ud = sign * d;
+                                int q = ud / 7;
+                                int di = ud - 7 * q;
+                                int a = sign * s - 12 * q - (12 * di + 5) / 7;
+
+                                both[k] = on0[k] & on1[k];
+                                index[k] = both[k] *
+                                        (di * TONAL_CONSONANCE_ALTERATIONS + a + A0);
+                        }
+                        for (size_t k = 0; k < BLOCK; k++) {
+                                double x = table[index[k]];
+
+                                acc[k] += both[k] ? x : 0.0;
+                        }
+                }
+        }
+
+        for (size_t k = 0; k < m; k++) {
+                score[k] = acc[k];
+                if (isnan(acc[k]) && TONAL_E_OK == st[k]) { st[k] = TONAL_E_RANGE; }
+        }
+}
+
+/*
+ * Roughness calls exp() for each pair of partials, which the compiler does
+ * not vectorize with the library's flags: this loop is scalar. Silent
+ * voices have frequency 0 and weight 0.
+ */
+static void block_roughness(
+        const struct tonal_consonance *c,
+        const struct tonal_pitch *const *pitch,
+        size_t voices,
+        size_t i0,
+        size_t m,
+        double *score,
+        int *st
+)
+{
+        double hz[TONAL_CONSONANCE_VOICES_MAX][BLOCK];
+        double on[TONAL_CONSONANCE_VOICES_MAX][BLOCK];
+
+        for (size_t v = 0; v < voices; v++) {
+                for (size_t k = 0; k < m; k++) {
+                        const struct tonal_pitch *tp = &pitch[v][i0 + k];
+
+                        hz[v][k] = 0.0;
+                        on[v][k] = 0.0;
+                        if (PA_NONE == tp->pitch_alteration) { continue; }
+                        if (tp_valid(tp) && TONAL_OK == tp_to_hz(tp, c->oc, &hz[v][k])) {
+                                on[v][k] = 1.0;
+                                continue;
+                        }
+                        hz[v][k] = 0.0;
+                        if (TONAL_E_OK == st[k]) {
+                                st[k] = tp_error(tp);
+                                if (TONAL_E_OK == st[k]) { st[k] = TONAL_E_RANGE; }
+                        }
+                }
+        }
+
+        for (size_t k = 0; k < m; k++) { score[k] = 0.0; }
+        for (size_t v0 = 0; v0 < voices; v0++) {
+                for (size_t v1 = v0 + 1; v1 < voices; v1++) {
+                        for (size_t k = 0; k < m; k++) {
+                                score[k] += on[v0][k] * on[v1][k] *
+                                        pair_roughness(hz[v0][k], hz[v1][k], c->partials);
+                        }
+                }
+        }
+}
+
+static int consonance_n_impl(
+        const struct tonal_consonance *c,
+        const struct tonal_pitch *const *pitch,
+        size_t voices,
+        double *score,
+        int *status,
+        size_t n
+)
+{
+        int fail;
+        int st[BLOCK];
+        size_t m;
+
+        if (0 == n) { return TONAL_OK; }
+        if (NULL == c || NULL == pitch || NULL == score) {
+                for (size_t i = 0; status && i < n; i++) { status[i] = TONAL_E_NULL; }
+                TONAL_FAILED(TONAL_STATS_CONSONANCE_N, TONAL_E_NULL);
+                return TONAL_FAIL;
+        }
+        for (size_t v = 0; v < voices; v++) {
+                if (NULL != pitch[v]) { continue; }
+                for (size_t i = 0; status && i < n; i++) { status[i] = TONAL_E_NULL; }
+                TONAL_FAILED(TONAL_STATS_CONSONANCE_N, TONAL_E_NULL);
+                return TONAL_FAIL;
+        }
+        if (
+                TONAL_OK != validate_consonance(c) ||
+                TONAL_CONSONANCE_VOICES_MAX < voices
+        ) {
+                for (size_t i = 0; status && i < n; i++) { status[i] = TONAL_E_FAIL; }
+                TONAL_FAILED(TONAL_STATS_CONSONANCE_N, TONAL_E_FAIL);
+                return TONAL_FAIL;
+        }
+
+        fail = 0;
+        for (size_t i0 = 0; i0 < n; i0 += m) {
+                m = n - i0 < BLOCK ? n - i0 : BLOCK;
+                for (size_t k = 0; k < m; k++) { st[k] = TONAL_E_OK; }
+                if (TONAL_CONSONANCE_ROUGHNESS == c->model) {
+                        block_roughness(c, pitch, voices, i0, m, &score[i0], st);
+                } else {
+                        block_table(c, pitch, voices, i0, m, &score[i0], st);
+                }
+                for (size_t k = 0; k < m; k++) {
+                        if (status) { status[i0 + k] = st[k]; }
+                        if (TONAL_E_OK != st[k]) {
+                                TONAL_FAILED(TONAL_STATS_CONSONANCE_N, st[k]);
+                        }
+                        fail |= st[k];
+                }
+        }
+        return fail ? TONAL_FAIL : TONAL_OK;
+}
+
+int tonal_consonance_n(
+        const struct tonal_consonance *c,
+        const struct tonal_pitch *const *pitch,
+        size_t voices,
+        double *score,
+        int *status,
+        size_t n
+)
+{
+        int ret;
+
+        TONAL_STATS_BATCH(TONAL_STATS_CONSONANCE_N, n);
+        TONAL_STATS_TIMER(t0);
+        TONAL_PROBE2(consonance_n_entry, pitch, n);
+        ret = consonance_n_impl(c, pitch, voices, score, status, n);
+        TONAL_STATS_ELAPSED(TONAL_STATS_CONSONANCE_N, t0);
+        TONAL_PROBE2(consonance_n_return, n, ret);
+        return ret;
+}
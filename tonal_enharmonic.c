@@ -0,0 +1,586 @@
+/*
+ * Copyright 2016 Martin Aberg
+ *
+ * This file is part of tonal.
+ *
+ * tonal is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * tonal is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Enharmonics, see tonal_enharmonic.h.
+ *
+ * Everything is done on Tonal Elements and Tonal Classes: two of them are
+ * enharmonic when their chromatic values are equal (modulo 12 for classes).
+ * A spelling with diatonic point dt of chromatic value cv has the alteration
+ * ALTERATION_TABLE[cv mod 12][dt], or that plus or minus 12 if the
+ * alteration range is wide enough, and the octave which makes up the rest.
+ */
+
+#include <assert.h>
+#include <stdlib.h>
+
+#include <tonal_enharmonic.h>
+#include "tonal_priv.h"
+
+static const int DT_TO_MPC_TABLE[7] = { 0, 2, 4, 5, 7, 9, 11 };
+
+/* Alteration of diatonic point dt spelling Music Pitch Class mpc, -6 to 5 */
+static const signed char ALTERATION_TABLE[12][7] = {
+/*          C   D   E   F   G   A   B */
+/*  0 */ {  0, -2, -4, -5,  5,  3,  1 },
+/*  1 */ {  1, -1, -3, -4, -6,  4,  2 },
+/*  2 */ {  2,  0, -2, -3, -5,  5,  3 },
+/*  3 */ {  3,  1, -1, -2, -4, -6,  4 },
+/*  4 */ {  4,  2,  0, -1, -3, -5,  5 },
+/*  5 */ {  5,  3,  1,  0, -2, -4, -6 },
+/*  6 */ { -6,  4,  2,  1, -1, -3, -5 },
+/*  7 */ { -5,  5,  3,  2,  0, -2, -4 },
+/*  8 */ { -4, -6,  4,  3,  1, -1, -3 },
+/*  9 */ { -3, -5,  5,  4,  2,  0, -2 },
+/* 10 */ { -2, -4, -6,  5,  3,  1, -1 },
+/* 11 */ { -1, -3, -5, -6,  4,  2,  0 },
+};
+
+static inline int mpc_of(int cv)
+{
+        int mpc = cv % 12;
+
+        return mpc < 0 ? mpc + 12 : mpc;
+}
+
+static inline int tc_mpc(const struct tonal_class *tc)
+{
+        return mpc_of(DT_TO_MPC_TABLE[tc->diatonic_point] + tc->alteration);
+}
+
+static inline int te_cv(const struct tonal_element *te)
+{
+        return 12 * te->octave + DT_TO_MPC_TABLE[te->diatonic_point] +
+                te->alteration;
+}
+
+/*
+ * Alterations within the range with which diatonic point dt spells mpc,
+ * smallest first. Returns how many, 0 to 2.
+ */
+static inline int spell(int mpc, int dt, int *a)
+{
+        int n = 0;
+        int a0 = ALTERATION_TABLE[mpc][dt];
+
+        if (-TONAL_ALTERATION_MAX <= a0 && a0 <= TONAL_ALTERATION_MAX) {
+                a[n++] = a0;
+        }
+#if 6 <= TONAL_ALTERATION_MAX
+        a0 = a0 < 0 ? a0 + 12 : a0 - 12;
+        if (-TONAL_ALTERATION_MAX <= a0 && a0 <= TONAL_ALTERATION_MAX) {
+                a[n++] = a0;
+        }
+#endif
+        return n;
+}
+
+/* The element with diatonic point dt and alteration a at chromatic value cv */
+static inline void te_spell(struct tonal_element *te, int cv, int dt, int a)
+{
+        te->diatonic_point = dt;
+        te->alteration = a;
+        te->octave = (cv - DT_TO_MPC_TABLE[dt] - a) / 12;
+        assert(cv == te_cv(te));
+}
+
+/*
+ * All elements at chromatic value cv, by number of accidentals and then by
+ * diatonic point. Returns how many.
+ */
+static int te_spellings(int cv, struct tonal_element *te)
+{
+        struct tonal_element t;
+        int a[2];
+        int mpc;
+        int n = 0;
+        int k;
+        int j;
+
+        mpc = mpc_of(cv);
+        for (int dt = 0; dt < 7; dt++) {
+                k = spell(mpc, dt, a);
+                for (int i = 0; i < k; i++) {
+                        te_spell(&t, cv, dt, a[i]);
+                        for (j = n; 0 < j && abs(a[i]) < abs(te[j - 1].alteration); j--) {
+                                te[j] = te[j - 1];
+                        }
+                        te[j] = t;
+                        n++;
+                }
+        }
+        assert(n <= TONAL_SPELLINGS_MAX);
+        return n;
+}
+
+int tpc_enh_equal(
+        const struct tonal_pitch_class *tpc0,
+        const struct tonal_pitch_class *tpc1,
+        int *equal
+)
+{
+        int ret;
+        struct tonal_class tc0;
+        struct tonal_class tc1;
+
+        ret = tpc_to_tc(tpc0, &tc0);
+        if (TONAL_OK != ret) { return ret; }
+
+        ret = tpc_to_tc(tpc1, &tc1);
+        if (TONAL_OK != ret) { return ret; }
+
+        if (NULL == equal) { return TONAL_FAIL; }
+
+        *equal = tc_mpc(&tc0) == tc_mpc(&tc1);
+        return TONAL_OK;
+}
+
+int tp_enh_equal(
+        const struct tonal_pitch *tp0,
+        const struct tonal_pitch *tp1,
+        int *equal
+)
+{
+        int ret;
+        struct tonal_element te0;
+        struct tonal_element te1;
+
+        ret = tp_to_te(tp0, &te0);
+        if (TONAL_OK != ret) { return ret; }
+
+        ret = tp_to_te(tp1, &te1);
+        if (TONAL_OK != ret) { return ret; }
+
+        if (NULL == equal) { return TONAL_FAIL; }
+
+        *equal = te_cv(&te0) == te_cv(&te1);
+        return TONAL_OK;
+}
+
+int tic_enh_equal(
+        const struct tonal_interval_class *tic0,
+        const struct tonal_interval_class *tic1,
+        int *equal
+)
+{
+        int ret;
+        struct tonal_class tc0;
+        struct tonal_class tc1;
+
+        ret = tic_to_tc(tic0, &tc0);
+        if (TONAL_OK != ret) { return ret; }
+
+        ret = tic_to_tc(tic1, &tc1);
+        if (TONAL_OK != ret) { return ret; }
+
+        if (NULL == equal) { return TONAL_FAIL; }
+
+        *equal = tc_mpc(&tc0) == tc_mpc(&tc1);
+        return TONAL_OK;
+}
+
+int ti_enh_equal(
+        const struct tonal_interval *ti0,
+        const struct tonal_interval *ti1,
+        int *equal
+)
+{
+        int ret;
+        struct tonal_element te0;
+        struct tonal_element te1;
+
+        ret = ti_to_te(ti0, &te0);
+        if (TONAL_OK != ret) { return ret; }
+
+        ret = ti_to_te(ti1, &te1);
+        if (TONAL_OK != ret) { return ret; }
+
+        if (NULL == equal) { return TONAL_FAIL; }
+
+        *equal = te_cv(&te0) == te_cv(&te1);
+        return TONAL_OK;
+}
+
+int tpc_enh_spellings(
+        const struct tonal_pitch_class *tpc,
+        struct tonal_pitch_class *spelling,
+        size_t *n
+)
+{
+        int ret;
+        int m;
+        struct tonal_class tc;
+        struct tonal_element te[TONAL_SPELLINGS_MAX];
+
+        ret = tpc_to_tc(tpc, &tc);
+        if (TONAL_OK != ret) { return ret; }
+
+        if (NULL == spelling || NULL == n) { return TONAL_FAIL; }
+
+        m = te_spellings(tc_mpc(&tc), te);
+        for (int i = 0; i < m; i++) {
+                ret = tc_to_tpc((struct tonal_class *) &te[i], &spelling[i]);
+                assert(TONAL_OK == ret);
+        }
+        *n = m;
+        return TONAL_OK;
+}
+
+int tp_enh_spellings(
+        const struct tonal_pitch *tp,
+        struct tonal_pitch *spelling,
+        size_t *n
+)
+{
+        int ret;
+        int m;
+        struct tonal_element te0;
+        struct tonal_element te[TONAL_SPELLINGS_MAX];
+        size_t k = 0;
+
+        ret = tp_to_te(tp, &te0);
+        if (TONAL_OK != ret) { return ret; }
+
+        if (NULL == spelling || NULL == n) { return TONAL_FAIL; }
+
+        m = te_spellings(te_cv(&te0), te);
+        for (int i = 0; i < m; i++) {
+                if (TONAL_OK == te_to_tp(&te[i], &spelling[k])) { k++; }
+        }
+        *n = k;
+        return TONAL_OK;
+}
+
+int tic_enh_spellings(
+        const struct tonal_interval_class *tic,
+        struct tonal_interval_class *spelling,
+        size_t *n
+)
+{
+        int ret;
+        int m;
+        struct tonal_class tc;
+        struct tonal_element te[TONAL_SPELLINGS_MAX];
+        size_t k = 0;
+
+        ret = tic_to_tc(tic, &tc);
+        if (TONAL_OK != ret) { return ret; }
+
+        if (NULL == spelling || NULL == n) { return TONAL_FAIL; }
+
+        /* Not every alteration is a quality of every diatonic interval. */
+        m = te_spellings(tc_mpc(&tc), te);
+        for (int i = 0; i < m; i++) {
+                if (TONAL_OK == tc_to_tic((struct tonal_class *) &te[i], &spelling[k])) {
+                        k++;
+                }
+        }
+        *n = k;
+        return TONAL_OK;
+}
+
+int ti_enh_spellings(
+        const struct tonal_interval *ti,
+        struct tonal_interval *spelling,
+        size_t *n
+)
+{
+        int ret;
+        int m;
+        struct tonal_element te0;
+        struct tonal_element te[TONAL_SPELLINGS_MAX];
+        size_t k = 0;
+
+        ret = ti_to_te(ti, &te0);
+        if (TONAL_OK != ret) { return ret; }
+
+        if (NULL == spelling || NULL == n) { return TONAL_FAIL; }
+
+        m = te_spellings(te_cv(&te0), te);
+        for (int i = 0; i < m; i++) {
+                if (TONAL_OK == te_to_ti(&te[i], &spelling[k])) { k++; }
+        }
+        *n = k;
+        return TONAL_OK;
+}
+
+int tpc_enh_respell(
+        const struct tonal_pitch_class *tpc,
+        int diatonic_pitch,
+        struct tonal_pitch_class *result
+)
+{
+        int ret;
+        int a[2];
+        struct tonal_class tc;
+
+        ret = tpc_to_tc(tpc, &tc);
+        if (TONAL_OK != ret) { return ret; }
+
+        if (diatonic_pitch < DP_C || DP_B < diatonic_pitch) { return TONAL_FAIL; }
+        if (NULL == result) { return TONAL_FAIL; }
+
+        if (0 == spell(tc_mpc(&tc), diatonic_pitch - DP_C, a)) { return TONAL_FAIL; }
+        tc.diatonic_point = diatonic_pitch - DP_C;
+        tc.alteration = a[0];
+        return tc_to_tpc(&tc, result);
+}
+
+int tp_enh_respell(
+        const struct tonal_pitch *tp,
+        int diatonic_pitch,
+        struct tonal_pitch *result
+)
+{
+        int ret;
+        int a[2];
+        int cv;
+        struct tonal_element te;
+
+        ret = tp_to_te(tp, &te);
+        if (TONAL_OK != ret) { return ret; }
+
+        if (diatonic_pitch < DP_C || DP_B < diatonic_pitch) { return TONAL_FAIL; }
+        if (NULL == result) { return TONAL_FAIL; }
+
+        cv = te_cv(&te);
+        if (0 == spell(mpc_of(cv), diatonic_pitch - DP_C, a)) { return TONAL_FAIL; }
+        te_spell(&te, cv, diatonic_pitch - DP_C, a[0]);
+        return te_to_tp(&te, result);
+}
+
+int tic_enh_respell(
+        const struct tonal_interval_class *tic,
+        int diatonic_interval,
+        struct tonal_interval_class *result
+)
+{
+        int ret;
+        int a[2];
+        int k;
+        int mpc;
+        struct tonal_class tc;
+
+        ret = tic_to_tc(tic, &tc);
+        if (TONAL_OK != ret) { return ret; }
+
+        if (diatonic_interval < DI_PRIME || DI_SEVENTH < diatonic_interval) {
+                return TONAL_FAIL;
+        }
+        if (NULL == result) { return TONAL_FAIL; }
+
+        mpc = tc_mpc(&tc);
+        k = spell(mpc, diatonic_interval - DI_PRIME, a);
+        for (int i = 0; i < k; i++) {
+                tc.diatonic_point = diatonic_interval - DI_PRIME;
+                tc.alteration = a[i];
+                if (TONAL_OK == tc_to_tic(&tc, result)) { return TONAL_OK; }
+        }
+        return TONAL_FAIL;
+}
+
+int ti_enh_respell(
+        const struct tonal_interval *ti,
+        int diatonic_interval,
+        struct tonal_interval *result
+)
+{
+        int ret;
+        int a[2];
+        int k;
+        int cv;
+        int dir;
+        int dt;
+        struct tonal_element te;
+        struct tonal_interval r;
+
+        ret = ti_to_te(ti, &te);
+        if (TONAL_OK != ret) { return ret; }
+
+        if (diatonic_interval < DI_PRIME || DI_SEVENTH < diatonic_interval) {
+                return TONAL_FAIL;
+        }
+        if (NULL == result) { return TONAL_FAIL; }
+
+        /*
+         * The same direction first. A downward interval is an element below
+         * zero, at the diatonic point which inverts the interval.
+         */
+        cv = te_cv(&te);
+        for (int pass = 0; pass < 2; pass++) {
+                dir = (0 == pass) == (ID_UP == ti->interval_direction) ? ID_UP : ID_DOWN;
+                dt = diatonic_interval - DI_PRIME;
+                if (ID_DOWN == dir) { dt = (7 - dt) % 7; }
+                k = spell(mpc_of(cv), dt, a);
+                for (int i = 0; i < k; i++) {
+                        te_spell(&te, cv, dt, a[i]);
+                        ret = te_to_ti(&te, &r);
+                        if (
+                                TONAL_OK == ret &&
+                                diatonic_interval == r.diatonic_interval &&
+                                dir == r.interval_direction
+                        ) {
+                                *result = r;
+                                return TONAL_OK;
+                        }
+                }
+        }
+        return TONAL_FAIL;
+}
+
+static void fill_status(int *status, size_t n, int error)
+{
+        for (size_t i = 0; status && i < n; i++) {
+                status[i] = error;
+        }
+}
+
+int tp_enh_equal_n(
+        const struct tonal_pitch *tp0,
+        const struct tonal_pitch *tp1,
+        int *equal,
+        int *status,
+        size_t n
+)
+{
+        int ret;
+        int fail;
+
+        if (0 == n) { return TONAL_OK; }
+        if (NULL == tp0 || NULL == tp1 || NULL == equal) {
+                fill_status(status, n, TONAL_E_NULL);
+                return TONAL_FAIL;
+        }
+
+        fail = 0;
+        for (size_t i = 0; i < n; i++) {
+                ret = tp_enh_equal(&tp0[i], &tp1[i], &equal[i]);
+                if (TONAL_OK != ret) {
+                        equal[i] = 0;
+                        if (status) {
+                                ret = tp_error(&tp0[i]);
+                                if (TONAL_E_OK == ret) { ret = tp_error(&tp1[i]); }
+                        }
+                }
+                if (status) { status[i] = ret; }
+                fail |= ret;
+        }
+        return fail ? TONAL_FAIL : TONAL_OK;
+}
+
+int ti_enh_equal_n(
+        const struct tonal_interval *ti0,
+        const struct tonal_interval *ti1,
+        int *equal,
+        int *status,
+        size_t n
+)
+{
+        int ret;
+        int fail;
+
+        if (0 == n) { return TONAL_OK; }
+        if (NULL == ti0 || NULL == ti1 || NULL == equal) {
+                fill_status(status, n, TONAL_E_NULL);
+                return TONAL_FAIL;
+        }
+
+        fail = 0;
+        for (size_t i = 0; i < n; i++) {
+                ret = ti_enh_equal(&ti0[i], &ti1[i], &equal[i]);
+                if (TONAL_OK != ret) {
+                        equal[i] = 0;
+                        if (status) {
+                                ret = ti_error(&ti0[i]);
+                                if (TONAL_E_OK == ret) { ret = ti_error(&ti1[i]); }
+                        }
+                }
+                if (status) { status[i] = ret; }
+                fail |= ret;
+        }
+        return fail ? TONAL_FAIL : TONAL_OK;
+}
+
+int tp_enh_respell_n(
+        const struct tonal_pitch *tp,
+        const int *diatonic_pitch,
+        struct tonal_pitch *result,
+        int *status,
+        size_t n
+)
+{
+        int ret;
+        int fail;
+        int dp;
+
+        if (0 == n) { return TONAL_OK; }
+        if (NULL == tp || NULL == diatonic_pitch || NULL == result) {
+                fill_status(status, n, TONAL_E_NULL);
+                return TONAL_FAIL;
+        }
+
+        fail = 0;
+        for (size_t i = 0; i < n; i++) {
+                dp = diatonic_pitch[i];
+                ret = tp_enh_respell(&tp[i], dp, &result[i]);
+                if (TONAL_OK != ret && status) {
+                        ret = tp_error(&tp[i]);
+                        if (TONAL_E_OK == ret) {
+                                ret = dp < DP_C || DP_B < dp ? TONAL_E_DIATONIC : TONAL_E_RANGE;
+                        }
+                }
+                if (status) { status[i] = ret; }
+                fail |= ret;
+        }
+        return fail ? TONAL_FAIL : TONAL_OK;
+}
+
+int ti_enh_respell_n(
+        const struct tonal_interval *ti,
+        const int *diatonic_interval,
+        struct tonal_interval *result,
+        int *status,
+        size_t n
+)
+{
+        int ret;
+        int fail;
+        int di;
+
+        if (0 == n) { return TONAL_OK; }
+        if (NULL == ti || NULL == diatonic_interval || NULL == result) {
+                fill_status(status, n, TONAL_E_NULL);
+                return TONAL_FAIL;
+        }
+
+        fail = 0;
+        for (size_t i = 0; i < n; i++) {
+                di = diatonic_interval[i];
+                ret = ti_enh_respell(&ti[i], di, &result[i]);
+                if (TONAL_OK != ret && status) {
+                        ret = ti_error(&ti[i]);
+                        if (TONAL_E_OK == ret) {
+                                ret = di < DI_PRIME || DI_SEVENTH < di ? TONAL_E_DIATONIC : TONAL_E_RANGE;
+                        }
+                }
+                if (status) { status[i] = ret; }
+                fail |= ret;
+        }
+        return fail ? TONAL_FAIL : TONAL_OK;
+}
@@ -0,0 +1,766 @@
+/*
+ * Copyright 2016 Martin Aberg
+ *
+ * This file is part of tonal.
+ *
+ * tonal is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * tonal is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Corpus ingestion, see tonal_ingest.h.
+ *
+ * The io_uring path drives the ring with the raw system calls, there is no
+ * liburing dependency. Each of depth slots works on one file at a time:
+ * openat and statx go out together, then reads until the file is in, then
+ * a close which nobody waits for. A slot which has delivered its file starts
+ * the next one. If fn stops the ingestion, the reads in flight are still
+ * reaped before returning since they write to our buffers.
+ *
+ * The thread path has workers which read whole files and queue them for the
+ * calling thread, with at most depth files queued.
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef TONAL_IO_URING
+#include <linux/io_uring.h>
+#include <linux/stat.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+
+#include <tonal_ingest.h>
+#include <tonal_abc.h>
+#include <tonal_kern.h>
+#include <tonal_musicxml.h>
+#include "tonal_priv.h"
+
+#define DEPTH_MAX 4096
+/* Worker threads of the thread path */
+#define THREADS_MAX 64
+
+/* A file read, handed from a reader to the callback */
+static int deliver(
+        tonal_ingest_fn fn,
+        void *arg,
+        const char *const *path,
+        size_t index,
+        int status,
+        const char *buf,
+        size_t size
+)
+{
+        struct tonal_ingest_file f;
+
+        f.index = index;
+        f.path = path[index];
+        f.status = status;
+        f.doc = TONAL_OK == status ? buf : "";
+        f.size = TONAL_OK == status ? size : 0;
+        return fn(&f, arg);
+}
+
+/* Read the whole file at path into a new buffer, NUL terminated. */
+static int read_file(const char *path, char **buf, size_t *size)
+{
+        struct stat st;
+        ssize_t len;
+        size_t done;
+        char *p;
+        int fd;
+
+        fd = open(path, O_RDONLY | O_CLOEXEC);
+        if (fd < 0) { return TONAL_FAIL; }
+        if (0 != fstat(fd, &st) || !S_ISREG(st.st_mode)) {
+                close(fd);
+                return TONAL_FAIL;
+        }
+        p = malloc(st.st_size + 1);
+        if (NULL == p) {
+                close(fd);
+                return TONAL_FAIL;
+        }
+        len = 0;
+        for (done = 0; done < (size_t) st.st_size; done += len) {
+                len = pread(fd, p + done, st.st_size - done, done);
+                if (len < 0 && EINTR == errno) {
+                        len = 0;
+                        continue;
+                }
+                /* A file which shrank ends early. */
+                if (len <= 0) { break; }
+        }
+        close(fd);
+        if (len < 0) {
+                free(p);
+                return TONAL_FAIL;
+        }
+        p[done] = '\0';
+        *buf = p;
+        *size = done;
+        return TONAL_OK;
+}
+
+struct item {
+        size_t index;
+        int status;
+        char *buf;
+        size_t size;
+        struct item *next;
+};
+
+struct pool {
+        const char *const *path;
+        size_t n;
+        size_t depth;
+        /* Next file to read */
+        size_t next;
+        int stop;
+        pthread_mutex_t lock;
+        pthread_cond_t not_empty;
+        pthread_cond_t not_full;
+        struct item *head;
+        struct item *tail;
+        size_t queued;
+};
+
+static void *pool_worker(void *arg)
+{
+        struct pool *p = arg;
+        struct item *it;
+        size_t i;
+
+        for (;;) {
+                i = __atomic_fetch_add(&p->next, 1, __ATOMIC_RELAXED);
+                if (p->n <= i) { break; }
+
+                it = malloc(sizeof *it);
+                if (NULL == it) {
+                        pthread_mutex_lock(&p->lock);
+                        p->stop = 1;
+                        pthread_cond_signal(&p->not_empty);
+                        pthread_mutex_unlock(&p->lock);
+                        break;
+                }
+                it->index = i;
+                it->buf = NULL;
+                it->size = 0;
+                it->next = NULL;
+                it->status = read_file(p->path[i], &it->buf, &it->size);
+
+                pthread_mutex_lock(&p->lock);
+                while (!p->stop && p->depth <= p->queued) {
+                        pthread_cond_wait(&p->not_full, &p->lock);
+                }
+                if (p->stop) {
+                        pthread_mutex_unlock(&p->lock);
+                        free(it->buf);
+                        free(it);
+                        break;
+                }
+                if (p->tail) { p->tail->next = it; } else { p->head = it; }
+                p->tail = it;
+                p->queued++;
+                pthread_cond_signal(&p->not_empty);
+                pthread_mutex_unlock(&p->lock);
+        }
+        return NULL;
+}
+
+static int ingest_threads(
+        const char *const *path,
+        size_t n,
+        int depth,
+        tonal_ingest_fn fn,
+        void *arg
+)
+{
+        pthread_t thread[THREADS_MAX];
+        struct pool p;
+        struct item *it;
+        size_t delivered = 0;
+        int nthreads;
+        int started;
+        int ret = TONAL_OK;
+
+        memset(&p, 0, sizeof p);
+        p.path = path;
+        p.n = n;
+        p.depth = depth;
+        pthread_mutex_init(&p.lock, NULL);
+        pthread_cond_init(&p.not_empty, NULL);
+        pthread_cond_init(&p.not_full, NULL);
+
+        nthreads = depth < THREADS_MAX ? depth : THREADS_MAX;
+        if ((size_t) nthreads > n) { nthreads = n; }
+        for (started = 0; started < nthreads; started++) {
+                if (0 != pthread_create(&thread[started], NULL, pool_worker, &p)) {
+                        break;
+                }
+        }
+        if (0 == started && n) { ret = TONAL_FAIL; }
+
+        while (TONAL_OK == ret && delivered < n) {
+                pthread_mutex_lock(&p.lock);
+                while (!p.stop && NULL == p.head) {
+                        pthread_cond_wait(&p.not_empty, &p.lock);
+                }
+                it = p.head;
+                if (it) {
+                        p.head = it->next;
+                        if (NULL == p.head) { p.tail = NULL; }
+                        p.queued--;
+                        pthread_cond_signal(&p.not_full);
+                }
+                pthread_mutex_unlock(&p.lock);
+                if (NULL == it) {
+                        /* A worker ran out of memory. */
+                        ret = TONAL_FAIL;
+                        break;
+                }
+
+                ret = deliver(fn, arg, path, it->index, it->status, it->buf, it->size);
+                delivered++;
+                free(it->buf);
+                free(it);
+        }
+
+        pthread_mutex_lock(&p.lock);
+        p.stop = 1;
+        pthread_cond_broadcast(&p.not_full);
+        pthread_mutex_unlock(&p.lock);
+        for (int i = 0; i < started; i++) { pthread_join(thread[i], NULL); }
+        while (p.head) {
+                it = p.head;
+                p.head = it->next;
+                free(it->buf);
+                free(it);
+        }
+        pthread_cond_destroy(&p.not_full);
+        pthread_cond_destroy(&p.not_empty);
+        pthread_mutex_destroy(&p.lock);
+        return ret;
+}
+
+#ifdef TONAL_IO_URING
+
+enum {
+        OP_OPEN = 1,
+        OP_STATX,
+        OP_READ,
+        OP_CLOSE
+};
+
+#define USER_DATA(slot, op) ((uint64_t) (slot) << 3 | (op))
+
+struct ring {
+        int fd;
+        unsigned entries;
+        unsigned *sq_head;
+        unsigned *sq_tail;
+        unsigned *sq_mask;
+        unsigned *sq_array;
+        unsigned *cq_head;
+        unsigned *cq_tail;
+        unsigned *cq_mask;
+        struct io_uring_sqe *sqes;
+        struct io_uring_cqe *cqes;
+        void *sq_map;
+        size_t sq_map_size;
+        void *cq_map;
+        size_t cq_map_size;
+        size_t sqes_size;
+        /* Queued, not yet submitted */
+        unsigned to_submit;
+};
+
+struct slot {
+        /* File being read, or SIZE_MAX if the slot is idle */
+        size_t index;
+        int fd;
+        /* Open and statx not yet completed */
+        int pending;
+        int status;
+        struct statx stx;
+        char *buf;
+        size_t size;
+        size_t done;
+};
+
+static int ring_enter(struct ring *r, unsigned min_complete)
+{
+        long ret;
+
+        do {
+                ret = syscall(
+                        __NR_io_uring_enter,
+                        r->fd,
+                        r->to_submit,
+                        min_complete,
+                        min_complete ? IORING_ENTER_GETEVENTS : 0,
+                        NULL,
+                        0
+                );
+        } while (ret < 0 && (EINTR == errno || EAGAIN == errno || EBUSY == errno));
+        if (ret < 0) { return TONAL_FAIL; }
+        r->to_submit -= ret;
+        return TONAL_OK;
+}
+
+static struct io_uring_sqe *get_sqe(struct ring *r)
+{
+        struct io_uring_sqe *sqe;
+        unsigned tail = *r->sq_tail;
+        unsigned i;
+
+        if (r->entries == tail - __atomic_load_n(r->sq_head, __ATOMIC_ACQUIRE)) {
+                if (TONAL_OK != ring_enter(r, 0)) { return NULL; }
+                if (r->entries == tail - __atomic_load_n(r->sq_head, __ATOMIC_ACQUIRE)) {
+                        return NULL;
+                }
+        }
+        i = tail & *r->sq_mask;
+        sqe = &r->sqes[i];
+        memset(sqe, 0, sizeof *sqe);
+        r->sq_array[i] = i;
+        return sqe;
+}
+
+static void put_sqe(struct ring *r)
+{
+        __atomic_store_n(r->sq_tail, *r->sq_tail + 1, __ATOMIC_RELEASE);
+        r->to_submit++;
+}
+
+static void ring_exit(struct ring *r)
+{
+        if (r->sqes) { munmap(r->sqes, r->sqes_size); }
+        if (r->cq_map && r->cq_map != r->sq_map) { munmap(r->cq_map, r->cq_map_size); }
+        if (r->sq_map) { munmap(r->sq_map, r->sq_map_size); }
+        if (0 <= r->fd) { close(r->fd); }
+}
+
+/* Set up a ring, if the kernel has it and the operations needed. */
+static int ring_init(struct ring *r, unsigned entries)
+{
+        static const int OPS[] = {
+                IORING_OP_OPENAT, IORING_OP_STATX, IORING_OP_READ, IORING_OP_CLOSE
+        };
+        struct io_uring_params p;
+        struct io_uring_probe *probe;
+        size_t probe_size;
+        char *sq;
+        char *cq;
+        int ok;
+
+        memset(r, 0, sizeof *r);
+        memset(&p, 0, sizeof p);
+        r->fd = syscall(__NR_io_uring_setup, entries, &p);
+        if (r->fd < 0) { return TONAL_FAIL; }
+
+        probe_size = sizeof *probe + 256 * sizeof probe->ops[0];
+        probe = calloc(1, probe_size);
+        ok = NULL != probe && 0 <= syscall(
+                __NR_io_uring_register, r->fd, IORING_REGISTER_PROBE, probe, 256
+        );
+        for (size_t i = 0; ok && i < sizeof OPS / sizeof OPS[0]; i++) {
+                ok = OPS[i] <= probe->last_op &&
+                        (probe->ops[OPS[i]].flags & IO_URING_OP_SUPPORTED);
+        }
+        free(probe);
+        if (!ok) {
+                ring_exit(r);
+                return TONAL_FAIL;
+        }
+
+        r->entries = p.sq_entries;
+        r->sq_map_size = p.sq_off.array + p.sq_entries * sizeof (unsigned);
+        r->cq_map_size = p.cq_off.cqes + p.cq_entries * sizeof (struct io_uring_cqe);
+        if (p.features & IORING_FEAT_SINGLE_MMAP) {
+                if (r->sq_map_size < r->cq_map_size) { r->sq_map_size = r->cq_map_size; }
+                r->cq_map_size = r->sq_map_size;
+        }
+        r->sq_map = mmap(NULL, r->sq_map_size, PROT_READ | PROT_WRITE,
+                MAP_SHARED | MAP_POPULATE, r->fd, IORING_OFF_SQ_RING);
+        if (MAP_FAILED == r->sq_map) {
+                r->sq_map = NULL;
+                ring_exit(r);
+                return TONAL_FAIL;
+        }
+        if (p.features & IORING_FEAT_SINGLE_MMAP) {
+                r->cq_map = r->sq_map;
+        } else {
+                r->cq_map = mmap(NULL, r->cq_map_size, PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_POPULATE, r->fd, IORING_OFF_CQ_RING);
+                if (MAP_FAILED == r->cq_map) {
+                        r->cq_map = NULL;
+                        ring_exit(r);
+                        return TONAL_FAIL;
+                }
+        }
+        r->sqes_size = p.sq_entries * sizeof (struct io_uring_sqe);
+        r->sqes = mmap(NULL, r->sqes_size, PROT_READ | PROT_WRITE,
+                MAP_SHARED | MAP_POPULATE, r->fd, IORING_OFF_SQES);
+        if (MAP_FAILED == r->sqes) {
+                r->sqes = NULL;
+                ring_exit(r);
+                return TONAL_FAIL;
+        }
+
+        sq = r->sq_map;
+        cq = r->cq_map;
+        r->sq_head = (unsigned *) (sq + p.sq_off.head);
+        r->sq_tail = (unsigned *) (sq + p.sq_off.tail);
+        r->sq_mask = (unsigned *) (sq + p.sq_off.ring_mask);
+        r->sq_array = (unsigned *) (sq + p.sq_off.array);
+        r->cq_head = (unsigned *) (cq + p.cq_off.head);
+        r->cq_tail = (unsigned *) (cq + p.cq_off.tail);
+        r->cq_mask = (unsigned *) (cq + p.cq_off.ring_mask);
+        r->cqes = (struct io_uring_cqe *) (cq + p.cq_off.cqes);
+        return TONAL_OK;
+}
+
+static int queue_open(struct ring *r, struct slot *s, size_t k, const char *path)
+{
+        struct io_uring_sqe *sqe;
+
+        sqe = get_sqe(r);
+        if (NULL == sqe) { return TONAL_FAIL; }
+        sqe->opcode = IORING_OP_OPENAT;
+        sqe->fd = AT_FDCWD;
+        sqe->addr = (uintptr_t) path;
+        sqe->open_flags = O_RDONLY | O_CLOEXEC;
+        sqe->user_data = USER_DATA(k, OP_OPEN);
+        put_sqe(r);
+        s->pending++;
+
+        sqe = get_sqe(r);
+        if (NULL == sqe) { return TONAL_FAIL; }
+        sqe->opcode = IORING_OP_STATX;
+        sqe->fd = AT_FDCWD;
+        sqe->addr = (uintptr_t) path;
+        sqe->len = STATX_SIZE | STATX_TYPE;
+        sqe->off = (uintptr_t) &s->stx;
+        sqe->user_data = USER_DATA(k, OP_STATX);
+        put_sqe(r);
+        s->pending++;
+        return TONAL_OK;
+}
+
+static int queue_read(struct ring *r, struct slot *s, size_t k)
+{
+        struct io_uring_sqe *sqe;
+
+        sqe = get_sqe(r);
+        if (NULL == sqe) { return TONAL_FAIL; }
+        sqe->opcode = IORING_OP_READ;
+        sqe->fd = s->fd;
+        sqe->addr = (uintptr_t) (s->buf + s->done);
+        sqe->len = s->size - s->done < 1U << 30 ? s->size - s->done : 1U << 30;
+        sqe->off = s->done;
+        sqe->user_data = USER_DATA(k, OP_READ);
+        put_sqe(r);
+        s->pending++;
+        return TONAL_OK;
+}
+
+static void queue_close(struct ring *r, struct slot *s)
+{
+        struct io_uring_sqe *sqe;
+
+        if (s->fd < 0) { return; }
+        sqe = get_sqe(r);
+        if (NULL == sqe) {
+                close(s->fd);
+        } else {
+                sqe->opcode = IORING_OP_CLOSE;
+                sqe->fd = s->fd;
+                sqe->user_data = USER_DATA(0, OP_CLOSE);
+                put_sqe(r);
+        }
+        s->fd = -1;
+}
+
+/*
+ * Sets *fallback and returns TONAL_FAIL, having done nothing, if there is no
+ * usable io_uring. Otherwise returns as tonal_ingest().
+ */
+static int ingest_uring(
+        const char *const *path,
+        size_t n,
+        int depth,
+        tonal_ingest_fn fn,
+        void *arg,
+        int *fallback
+)
+{
+        struct ring r;
+        struct slot *slot;
+        struct io_uring_cqe *cqe;
+        struct slot *s;
+        unsigned entries;
+        unsigned head;
+        size_t next = 0;
+        size_t active = 0;
+        size_t k;
+        int op;
+        int res;
+        int ret = TONAL_OK;
+
+        /* Open and statx, or a read, and a close per slot */
+        for (entries = 4; entries < 3 * (unsigned) depth; entries *= 2) { }
+        *fallback = 0;
+        if (TONAL_OK != ring_init(&r, entries)) {
+                *fallback = 1;
+                return TONAL_FAIL;
+        }
+        slot = calloc(depth, sizeof *slot);
+        if (NULL == slot) {
+                ring_exit(&r);
+                return TONAL_FAIL;
+        }
+        for (k = 0; k < (size_t) depth; k++) {
+                slot[k].index = SIZE_MAX;
+                slot[k].fd = -1;
+        }
+
+        for (k = 0; k < (size_t) depth && next < n; k++, next++) {
+                slot[k].index = next;
+                if (TONAL_OK != queue_open(&r, &slot[k], k, path[next])) {
+                        ret = TONAL_FAIL;
+                }
+                /* A half queued file is still reaped. */
+                if (slot[k].pending) { active++; }
+                if (TONAL_OK != ret) { break; }
+        }
+
+        while (active) {
+                if (TONAL_OK != ring_enter(&r, 1)) {
+                        /*
+                         * Nothing more can be reaped, so the buffers of the
+                         * reads in flight are left to the kernel.
+                         */
+                        slot = NULL;
+                        ret = TONAL_FAIL;
+                        break;
+                }
+                head = *r.cq_head;
+                while (head != __atomic_load_n(r.cq_tail, __ATOMIC_ACQUIRE)) {
+                        cqe = &r.cqes[head & *r.cq_mask];
+                        k = cqe->user_data >> 3;
+                        op = cqe->user_data & 7;
+                        res = cqe->res;
+                        head++;
+                        __atomic_store_n(r.cq_head, head, __ATOMIC_RELEASE);
+                        if (OP_CLOSE == op) { continue; }
+
+                        s = &slot[k];
+                        s->pending--;
+                        if (OP_OPEN == op) {
+                                if (res < 0) { s->status = TONAL_FAIL; } else { s->fd = res; }
+                        } else if (OP_STATX == op) {
+                                if (res < 0 || !S_ISREG(s->stx.stx_mode)) {
+                                        s->status = TONAL_FAIL;
+                                }
+                                s->size = s->stx.stx_size;
+                        } else if (OP_READ == op) {
+                                if (res < 0 && -EINTR != res && -EAGAIN != res) {
+                                        s->status = TONAL_FAIL;
+                                } else if (0 == res) {
+                                        /* The file shrank. */
+                                        s->size = s->done;
+                                } else if (0 < res) {
+                                        s->done += res;
+                                }
+                        }
+                        if (s->pending) { continue; }
+
+                        /* Open and statx are in, or a read */
+                        if (TONAL_OK == s->status && TONAL_OK == ret) {
+                                if (NULL == s->buf) {
+                                        s->buf = malloc(s->size + 1);
+                                        if (NULL == s->buf) { s->status = TONAL_FAIL; }
+                                }
+                                if (s->buf && s->done < s->size) {
+                                        if (TONAL_OK == queue_read(&r, s, k)) { continue; }
+                                        s->status = TONAL_FAIL;
+                                }
+                        }
+
+                        /* Done with this file */
+                        queue_close(&r, s);
+                        if (TONAL_OK == ret) {
+                                if (s->buf) { s->buf[s->done] = '\0'; }
+                                ret = deliver(fn, arg, path, s->index, s->status, s->buf, s->done);
+                        }
+                        free(s->buf);
+                        s->buf = NULL;
+                        s->size = 0;
+                        s->done = 0;
+                        s->status = TONAL_OK;
+                        s->index = SIZE_MAX;
+                        active--;
+                        if (TONAL_OK == ret && next < n) {
+                                s->index = next++;
+                                if (TONAL_OK != queue_open(&r, s, k, path[s->index])) {
+                                        ret = TONAL_FAIL;
+                                }
+                                if (s->pending) { active++; }
+                        }
+                }
+        }
+        /* Send the last closes. */
+        if (r.to_submit) { ring_enter(&r, 0); }
+
+        free(slot);
+        ring_exit(&r);
+        return ret;
+}
+
+#endif
+
+int tonal_ingest(
+        const char *const *path,
+        size_t n,
+        int depth,
+        int mode,
+        tonal_ingest_fn fn,
+        void *arg
+)
+{
+        int ret;
+#ifdef TONAL_IO_URING
+        int fallback;
+#endif
+
+        if ((NULL == path && n) || NULL == fn) { return TONAL_FAIL; }
+        if (depth < 1 || DEPTH_MAX < depth) { return TONAL_FAIL; }
+        if (mode < 0 || TONAL_INGEST_NONE <= mode) { return TONAL_FAIL; }
+        if (0 == n) { return TONAL_OK; }
+
+#ifdef TONAL_IO_URING
+        if (TONAL_INGEST_AUTO == mode) {
+                ret = ingest_uring(path, n, depth, fn, arg, &fallback);
+                if (!fallback) {
+                        TONAL_PROBE2(ingest_return, n, ret);
+                        return ret;
+                }
+        }
+#endif
+        ret = ingest_threads(path, n, depth, fn, arg);
+        TONAL_PROBE2(ingest_return, n, ret);
+        return ret;
+}
+
+struct parse {
+        int oc;
+        struct tonal_arena arena;
+        struct tonal_ingest_score score;
+        tonal_ingest_score_fn fn;
+        void *arg;
+};
+
+static int add_pitch(struct parse *p, int error, const struct tonal_pitch *tp)
+{
+        if (TONAL_E_OK != error) { return TONAL_FAIL; }
+        return tonal_seq_append(&p->score.pitch, tp, 1);
+}
+
+static int kern_note(const struct tonal_kern_note *note, void *arg)
+{
+        return add_pitch(arg, note->error, &note->pitch);
+}
+
+static int abc_note(const struct tonal_abc_note *note, void *arg)
+{
+        return add_pitch(arg, note->error, &note->pitch);
+}
+
+/* MusicXML octaves put middle C in octave 4. */
+static int musicxml_note(const struct tonal_musicxml_note *note, void *arg)
+{
+        struct parse *p = arg;
+        struct tonal_pitch tp = note->pitch;
+
+        if (OC_C5 == p->oc) { tp.octave++; }
+        return add_pitch(p, note->error, &tp);
+}
+
+static int has_extension(const char *path, const char *ext)
+{
+        const char *dot = strrchr(path, '.');
+
+        return dot && 0 == strcasecmp(dot + 1, ext);
+}
+
+static int parse_file(const struct tonal_ingest_file *file, void *arg)
+{
+        struct parse *p = arg;
+        int ret = file->status;
+
+        tonal_arena_reset(&p->arena);
+        tonal_seq_init(&p->score.pitch, &p->arena);
+        p->score.index = file->index;
+        p->score.path = file->path;
+
+        if (TONAL_OK != ret) {
+        } else if (has_extension(file->path, "krn")) {
+                ret = tonal_kern_scan(file->doc, file->size, p->oc, kern_note, p);
+        } else if (has_extension(file->path, "abc")) {
+                ret = tonal_abc_scan(file->doc, file->size, p->oc, abc_note, p);
+        } else if (
+                has_extension(file->path, "musicxml") ||
+                has_extension(file->path, "xml")
+        ) {
+                ret = tonal_musicxml_scan(file->doc, file->size, musicxml_note, p);
+        } else {
+                ret = TONAL_FAIL;
+        }
+        p->score.status = TONAL_OK == ret ? TONAL_OK : TONAL_FAIL;
+        return p->fn(&p->score, p->arg);
+}
+
+int tonal_ingest_scores(
+        const char *const *path,
+        size_t n,
+        int depth,
+        int mode,
+        int oc,
+        tonal_ingest_score_fn fn,
+        void *arg
+)
+{
+        struct parse p;
+        int ret;
+
+        if (NULL == fn || (OC_C5 != oc && OC_C4 != oc)) { return TONAL_FAIL; }
+
+        memset(&p, 0, sizeof p);
+        p.oc = oc;
+        p.fn = fn;
+        p.arg = arg;
+        tonal_arena_init(&p.arena, 0);
+        ret = tonal_ingest(path, n, depth, mode, parse_file, &p);
+        tonal_arena_free(&p.arena);
+        return ret;
+}
@@ -0,0 +1,589 @@
+/*
+ * Copyright 2016 Martin Aberg
+ *
+ * This file is part of tonal.
+ *
+ * tonal is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * tonal is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Interval class operations, see tonal_interval.h.
+ *
+ * Inversion maps the diatonic interval and the interval alteration
+ * independently: the diatonic interval by INV_DI_TABLE, and the alteration
+ * by swapping minor and major and reflecting the diminished ones onto the
+ * augmented ones. Perfect intervals invert to perfect intervals, so the
+ * result is always valid.
+ */
+
+#include <assert.h>
+
+#include <tonal_interval.h>
+#include "tonal_priv.h"
+
+/* Inverted diatonic interval */
+static const int INV_DI_TABLE[DI_NONE] = { 0, 6, 5, 4, 3, 2, 1 };
+
+/* Diatonic intervals with perfect rather than minor and major qualities */
+static const int PERFECT_TABLE[DI_NONE] = { 1, 0, 0, 1, 1, 0, 0 };
+
+/* Semitones of the major or perfect diatonic intervals */
+static const int DI_TO_SEMITONES_TABLE[DI_NONE] = { 0, 2, 4, 5, 7, 9, 11 };
+
+static inline int tic_valid(int di, int ia)
+{
+        if (di < DI_PRIME || DI_NONE <= di || ia < 0 || IA_NONE <= ia) {
+                return 0;
+        }
+        if (PERFECT_TABLE[di]) { return IA_MINOR != ia && IA_MAJOR != ia; }
+        return IA_PERFECT != ia;
+}
+
+/* A diminished prime is only an interval an octave or more up. */
+static inline int ti_valid(const struct tonal_interval *ti)
+{
+        int di = ti->diatonic_interval;
+        int ia = ti->interval_alteration;
+
+        return
+                tic_valid(di, ia) &&
+                0 <= ti->octave &&
+                (ID_UP == ti->interval_direction ||
+                 ID_DOWN == ti->interval_direction) &&
+                !(0 == ti->octave && DI_PRIME == di && ia < IA_PERFECT);
+}
+
+static inline int ia_inv(int ia)
+{
+        if (IA_MINOR == ia) { return IA_MAJOR; }
+        if (IA_MAJOR == ia) { return IA_MINOR; }
+        if (IA_PERFECT == ia) { return IA_PERFECT; }
+        return IA_DIMINISHED + IA_AUGMENTED - ia;
+}
+
+/* Inverted interval class of a valid di and ia */
+static inline void tic_inv_fields(int di, int ia, struct tonal_interval_class *tic)
+{
+        tic->diatonic_interval = INV_DI_TABLE[di];
+        tic->interval_alteration = ia_inv(ia);
+}
+
+/* Unordered interval class of a valid di and ia */
+static inline void tic_unordered_fields(
+        int di,
+        int ia,
+        struct tonal_interval_class *tic
+)
+{
+        if (DI_FOURTH < di || (DI_PRIME == di && ia < IA_PERFECT)) {
+                tic_inv_fields(di, ia, tic);
+        } else {
+                tic->diatonic_interval = di;
+                tic->interval_alteration = ia;
+        }
+}
+
+/*
+ * The inversion of a prime is an octave, and that of an octave a prime. An
+ * augmented octave inverts to a diminished prime, which is written as an
+ * augmented prime the other way.
+ */
+static inline void ti_inv_fields(
+        const struct tonal_interval *ti0,
+        struct tonal_interval *ti1
+)
+{
+        int di = ti0->diatonic_interval;
+        int ia = ti0->interval_alteration;
+        int dir = ti0->interval_direction;
+
+        if (DI_PRIME == di && 0 == ti0->octave) {
+                ti1->diatonic_interval = DI_PRIME;
+                ti1->interval_alteration = ia_inv(ia);
+                ti1->octave = 1;
+                ti1->interval_direction = dir;
+        } else if (DI_PRIME == di && IA_PERFECT < ia) {
+                ti1->diatonic_interval = DI_PRIME;
+                ti1->interval_alteration = ia;
+                ti1->octave = 0;
+                ti1->interval_direction = ID_UP == dir ? ID_DOWN : ID_UP;
+        } else {
+                tic_inv_fields(di, ia, (struct tonal_interval_class *) ti1);
+                ti1->octave = 0;
+                ti1->interval_direction = dir;
+        }
+}
+
+/* A diminished octave stays, it is less than an octave. */
+static inline void ti_simple_fields(
+        const struct tonal_interval *ti0,
+        struct tonal_interval *ti1
+)
+{
+        *ti1 = *ti0;
+        ti1->octave =
+                DI_PRIME == ti0->diatonic_interval &&
+                ti0->interval_alteration < IA_PERFECT &&
+                0 < ti0->octave;
+}
+
+static inline void ti_ordered_fields(
+        const struct tonal_interval *ti,
+        struct tonal_interval_class *tic
+)
+{
+        int di = ti->diatonic_interval;
+        int ia = ti->interval_alteration;
+
+        if (ID_DOWN == ti->interval_direction) {
+                tic_inv_fields(di, ia, tic);
+        } else {
+                tic->diatonic_interval = di;
+                tic->interval_alteration = ia;
+        }
+}
+
+/*
+ * Interval alteration of no alteration from DI_TO_SEMITONES_TABLE, indexed by
+ * PERFECT_TABLE[di] and whether the interval is larger than major. Diminished
+ * perfect intervals skip minor and major.
+ */
+static const int IA_BASE_TABLE[2][2] = {
+        { IA_MAJOR, IA_PERFECT },
+        { IA_DIMINISHED + 1, IA_PERFECT },
+};
+
+/* Signed size of a valid interval */
+static inline int ti_semitones_fields(const struct tonal_interval *ti)
+{
+        int di = ti->diatonic_interval;
+        int ia = ti->interval_alteration;
+        int base = IA_BASE_TABLE[PERFECT_TABLE[di]][IA_MAJOR < ia];
+        int semitones = 12 * ti->octave + DI_TO_SEMITONES_TABLE[di] + ia - base;
+
+        return ID_DOWN == ti->interval_direction ? -semitones : semitones;
+}
+
+static inline int ti_steps_fields(const struct tonal_interval *ti)
+{
+        int steps = 7 * ti->octave + ti->diatonic_interval;
+
+        return ID_DOWN == ti->interval_direction ? -steps : steps;
+}
+
+static inline int ti_compare_fields(
+        const struct tonal_interval *ti0,
+        const struct tonal_interval *ti1
+)
+{
+        int a = ti_semitones_fields(ti0);
+        int b = ti_semitones_fields(ti1);
+
+        if (a == b) {
+                a = ti_steps_fields(ti0);
+                b = ti_steps_fields(ti1);
+        }
+        return (a > b) - (a < b);
+}
+
+/* Reason why tic is invalid */
+static int tic_error(const struct tonal_interval_class *tic)
+{
+        struct tonal_interval ti;
+
+        if (NULL == tic) { return TONAL_E_NULL; }
+        ti.diatonic_interval = tic->diatonic_interval;
+        ti.interval_alteration = tic->interval_alteration;
+        ti.octave = 0;
+        ti.interval_direction = ID_UP;
+        return ti_error(&ti);
+}
+
+int tic_to_id(const struct tonal_interval_class *tic, int *id)
+{
+        if (NULL == tic || NULL == id) { return TONAL_FAIL; }
+        if (!tic_valid(tic->diatonic_interval, tic->interval_alteration)) {
+                return TONAL_FAIL;
+        }
+
+        *id = tic->diatonic_interval * IA_NONE + tic->interval_alteration;
+        assert(0 <= *id && *id < TONAL_TIC_ID_COUNT);
+        return TONAL_OK;
+}
+
+int id_to_tic(int id, struct tonal_interval_class *tic)
+{
+        int di;
+        int ia;
+
+        if (NULL == tic) { return TONAL_FAIL; }
+        if (id < 0 || TONAL_TIC_ID_COUNT <= id) { return TONAL_FAIL; }
+
+        di = id / IA_NONE;
+        ia = id % IA_NONE;
+        if (!tic_valid(di, ia)) { return TONAL_FAIL; }
+
+        tic->diatonic_interval = di;
+        tic->interval_alteration = ia;
+        return TONAL_OK;
+}
+
+int tic_inv(
+        const struct tonal_interval_class *tic0,
+        struct tonal_interval_class *tic1
+)
+{
+        if (NULL == tic0 || NULL == tic1) { return TONAL_FAIL; }
+        if (!tic_valid(tic0->diatonic_interval, tic0->interval_alteration)) {
+                return TONAL_FAIL;
+        }
+
+        tic_inv_fields(tic0->diatonic_interval, tic0->interval_alteration, tic1);
+        return TONAL_OK;
+}
+
+int ti_inv(
+        const struct tonal_interval *ti0,
+        struct tonal_interval *ti1
+)
+{
+        if (NULL == ti0 || NULL == ti1) { return TONAL_FAIL; }
+        if (!ti_valid(ti0)) { return TONAL_FAIL; }
+
+        ti_inv_fields(ti0, ti1);
+        return TONAL_OK;
+}
+
+int ti_simple(
+        const struct tonal_interval *ti0,
+        struct tonal_interval *ti1
+)
+{
+        if (NULL == ti0 || NULL == ti1) { return TONAL_FAIL; }
+        if (!ti_valid(ti0)) { return TONAL_FAIL; }
+
+        ti_simple_fields(ti0, ti1);
+        return TONAL_OK;
+}
+
+int ti_ordered_class(
+        const struct tonal_interval *ti,
+        struct tonal_interval_class *tic
+)
+{
+        if (NULL == ti || NULL == tic) { return TONAL_FAIL; }
+        if (!ti_valid(ti)) { return TONAL_FAIL; }
+
+        ti_ordered_fields(ti, tic);
+        return TONAL_OK;
+}
+
+int tic_unordered_class(
+        const struct tonal_interval_class *tic0,
+        struct tonal_interval_class *tic1
+)
+{
+        if (NULL == tic0 || NULL == tic1) { return TONAL_FAIL; }
+        if (!tic_valid(tic0->diatonic_interval, tic0->interval_alteration)) {
+                return TONAL_FAIL;
+        }
+
+        tic_unordered_fields(
+                tic0->diatonic_interval,
+                tic0->interval_alteration,
+                tic1
+        );
+        return TONAL_OK;
+}
+
+int ti_unordered_class(
+        const struct tonal_interval *ti,
+        struct tonal_interval_class *tic
+)
+{
+        if (NULL == ti || NULL == tic) { return TONAL_FAIL; }
+        if (!ti_valid(ti)) { return TONAL_FAIL; }
+
+        tic_unordered_fields(ti->diatonic_interval, ti->interval_alteration, tic);
+        return TONAL_OK;
+}
+
+int ti_semitones(const struct tonal_interval *ti, int *semitones)
+{
+        if (NULL == ti || NULL == semitones) { return TONAL_FAIL; }
+        if (!ti_valid(ti)) { return TONAL_FAIL; }
+
+        *semitones = ti_semitones_fields(ti);
+        return TONAL_OK;
+}
+
+int ti_steps(const struct tonal_interval *ti, int *steps)
+{
+        if (NULL == ti || NULL == steps) { return TONAL_FAIL; }
+        if (!ti_valid(ti)) { return TONAL_FAIL; }
+
+        *steps = ti_steps_fields(ti);
+        return TONAL_OK;
+}
+
+int ti_compare(
+        const struct tonal_interval *ti0,
+        const struct tonal_interval *ti1,
+        int *order
+)
+{
+        if (NULL == ti0 || NULL == ti1 || NULL == order) { return TONAL_FAIL; }
+        if (!ti_valid(ti0) || !ti_valid(ti1)) { return TONAL_FAIL; }
+
+        *order = ti_compare_fields(ti0, ti1);
+        return TONAL_OK;
+}
+
+static void fill_status(int *status, size_t n, int value)
+{
+        for (size_t i = 0; status && i < n; i++) { status[i] = value; }
+}
+
+int tic_inv_n(
+        const struct tonal_interval_class *tic0,
+        struct tonal_interval_class *tic1,
+        int *status,
+        size_t n
+)
+{
+        int ret;
+        int fail;
+        int di;
+        int ia;
+
+        if (0 == n) { return TONAL_OK; }
+        if (NULL == tic0 || NULL == tic1) {
+                fill_status(status, n, TONAL_E_NULL);
+                return TONAL_FAIL;
+        }
+
+        fail = 0;
+        for (size_t i = 0; i < n; i++) {
+                di = tic0[i].diatonic_interval;
+                ia = tic0[i].interval_alteration;
+                ret = TONAL_OK;
+                if (tic_valid(di, ia)) {
+                        tic_inv_fields(di, ia, &tic1[i]);
+                } else {
+                        ret = status ? tic_error(&tic0[i]) : TONAL_FAIL;
+                }
+                if (status) { status[i] = ret; }
+                fail |= ret;
+        }
+        return fail ? TONAL_FAIL : TONAL_OK;
+}
+
+/*
+ * The interval to interval batch operations share their loop, op is
+ * inlined into each.
+ */
+static inline int ti_map_n(
+        const struct tonal_interval *ti0,
+        struct tonal_interval *ti1,
+        int *status,
+        size_t n,
+        void (*op)(const struct tonal_interval *, struct tonal_interval *)
+)
+{
+        int ret;
+        int fail;
+
+        if (0 == n) { return TONAL_OK; }
+        if (NULL == ti0 || NULL == ti1) {
+                fill_status(status, n, TONAL_E_NULL);
+                return TONAL_FAIL;
+        }
+
+        fail = 0;
+        for (size_t i = 0; i < n; i++) {
+                ret = TONAL_OK;
+                if (ti_valid(&ti0[i])) {
+                        op(&ti0[i], &ti1[i]);
+                } else {
+                        ret = status ? ti_error(&ti0[i]) : TONAL_FAIL;
+                }
+                if (status) { status[i] = ret; }
+                fail |= ret;
+        }
+        return fail ? TONAL_FAIL : TONAL_OK;
+}
+
+static inline int ti_class_n(
+        const struct tonal_interval *ti,
+        struct tonal_interval_class *tic,
+        int *status,
+        size_t n,
+        void (*op)(const struct tonal_interval *, struct tonal_interval_class *)
+)
+{
+        int ret;
+        int fail;
+
+        if (0 == n) { return TONAL_OK; }
+        if (NULL == ti || NULL == tic) {
+                fill_status(status, n, TONAL_E_NULL);
+                return TONAL_FAIL;
+        }
+
+        fail = 0;
+        for (size_t i = 0; i < n; i++) {
+                ret = TONAL_OK;
+                if (ti_valid(&ti[i])) {
+                        op(&ti[i], &tic[i]);
+                } else {
+                        ret = status ? ti_error(&ti[i]) : TONAL_FAIL;
+                }
+                if (status) { status[i] = ret; }
+                fail |= ret;
+        }
+        return fail ? TONAL_FAIL : TONAL_OK;
+}
+
+static inline void ti_unordered_fields(
+        const struct tonal_interval *ti,
+        struct tonal_interval_class *tic
+)
+{
+        tic_unordered_fields(ti->diatonic_interval, ti->interval_alteration, tic);
+}
+
+int ti_inv_n(
+        const struct tonal_interval *ti0,
+        struct tonal_interval *ti1,
+        int *status,
+        size_t n
+)
+{
+        return ti_map_n(ti0, ti1, status, n, ti_inv_fields);
+}
+
+int ti_simple_n(
+        const struct tonal_interval *ti0,
+        struct tonal_interval *ti1,
+        int *status,
+        size_t n
+)
+{
+        return ti_map_n(ti0, ti1, status, n, ti_simple_fields);
+}
+
+int ti_ordered_class_n(
+        const struct tonal_interval *ti,
+        struct tonal_interval_class *tic,
+        int *status,
+        size_t n
+)
+{
+        return ti_class_n(ti, tic, status, n, ti_ordered_fields);
+}
+
+int ti_unordered_class_n(
+        const struct tonal_interval *ti,
+        struct tonal_interval_class *tic,
+        int *status,
+        size_t n
+)
+{
+        return ti_class_n(ti, tic, status, n, ti_unordered_fields);
+}
+
+static inline int ti_value_n(
+        const struct tonal_interval *ti,
+        int *value,
+        int *status,
+        size_t n,
+        int (*op)(const struct tonal_interval *)
+)
+{
+        int ret;
+        int fail;
+
+        if (0 == n) { return TONAL_OK; }
+        if (NULL == ti || NULL == value) {
+                fill_status(status, n, TONAL_E_NULL);
+                return TONAL_FAIL;
+        }
+
+        fail = 0;
+        for (size_t i = 0; i < n; i++) {
+                ret = TONAL_OK;
+                if (ti_valid(&ti[i])) {
+                        value[i] = op(&ti[i]);
+                } else {
+                        ret = status ? ti_error(&ti[i]) : TONAL_FAIL;
+                }
+                if (status) { status[i] = ret; }
+                fail |= ret;
+        }
+        return fail ? TONAL_FAIL : TONAL_OK;
+}
+
+int ti_semitones_n(
+        const struct tonal_interval *ti,
+        int *semitones,
+        int *status,
+        size_t n
+)
+{
+        return ti_value_n(ti, semitones, status, n, ti_semitones_fields);
+}
+
+int ti_steps_n(
+        const struct tonal_interval *ti,
+        int *steps,
+        int *status,
+        size_t n
+)
+{
+        return ti_value_n(ti, steps, status, n, ti_steps_fields);
+}
+
+int ti_compare_n(
+        const struct tonal_interval *ti0,
+        const struct tonal_interval *ti1,
+        int *order,
+        int *status,
+        size_t n
+)
+{
+        int ret;
+        int fail;
+
+        if (0 == n) { return TONAL_OK; }
+        if (NULL == ti0 || NULL == ti1 || NULL == order) {
+                fill_status(status, n, TONAL_E_NULL);
+                return TONAL_FAIL;
+        }
+
+        fail = 0;
+        for (size_t i = 0; i < n; i++) {
+                ret = TONAL_OK;
+                if (ti_valid(&ti0[i]) && ti_valid(&ti1[i])) {
+                        order[i] = ti_compare_fields(&ti0[i], &ti1[i]);
+                } else if (status) {
+                        ret = ti_error(&ti0[i]);
+                        if (TONAL_E_OK == ret) { ret = ti_error(&ti1[i]); }
+                } else {
+                        ret = TONAL_FAIL;
+                }
+                if (status) { status[i] = ret; }
+                fail |= ret;
+        }
+        return fail ? TONAL_FAIL : TONAL_OK;
+}
@@ -0,0 +1,63 @@
+/*
+ * Copyright 2016 Martin Aberg
+ *
+ * This file is part of tonal.
+ *
+ * tonal is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * tonal is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* File input for the score readers, see tonal_priv.h. */
+
+#define _POSIX_C_SOURCE 200112L
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "tonal_priv.h"
+
+int tonal_map_file(const char *path, const char **doc, size_t *size)
+{
+        struct stat st;
+        void *p;
+        int fd;
+
+        if (NULL == path || NULL == doc || NULL == size) { return TONAL_FAIL; }
+
+        fd = open(path, O_RDONLY);
+        if (fd < 0) { return TONAL_FAIL; }
+        if (0 != fstat(fd, &st)) {
+                close(fd);
+                return TONAL_FAIL;
+        }
+        if (0 == st.st_size) {
+                close(fd);
+                *doc = "";
+                *size = 0;
+                return TONAL_OK;
+        }
+        p = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (MAP_FAILED == p) { return TONAL_FAIL; }
+
+        posix_madvise(p, st.st_size, POSIX_MADV_SEQUENTIAL);
+        *doc = p;
+        *size = st.st_size;
+        return TONAL_OK;
+}
+
+void tonal_unmap_file(const char *doc, size_t size)
+{
+        if (size) { munmap((void *) doc, size); }
+}
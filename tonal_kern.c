@@ -0,0 +1,548 @@
+/*
+ * Copyright 2016 Martin Aberg
+ *
+ * This file is part of tonal.
+ *
+ * tonal is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * tonal is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Humdrum **kern pitches, see tonal_kern.h.
+ *
+ * Lines and fields are found with memchr(). The only state kept across lines
+ * is the list of spines, which changes on interpretation lines only, so
+ * nothing is allocated per token.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <tonal_kern.h>
+#include "tonal_priv.h"
+
+/* Longest letter run accepted, 64 octaves from middle C */
+#define MAX_REPEAT 64
+
+struct spine {
+        /* Track of a **kern spine, -1 for other spines */
+        int track;
+};
+
+struct scan {
+        const char *doc;
+        const char *end;
+        int base;
+        tonal_kern_fn fn;
+        void *arg;
+        /* Current spines, and room for the next line's */
+        struct spine *spine;
+        struct spine *next;
+        int nspines;
+        int maxspines;
+        int ntracks;
+        struct tonal_kern_note note;
+};
+
+/* Octave of middle C with octave convention oc */
+static int middle_c(int oc, int *base)
+{
+        switch (oc) {
+                case OC_C5: *base = 5; return TONAL_OK;
+                case OC_C4: *base = 4; return TONAL_OK;
+        }
+        return TONAL_FAIL;
+}
+
+static inline int is_name(char c)
+{
+        return ('a' <= c && c <= 'g') || ('A' <= c && c <= 'G');
+}
+
+/*
+ * Pitch of the kern token [p, end) with middle C in octave base. Returns
+ * TONAL_E_OK, TONAL_E_NONE if the token has no pitch, or the reason it is
+ * invalid.
+ */
+static int parse_kern(
+        const char *p,
+        const char *end,
+        int base,
+        struct tonal_pitch *tp
+)
+{
+        static const char NAMES[] = "cdefgab";
+        int alter = 0;
+        int n = 0;
+        char c;
+
+        while (p < end && !is_name(*p)) { p++; }
+        if (p == end) { return TONAL_E_NONE; }
+
+        c = *p;
+        for (; p < end && c == *p; p++) {
+                if (MAX_REPEAT < ++n) { return TONAL_E_FAIL; }
+        }
+        for (; p < end; p++) {
+                if ('#' == *p && 0 <= alter) {
+                        alter++;
+                } else if ('-' == *p && alter <= 0) {
+                        alter--;
+                } else if ('#' == *p || '-' == *p) {
+                        return TONAL_E_ALTERATION;
+                } else if ('n' != *p) {
+                        break;
+                }
+                if (TONAL_ALTERATION_MAX < abs(alter)) {
+                        return TONAL_E_ALTERATION;
+                }
+        }
+        for (; p < end; p++) {
+                if (is_name(*p)) { return TONAL_E_FAIL; }
+        }
+
+        tp->diatonic_pitch = strchr(NAMES, 'a' <= c ? c : c - 'A' + 'a') - NAMES;
+        tp->pitch_alteration = PA_ALTERATION(alter);
+        tp->octave = 'a' <= c ? base + n - 1 : base - n;
+        return TONAL_E_OK;
+}
+
+int tonal_kern_parse(
+        const char *str,
+        size_t len,
+        int oc,
+        struct tonal_pitch *tp
+)
+{
+        struct tonal_pitch tmp;
+        int base;
+        int ret;
+
+        if (NULL == str || NULL == tp) { return TONAL_FAIL; }
+
+        ret = middle_c(oc, &base);
+        if (TONAL_OK != ret) { return ret; }
+
+        if (TONAL_E_OK != parse_kern(str, str + len, base, &tmp)) {
+                return TONAL_FAIL;
+        }
+        *tp = tmp;
+        return TONAL_OK;
+}
+
+static int grow_spines(struct scan *s, int n)
+{
+        struct spine *spine;
+        struct spine *next;
+        int max;
+
+        if (n <= s->maxspines) { return TONAL_OK; }
+        max = s->maxspines ? s->maxspines : 16;
+        while (max < n) { max *= 2; }
+
+        spine = realloc(s->spine, max * sizeof *spine);
+        if (NULL == spine) { return TONAL_FAIL; }
+        s->spine = spine;
+        next = realloc(s->next, max * sizeof *next);
+        if (NULL == next) { return TONAL_FAIL; }
+        s->next = next;
+        s->maxspines = max;
+        return TONAL_OK;
+}
+
+#define TOKEN_IS(p, len, str) \
+        ((len) == sizeof (str) - 1 && 0 == memcmp((p), (str), (len)))
+
+/* End of the field starting at p: the next tab, or end */
+static const char *field_end(const char *p, const char *end)
+{
+        const char *tab = memchr(p, '\t', end - p);
+
+        return tab ? tab : end;
+}
+
+/* Apply the exclusive interpretations and spine manipulators of a line. */
+static int interpretation(struct scan *s, const char *p, const char *end)
+{
+        struct spine *tmp;
+        /* Previous field was *v, or an unpaired *x */
+        int join = 0;
+        int swap = 0;
+        int n = 0;
+        int i = 0;
+
+        /* A new set of spines after all were terminated */
+        if (0 == s->nspines) {
+                int nfields = 1;
+
+                for (const char *q = p; (q = memchr(q, '\t', end - q)); q++) {
+                        nfields++;
+                }
+                if (TONAL_OK != grow_spines(s, nfields)) { return TONAL_FAIL; }
+                for (i = 0; i < nfields; i++) { s->spine[i].track = -1; }
+                s->nspines = nfields;
+                i = 0;
+        }
+        /* Each spine becomes at most two. */
+        if (TONAL_OK != grow_spines(s, 2 * s->nspines)) { return TONAL_FAIL; }
+
+        for (;;) {
+                const char *e = field_end(p, end);
+                size_t len = e - p;
+
+                if (i == s->nspines) { return TONAL_FAIL; }
+                if (TOKEN_IS(p, len, "*^")) {
+                        s->next[n++] = s->spine[i];
+                        s->next[n++] = s->spine[i];
+                } else if (TOKEN_IS(p, len, "*v")) {
+                        /* Spines are joined into the first of a run of *v. */
+                        if (!join) {
+                                s->next[n++] = s->spine[i];
+                        }
+                } else if (TOKEN_IS(p, len, "*x")) {
+                        /* Exchange with the next spine, which also has *x. */
+                        if (swap) {
+                                s->next[n] = s->next[n - 1];
+                                s->next[n - 1] = s->spine[i];
+                                n++;
+                        } else {
+                                s->next[n++] = s->spine[i];
+                        }
+                } else if (TOKEN_IS(p, len, "*+")) {
+                        s->next[n++] = s->spine[i];
+                        s->next[n].track = -1;
+                        n++;
+                } else if (TOKEN_IS(p, len, "*-")) {
+                        ;
+                } else if (2 <= len && 0 == memcmp(p, "**", 2)) {
+                        s->next[n].track = TOKEN_IS(p, len, "**kern") ?
+                                s->ntracks++ : -1;
+                        n++;
+                } else {
+                        s->next[n++] = s->spine[i];
+                }
+                join = TOKEN_IS(p, len, "*v");
+                swap = TOKEN_IS(p, len, "*x") && !swap;
+                i++;
+                if (e == end) { break; }
+                p = e + 1;
+        }
+        if (i != s->nspines) { return TONAL_FAIL; }
+
+        tmp = s->spine;
+        s->spine = s->next;
+        s->next = tmp;
+        s->nspines = n;
+        return TONAL_OK;
+}
+
+static int data(struct scan *s, const char *p, const char *end)
+{
+        struct tonal_kern_note *note = &s->note;
+        int i = 0;
+
+        for (;;) {
+                const char *e = field_end(p, end);
+
+                if (i == s->nspines) { return TONAL_FAIL; }
+                if (0 <= s->spine[i].track) {
+                        note->track = s->spine[i].track;
+                        note->column = i;
+                        note->chord = 0;
+                        /* Chord notes are separated by spaces. */
+                        for (const char *q = p; ; ) {
+                                const char *sp = memchr(q, ' ', e - q);
+                                const char *qe = sp ? sp : e;
+                                int ret;
+
+                                note->error = parse_kern(q, qe, s->base, &note->pitch);
+                                if (TONAL_E_NONE != note->error) {
+                                        ret = s->fn(note, s->arg);
+                                        if (TONAL_OK != ret) { return ret; }
+                                        note->chord++;
+                                }
+                                if (qe == e) { break; }
+                                q = qe + 1;
+                        }
+                }
+                i++;
+                if (e == end) { break; }
+                p = e + 1;
+        }
+        return i == s->nspines ? TONAL_OK : TONAL_FAIL;
+}
+
+static int scan(struct scan *s)
+{
+        const char *p = s->doc;
+
+        s->note.line = 0;
+        while (p < s->end) {
+                const char *nl = memchr(p, '\n', s->end - p);
+                const char *end = nl ? nl : s->end;
+                int ret = TONAL_OK;
+
+                s->note.line++;
+                if (p < end && '\r' == end[-1]) { end--; }
+                if (p == end || '!' == *p) {
+                        /* Empty line or comment */
+                } else if ('*' == *p) {
+                        ret = interpretation(s, p, end);
+                } else if ('=' == *p) {
+                        /* Barline */
+                } else if (0 == s->nspines) {
+                        ret = TONAL_FAIL;
+                } else {
+                        ret = data(s, p, end);
+                }
+                if (TONAL_OK != ret) { return ret; }
+                p = nl ? nl + 1 : s->end;
+        }
+        return TONAL_OK;
+}
+
+static int kern_scan_impl(
+        const char *doc,
+        size_t size,
+        int oc,
+        tonal_kern_fn fn,
+        void *arg
+)
+{
+        struct scan s;
+        int ret;
+
+        if ((NULL == doc && size) || NULL == fn) { return TONAL_FAIL; }
+
+        memset(&s, 0, sizeof s);
+        ret = middle_c(oc, &s.base);
+        if (TONAL_OK != ret) { return ret; }
+        s.doc = doc;
+        s.end = doc + size;
+        s.fn = fn;
+        s.arg = arg;
+        ret = scan(&s);
+        free(s.spine);
+        free(s.next);
+        return ret;
+}
+
+int tonal_kern_scan(
+        const char *doc,
+        size_t size,
+        int oc,
+        tonal_kern_fn fn,
+        void *arg
+)
+{
+        int ret;
+
+        TONAL_STATS_BATCH(TONAL_STATS_KERN_SCAN, size);
+        TONAL_STATS_TIMER(t0);
+        ret = kern_scan_impl(doc, size, oc, fn, arg);
+        TONAL_STATS_ELAPSED(TONAL_STATS_KERN_SCAN, t0);
+        if (TONAL_OK != ret) {
+                TONAL_FAILED(TONAL_STATS_KERN_SCAN, TONAL_E_FAIL);
+        }
+        TONAL_PROBE2(kern_scan_return, size, ret);
+        return ret;
+}
+
+static int collect(const struct tonal_kern_note *note, void *arg)
+{
+        struct tonal_kern_score *score = arg;
+        struct tonal_kern_track *t;
+
+        if (TONAL_E_OK != note->error) { return TONAL_FAIL; }
+
+        if (score->ntracks <= note->track) {
+                struct tonal_kern_track *track;
+                int n = note->track + 1;
+
+                track = tonal_arena_realloc(
+                        score->arena,
+                        score->track,
+                        score->ntracks * sizeof *track,
+                        n * sizeof *track
+                );
+                if (NULL == track) { return TONAL_FAIL; }
+                memset(&track[score->ntracks], 0,
+                        (n - score->ntracks) * sizeof *track);
+                score->track = track;
+                score->ntracks = n;
+        }
+        t = &score->track[note->track];
+        if (t->n == t->max) {
+                size_t max = t->max ? 2 * t->max : 256;
+                struct tonal_pitch *pitch;
+
+                pitch = tonal_arena_realloc(
+                        score->arena,
+                        t->pitch,
+                        t->max * sizeof *pitch,
+                        max * sizeof *pitch
+                );
+                if (NULL == pitch) { return TONAL_FAIL; }
+                t->pitch = pitch;
+                t->max = max;
+        }
+        t->pitch[t->n++] = note->pitch;
+        return TONAL_OK;
+}
+
+int tonal_kern_read(
+        const char *doc,
+        size_t size,
+        int oc,
+        struct tonal_kern_score *score
+)
+{
+        return tonal_kern_read_arena(doc, size, oc, NULL, score);
+}
+
+int tonal_kern_read_arena(
+        const char *doc,
+        size_t size,
+        int oc,
+        struct tonal_arena *arena,
+        struct tonal_kern_score *score
+)
+{
+        if (NULL == score) { return TONAL_FAIL; }
+
+        score->track = NULL;
+        score->ntracks = 0;
+        score->arena = arena;
+        return tonal_kern_scan(doc, size, oc, collect, score);
+}
+
+int tonal_kern_read_file(
+        const char *path,
+        int oc,
+        struct tonal_kern_score *score
+)
+{
+        const char *doc;
+        size_t size;
+        int ret;
+
+        if (NULL == score) { return TONAL_FAIL; }
+
+        score->track = NULL;
+        score->ntracks = 0;
+        score->arena = NULL;
+        ret = tonal_map_file(path, &doc, &size);
+        if (TONAL_OK != ret) { return ret; }
+        ret = tonal_kern_read(doc, size, oc, score);
+        tonal_unmap_file(doc, size);
+        return ret;
+}
+
+void tonal_kern_score_free(struct tonal_kern_score *score)
+{
+        if (NULL == score) { return; }
+
+        if (NULL == score->arena) {
+                for (int i = 0; i < score->ntracks; i++) {
+                        free(score->track[i].pitch);
+                }
+                free(score->track);
+        }
+        score->track = NULL;
+        score->ntracks = 0;
+}
+
+int tonal_kern_snprint(
+        char *buf,
+        size_t size,
+        const struct tonal_pitch *tp,
+        int oc
+)
+{
+        static const char NAMES[] = "cdefgab";
+        struct tonal_pitch valid;
+        int alter;
+        int base;
+        int ret;
+        long n;
+        char c;
+        size_t len;
+
+        if (NULL == buf || NULL == tp) { return TONAL_FAIL; }
+
+        ret = middle_c(oc, &base);
+        if (TONAL_OK != ret) { return ret; }
+        ret = tp_set(&valid, tp->diatonic_pitch, tp->pitch_alteration, tp->octave);
+        if (TONAL_OK != ret) { return ret; }
+
+        c = NAMES[tp->diatonic_pitch];
+        if (base <= tp->octave) {
+                n = (long) tp->octave - base + 1;
+        } else {
+                c = c - 'a' + 'A';
+                n = (long) base - tp->octave;
+        }
+        alter = tp->pitch_alteration - PA_;
+        if ((long) size <= n) { return TONAL_FAIL; }
+        len = n + abs(alter);
+        if (size <= len) { return TONAL_FAIL; }
+
+        memset(buf, c, n);
+        memset(buf + n, alter < 0 ? '-' : '#', abs(alter));
+        buf[len] = '\0';
+        return TONAL_OK;
+}
+
+int tonal_kern_write(
+        FILE *stream,
+        const struct tonal_kern_score *score,
+        int oc
+)
+{
+        /* Up to MAX_REPEAT octaves from middle C */
+        char buf[MAX_REPEAT + TONAL_ALTERATION_MAX + 2];
+        size_t rows = 0;
+        int ret = 0;
+
+        if (NULL == stream || NULL == score) { return TONAL_FAIL; }
+        if (0 == score->ntracks) { return TONAL_OK; }
+
+        for (int i = 0; i < score->ntracks; i++) {
+                if (rows < score->track[i].n) { rows = score->track[i].n; }
+                ret |= fprintf(stream, "%s**kern", i ? "\t" : "") < 0;
+        }
+        ret |= fputc('\n', stream) < 0;
+
+        for (size_t r = 0; r < rows; r++) {
+                for (int i = 0; i < score->ntracks; i++) {
+                        const struct tonal_kern_track *t = &score->track[i];
+
+                        if (i) { ret |= fputc('\t', stream) < 0; }
+                        if (t->n <= r) {
+                                ret |= fputc('.', stream) < 0;
+                                continue;
+                        }
+                        if (TONAL_OK != tonal_kern_snprint(buf, sizeof buf, &t->pitch[r], oc)) {
+                                return TONAL_FAIL;
+                        }
+                        ret |= fputs(buf, stream) < 0;
+                }
+                ret |= fputc('\n', stream) < 0;
+        }
+
+        for (int i = 0; i < score->ntracks; i++) {
+                ret |= fprintf(stream, "%s*-", i ? "\t" : "") < 0;
+        }
+        ret |= fputc('\n', stream) < 0;
+        return ret ? TONAL_FAIL : TONAL_OK;
+}
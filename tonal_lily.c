@@ -0,0 +1,301 @@
+/*
+ * Copyright 2016 Martin Aberg
+ *
+ * This file is part of tonal.
+ *
+ * tonal is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * tonal is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * LilyPond writer, see tonal_lily.h.
+ *
+ * Pitches are formatted straight into the buffer, which is grown before each
+ * pitch if needed. No stdio is involved.
+ */
+
+#include <assert.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <tonal_lily.h>
+#include "tonal_priv.h"
+
+/* Most octave marks written, 64 octaves from the reference */
+#define MAX_MARKS 64
+/* Longest pitch: letter, "isis", marks */
+#define MAX_PITCH (1 + 4 + MAX_MARKS)
+
+static const char NAMES[DP_NONE] = { 'c', 'd', 'e', 'f', 'g', 'a', 'b' };
+
+/* Octave of "c", one below middle C, with octave convention oc */
+static int c_octave(int oc, int *base)
+{
+        switch (oc) {
+                case OC_C5: *base = 4; return TONAL_OK;
+                case OC_C4: *base = 3; return TONAL_OK;
+        }
+        return TONAL_FAIL;
+}
+
+/* Validate tp for the writer: no triple accidentals, and a sane octave. */
+static int check(const struct tonal_pitch *tp)
+{
+        struct tonal_pitch valid;
+        int ret;
+
+        if (NULL == tp) { return TONAL_FAIL; }
+
+        ret = tp_set(&valid, tp->diatonic_pitch, tp->pitch_alteration, tp->octave);
+        if (TONAL_OK != ret) { return ret; }
+        if (2 < abs(tp->pitch_alteration - PA_)) { return TONAL_FAIL; }
+        if (tp->octave < -INT_MAX / 8 || INT_MAX / 8 < tp->octave) {
+                return TONAL_FAIL;
+        }
+        return TONAL_OK;
+}
+
+/*
+ * Write the name of tp and marks octave marks to out, which has room for
+ * MAX_PITCH characters. Returns the length.
+ */
+static size_t format(char *out, const struct tonal_pitch *tp, int marks)
+{
+        static const char *const SUFFIX[] = { "eses", "es", "", "is", "isis" };
+        int alter = tp->pitch_alteration - PA_;
+        char c = NAMES[tp->diatonic_pitch];
+        const char *suffix = SUFFIX[alter + 2];
+        size_t n = 0;
+
+        assert(-MAX_MARKS <= marks && marks <= MAX_MARKS);
+        out[n++] = c;
+        /* "es" and "as", not "ees" and "aes" */
+        if (alter < 0 && ('e' == c || 'a' == c)) { suffix++; }
+        while (*suffix) { out[n++] = *suffix++; }
+        for (; 0 < marks; marks--) { out[n++] = '\''; }
+        for (; marks < 0; marks++) { out[n++] = ','; }
+        return n;
+}
+
+static int reserve(struct tonal_lily *w, size_t n)
+{
+        char *buf;
+        size_t max;
+
+        if (w->len + n < w->max) { return TONAL_OK; }
+        max = w->max ? w->max : 4096;
+        while (max <= w->len + n) { max *= 2; }
+        buf = realloc(w->buf, max);
+        if (NULL == buf) { return TONAL_FAIL; }
+        w->buf = buf;
+        w->max = max;
+        return TONAL_OK;
+}
+
+/* Octave marks of tp in the current mode */
+static int get_marks(const struct tonal_lily *w, const struct tonal_pitch *tp, int *marks)
+{
+        struct tonal_element te;
+        struct tonal_element prev;
+        int base;
+        int d;
+        int ret;
+
+        if (TONAL_LILY_ABSOLUTE == w->mode) {
+                ret = c_octave(w->oc, &base);
+                if (TONAL_OK != ret) { return ret; }
+                d = tp->octave - base;
+        } else {
+                ret = tp_to_te(tp, &te);
+                if (TONAL_OK != ret) { return ret; }
+                ret = tp_to_te(&w->prev, &prev);
+                if (TONAL_OK != ret) { return ret; }
+                /* Diatonic steps from the previous pitch */
+                d = te_get_diatonic_value(&te) - te_get_diatonic_value(&prev);
+                /* Unmarked, the pitch is within a fourth. */
+                d = d < 0 ? -((-d + 3) / 7) : (d + 3) / 7;
+        }
+        if (d < -MAX_MARKS || MAX_MARKS < d) { return TONAL_FAIL; }
+        *marks = d;
+        return TONAL_OK;
+}
+
+static int put_pitch(struct tonal_lily *w, const struct tonal_pitch *tp)
+{
+        int marks;
+        int ret;
+
+        ret = check(tp);
+        if (TONAL_OK != ret) { return ret; }
+        ret = get_marks(w, tp, &marks);
+        if (TONAL_OK != ret) { return ret; }
+        ret = reserve(w, MAX_PITCH);
+        if (TONAL_OK != ret) { return ret; }
+
+        w->len += format(w->buf + w->len, tp, marks);
+        w->buf[w->len] = '\0';
+        w->prev = *tp;
+        return TONAL_OK;
+}
+
+int tonal_lily_init(
+        struct tonal_lily *w,
+        int mode,
+        const struct tonal_pitch *ref,
+        int oc
+)
+{
+        int base;
+        int ret;
+
+        if (NULL == w) { return TONAL_FAIL; }
+
+        memset(w, 0, sizeof *w);
+        ret = c_octave(oc, &base);
+        if (TONAL_OK != ret) { return ret; }
+        if (TONAL_LILY_RELATIVE == mode) {
+                ret = check(ref);
+                if (TONAL_OK != ret) { return ret; }
+                w->prev = *ref;
+        } else if (TONAL_LILY_ABSOLUTE != mode) {
+                return TONAL_FAIL;
+        }
+        w->mode = mode;
+        w->oc = oc;
+        return reserve(w, 0);
+}
+
+void tonal_lily_free(struct tonal_lily *w)
+{
+        if (NULL == w) { return; }
+
+        free(w->buf);
+        w->buf = NULL;
+        w->len = 0;
+        w->max = 0;
+}
+
+int tonal_lily_append(struct tonal_lily *w, const char *str)
+{
+        size_t n;
+        int ret;
+
+        if (NULL == w || NULL == str) { return TONAL_FAIL; }
+
+        n = strlen(str);
+        ret = reserve(w, n);
+        if (TONAL_OK != ret) { return ret; }
+        memcpy(w->buf + w->len, str, n + 1);
+        w->len += n;
+        return TONAL_OK;
+}
+
+int tonal_lily_pitch(struct tonal_lily *w, const struct tonal_pitch *tp)
+{
+        if (NULL == w || NULL == w->buf) { return TONAL_FAIL; }
+
+        return put_pitch(w, tp);
+}
+
+int tonal_lily_pitches(
+        struct tonal_lily *w,
+        const struct tonal_pitch *tp,
+        size_t n,
+        const char *suffix
+)
+{
+        size_t len;
+        int ret;
+
+        if (NULL == w || NULL == w->buf || (NULL == tp && n)) {
+                return TONAL_FAIL;
+        }
+        if (NULL == suffix) { suffix = ""; }
+
+        len = strlen(suffix);
+        /* Room for all of them, unless the marks get long */
+        ret = reserve(w, n * (len + 8));
+        if (TONAL_OK != ret) { return ret; }
+        for (size_t i = 0; i < n; i++) {
+                ret = put_pitch(w, &tp[i]);
+                if (TONAL_OK != ret) { return ret; }
+                ret = reserve(w, len);
+                if (TONAL_OK != ret) { return ret; }
+                memcpy(w->buf + w->len, suffix, len + 1);
+                w->len += len;
+        }
+        return TONAL_OK;
+}
+
+int tonal_lily_chord(
+        struct tonal_lily *w,
+        const struct tonal_pitch *tp,
+        size_t n
+)
+{
+        struct tonal_pitch prev;
+        size_t len;
+        int ret;
+
+        if (NULL == w || NULL == w->buf || NULL == tp || 0 == n) {
+                return TONAL_FAIL;
+        }
+
+        prev = w->prev;
+        len = w->len;
+        ret = tonal_lily_append(w, "<");
+        for (size_t i = 0; TONAL_OK == ret && i < n; i++) {
+                if (i) { ret = tonal_lily_append(w, " "); }
+                if (TONAL_OK == ret) { ret = put_pitch(w, &tp[i]); }
+        }
+        if (TONAL_OK == ret) { ret = tonal_lily_append(w, ">"); }
+        if (TONAL_OK != ret) {
+                /* Leave no half chord behind. */
+                w->len = len;
+                w->buf[len] = '\0';
+                w->prev = prev;
+                return ret;
+        }
+        w->prev = tp[0];
+        return TONAL_OK;
+}
+
+int tonal_lily_snprint(
+        char *buf,
+        size_t size,
+        const struct tonal_pitch *tp,
+        int oc
+)
+{
+        struct tonal_lily w;
+        char out[MAX_PITCH];
+        int marks;
+        size_t n;
+        int ret;
+
+        if (NULL == buf) { return TONAL_FAIL; }
+
+        ret = check(tp);
+        if (TONAL_OK != ret) { return ret; }
+        w.mode = TONAL_LILY_ABSOLUTE;
+        w.oc = oc;
+        ret = get_marks(&w, tp, &marks);
+        if (TONAL_OK != ret) { return ret; }
+
+        n = format(out, tp, marks);
+        if (size <= n) { return TONAL_FAIL; }
+        memcpy(buf, out, n);
+        buf[n] = '\0';
+        return TONAL_OK;
+}
@@ -0,0 +1,193 @@
+/*
+ * Copyright 2016 Martin Aberg
+ *
+ * This file is part of tonal.
+ *
+ * tonal is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * tonal is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Line of fifths, see tonal_lof.h.
+ *
+ * A Tonal Class sits at DT_TO_LOF_TABLE[diatonic_point] + 7 * alteration.
+ * Going back, the position counted from F splits into seven diatonic points
+ * and the alteration.
+ */
+
+#include <assert.h>
+
+#include <tonal_lof.h>
+#include "tonal_priv.h"
+
+/* Positions of the unaltered diatonic points C to B */
+static const int DT_TO_LOF_TABLE[7] = { 0, 2, 4, -1, 1, 3, 5 };
+
+/* Diatonic points in fifths from F */
+static const int LOF_TO_DT_TABLE[7] = { 3, 0, 4, 1, 5, 2, 6 };
+
+static inline int tc_lof(const struct tonal_class *tc)
+{
+        return DT_TO_LOF_TABLE[tc->diatonic_point] + 7 * tc->alteration;
+}
+
+static inline int tc_from_lof(struct tonal_class *tc, int lof)
+{
+        int k;
+        int a;
+
+        if (lof < TONAL_LOF_MIN || TONAL_LOF_MAX < lof) { return TONAL_FAIL; }
+
+        /* Floor division, from F */
+        k = lof + 1;
+        a = k < 0 ? -((6 - k) / 7) : k / 7;
+        tc->diatonic_point = LOF_TO_DT_TABLE[k - 7 * a];
+        tc->alteration = a;
+        assert(lof == tc_lof(tc));
+        return TONAL_OK;
+}
+
+int tpc_to_lof(const struct tonal_pitch_class *tpc, int *lof)
+{
+        int ret;
+        struct tonal_class tc;
+
+        ret = tpc_to_tc(tpc, &tc);
+        if (TONAL_OK != ret) { return ret; }
+
+        if (NULL == lof) { return TONAL_FAIL; }
+
+        *lof = tc_lof(&tc);
+        return TONAL_OK;
+}
+
+int tic_to_lof(const struct tonal_interval_class *tic, int *lof)
+{
+        int ret;
+        struct tonal_class tc;
+
+        ret = tic_to_tc(tic, &tc);
+        if (TONAL_OK != ret) { return ret; }
+
+        if (NULL == lof) { return TONAL_FAIL; }
+
+        *lof = tc_lof(&tc);
+        return TONAL_OK;
+}
+
+int lof_to_tpc(int lof, struct tonal_pitch_class *tpc)
+{
+        int ret;
+        struct tonal_class tc;
+
+        if (NULL == tpc) { return TONAL_FAIL; }
+
+        ret = tc_from_lof(&tc, lof);
+        if (TONAL_OK != ret) { return ret; }
+
+        return tc_to_tpc(&tc, tpc);
+}
+
+int lof_to_tic(int lof, struct tonal_interval_class *tic)
+{
+        int ret;
+        struct tonal_class tc;
+
+        if (NULL == tic) { return TONAL_FAIL; }
+
+        ret = tc_from_lof(&tc, lof);
+        if (TONAL_OK != ret) { return ret; }
+
+        return tc_to_tic(&tc, tic);
+}
+
+int tpc_lof_distance(
+        const struct tonal_pitch_class *tpc0,
+        const struct tonal_pitch_class *tpc1,
+        int *distance
+)
+{
+        int ret;
+        int lof0;
+        int lof1;
+
+        ret = tpc_to_lof(tpc0, &lof0);
+        if (TONAL_OK != ret) { return ret; }
+
+        ret = tpc_to_lof(tpc1, &lof1);
+        if (TONAL_OK != ret) { return ret; }
+
+        if (NULL == distance) { return TONAL_FAIL; }
+
+        *distance = lof0 < lof1 ? lof1 - lof0 : lof0 - lof1;
+        return TONAL_OK;
+}
+
+/* Position of a pitch, or INT_MIN if it is invalid */
+static inline int tp_lof(const struct tonal_pitch *tp)
+{
+        int dp = tp->diatonic_pitch;
+        int pa = tp->pitch_alteration;
+
+        if (dp < DP_C || DP_B < dp || pa < 0 || PA_NONE <= pa) { return INT_MIN; }
+        return DT_TO_LOF_TABLE[dp - DP_C] + 7 * (pa - PA_);
+}
+
+int tp_to_lof_n(
+        const struct tonal_pitch *tp,
+        int *lof,
+        int *status,
+        size_t n
+)
+{
+        int ret;
+        int fail;
+
+        if (0 == n) { return TONAL_OK; }
+        if (NULL == tp || NULL == lof) {
+                for (size_t i = 0; status && i < n; i++) {
+                        status[i] = TONAL_E_NULL;
+                }
+                return TONAL_FAIL;
+        }
+
+        fail = 0;
+        for (size_t i = 0; i < n; i++) {
+                lof[i] = tp_lof(&tp[i]);
+                ret = INT_MIN == lof[i] ? TONAL_FAIL : TONAL_OK;
+                if (TONAL_OK != ret && status) { ret = tp_error(&tp[i]); }
+                if (status) { status[i] = ret; }
+                fail |= ret;
+        }
+        return fail ? TONAL_FAIL : TONAL_OK;
+}
+
+int tp_lof_center_n(
+        const struct tonal_pitch *tp,
+        size_t n,
+        double *center
+)
+{
+        long long sum = 0;
+        int lof;
+
+        if (0 == n || NULL == tp || NULL == center) { return TONAL_FAIL; }
+
+        for (size_t i = 0; i < n; i++) {
+                lof = tp_lof(&tp[i]);
+                if (INT_MIN == lof) { return TONAL_FAIL; }
+                sum += lof;
+        }
+        *center = (double) sum / n;
+        return TONAL_OK;
+}
@@ -0,0 +1,463 @@
+/*
+ * Copyright 2016 Martin Aberg
+ *
+ * This file is part of tonal.
+ *
+ * tonal is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * tonal is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * MusicXML pitch scanner, see tonal_musicxml.h.
+ *
+ * The scanner jumps from one '<' to the next with memchr(), which the C
+ * library implements with vector instructions, and looks only at the element
+ * name of each tag. Attributes are parsed for <score-part> and <part> only,
+ * and text only for the few elements which make up a pitched note. Tags are
+ * matched by name alone; the nesting is tracked with a handful of flags.
+ */
+
+#include <assert.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <tonal_musicxml.h>
+#include "tonal_priv.h"
+
+struct part_id {
+        const char *id;
+        size_t len;
+};
+
+struct scan {
+        const char *doc;
+        const char *end;
+        tonal_musicxml_fn fn;
+        void *arg;
+        /* Part ids in order of appearance */
+        struct part_id *parts;
+        int nparts;
+        int maxparts;
+        int timewise;
+        int in_note;
+        int in_pitch;
+        int pitched;
+        /* -1 if no <step>, DP_NONE if not a step letter */
+        int dp;
+        int alter;
+        int alter_ok;
+        int octave;
+        int octave_ok;
+        struct tonal_musicxml_note note;
+};
+
+#define NAME_IS(name, len, str) \
+        ((len) == sizeof (str) - 1 && 0 == memcmp((name), (str), (len)))
+
+static inline int is_space(char c)
+{
+        return ' ' == c || '\t' == c || '\n' == c || '\r' == c;
+}
+
+/* First occurrence of str (n characters) in [p, end), or NULL */
+static const char *find(const char *p, const char *end, const char *str, size_t n)
+{
+        while ((size_t) (end - p) >= n) {
+                p = memchr(p, str[0], end - p - n + 1);
+                if (NULL == p) { return NULL; }
+                if (0 == memcmp(p, str, n)) { return p; }
+                p++;
+        }
+        return NULL;
+}
+
+/* The '>' closing the tag starting at p, or NULL. Quotes may hide a '>'. */
+static const char *tag_end(const char *p, const char *end)
+{
+        const char *gt;
+        char q = 0;
+
+        gt = memchr(p, '>', end - p);
+        if (NULL == gt) { return NULL; }
+        if (NULL == memchr(p, '"', gt - p) && NULL == memchr(p, '\'', gt - p)) {
+                return gt;
+        }
+        for (; p < end; p++) {
+                if (q) {
+                        if (q == *p) { q = 0; }
+                } else if ('"' == *p || '\'' == *p) {
+                        q = *p;
+                } else if ('>' == *p) {
+                        return p;
+                }
+        }
+        return NULL;
+}
+
+static size_t name_len(const char *p, const char *end)
+{
+        const char *q = p;
+
+        while (q < end && !is_space(*q) && '>' != *q && '/' != *q) {
+                q++;
+        }
+        return q - p;
+}
+
+/* Value of attribute name in the attribute list [p, gt) */
+static int tag_attr(
+        const char *p,
+        const char *gt,
+        const char *name,
+        const char **val,
+        size_t *len
+)
+{
+        size_t n = strlen(name);
+
+        while (p < gt) {
+                const char *a;
+                const char *v;
+                char q;
+
+                while (p < gt && is_space(*p)) { p++; }
+                a = p;
+                while (p < gt && '"' != *p && '\'' != *p) { p++; }
+                if (p == gt) { return TONAL_FAIL; }
+                q = *p++;
+                v = p;
+                p = memchr(p, q, gt - p);
+                if (NULL == p) { return TONAL_FAIL; }
+                if (
+                        (size_t) (v - a) > n &&
+                        0 == memcmp(a, name, n) &&
+                        ('=' == a[n] || is_space(a[n]))
+                ) {
+                        *val = v;
+                        *len = p - v;
+                        return TONAL_OK;
+                }
+                p++;
+        }
+        return TONAL_FAIL;
+}
+
+/*
+ * Integer in [p, end), surrounded by optional white space. A fraction is
+ * accepted only if it is zero, as in "1.0".
+ */
+static int parse_int(const char *p, const char *end, int *value)
+{
+        int neg = 0;
+        long v = 0;
+
+        while (p < end && is_space(*p)) { p++; }
+        while (end > p && is_space(end[-1])) { end--; }
+        if (p < end && ('-' == *p || '+' == *p)) { neg = '-' == *p++; }
+        if (p == end || *p < '0' || '9' < *p) { return TONAL_FAIL; }
+        for (; p < end && '0' <= *p && *p <= '9'; p++) {
+                v = v * 10 + (*p - '0');
+                if (INT_MAX < v) { return TONAL_FAIL; }
+        }
+        if (p < end && '.' == *p) {
+                for (p++; p < end && '0' == *p; p++) {
+                        ;
+                }
+        }
+        if (p != end) { return TONAL_FAIL; }
+        *value = neg ? (int) -v : (int) v;
+        return TONAL_OK;
+}
+
+static int parse_step(const char *p, const char *end)
+{
+        static const char STEPS[] = "CDEFGAB";
+        const char *s;
+
+        while (p < end && is_space(*p)) { p++; }
+        while (end > p && is_space(end[-1])) { end--; }
+        if (1 != end - p || '\0' == *p) { return DP_NONE; }
+        s = memchr(STEPS, *p, DP_NONE);
+        return s ? s - STEPS : DP_NONE;
+}
+
+static int add_part(struct scan *s, const char *id, size_t len)
+{
+        for (int i = 0; i < s->nparts; i++) {
+                if (len == s->parts[i].len && 0 == memcmp(id, s->parts[i].id, len)) {
+                        return i;
+                }
+        }
+        if (s->nparts == s->maxparts) {
+                int max = s->maxparts ? 2 * s->maxparts : 16;
+                struct part_id *parts;
+
+                parts = realloc(s->parts, max * sizeof *parts);
+                if (NULL == parts) { return -1; }
+                s->parts = parts;
+                s->maxparts = max;
+        }
+        s->parts[s->nparts].id = id;
+        s->parts[s->nparts].len = len;
+        return s->nparts++;
+}
+
+static void note_begin(struct scan *s, size_t offset)
+{
+        s->in_note = 1;
+        s->in_pitch = 0;
+        s->pitched = 0;
+        s->dp = -1;
+        s->alter = 0;
+        s->alter_ok = 1;
+        s->octave_ok = 0;
+        s->note.voice = 1;
+        s->note.duration = 0;
+        s->note.chord = 0;
+        s->note.offset = offset;
+}
+
+static int note_end(struct scan *s)
+{
+        struct tonal_musicxml_note *n = &s->note;
+
+        s->in_note = 0;
+        s->in_pitch = 0;
+        if (!s->pitched) { return TONAL_OK; }
+
+        if (-1 == s->dp || !s->octave_ok) {
+                n->error = TONAL_E_FAIL;
+        } else if (DP_NONE == s->dp) {
+                n->error = TONAL_E_DIATONIC;
+        } else if (
+                !s->alter_ok ||
+                s->alter < -TONAL_ALTERATION_MAX ||
+                TONAL_ALTERATION_MAX < s->alter
+        ) {
+                n->error = TONAL_E_ALTERATION;
+        } else {
+                int ret;
+
+                ret = tp_set(&n->pitch, s->dp, PA_ALTERATION(s->alter), s->octave);
+                assert(TONAL_OK == ret);
+                (void) ret;
+                n->error = TONAL_E_OK;
+        }
+        return s->fn(n, s->arg);
+}
+
+/* Start tag at p, after the '<'. Returns where to continue, or NULL. */
+static const char *start_tag(struct scan *s, const char *p)
+{
+        const char *gt;
+        const char *text;
+        const char *text_end;
+        const char *name = p;
+        size_t len;
+
+        len = name_len(p, s->end);
+        gt = tag_end(p + len, s->end);
+        if (0 == len || NULL == gt) { return NULL; }
+        p = gt + 1;
+
+        /* Elements whose text is read */
+        text = p;
+        text_end = NULL;
+        if (s->in_note && '/' != gt[-1] && (
+                (s->in_pitch && (
+                        NAME_IS(name, len, "step") ||
+                        NAME_IS(name, len, "alter") ||
+                        NAME_IS(name, len, "octave")
+                )) ||
+                NAME_IS(name, len, "voice") ||
+                NAME_IS(name, len, "duration")
+        )) {
+                text_end = memchr(text, '<', s->end - text);
+                if (NULL == text_end) { return NULL; }
+        }
+
+        if (text_end) {
+                if (NAME_IS(name, len, "step")) {
+                        s->dp = parse_step(text, text_end);
+                } else if (NAME_IS(name, len, "alter")) {
+                        s->alter_ok = TONAL_OK == parse_int(text, text_end, &s->alter);
+                } else if (NAME_IS(name, len, "octave")) {
+                        s->octave_ok = TONAL_OK == parse_int(text, text_end, &s->octave);
+                } else if (NAME_IS(name, len, "voice")) {
+                        if (TONAL_OK != parse_int(text, text_end, &s->note.voice)) {
+                                s->note.voice = 1;
+                        }
+                } else if (TONAL_OK != parse_int(text, text_end, &s->note.duration)) {
+                        s->note.duration = 0;
+                }
+                return text_end;
+        }
+
+        if (NAME_IS(name, len, "note")) {
+                if ('/' != gt[-1]) { note_begin(s, name - 1 - s->doc); }
+        } else if (s->in_note) {
+                if (NAME_IS(name, len, "pitch")) {
+                        s->in_pitch = '/' != gt[-1];
+                } else if (NAME_IS(name, len, "chord")) {
+                        s->note.chord = 1;
+                }
+        } else if (NAME_IS(name, len, "measure")) {
+                s->note.measure++;
+        } else if (NAME_IS(name, len, "part") || NAME_IS(name, len, "score-part")) {
+                const char *id;
+                size_t id_len;
+                int part;
+
+                if (TONAL_OK != tag_attr(name + len, gt, "id", &id, &id_len)) {
+                        return NULL;
+                }
+                part = add_part(s, id, id_len);
+                if (part < 0) { return NULL; }
+                if ('p' == name[0]) {
+                        s->note.part = part;
+                        s->note.part_id = id;
+                        s->note.part_id_len = id_len;
+                        if (!s->timewise) { s->note.measure = -1; }
+                }
+        } else if (NAME_IS(name, len, "score-timewise")) {
+                s->timewise = 1;
+        }
+        return p;
+}
+
+/* Markup starting with "<!" at p, after the '<' */
+static const char *skip_markup(const char *p, const char *end)
+{
+        int depth = 0;
+
+        if (end - p >= 3 && 0 == memcmp(p, "!--", 3)) {
+                p = find(p + 3, end, "-->", 3);
+                return p ? p + 3 : NULL;
+        }
+        if (end - p >= 8 && 0 == memcmp(p, "![CDATA[", 8)) {
+                p = find(p + 8, end, "]]>", 3);
+                return p ? p + 3 : NULL;
+        }
+        /* <!DOCTYPE ...>, possibly with an internal subset in [] */
+        for (; p < end; p++) {
+                if ('[' == *p) {
+                        depth++;
+                } else if (']' == *p) {
+                        depth--;
+                } else if ('>' == *p && depth <= 0) {
+                        return p + 1;
+                }
+        }
+        return NULL;
+}
+
+static int scan(struct scan *s)
+{
+        const char *p = s->doc;
+        const char *end = s->end;
+
+        while (p < end) {
+                p = memchr(p, '<', end - p);
+                if (NULL == p) { break; }
+                if (++p == end) { return TONAL_FAIL; }
+
+                if ('/' == *p) {
+                        const char *name = p + 1;
+                        size_t len = name_len(name, end);
+
+                        p = memchr(name, '>', end - name);
+                        if (NULL == p) { return TONAL_FAIL; }
+                        if (NAME_IS(name, len, "note") && s->in_note) {
+                                int ret;
+
+                                ret = note_end(s);
+                                if (TONAL_OK != ret) { return ret; }
+                        } else if (NAME_IS(name, len, "pitch") && s->in_pitch) {
+                                s->in_pitch = 0;
+                                s->pitched = 1;
+                        }
+                } else if ('!' == *p) {
+                        p = skip_markup(p, end);
+                } else if ('?' == *p) {
+                        p = find(p, end, "?>", 2);
+                } else {
+                        p = start_tag(s, p);
+                }
+                if (NULL == p) { return TONAL_FAIL; }
+        }
+        return TONAL_OK;
+}
+
+static int musicxml_scan_impl(
+        const char *doc,
+        size_t size,
+        tonal_musicxml_fn fn,
+        void *arg
+)
+{
+        struct scan s;
+        int ret;
+
+        if ((NULL == doc && size) || NULL == fn) { return TONAL_FAIL; }
+
+        memset(&s, 0, sizeof s);
+        s.doc = doc;
+        s.end = doc + size;
+        s.fn = fn;
+        s.arg = arg;
+        s.note.part = -1;
+        s.note.measure = -1;
+        ret = size ? scan(&s) : TONAL_OK;
+        free(s.parts);
+        return ret;
+}
+
+int tonal_musicxml_scan(
+        const char *doc,
+        size_t size,
+        tonal_musicxml_fn fn,
+        void *arg
+)
+{
+        int ret;
+
+        TONAL_STATS_BATCH(TONAL_STATS_MUSICXML_SCAN, size);
+        TONAL_STATS_TIMER(t0);
+        ret = musicxml_scan_impl(doc, size, fn, arg);
+        TONAL_STATS_ELAPSED(TONAL_STATS_MUSICXML_SCAN, t0);
+        if (TONAL_OK != ret) {
+                TONAL_FAILED(TONAL_STATS_MUSICXML_SCAN, TONAL_E_FAIL);
+        }
+        TONAL_PROBE2(musicxml_scan_return, size, ret);
+        return ret;
+}
+
+int tonal_musicxml_scan_file(
+        const char *path,
+        tonal_musicxml_fn fn,
+        void *arg
+)
+{
+        const char *doc;
+        size_t size;
+        int ret;
+
+        if (NULL == path || NULL == fn) { return TONAL_FAIL; }
+
+        ret = tonal_map_file(path, &doc, &size);
+        if (TONAL_OK != ret) { return ret; }
+        ret = tonal_musicxml_scan(doc, size, fn, arg);
+        tonal_unmap_file(doc, size);
+        return ret;
+}
@@ -33,7 +33,7 @@
 struct tonal_class {
         /* { 0, 1, 2, 3, 4, 5, 6 } */
         int diatonic_point;
-        /* { -2, -1, 0, 1, 2 } */
+        /* -TONAL_ALTERATION_MAX to TONAL_ALTERATION_MAX, { -2, ..., 2 } by default */
         int alteration;
 };
 
@@ -46,7 +46,7 @@ struct tonal_class {
 struct tonal_element {
         /* Allowed values are { 0, 1, 2, 3, 4, 5, 6 } */
         int diatonic_point;
-        /* Allowed values are { -2, -1, 0, 1, 2 } */
+        /* Allowed values are -TONAL_ALTERATION_MAX to TONAL_ALTERATION_MAX */
         int alteration;
         /* The octave may have any integer value is allowed. */
         int octave;
@@ -76,6 +76,9 @@ extern int dt_get_mpc_value(int dt);
  *
  * tonal_class -> {-2..13}
  *
+ * With TONAL_ALTERATION_MAX above 2, the range extends as far below 0 and
+ * above 11.
+ *
  * Returns INT_MIN if tc is invalid.
  */
 extern int tc_get_mpc_value(const struct tonal_class *tc);
@@ -120,8 +123,8 @@ extern int te_inv(struct tonal_element *te);
 /*
  * Subtract Tonal Elements
  *
- * te2 := te1 - te0
- * Definition of subtraction: te1 - te0 == te1 + te_inv(te0)
+ * te2 := te0 - te1
+ * Definition of subtraction: te0 - te1 == te0 + te_inv(te1)
  */
 extern int te_sub(
         const struct tonal_element *te0,
@@ -181,6 +184,109 @@ extern int te_to_ti(
 /* Pretty print */
 extern int te_print(FILE *stream, const struct tonal_element *te);
 
+/* Reason (TONAL_E_) why tp or ti is invalid, TONAL_E_OK if it is valid. */
+extern int tp_error(const struct tonal_pitch *tp);
+extern int ti_error(const struct tonal_interval *ti);
+
+
+/*
+ * Call statistics (tonal_stats.h)
+ *
+ * The TONAL_STATS_ macros count calls and failures when compiled with
+ * -DTONAL_STATS. Otherwise they expand to nothing and their arguments are not
+ * evaluated.
+ */
+#include <tonal_stats.h>
+
+#ifdef TONAL_STATS
+/* Count one call of a scalar function. */
+extern void tonal_stats_call(int fn);
+/* Count one call of a batch function with n elements. */
+extern void tonal_stats_batch(int fn, size_t n);
+/* Count one failed element with reason error (TONAL_E_). */
+extern void tonal_stats_fail(int fn, int error);
+
+#define TONAL_STATS_ENABLED 1
+#define TONAL_STATS_CALL(fn) tonal_stats_call(fn)
+#define TONAL_STATS_BATCH(fn, n) tonal_stats_batch((fn), (n))
+#define TONAL_STATS_FAIL(fn, error) tonal_stats_fail((fn), (error))
+#else
+#define TONAL_STATS_ENABLED 0
+#define TONAL_STATS_CALL(fn) ((void) 0)
+#define TONAL_STATS_BATCH(fn, n) ((void) 0)
+#define TONAL_STATS_FAIL(fn, error) ((void) 0)
+#endif
+
+/*
+ * With TONAL_STATS_LATENCY, TONAL_STATS_TIMER declares and starts timer t and
+ * TONAL_STATS_ELAPSED records the time since t for function fn.
+ */
+#if defined(TONAL_STATS) && defined(TONAL_STATS_LATENCY)
+/* Monotonic clock in nanoseconds */
+extern unsigned long long tonal_stats_now(void);
+extern void tonal_stats_latency(int fn, unsigned long long ns);
+
+#define TONAL_STATS_TIMER(t) unsigned long long t = tonal_stats_now()
+#define TONAL_STATS_ELAPSED(fn, t) \
+        tonal_stats_latency((fn), tonal_stats_now() - (t))
+#else
+#define TONAL_STATS_TIMER(t) ((void) 0)
+#define TONAL_STATS_ELAPSED(fn, t) ((void) 0)
+#endif
+
+
+/*
+ * Static tracepoints
+ *
+ * Compiled with -DTONAL_USDT, TONAL_PROBE places a USDT probe (sys/sdt.h) in
+ * provider "tonal". A probe is a single nop until a tracer such as perf or
+ * bpftrace attaches to it. Otherwise the macros expand to nothing.
+ */
+#ifdef TONAL_USDT
+#include <sys/sdt.h>
+
+#define TONAL_USDT_ENABLED 1
+#define TONAL_PROBE1(name, a) DTRACE_PROBE1(tonal, name, a)
+#define TONAL_PROBE2(name, a, b) DTRACE_PROBE2(tonal, name, a, b)
+#else
+#define TONAL_USDT_ENABLED 0
+#define TONAL_PROBE1(name, a) ((void) 0)
+#define TONAL_PROBE2(name, a, b) ((void) 0)
+#endif
+
+
+/*
+ * Failure recording
+ *
+ * TONAL_FAILED counts a failure of function fn (TONAL_STATS_) with reason
+ * error (TONAL_E_) and fires the "fail" probe. Since the reason is only worked
+ * out when it is recorded, call sites test TONAL_RECORD_FAILURES before
+ * computing it for nothing.
+ */
+#define TONAL_RECORD_FAILURES (TONAL_STATS_ENABLED || TONAL_USDT_ENABLED)
+
+#if TONAL_RECORD_FAILURES
+#define TONAL_FAILED(fn, error) \
+        do { \
+                int tonal_failed_error_ = (error); \
+                TONAL_STATS_FAIL((fn), tonal_failed_error_); \
+                TONAL_PROBE2(fail, (fn), tonal_failed_error_); \
+        } while (0)
+#else
+#define TONAL_FAILED(fn, error) ((void) 0)
+#endif
+
+
+/*
+ * Files
+ *
+ * tonal_map_file() maps the file at path read-only into memory, for one
+ * sequential pass. An empty file gives an empty document. Release it with
+ * tonal_unmap_file().
+ */
+extern int tonal_map_file(const char *path, const char **doc, size_t *size);
+extern void tonal_unmap_file(const char *doc, size_t size);
+
 
 #endif
 
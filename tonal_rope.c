@@ -0,0 +1,465 @@
+/*
+ * Copyright 2016 Martin Aberg
+ *
+ * This file is part of tonal.
+ *
+ * tonal is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * tonal is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Pitch rope, see tonal_rope.h.
+ *
+ * There is always at least one chunk, empty only if the rope is. Edits which
+ * add or remove chunks rebuild the Fenwick tree, O(chunks), other edits add
+ * their difference to it. Tree counts are size_t and differences wrap, which
+ * sums correctly.
+ */
+
+#include <assert.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <tonal_rope.h>
+#include "tonal_priv.h"
+
+#define CHUNK_MAX 512
+/* Neighbours which fit in this many together are merged. */
+#define MERGE_MAX (CHUNK_MAX / 2)
+
+struct tonal_rope_chunk {
+        size_t n;
+        size_t hist[12];
+        unsigned char pc[CHUNK_MAX];
+        struct tonal_pitch tp[CHUNK_MAX];
+};
+
+struct tonal_rope_node {
+        size_t count;
+        size_t hist[12];
+};
+
+static int pitch_class(const struct tonal_pitch *tp, unsigned char *pc)
+{
+        int mnn;
+
+        mnn = tp_to_mnn(tp);
+        if (INT_MIN == mnn) { return TONAL_FAIL; }
+        *pc = (mnn % 12 + 12) % 12;
+        return TONAL_OK;
+}
+
+static void node_add(struct tonal_rope_node *dst, const struct tonal_rope_node *src)
+{
+        dst->count += src->count;
+        for (int i = 0; i < 12; i++) { dst->hist[i] += src->hist[i]; }
+}
+
+static void rebuild(struct tonal_rope *r)
+{
+        struct tonal_rope_node *t = r->tree;
+        size_t parent;
+
+        for (size_t k = 1; k <= r->nchunks; k++) {
+                t[k].count = r->chunk[k - 1]->n;
+                memcpy(t[k].hist, r->chunk[k - 1]->hist, sizeof t[k].hist);
+        }
+        for (size_t k = 1; k <= r->nchunks; k++) {
+                parent = k + (k & -k);
+                if (parent <= r->nchunks) { node_add(&t[parent], &t[k]); }
+        }
+}
+
+/* Add d to chunk i in the tree. */
+static void tree_apply(struct tonal_rope *r, size_t i, const struct tonal_rope_node *d)
+{
+        for (size_t k = i + 1; k <= r->nchunks; k += k & -k) {
+                node_add(&r->tree[k], d);
+        }
+}
+
+/* Sum of the chunks before chunk i */
+static void tree_prefix(const struct tonal_rope *r, size_t i, struct tonal_rope_node *sum)
+{
+        memset(sum, 0, sizeof *sum);
+        for (size_t k = i; k; k -= k & -k) { node_add(sum, &r->tree[k]); }
+}
+
+/* Chunk and offset of position pos, the end of the last chunk for r->size */
+static void locate(const struct tonal_rope *r, size_t pos, size_t *ci, size_t *off)
+{
+        size_t step;
+        size_t k;
+
+        if (pos == r->size) {
+                *ci = r->nchunks - 1;
+                *off = r->chunk[*ci]->n;
+                return;
+        }
+        for (step = 1; step <= r->nchunks / 2; step *= 2) { }
+        k = 0;
+        for (; step; step /= 2) {
+                if (k + step <= r->nchunks && r->tree[k + step].count <= pos) {
+                        k += step;
+                        pos -= r->tree[k].count;
+                }
+        }
+        *ci = k;
+        *off = pos;
+}
+
+/* Make room for n more chunks. */
+static int reserve(struct tonal_rope *r, size_t n)
+{
+        struct tonal_rope_chunk **chunk;
+        struct tonal_rope_node *tree;
+        size_t max;
+
+        if (r->nchunks + n <= r->max) { return TONAL_OK; }
+        max = r->max ? 2 * r->max : 16;
+        while (max < r->nchunks + n) { max *= 2; }
+        chunk = realloc(r->chunk, max * sizeof *chunk);
+        if (NULL == chunk) { return TONAL_FAIL; }
+        r->chunk = chunk;
+        tree = realloc(r->tree, (max + 1) * sizeof *tree);
+        if (NULL == tree) { return TONAL_FAIL; }
+        r->tree = tree;
+        r->max = max;
+        return TONAL_OK;
+}
+
+static struct tonal_rope_chunk *new_chunk(void)
+{
+        struct tonal_rope_chunk *c;
+
+        c = malloc(sizeof *c);
+        if (NULL == c) { return NULL; }
+        c->n = 0;
+        memset(c->hist, 0, sizeof c->hist);
+        return c;
+}
+
+/* Put the empty chunk c at index i, in room made by reserve(). */
+static void add_chunk(struct tonal_rope *r, size_t i, struct tonal_rope_chunk *c)
+{
+        memmove(&r->chunk[i + 1], &r->chunk[i], (r->nchunks - i) * sizeof *r->chunk);
+        r->chunk[i] = c;
+        r->nchunks++;
+}
+
+static void remove_chunk(struct tonal_rope *r, size_t i)
+{
+        free(r->chunk[i]);
+        r->nchunks--;
+        memmove(&r->chunk[i], &r->chunk[i + 1], (r->nchunks - i) * sizeof *r->chunk);
+}
+
+/* Move pitches off to the end of chunk i to the empty chunk next after it. */
+static void split(
+        struct tonal_rope *r,
+        size_t i,
+        size_t off,
+        struct tonal_rope_chunk *next
+)
+{
+        struct tonal_rope_chunk *c;
+        size_t k;
+
+        add_chunk(r, i + 1, next);
+        c = r->chunk[i];
+        k = c->n - off;
+        memcpy(next->tp, c->tp + off, k * sizeof *c->tp);
+        memcpy(next->pc, c->pc + off, k);
+        for (size_t j = 0; j < k; j++) {
+                c->hist[next->pc[j]]--;
+                next->hist[next->pc[j]]++;
+        }
+        c->n = off;
+        next->n = k;
+}
+
+/* Append chunk i + 1 to chunk i. */
+static void merge(struct tonal_rope *r, size_t i)
+{
+        struct tonal_rope_chunk *c = r->chunk[i];
+        struct tonal_rope_chunk *next = r->chunk[i + 1];
+
+        memcpy(c->tp + c->n, next->tp, next->n * sizeof *c->tp);
+        memcpy(c->pc + c->n, next->pc, next->n);
+        for (int j = 0; j < 12; j++) { c->hist[j] += next->hist[j]; }
+        c->n += next->n;
+        remove_chunk(r, i + 1);
+}
+
+int tonal_rope_init(struct tonal_rope *r)
+{
+        struct tonal_rope_chunk *c;
+        int ret;
+
+        if (NULL == r) { return TONAL_FAIL; }
+
+        memset(r, 0, sizeof *r);
+        ret = reserve(r, 1);
+        c = TONAL_OK == ret ? new_chunk() : NULL;
+        if (NULL == c) {
+                tonal_rope_free(r);
+                return TONAL_FAIL;
+        }
+        add_chunk(r, 0, c);
+        rebuild(r);
+        return TONAL_OK;
+}
+
+void tonal_rope_free(struct tonal_rope *r)
+{
+        if (NULL == r) { return; }
+
+        for (size_t i = 0; i < r->nchunks; i++) { free(r->chunk[i]); }
+        free(r->chunk);
+        free(r->tree);
+        memset(r, 0, sizeof *r);
+}
+
+int tonal_rope_insert(
+        struct tonal_rope *r,
+        size_t pos,
+        const struct tonal_pitch *tp,
+        size_t n
+)
+{
+        struct tonal_rope_node d;
+        struct tonal_rope_chunk *c;
+        struct tonal_rope_chunk **spare;
+        unsigned char pc;
+        int resized = 0;
+        size_t nspare;
+        size_t used = 0;
+        size_t ci;
+        size_t off;
+        size_t k;
+        int ret;
+
+        if (NULL == r || NULL == r->chunk || r->size < pos) { return TONAL_FAIL; }
+        if (NULL == tp && n) { return TONAL_FAIL; }
+        if (0 == n) { return TONAL_OK; }
+        /* All or nothing: check the pitches and allocate before copying. */
+        for (size_t i = 0; i < n; i++) {
+                ret = pitch_class(&tp[i], &pc);
+                if (TONAL_OK != ret) { return ret; }
+        }
+        /* One chunk to split the one at pos, and one per CHUNK_MAX pitches */
+        nspare = (n + CHUNK_MAX - 1) / CHUNK_MAX + 1;
+        ret = reserve(r, nspare);
+        if (TONAL_OK != ret) { return ret; }
+        spare = malloc(nspare * sizeof *spare);
+        if (NULL == spare) { return TONAL_FAIL; }
+        for (size_t i = 0; i < nspare; i++) {
+                spare[i] = new_chunk();
+                if (NULL != spare[i]) { continue; }
+                while (i--) { free(spare[i]); }
+                free(spare);
+                return TONAL_FAIL;
+        }
+
+        locate(r, pos, &ci, &off);
+        while (n) {
+                c = r->chunk[ci];
+                if (CHUNK_MAX == c->n) {
+                        assert(used < nspare);
+                        if (CHUNK_MAX == off) {
+                                add_chunk(r, ci + 1, spare[used++]);
+                                ci++;
+                                off = 0;
+                        } else {
+                                split(r, ci, off, spare[used++]);
+                        }
+                        resized = 1;
+                        continue;
+                }
+
+                k = CHUNK_MAX - c->n < n ? CHUNK_MAX - c->n : n;
+                memmove(c->tp + off + k, c->tp + off, (c->n - off) * sizeof *c->tp);
+                memmove(c->pc + off + k, c->pc + off, c->n - off);
+                memset(&d, 0, sizeof d);
+                for (size_t j = 0; j < k; j++) {
+                        c->tp[off + j] = tp[j];
+                        pitch_class(&tp[j], &c->pc[off + j]);
+                        c->hist[c->pc[off + j]]++;
+                        d.hist[c->pc[off + j]]++;
+                }
+                c->n += k;
+                d.count = k;
+                if (!resized) { tree_apply(r, ci, &d); }
+                r->size += k;
+                off += k;
+                tp += k;
+                n -= k;
+        }
+        while (used < nspare) { free(spare[used++]); }
+        free(spare);
+        if (resized) { rebuild(r); }
+        return TONAL_OK;
+}
+
+int tonal_rope_erase(struct tonal_rope *r, size_t pos, size_t n)
+{
+        struct tonal_rope_node d;
+        struct tonal_rope_chunk *c;
+        int resized = 0;
+        size_t ci;
+        size_t ci0;
+        size_t off;
+        size_t k;
+
+        if (NULL == r || NULL == r->chunk) { return TONAL_FAIL; }
+        if (r->size < pos || r->size - pos < n) { return TONAL_FAIL; }
+        if (0 == n) { return TONAL_OK; }
+
+        locate(r, pos, &ci, &off);
+        ci0 = ci;
+        while (n) {
+                c = r->chunk[ci];
+                k = c->n - off < n ? c->n - off : n;
+                memset(&d, 0, sizeof d);
+                for (size_t j = off; j < off + k; j++) {
+                        c->hist[c->pc[j]]--;
+                        d.hist[c->pc[j]]--;
+                }
+                memmove(c->tp + off, c->tp + off + k, (c->n - off - k) * sizeof *c->tp);
+                memmove(c->pc + off, c->pc + off + k, c->n - off - k);
+                c->n -= k;
+                d.count = -k;
+                if (!resized) { tree_apply(r, ci, &d); }
+                r->size -= k;
+                n -= k;
+                if (0 == c->n && 1 < r->nchunks) {
+                        remove_chunk(r, ci);
+                        resized = 1;
+                } else {
+                        ci++;
+                }
+                off = 0;
+        }
+
+        /* Keep the chunks from getting small around the edit. */
+        if (0 < ci0) { ci0--; }
+        for (size_t i = ci0; i < ci0 + 2 && i + 1 < r->nchunks; i++) {
+                if (r->chunk[i]->n + r->chunk[i + 1]->n <= MERGE_MAX) {
+                        merge(r, i);
+                        resized = 1;
+                }
+        }
+        if (resized) { rebuild(r); }
+        return TONAL_OK;
+}
+
+int tonal_rope_set(
+        struct tonal_rope *r,
+        size_t pos,
+        const struct tonal_pitch *tp
+)
+{
+        struct tonal_rope_node d;
+        struct tonal_rope_chunk *c;
+        unsigned char pc;
+        size_t ci;
+        size_t off;
+        int ret;
+
+        if (NULL == r || NULL == r->chunk || NULL == tp || r->size <= pos) {
+                return TONAL_FAIL;
+        }
+        ret = pitch_class(tp, &pc);
+        if (TONAL_OK != ret) { return ret; }
+
+        locate(r, pos, &ci, &off);
+        c = r->chunk[ci];
+        memset(&d, 0, sizeof d);
+        c->hist[c->pc[off]]--;
+        d.hist[c->pc[off]]--;
+        c->hist[pc]++;
+        d.hist[pc]++;
+        c->pc[off] = pc;
+        c->tp[off] = *tp;
+        tree_apply(r, ci, &d);
+        return TONAL_OK;
+}
+
+int tonal_rope_get(
+        const struct tonal_rope *r,
+        size_t pos,
+        struct tonal_pitch *tp,
+        size_t n
+)
+{
+        const struct tonal_rope_chunk *c;
+        size_t ci;
+        size_t off;
+        size_t k;
+
+        if (NULL == r || NULL == r->chunk || (NULL == tp && n)) {
+                return TONAL_FAIL;
+        }
+        if (r->size < pos || r->size - pos < n) { return TONAL_FAIL; }
+        if (0 == n) { return TONAL_OK; }
+
+        locate(r, pos, &ci, &off);
+        for (; n; ci++, off = 0) {
+                c = r->chunk[ci];
+                k = c->n - off < n ? c->n - off : n;
+                memcpy(tp, c->tp + off, k * sizeof *tp);
+                tp += k;
+                n -= k;
+        }
+        return TONAL_OK;
+}
+
+/* Histogram of positions 0 to pos, sign 1 to add it to hist, -1 to subtract */
+static void prefix_histogram(const struct tonal_rope *r, size_t pos, size_t *hist, int sign)
+{
+        const struct tonal_rope_chunk *c;
+        struct tonal_rope_node sum;
+        size_t ci;
+        size_t off;
+
+        locate(r, pos, &ci, &off);
+        c = r->chunk[ci];
+        /* Scan the shorter part of the chunk. */
+        if (off <= c->n / 2) {
+                tree_prefix(r, ci, &sum);
+                for (size_t j = 0; j < off; j++) { sum.hist[c->pc[j]]++; }
+        } else {
+                tree_prefix(r, ci + 1, &sum);
+                for (size_t j = off; j < c->n; j++) { sum.hist[c->pc[j]]--; }
+        }
+        for (int i = 0; i < 12; i++) {
+                hist[i] += 0 < sign ? sum.hist[i] : -sum.hist[i];
+        }
+}
+
+int tonal_rope_histogram(
+        const struct tonal_rope *r,
+        size_t begin,
+        size_t end,
+        size_t hist[12]
+)
+{
+        if (NULL == r || NULL == r->chunk || NULL == hist) { return TONAL_FAIL; }
+        if (end < begin || r->size < end) { return TONAL_FAIL; }
+
+        memset(hist, 0, 12 * sizeof *hist);
+        prefix_histogram(r, end, hist, 1);
+        prefix_histogram(r, begin, hist, -1);
+        return TONAL_OK;
+}
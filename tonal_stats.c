@@ -0,0 +1,390 @@
+/*
+ * Copyright 2016 Martin Aberg
+ *
+ * This file is part of tonal.
+ *
+ * tonal is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * tonal is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Call statistics, see tonal_stats.h.
+ *
+ * Each thread counts into its own block, allocated and registered on the
+ * first counted call. Only the owning thread writes a block, with relaxed
+ * atomic stores so that tonal_stats_snapshot() can read it at any time. The
+ * blocks are cache line aligned and padded so that threads never share a
+ * line. When a thread exits, its counts are moved to the retired totals.
+ */
+
+#ifdef TONAL_STATS
+#define _POSIX_C_SOURCE 200112L
+#include <pthread.h>
+#include <stdlib.h>
+#include <time.h>
+#endif
+#include <string.h>
+
+#include <tonal_stats.h>
+#include "tonal_priv.h"
+
+const char *const tonal_stats_fn_str[] = {
+        "tp_add", "ti_add", "tp_sub", "ti_sub", "tp_to_mnn",
+        "tp_add_n", "tp_transpose_n", "tp_sub_n", "tp_to_mnn_n",
+        "tonal_musicxml_scan", "tonal_kern_scan", "tonal_abc_scan",
+        "tonal_abc_read_book", "tonal_consonance_n",
+        "NONE"
+};
+
+/* JSON keys for the failure reasons, indexed by TONAL_E_. */
+static const char *const ERROR_KEY[] = {
+        "ok", "fail", "null", "diatonic", "alteration", "octave",
+        "quality", "direction", "range"
+};
+
+enum {
+        SUB = TONAL_STATS_LATENCY_SUB,
+        NSUB = 1 << TONAL_STATS_LATENCY_SUB
+};
+
+/*
+ * Values below NSUB have a bucket each. Above, the bucket is given by the
+ * position of the highest set bit and the SUB bits below it.
+ */
+static inline int latency_bucket(unsigned long long ns)
+{
+        int e;
+
+        if (ns < NSUB) { return (int) ns; }
+        for (e = SUB; e < 63 && (ns >> (e + 1)); e++) {
+                ;
+        }
+        if (TONAL_STATS_LATENCY_BUCKETS <= ((e - SUB + 1) << SUB)) {
+                return TONAL_STATS_LATENCY_BUCKETS - 1;
+        }
+        return ((e - SUB + 1) << SUB) + (int) (ns >> (e - SUB)) - NSUB;
+}
+
+/* Largest value of bucket b */
+static unsigned long long latency_bucket_max(int b)
+{
+        int shift;
+
+        if (b < NSUB) { return b; }
+        shift = (b >> SUB) - 1;
+        return ((unsigned long long) (NSUB + (b & (NSUB - 1))) << shift) +
+                (1ULL << shift) - 1;
+}
+
+#ifdef TONAL_STATS
+
+#define CACHE_LINE 64
+
+struct stats_thread {
+        struct tonal_stats stats;
+        struct stats_thread *next;
+        struct stats_thread **prevp;
+        /* Pad to a whole number of cache lines. */
+        char pad[
+                CACHE_LINE - (
+                        sizeof (struct tonal_stats) +
+                        2 * sizeof (void *)
+                ) % CACHE_LINE
+        ];
+};
+
+static pthread_mutex_t stats_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t stats_once = PTHREAD_ONCE_INIT;
+static pthread_key_t stats_key;
+/* Blocks of running threads, protected by stats_lock */
+static struct stats_thread *stats_threads;
+/* Counts of exited threads, protected by stats_lock */
+static struct tonal_stats stats_retired;
+static __thread struct stats_thread *stats_self;
+
+static void stats_add(struct tonal_stats *sum, const struct tonal_stats *s)
+{
+        const unsigned long long *src = (const unsigned long long *) s;
+        unsigned long long *dst = (unsigned long long *) sum;
+
+        for (size_t i = 0; i < sizeof *s / sizeof *src; i++) {
+                dst[i] += __atomic_load_n(&src[i], __ATOMIC_RELAXED);
+        }
+}
+
+/*
+ * Runs on the exiting thread. A counted call from a later destructor of the
+ * thread then starts a new block, which pthread retires on its next round of
+ * destructors, instead of counting into the freed one.
+ */
+static void stats_thread_exit(void *arg)
+{
+        struct stats_thread *self = arg;
+
+        stats_self = NULL;
+        pthread_mutex_lock(&stats_lock);
+        stats_add(&stats_retired, &self->stats);
+        *self->prevp = self->next;
+        if (self->next) { self->next->prevp = self->prevp; }
+        pthread_mutex_unlock(&stats_lock);
+        free(self);
+}
+
+static void stats_init(void)
+{
+        pthread_key_create(&stats_key, stats_thread_exit);
+}
+
+static struct stats_thread *stats_thread_new(void)
+{
+        struct stats_thread *self;
+
+        pthread_once(&stats_once, stats_init);
+        if (0 != posix_memalign((void **) &self, CACHE_LINE, sizeof *self)) {
+                return NULL;
+        }
+        memset(self, 0, sizeof *self);
+
+        pthread_mutex_lock(&stats_lock);
+        self->next = stats_threads;
+        self->prevp = &stats_threads;
+        if (stats_threads) { stats_threads->prevp = &self->next; }
+        stats_threads = self;
+        pthread_mutex_unlock(&stats_lock);
+
+        pthread_setspecific(stats_key, self);
+        stats_self = self;
+        return self;
+}
+
+static inline struct tonal_stats_fn *stats_fn(int fn)
+{
+        struct stats_thread *self = stats_self;
+
+        if (NULL == self) {
+                self = stats_thread_new();
+                if (NULL == self) { return NULL; }
+        }
+        return &self->stats.fn[fn];
+}
+
+/* Only the owning thread writes, so a plain read is enough. */
+static inline void bump(unsigned long long *c, unsigned long long n)
+{
+        __atomic_store_n(c, *c + n, __ATOMIC_RELAXED);
+}
+
+void tonal_stats_call(int fn)
+{
+        struct tonal_stats_fn *s = stats_fn(fn);
+
+        if (NULL == s) { return; }
+        bump(&s->calls, 1);
+        bump(&s->elements, 1);
+}
+
+void tonal_stats_batch(int fn, size_t n)
+{
+        struct tonal_stats_fn *s = stats_fn(fn);
+        int b;
+
+        if (NULL == s) { return; }
+        for (b = 0; b < TONAL_STATS_BATCH_BUCKETS - 1 && (n >> b); b++) {
+                ;
+        }
+        bump(&s->calls, 1);
+        bump(&s->elements, n);
+        bump(&s->batch[b], 1);
+}
+
+void tonal_stats_fail(int fn, int error)
+{
+        struct tonal_stats_fn *s = stats_fn(fn);
+
+        if (NULL == s) { return; }
+        if (error <= TONAL_E_OK || TONAL_E_NONE <= error) {
+                error = TONAL_E_FAIL;
+        }
+        bump(&s->failures[error], 1);
+}
+
+#ifdef TONAL_STATS_LATENCY
+unsigned long long tonal_stats_now(void)
+{
+        struct timespec ts;
+
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (unsigned long long) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+void tonal_stats_latency(int fn, unsigned long long ns)
+{
+        struct tonal_stats_fn *s = stats_fn(fn);
+
+        if (NULL == s) { return; }
+        bump(&s->latency[latency_bucket(ns)], 1);
+}
+#endif
+
+int tonal_stats_snapshot(struct tonal_stats *stats)
+{
+        struct stats_thread *t;
+
+        if (NULL == stats) { return TONAL_FAIL; }
+
+        memset(stats, 0, sizeof *stats);
+        pthread_mutex_lock(&stats_lock);
+        stats_add(stats, &stats_retired);
+        for (t = stats_threads; t; t = t->next) {
+                stats_add(stats, &t->stats);
+        }
+        pthread_mutex_unlock(&stats_lock);
+        return TONAL_OK;
+}
+
+#else
+
+int tonal_stats_snapshot(struct tonal_stats *stats)
+{
+        if (stats) { memset(stats, 0, sizeof *stats); }
+        return TONAL_FAIL;
+}
+
+#endif
+
+unsigned long long tonal_stats_percentile(
+        const struct tonal_stats_fn *fn,
+        double q
+)
+{
+        unsigned long long total = 0;
+        unsigned long long rank;
+        unsigned long long n = 0;
+
+        if (NULL == fn) { return 0; }
+        for (int b = 0; b < TONAL_STATS_LATENCY_BUCKETS; b++) {
+                total += fn->latency[b];
+        }
+        if (0 == total) { return 0; }
+
+        if (q < 0) { q = 0; }
+        if (1 < q) { q = 1; }
+        rank = (unsigned long long) (q * total + 0.5);
+        if (0 == rank) { rank = 1; }
+        for (int b = 0; b < TONAL_STATS_LATENCY_BUCKETS; b++) {
+                n += fn->latency[b];
+                if (rank <= n) { return latency_bucket_max(b); }
+        }
+        return latency_bucket_max(TONAL_STATS_LATENCY_BUCKETS - 1);
+}
+
+static unsigned long long fn_failures(const struct tonal_stats_fn *s)
+{
+        unsigned long long n = 0;
+
+        for (int e = TONAL_E_FAIL; e < TONAL_E_NONE; e++) {
+                n += s->failures[e];
+        }
+        return n;
+}
+
+int tonal_stats_print(FILE *stream, const struct tonal_stats *stats)
+{
+        int ret = 0;
+
+        if (NULL == stream || NULL == stats) { return TONAL_FAIL; }
+
+        for (int fn = 0; fn < TONAL_STATS_NONE; fn++) {
+                const struct tonal_stats_fn *s = &stats->fn[fn];
+
+                if (0 == s->calls) { continue; }
+                ret |= fprintf(
+                        stream,
+                        "%-16s calls %llu  elements %llu  failures %llu",
+                        tonal_stats_fn_str[fn],
+                        s->calls,
+                        s->elements,
+                        fn_failures(s)
+                ) < 0;
+                for (int e = TONAL_E_FAIL; e < TONAL_E_NONE; e++) {
+                        if (0 == s->failures[e]) { continue; }
+                        ret |= fprintf(
+                                stream,
+                                "  %s %llu",
+                                ERROR_KEY[e],
+                                s->failures[e]
+                        ) < 0;
+                }
+                if (tonal_stats_percentile(s, 1)) {
+                        ret |= fprintf(
+                                stream,
+                                "  p50 %lluns  p99 %lluns  p999 %lluns",
+                                tonal_stats_percentile(s, 0.5),
+                                tonal_stats_percentile(s, 0.99),
+                                tonal_stats_percentile(s, 0.999)
+                        ) < 0;
+                }
+                ret |= fprintf(stream, "\n") < 0;
+        }
+        return ret ? TONAL_FAIL : TONAL_OK;
+}
+
+int tonal_stats_print_json(FILE *stream, const struct tonal_stats *stats)
+{
+        int ret = 0;
+
+        if (NULL == stream || NULL == stats) { return TONAL_FAIL; }
+
+        ret |= fprintf(stream, "{") < 0;
+        for (int fn = 0; fn < TONAL_STATS_NONE; fn++) {
+                const struct tonal_stats_fn *s = &stats->fn[fn];
+
+                ret |= fprintf(
+                        stream,
+                        "%s\"%s\":{\"calls\":%llu,\"elements\":%llu,"
+                        "\"failures\":{",
+                        fn ? "," : "",
+                        tonal_stats_fn_str[fn],
+                        s->calls,
+                        s->elements
+                ) < 0;
+                for (int e = TONAL_E_FAIL; e < TONAL_E_NONE; e++) {
+                        ret |= fprintf(
+                                stream,
+                                "%s\"%s\":%llu",
+                                TONAL_E_FAIL == e ? "" : ",",
+                                ERROR_KEY[e],
+                                s->failures[e]
+                        ) < 0;
+                }
+                ret |= fprintf(stream, "},\"batch\":[") < 0;
+                for (int b = 0; b < TONAL_STATS_BATCH_BUCKETS; b++) {
+                        ret |= fprintf(
+                                stream,
+                                "%s%llu",
+                                b ? "," : "",
+                                s->batch[b]
+                        ) < 0;
+                }
+                ret |= fprintf(
+                        stream,
+                        "],\"latency_ns\":{\"p50\":%llu,\"p99\":%llu,"
+                        "\"p999\":%llu}}",
+                        tonal_stats_percentile(s, 0.5),
+                        tonal_stats_percentile(s, 0.99),
+                        tonal_stats_percentile(s, 0.999)
+                ) < 0;
+        }
+        ret |= fprintf(stream, "}\n") < 0;
+        return ret ? TONAL_FAIL : TONAL_OK;
+}
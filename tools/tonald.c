@@ -0,0 +1,543 @@
+/*
+ * Copyright 2016 Martin Aberg
+ *
+ * This file is part of tonal.
+ *
+ * tonal is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * tonal is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * tonald - serve tonal over a Unix domain socket
+ *
+ *   $ ./tonald [socket]
+ *
+ * Serves the protocol of tonald.h to any number of clients from one thread
+ * with epoll. The requests which arrive in one round of events are gathered
+ * per operation, from all clients, and handed to one batch function call
+ * (tp_add_n(), tp_sub_n(), tp_to_mnn_n()) each. The responses are then
+ * scattered back to the output buffers of the clients.
+ *
+ * The tonal tables are compiled in, so the saving over calling the library
+ * in each worker is process start and the per call overhead, not table
+ * construction.
+ *
+ * Stops on SIGINT or SIGTERM, removes the socket and prints the number of
+ * requests and batch calls.
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <limits.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include <tonal.h>
+#include "tonald.h"
+
+#define MAX_EVENTS 256
+/* Read at most this much per client and round */
+#define READ_SIZE (64 * 1024)
+/* Stop reading from a client with this much output not yet sent */
+#define OUT_LIMIT (4 * 1024 * 1024)
+
+struct client {
+        int fd;
+        /* Received, not yet a whole request */
+        char *in;
+        size_t in_len;
+        size_t in_max;
+        /* Responses, sent from out_pos */
+        char *out;
+        size_t out_pos;
+        size_t out_len;
+        size_t out_max;
+        /* Events polled for */
+        uint32_t events;
+        /* Sent all requests, close when the responses are out */
+        int eof;
+        /* Failed or broke the protocol, close after this round */
+        int closing;
+        /* On the list of clients to flush this round */
+        int dirty;
+        struct client *next_dirty;
+};
+
+/* Requests of one client in a batch: results go to out at off. */
+struct span {
+        struct client *c;
+        size_t off;
+        size_t first;
+        size_t n;
+};
+
+/* Requests of one operation gathered in a round */
+struct batch {
+        struct tonald_item *item;
+        size_t n;
+        size_t max;
+        struct span *span;
+        size_t nspans;
+        size_t spans_max;
+};
+
+/* Arguments and results of the batch functions */
+struct scratch {
+        struct tonal_pitch *tp0;
+        struct tonal_pitch *tp1;
+        struct tonal_interval *ti;
+        struct tonal_pitch *tp_out;
+        struct tonal_interval *ti_out;
+        int *mnn;
+        int *status;
+        size_t max;
+};
+
+static volatile sig_atomic_t stop;
+static int ep;
+static struct batch batch[TONALD_NONE];
+static struct scratch scratch;
+static struct client *dirty;
+static unsigned long long nrequests;
+static unsigned long long nitems;
+static unsigned long long ncalls;
+
+static void on_signal(int sig)
+{
+        (void) sig;
+        stop = 1;
+}
+
+/* Make room for need elements of size at *p. */
+static int grow(void *p, size_t *max, size_t need, size_t size)
+{
+        void **pp = p;
+        void *q;
+        size_t m;
+
+        if (need <= *max) { return TONAL_OK; }
+        m = *max ? *max : 64;
+        while (m < need) { m *= 2; }
+        q = realloc(*pp, m * size);
+        if (NULL == q) { return TONAL_FAIL; }
+        *pp = q;
+        *max = m;
+        return TONAL_OK;
+}
+
+static void mark_dirty(struct client *c)
+{
+        if (c->dirty) { return; }
+        c->dirty = 1;
+        c->next_dirty = dirty;
+        dirty = c;
+}
+
+static void add_client(int fd)
+{
+        struct epoll_event ev;
+        struct client *c;
+
+        c = calloc(1, sizeof *c);
+        if (NULL == c) {
+                close(fd);
+                return;
+        }
+        c->fd = fd;
+        c->events = EPOLLIN;
+        ev.events = c->events;
+        ev.data.ptr = c;
+        if (0 != epoll_ctl(ep, EPOLL_CTL_ADD, fd, &ev)) {
+                close(fd);
+                free(c);
+        }
+}
+
+static void drop_client(struct client *c)
+{
+        epoll_ctl(ep, EPOLL_CTL_DEL, c->fd, NULL);
+        close(c->fd);
+        free(c->in);
+        free(c->out);
+        free(c);
+}
+
+static void accept_clients(int lfd)
+{
+        int fd;
+
+        for (;;) {
+                fd = accept4(lfd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+                if (fd < 0) { return; }
+                add_client(fd);
+        }
+}
+
+/* Queue one request of c: item[0..n) into the batch of op. */
+static int queue(struct client *c, const struct tonald_head *head, const char *item)
+{
+        struct batch *b = &batch[head->op];
+        struct span *s;
+        size_t size;
+        int ret;
+
+        ret = grow(&b->item, &b->max, b->n + head->n, sizeof *b->item);
+        if (TONAL_OK != ret) { return ret; }
+        ret = grow(&b->span, &b->spans_max, b->nspans + 1, sizeof *b->span);
+        if (TONAL_OK != ret) { return ret; }
+        size = sizeof *head + head->n * sizeof (struct tonald_result);
+        ret = grow(&c->out, &c->out_max, c->out_len + size, 1);
+        if (TONAL_OK != ret) { return ret; }
+
+        memcpy(&b->item[b->n], item, head->n * sizeof *b->item);
+        memcpy(c->out + c->out_len, head, sizeof *head);
+        s = &b->span[b->nspans++];
+        s->c = c;
+        s->off = c->out_len + sizeof *head;
+        s->first = b->n;
+        s->n = head->n;
+        b->n += head->n;
+        c->out_len += size;
+        nrequests++;
+        return TONAL_OK;
+}
+
+static void read_requests(struct client *c)
+{
+        struct tonald_head head;
+        size_t pos;
+        size_t size;
+        ssize_t len;
+
+        if (TONAL_OK != grow(&c->in, &c->in_max, c->in_len + READ_SIZE, 1)) {
+                c->closing = 1;
+                return;
+        }
+        len = read(c->fd, c->in + c->in_len, READ_SIZE);
+        if (0 == len) { c->eof = 1; }
+        if (len < 0 && EAGAIN != errno && EINTR != errno) { c->closing = 1; }
+        if (len <= 0) { return; }
+        c->in_len += len;
+
+        pos = 0;
+        while (sizeof head <= c->in_len - pos) {
+                memcpy(&head, c->in + pos, sizeof head);
+                if (TONALD_NONE <= head.op || TONALD_MAX < head.n) {
+                        c->closing = 1;
+                        return;
+                }
+                size = sizeof head + head.n * sizeof (struct tonald_item);
+                if (c->in_len - pos < size) { break; }
+                if (TONAL_OK != queue(c, &head, c->in + pos + sizeof head)) {
+                        c->closing = 1;
+                        return;
+                }
+                mark_dirty(c);
+                pos += size;
+        }
+        memmove(c->in, c->in + pos, c->in_len - pos);
+        c->in_len -= pos;
+}
+
+static void get_pitch(struct tonal_pitch *tp, const int32_t *arg)
+{
+        tp->diatonic_pitch = arg[0];
+        tp->pitch_alteration = arg[1];
+        tp->octave = arg[2];
+}
+
+static void get_interval(struct tonal_interval *ti, const int32_t *arg)
+{
+        ti->diatonic_interval = arg[0];
+        ti->interval_alteration = arg[1];
+        ti->octave = arg[2];
+        ti->interval_direction = arg[3];
+}
+
+static int resize(void *p, size_t size)
+{
+        void **pp = p;
+        void *q;
+
+        q = realloc(*pp, size);
+        if (NULL == q) { return TONAL_FAIL; }
+        *pp = q;
+        return TONAL_OK;
+}
+
+static int grow_scratch(size_t need)
+{
+        struct scratch *s = &scratch;
+        size_t max;
+
+        if (need <= s->max) { return TONAL_OK; }
+        max = s->max ? s->max : 64;
+        while (max < need) { max *= 2; }
+        if (
+                TONAL_OK != resize(&s->tp0, max * sizeof *s->tp0) ||
+                TONAL_OK != resize(&s->tp1, max * sizeof *s->tp1) ||
+                TONAL_OK != resize(&s->ti, max * sizeof *s->ti) ||
+                TONAL_OK != resize(&s->tp_out, max * sizeof *s->tp_out) ||
+                TONAL_OK != resize(&s->ti_out, max * sizeof *s->ti_out) ||
+                TONAL_OK != resize(&s->mnn, max * sizeof *s->mnn) ||
+                TONAL_OK != resize(&s->status, max * sizeof *s->status)
+        ) {
+                return TONAL_FAIL;
+        }
+        s->max = max;
+        return TONAL_OK;
+}
+
+/* Run the batch of op with one library call and scatter the results. */
+static int run_batch(int op)
+{
+        struct batch *b = &batch[op];
+        struct scratch *s = &scratch;
+        struct tonald_result r;
+        size_t i;
+
+        if (0 == b->n) { return TONAL_OK; }
+
+        if (TONAL_OK != grow_scratch(b->n)) { return TONAL_FAIL; }
+
+        for (i = 0; i < b->n; i++) {
+                get_pitch(&s->tp0[i], &b->item[i].arg[0]);
+        }
+        switch (op) {
+        case TONALD_ADD:
+                for (i = 0; i < b->n; i++) {
+                        get_interval(&s->ti[i], &b->item[i].arg[3]);
+                }
+                tp_add_n(s->tp0, s->ti, s->tp_out, s->status, b->n);
+                ncalls++;
+                break;
+        case TONALD_SUB:
+                for (i = 0; i < b->n; i++) {
+                        get_pitch(&s->tp1[i], &b->item[i].arg[3]);
+                }
+                tp_sub_n(s->tp0, s->tp1, s->ti_out, s->status, b->n);
+                ncalls++;
+                break;
+        case TONALD_MNN:
+                tp_to_mnn_n(s->tp0, s->mnn, b->n);
+                ncalls++;
+                for (i = 0; i < b->n; i++) {
+                        s->status[i] = INT_MIN == s->mnn[i] ?
+                                TONAL_E_FAIL : TONAL_E_OK;
+                }
+                break;
+        case TONALD_SPELL:
+                /* No batch function, spell one at a time. */
+                for (i = 0; i < b->n; i++) {
+                        s->status[i] = tp_from_mnn(
+                                &s->tp_out[i],
+                                b->item[i].arg[0],
+                                b->item[i].arg[1]
+                        );
+                }
+                break;
+        }
+
+        for (size_t k = 0; k < b->nspans; k++) {
+                const struct span *sp = &b->span[k];
+
+                for (size_t j = 0; j < sp->n; j++) {
+                        i = sp->first + j;
+                        memset(&r, 0, sizeof r);
+                        r.status = s->status[i];
+                        if (TONALD_SUB == op) {
+                                r.val[0] = s->ti_out[i].diatonic_interval;
+                                r.val[1] = s->ti_out[i].interval_alteration;
+                                r.val[2] = s->ti_out[i].octave;
+                                r.val[3] = s->ti_out[i].interval_direction;
+                        } else if (TONALD_MNN == op) {
+                                r.val[0] = s->mnn[i];
+                        } else {
+                                r.val[0] = s->tp_out[i].diatonic_pitch;
+                                r.val[1] = s->tp_out[i].pitch_alteration;
+                                r.val[2] = s->tp_out[i].octave;
+                        }
+                        memcpy(sp->c->out + sp->off + j * sizeof r, &r, sizeof r);
+                }
+        }
+        nitems += b->n;
+        b->n = 0;
+        b->nspans = 0;
+        return TONAL_OK;
+}
+
+static void flush(struct client *c)
+{
+        ssize_t len;
+
+        while (c->out_pos < c->out_len) {
+                len = write(c->fd, c->out + c->out_pos, c->out_len - c->out_pos);
+                if (len < 0) {
+                        if (EINTR == errno) { continue; }
+                        if (EAGAIN != errno) { c->closing = 1; }
+                        break;
+                }
+                c->out_pos += len;
+        }
+        /*
+         * Move what is left to the front, so that the buffer holds only the
+         * unsent responses and does not grow with each partial write. The
+         * batches of this round have been run, so no span points into it.
+         */
+        if (c->out_pos) {
+                memmove(c->out, c->out + c->out_pos, c->out_len - c->out_pos);
+                c->out_len -= c->out_pos;
+                c->out_pos = 0;
+        }
+}
+
+/* Poll for input unless too much output is waiting, and for output if any */
+static void update_events(struct client *c)
+{
+        struct epoll_event ev;
+        size_t pending = c->out_len - c->out_pos;
+        uint32_t events;
+
+        events = (!c->eof && pending <= OUT_LIMIT ? EPOLLIN : 0) |
+                (pending ? EPOLLOUT : 0);
+        if (events == c->events) { return; }
+        ev.events = events;
+        ev.data.ptr = c;
+        if (0 != epoll_ctl(ep, EPOLL_CTL_MOD, c->fd, &ev)) {
+                c->closing = 1;
+                return;
+        }
+        c->events = events;
+}
+
+static int listen_on(const char *path)
+{
+        struct sockaddr_un addr;
+        int fd;
+
+        memset(&addr, 0, sizeof addr);
+        addr.sun_family = AF_UNIX;
+        if (sizeof addr.sun_path <= strlen(path)) {
+                fprintf(stderr, "tonald: socket path too long\n");
+                return -1;
+        }
+        strcpy(addr.sun_path, path);
+        unlink(path);
+
+        fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (fd < 0) {
+                perror("tonald: socket");
+                return -1;
+        }
+        if (
+                0 != bind(fd, (struct sockaddr *) &addr, sizeof addr) ||
+                0 != listen(fd, SOMAXCONN)
+        ) {
+                perror("tonald: bind");
+                close(fd);
+                return -1;
+        }
+        return fd;
+}
+
+int main(int argc, char **argv)
+{
+        static struct epoll_event events[MAX_EVENTS];
+        const char *path = TONALD_SOCKET;
+        struct epoll_event ev;
+        struct sigaction sa;
+        int lfd;
+        int n;
+
+        if (2 < argc) {
+                fprintf(stderr, "usage: tonald [socket]\n");
+                return 2;
+        }
+        if (2 == argc) { path = argv[1]; }
+
+        memset(&sa, 0, sizeof sa);
+        sa.sa_handler = on_signal;
+        sigaction(SIGINT, &sa, NULL);
+        sigaction(SIGTERM, &sa, NULL);
+        signal(SIGPIPE, SIG_IGN);
+
+        lfd = listen_on(path);
+        if (lfd < 0) { return 1; }
+        ep = epoll_create1(EPOLL_CLOEXEC);
+        if (ep < 0) {
+                perror("tonald: epoll_create1");
+                return 1;
+        }
+        ev.events = EPOLLIN;
+        ev.data.ptr = NULL;
+        epoll_ctl(ep, EPOLL_CTL_ADD, lfd, &ev);
+
+        while (!stop) {
+                n = epoll_wait(ep, events, MAX_EVENTS, -1);
+                if (n < 0) {
+                        if (EINTR == errno) { continue; }
+                        perror("tonald: epoll_wait");
+                        break;
+                }
+
+                /* Gather the requests of this round. */
+                for (int i = 0; i < n; i++) {
+                        struct client *c = events[i].data.ptr;
+
+                        if (NULL == c) {
+                                accept_clients(lfd);
+                                continue;
+                        }
+                        if (events[i].events & EPOLLERR) { c->closing = 1; }
+                        if (events[i].events & (EPOLLIN | EPOLLHUP) && !c->eof) {
+                                read_requests(c);
+                        }
+                        mark_dirty(c);
+                }
+
+                /* One batch call per operation */
+                for (int op = 0; op < TONALD_NONE; op++) {
+                        if (TONAL_OK != run_batch(op)) {
+                                fprintf(stderr, "tonald: out of memory\n");
+                                stop = 1;
+                        }
+                }
+
+                while (dirty) {
+                        struct client *c = dirty;
+
+                        dirty = c->next_dirty;
+                        c->dirty = 0;
+                        flush(c);
+                        if (c->eof && 0 == c->out_len) { c->closing = 1; }
+                        if (!c->closing) { update_events(c); }
+                        if (c->closing) { drop_client(c); }
+                }
+        }
+
+        unlink(path);
+        fprintf(
+                stderr,
+                "tonald: %llu requests, %llu items, %llu batch calls\n",
+                nrequests,
+                nitems,
+                ncalls
+        );
+        return 0;
+}
@@ -0,0 +1,73 @@
+/*
+ * Copyright 2016 Martin Aberg
+ *
+ * This file is part of tonal.
+ *
+ * tonal is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * tonal is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * tonald protocol
+ *
+ * A client sends requests on a Unix stream socket and gets one response per
+ * request, in order. Everything is in host byte order: client and server are
+ * on the same host.
+ *
+ * A request is a struct tonald_head followed by n items, a response the same
+ * head followed by n results. Item and result fields by operation:
+ *
+ *   op            arg[0..2]   arg[3..6]   val[0..3]
+ *   TONALD_ADD    pitch       interval    pitch + interval
+ *   TONALD_SUB    pitch       pitch       pitch - pitch, an interval
+ *   TONALD_MNN    pitch       -           MIDI note number, OC_C5
+ *   TONALD_SPELL  mnn, oc     -           pitch
+ *
+ * A pitch is the fields of struct tonal_pitch, an interval those of struct
+ * tonal_interval, in order.
+ *
+ * status is TONAL_E_OK or the reason for the failure. A request with an
+ * unknown op or more than TONALD_MAX items closes the connection.
+ */
+
+#ifndef TONALD_H_
+#define TONALD_H_
+
+#include <stdint.h>
+
+#define TONALD_SOCKET "/tmp/tonald.sock"
+#define TONALD_MAX 65536
+
+enum {
+        TONALD_ADD,
+        TONALD_SUB,
+        TONALD_MNN,
+        TONALD_SPELL,
+        TONALD_NONE
+};
+
+struct tonald_head {
+        uint32_t op;
+        uint32_t n;
+};
+
+struct tonald_item {
+        int32_t arg[7];
+};
+
+struct tonald_result {
+        int32_t status;
+        int32_t val[4];
+};
+
+#endif
@@ -0,0 +1,335 @@
+/*
+ * Copyright 2016 Martin Aberg
+ *
+ * This file is part of tonal.
+ *
+ * tonal is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * tonal is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Load generator for tonald
+ *
+ *   $ ./tonald_bench [-s socket] [-c clients] [-t threads] [-n items]
+ *                    [-d seconds]
+ *
+ * Opens clients connections, spread over threads threads. Each thread sends
+ * one TONALD_ADD request of items items on each of its connections, then
+ * waits for all the responses, and repeats for the duration. Every response
+ * is compared with the result of tp_add_n() in the client. Prints the
+ * throughput and the request latency percentiles.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include <tonal.h>
+#include "tonald.h"
+
+struct worker {
+        pthread_t thread;
+        int nclients;
+        int *fd;
+        /* Latencies (ns) of the requests */
+        unsigned long long *lat;
+        size_t nlat;
+        size_t max;
+        unsigned long long errors;
+};
+
+static const char *path = TONALD_SOCKET;
+static int nitems = 16;
+static double seconds = 5;
+static char *request;
+static size_t request_size;
+static char *expected;
+static size_t expected_size;
+
+static unsigned long long now(void)
+{
+        struct timespec ts;
+
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static int connect_to(const char *path)
+{
+        struct sockaddr_un addr;
+        int fd;
+
+        memset(&addr, 0, sizeof addr);
+        addr.sun_family = AF_UNIX;
+        strncpy(addr.sun_path, path, sizeof addr.sun_path - 1);
+        fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0) { return -1; }
+        if (0 != connect(fd, (struct sockaddr *) &addr, sizeof addr)) {
+                close(fd);
+                return -1;
+        }
+        return fd;
+}
+
+static int write_all(int fd, const char *buf, size_t size)
+{
+        ssize_t len;
+
+        while (size) {
+                len = write(fd, buf, size);
+                if (len <= 0) { return TONAL_FAIL; }
+                buf += len;
+                size -= len;
+        }
+        return TONAL_OK;
+}
+
+static int read_all(int fd, char *buf, size_t size)
+{
+        ssize_t len;
+
+        while (size) {
+                len = read(fd, buf, size);
+                if (len <= 0) { return TONAL_FAIL; }
+                buf += len;
+                size -= len;
+        }
+        return TONAL_OK;
+}
+
+/* The request all clients send, and its response computed here */
+static int make_request(void)
+{
+        struct tonald_head head = { TONALD_ADD, nitems };
+        struct tonald_item *item;
+        struct tonald_result *result;
+        struct tonal_pitch *tp;
+        struct tonal_interval *ti;
+        struct tonal_pitch *sum;
+        int *status;
+        int ret;
+
+        request_size = sizeof head + nitems * sizeof *item;
+        expected_size = sizeof head + nitems * sizeof *result;
+        request = calloc(1, request_size);
+        expected = calloc(1, expected_size);
+        tp = calloc(nitems, sizeof *tp);
+        ti = calloc(nitems, sizeof *ti);
+        sum = calloc(nitems, sizeof *sum);
+        status = calloc(nitems, sizeof *status);
+        if (!request || !expected || !tp || !ti || !sum || !status) {
+                return TONAL_FAIL;
+        }
+
+        memcpy(request, &head, sizeof head);
+        memcpy(expected, &head, sizeof head);
+        item = (struct tonald_item *) (request + sizeof head);
+        result = (struct tonald_result *) (expected + sizeof head);
+        for (int i = 0; i < nitems; i++) {
+                ret = tp_set(&tp[i], i % DP_NONE, PA_ + i % 3 - 1, i % 9);
+                if (TONAL_OK != ret) { return ret; }
+                ret = ti_set(&ti[i], i % DI_NONE, IA_PERFECT, i % 2, i % 2);
+                if (TONAL_OK != ret) {
+                        ret = ti_set(&ti[i], i % DI_NONE, IA_MAJOR, i % 2, i % 2);
+                }
+                if (TONAL_OK != ret) { return ret; }
+                item[i].arg[0] = tp[i].diatonic_pitch;
+                item[i].arg[1] = tp[i].pitch_alteration;
+                item[i].arg[2] = tp[i].octave;
+                item[i].arg[3] = ti[i].diatonic_interval;
+                item[i].arg[4] = ti[i].interval_alteration;
+                item[i].arg[5] = ti[i].octave;
+                item[i].arg[6] = ti[i].interval_direction;
+        }
+        tp_add_n(tp, ti, sum, status, nitems);
+        for (int i = 0; i < nitems; i++) {
+                result[i].status = status[i];
+                if (TONAL_OK != status[i]) { continue; }
+                result[i].val[0] = sum[i].diatonic_pitch;
+                result[i].val[1] = sum[i].pitch_alteration;
+                result[i].val[2] = sum[i].octave;
+        }
+        free(tp);
+        free(ti);
+        free(sum);
+        free(status);
+        return TONAL_OK;
+}
+
+static void *work(void *arg)
+{
+        struct worker *w = arg;
+        unsigned long long *t0;
+        unsigned long long end;
+        char *response;
+
+        t0 = calloc(w->nclients, sizeof *t0);
+        response = malloc(expected_size);
+        if (NULL == t0 || NULL == response) {
+                w->errors++;
+                goto out;
+        }
+
+        end = now() + seconds * 1e9;
+        while (now() < end) {
+                for (int i = 0; i < w->nclients; i++) {
+                        t0[i] = now();
+                        if (TONAL_OK != write_all(w->fd[i], request, request_size)) {
+                                w->errors++;
+                                goto out;
+                        }
+                }
+                for (int i = 0; i < w->nclients; i++) {
+                        if (TONAL_OK != read_all(w->fd[i], response, expected_size)) {
+                                w->errors++;
+                                goto out;
+                        }
+                        if (w->nlat == w->max) {
+                                unsigned long long *lat;
+
+                                w->max = w->max ? 2 * w->max : 4096;
+                                lat = realloc(w->lat, w->max * sizeof *lat);
+                                if (NULL == lat) {
+                                        w->errors++;
+                                        goto out;
+                                }
+                                w->lat = lat;
+                        }
+                        w->lat[w->nlat++] = now() - t0[i];
+                        if (0 != memcmp(response, expected, expected_size)) {
+                                w->errors++;
+                        }
+                }
+        }
+out:
+        free(t0);
+        free(response);
+        return NULL;
+}
+
+static int compare(const void *a, const void *b)
+{
+        const unsigned long long *x = a;
+        const unsigned long long *y = b;
+
+        return (*x > *y) - (*x < *y);
+}
+
+static double percentile(const unsigned long long *lat, size_t n, double p)
+{
+        size_t i = p * (n - 1);
+
+        return lat[i] / 1e3;
+}
+
+int main(int argc, char **argv)
+{
+        struct worker *worker;
+        unsigned long long *lat;
+        unsigned long long errors;
+        unsigned long long t0;
+        double elapsed;
+        int nclients = 64;
+        int nthreads = 4;
+        size_t n;
+        int opt;
+
+        while (-1 != (opt = getopt(argc, argv, "s:c:t:n:d:"))) {
+                switch (opt) {
+                case 's': path = optarg; break;
+                case 'c': nclients = atoi(optarg); break;
+                case 't': nthreads = atoi(optarg); break;
+                case 'n': nitems = atoi(optarg); break;
+                case 'd': seconds = atof(optarg); break;
+                default:
+                        fprintf(
+                                stderr,
+                                "usage: tonald_bench [-s socket] [-c clients] "
+                                "[-t threads] [-n items] [-d seconds]\n"
+                        );
+                        return 2;
+                }
+        }
+        if (
+                nclients < 1 || nthreads < 1 || nthreads > nclients ||
+                nitems < 1 || TONALD_MAX < nitems
+        ) {
+                fprintf(stderr, "tonald_bench: invalid argument\n");
+                return 2;
+        }
+        if (TONAL_OK != make_request()) {
+                fprintf(stderr, "tonald_bench: out of memory\n");
+                return 1;
+        }
+
+        worker = calloc(nthreads, sizeof *worker);
+        if (NULL == worker) { return 1; }
+        for (int t = 0; t < nthreads; t++) {
+                struct worker *w = &worker[t];
+
+                w->nclients = nclients / nthreads + (t < nclients % nthreads);
+                w->fd = calloc(w->nclients, sizeof *w->fd);
+                if (NULL == w->fd) { return 1; }
+                for (int i = 0; i < w->nclients; i++) {
+                        w->fd[i] = connect_to(path);
+                        if (w->fd[i] < 0) {
+                                perror("tonald_bench: connect");
+                                return 1;
+                        }
+                }
+        }
+
+        t0 = now();
+        for (int t = 0; t < nthreads; t++) {
+                pthread_create(&worker[t].thread, NULL, work, &worker[t]);
+        }
+        n = 0;
+        errors = 0;
+        for (int t = 0; t < nthreads; t++) {
+                pthread_join(worker[t].thread, NULL);
+                n += worker[t].nlat;
+                errors += worker[t].errors;
+        }
+        elapsed = (now() - t0) / 1e9;
+
+        lat = malloc((n ? n : 1) * sizeof *lat);
+        if (NULL == lat) { return 1; }
+        n = 0;
+        for (int t = 0; t < nthreads; t++) {
+                memcpy(lat + n, worker[t].lat, worker[t].nlat * sizeof *lat);
+                n += worker[t].nlat;
+        }
+        if (0 == n) {
+                fprintf(stderr, "tonald_bench: no responses\n");
+                return 1;
+        }
+        qsort(lat, n, sizeof *lat, compare);
+
+        printf("%d clients, %d threads, %d items per request\n",
+                nclients, nthreads, nitems);
+        printf("%.0f requests/s, %.0f items/s\n",
+                n / elapsed, n * (double) nitems / elapsed);
+        printf("latency us: p50 %.1f  p99 %.1f  p99.9 %.1f  max %.1f\n",
+                percentile(lat, n, 0.5),
+                percentile(lat, n, 0.99),
+                percentile(lat, n, 0.999),
+                lat[n - 1] / 1e3);
+        printf("%llu errors\n", errors);
+        return errors ? 1 : 0;
+}